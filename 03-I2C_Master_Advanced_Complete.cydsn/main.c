@@ -12,7 +12,7 @@
 // Include required header files
 #include "I2C_Interface.h"
 #include "project.h"
-#include "stdio.h"
+#include "Log.h"
 
 /**
 *   \brief 7-bit I2C address of the slave device.
@@ -73,17 +73,15 @@ int main(void)
     
     CyDelay(5); //"The boot procedure is complete about 5 milliseconds after device power-up."
     
-    // String to print out messages on the UART
-    char message[50];
-
     // Check which devices are present on the I2C bus
     for (int i = 0 ; i < 128; i++)
     {
         if (I2C_Peripheral_IsDeviceConnected(i))
         {
             // print out the address is hex format
-            sprintf(message, "Device 0x%02X is connected\r\n", i);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "Device 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, i);
+            LOG_STRING(LOG_LEVEL_INFO, " is connected\r\n");
         }
         
     }
@@ -99,12 +97,13 @@ int main(void)
                                                   &who_am_i_reg);
     if (error == NO_ERROR)
     {
-        sprintf(message, "WHO AM I REG: 0x%02X [Expected: 0x33]\r\n", who_am_i_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "WHO AM I REG: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, who_am_i_reg);
+        LOG_STRING(LOG_LEVEL_INFO, " [Expected: 0x33]\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm\r\n");   
     }
     
     /*      I2C Reading Status Register       */
@@ -116,12 +115,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "STATUS REGISTER: 0x%02X\r\n", status_register);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "STATUS REGISTER: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, status_register);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read status register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read status register\r\n");   
     }
     
     /******************************************/
@@ -134,12 +134,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
     /******************************************/
@@ -147,7 +148,7 @@ int main(void)
     /******************************************/
     
         
-    UART_Debug_PutString("\r\nWriting new values..\r\n");
+    LOG_STRING(LOG_LEVEL_INFO, "\r\nWriting new values..\r\n");
     
     if (ctrl_reg1 != LIS3DH_NORMAL_MODE_CTRL_REG1)
     {
@@ -159,12 +160,13 @@ int main(void)
     
         if (error == NO_ERROR)
         {
-            sprintf(message, "CONTROL REGISTER 1 successfully written as: 0x%02X\r\n", ctrl_reg1);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 successfully written as: 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+            LOG_STRING(LOG_LEVEL_INFO, "\r\n");
         }
         else
         {
-            UART_Debug_PutString("Error occurred during I2C comm to set control register 1\r\n");   
+            LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to set control register 1\r\n");   
         }
     }
     
@@ -178,12 +180,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1 after overwrite operation: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 after overwrite operation: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
      /******************************************/
@@ -198,12 +201,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "TEMPERATURE CONFIG REGISTER: 0x%02X\r\n", tmp_cfg_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "TEMPERATURE CONFIG REGISTER: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, tmp_cfg_reg);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read temperature config register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read temperature config register\r\n");   
     }
     
     
@@ -220,12 +224,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "TEMPERATURE CONFIG REGISTER after being updated: 0x%02X\r\n", tmp_cfg_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "TEMPERATURE CONFIG REGISTER after being updated: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, tmp_cfg_reg);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read temperature config register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read temperature config register\r\n");   
     }
     
     uint8_t ctrl_reg4;
@@ -236,12 +241,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
     
@@ -258,12 +264,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4 after being updated: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4 after being updated: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
     int16_t OutTemp;
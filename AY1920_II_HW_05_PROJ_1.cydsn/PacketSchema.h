@@ -0,0 +1,204 @@
+/**
+*   \file PacketSchema.h
+*   \brief Layouts of the fixed frames sent over UART.
+*
+*   Each packet is described once, as a list of fields: the firmware
+*   expands the list into the offsets, a sample struct and an encoder
+*   with every offset fixed at compile time (no loop over the fields, no
+*   branch on the layout); the host tool (Host/PacketSchema) expands the
+*   same list into the decoder and into the Bridge Control Panel .iic and
+*   .ini files. Firmware, host and plotter are built from the same
+*   revision, so a field added here is byte-exact everywhere.
+*
+*   A packet is the header byte, BATCH samples of the fields and the
+*   footer byte. The fields are little endian integers of 1, 2 or 4 bytes:
+*
+*       FIELD(packet, name, bytes, sign, scale, color)
+*
+*   with sign 1 for signed values, scale the unit of the value as plotted
+*   and color the plot color of Bridge Control Panel.
+*
+*   The frames whose layout follows the configuration (the 0xA0 frame with
+*   some axes disabled, 0xA2, 0xA4, 0xA5) are laid out at run time by
+*   their modules; ACC is the 0xA0 frame with all the axes, as plotted.
+*
+*   Every project keeps a copy of this file with the whole list.
+*/
+
+#ifndef __PACKET_SCHEMA_H
+    #define __PACKET_SCHEMA_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Packets, by name.
+    */
+    #define PACKET_LIST(PACKET) \
+        PACKET(TEMP) \
+        PACKET(ACC_MG) \
+        PACKET(ACC) \
+        PACKET(AUX) \
+        PACKET(LOSS)
+
+    /**
+    *   \brief PROJ_1: temperature from ADC3 (10-bit).
+    */
+    #define PACKET_TEMP_HEADER 0xA0
+    #define PACKET_TEMP_FOOTER 0xC0
+    #define PACKET_TEMP_BATCH 1
+    #define PACKET_TEMP_FIELDS(FIELD, P) \
+        FIELD(P, temp, 2, 1, 1, Red)
+
+    /**
+    *   \brief PROJ_2: acceleration in mg.
+    */
+    #define PACKET_ACC_MG_HEADER 0xA0
+    #define PACKET_ACC_MG_FOOTER 0xC0
+    #define PACKET_ACC_MG_BATCH 1
+    #define PACKET_ACC_MG_FIELDS(FIELD, P) \
+        FIELD(P, accX, 2, 1, 1, Red) \
+        FIELD(P, accY, 2, 1, 1, Blue) \
+        FIELD(P, accZ, 2, 1, 1, Green)
+
+    /**
+    *   \brief PROJ_3: acceleration in m/s^2 x 10000.
+    */
+    #define PACKET_ACC_HEADER 0xA0
+    #define PACKET_ACC_FOOTER 0xC0
+    #define PACKET_ACC_BATCH 1
+    #define PACKET_ACC_FIELDS(FIELD, P) \
+        FIELD(P, accX, 4, 1, 0.0001, Red) \
+        FIELD(P, accY, 4, 1, 0.0001, Blue) \
+        FIELD(P, accZ, 4, 1, 0.0001, Green)
+
+    /**
+    *   \brief PROJ_3: ADC1, ADC2 and ADC3 (temperature), 10-bit.
+    */
+    #define PACKET_AUX_HEADER 0xA1
+    #define PACKET_AUX_FOOTER 0xC0
+    #define PACKET_AUX_BATCH 1
+    #define PACKET_AUX_FIELDS(FIELD, P) \
+        FIELD(P, adc1, 2, 1, 1, Orange) \
+        FIELD(P, adc2, 2, 1, 1, Purple) \
+        FIELD(P, temp, 2, 1, 1, Maroon)
+
+    /**
+    *   \brief PROJ_3: samples lost since the previous marker, by cause (saturated at 255).
+    */
+    #define PACKET_LOSS_HEADER 0xA3
+    #define PACKET_LOSS_FOOTER 0xC0
+    #define PACKET_LOSS_BATCH 1
+    #define PACKET_LOSS_FIELDS(FIELD, P) \
+        FIELD(P, overruns, 1, 0, 1, Black) \
+        FIELD(P, merges, 1, 0, 1, Gray) \
+        FIELD(P, drops, 1, 0, 1, OrangeRed) \
+        FIELD(P, errors, 1, 0, 1, Red)
+
+    /**
+    *   \brief C type of a field, by bytes and sign.
+    */
+    #define PACKET_TYPE_1_0 uint8_t
+    #define PACKET_TYPE_1_1 int8_t
+    #define PACKET_TYPE_2_0 uint16_t
+    #define PACKET_TYPE_2_1 int16_t
+    #define PACKET_TYPE_4_0 uint32_t
+    #define PACKET_TYPE_4_1 int32_t
+
+    /**
+    *   \brief Little endian stores and loads of the fields.
+    */
+    static inline void Packet_Put1(uint8_t* bytes, uint32_t value)
+    {
+        bytes[0] = (uint8_t)value;
+    }
+
+    static inline void Packet_Put2(uint8_t* bytes, uint32_t value)
+    {
+        bytes[0] = (uint8_t)value;
+        bytes[1] = (uint8_t)(value >> 8);
+    }
+
+    static inline void Packet_Put4(uint8_t* bytes, uint32_t value)
+    {
+        bytes[0] = (uint8_t)value;
+        bytes[1] = (uint8_t)(value >> 8);
+        bytes[2] = (uint8_t)(value >> 16);
+        bytes[3] = (uint8_t)(value >> 24);
+    }
+
+    static inline uint32_t Packet_Get1(const uint8_t* bytes)
+    {
+        return bytes[0];
+    }
+
+    static inline uint32_t Packet_Get2(const uint8_t* bytes)
+    {
+        return bytes[0] | ((uint32_t)bytes[1] << 8);
+    }
+
+    static inline uint32_t Packet_Get4(const uint8_t* bytes)
+    {
+        return bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+    }
+
+    /**
+    *   \brief Expansions of a field.
+    *
+    *   The offsets are enumerated in order: the offset of each field is the
+    *   end of the previous one, the header is at offset 0.
+    */
+    #define PACKET_FIELD_MEMBER(P, name, bytes, sign, scale, color) PACKET_TYPE_##bytes##_##sign name;
+    #define PACKET_FIELD_OFFSET(P, name, bytes, sign, scale, color) \
+        PACKET_##P##_##name##_OFFSET, PACKET_##P##_##name##_LAST = PACKET_##P##_##name##_OFFSET + (bytes) - 1,
+    #define PACKET_FIELD_ENCODE(P, name, bytes, sign, scale, color) \
+        Packet_Put##bytes(&sample_bytes[PACKET_##P##_##name##_OFFSET], (uint32_t)samples[s].name);
+    #define PACKET_FIELD_DECODE(P, name, bytes, sign, scale, color) \
+        samples[s].name = (PACKET_TYPE_##bytes##_##sign)Packet_Get##bytes(&sample_bytes[PACKET_##P##_##name##_OFFSET]);
+
+    /**
+    *   \brief Generate the layout, the sample struct, the encoder and the decoder of a packet.
+    *
+    *   For a packet P:
+    *   - PACKET_P_LENGTH: bytes of the frame, header and footer included;
+    *   - PACKET_P_SAMPLE_LENGTH: bytes of a sample;
+    *   - PACKET_P_<field>_OFFSET: offset of a field in the first sample;
+    *   - Packet_P: a sample, one member per field;
+    *   - Packet_Encode_P(frame, samples): write the frame of BATCH samples;
+    *   - Packet_Decode_P(frame, samples): read the samples of a frame.
+    */
+    #define PACKET_DEFINE(P) \
+        enum { \
+            PACKET_##P##_START, \
+            PACKET_##P##_FIELDS(PACKET_FIELD_OFFSET, P) \
+            PACKET_##P##_END \
+        }; \
+        enum { \
+            PACKET_##P##_SAMPLE_LENGTH = PACKET_##P##_END - 1, \
+            PACKET_##P##_LENGTH = 2 + PACKET_##P##_BATCH*PACKET_##P##_SAMPLE_LENGTH \
+        }; \
+        typedef struct { \
+            PACKET_##P##_FIELDS(PACKET_FIELD_MEMBER, P) \
+        } Packet_##P; \
+        static inline void Packet_Encode_##P(uint8_t* frame, const Packet_##P* samples) \
+        { \
+            frame[0] = PACKET_##P##_HEADER; \
+            for (uint8_t s = 0; s < PACKET_##P##_BATCH; s++) \
+            { \
+                uint8_t* sample_bytes = &frame[s*PACKET_##P##_SAMPLE_LENGTH]; \
+                PACKET_##P##_FIELDS(PACKET_FIELD_ENCODE, P) \
+            } \
+            frame[PACKET_##P##_LENGTH - 1] = PACKET_##P##_FOOTER; \
+        } \
+        static inline void Packet_Decode_##P(const uint8_t* frame, Packet_##P* samples) \
+        { \
+            for (uint8_t s = 0; s < PACKET_##P##_BATCH; s++) \
+            { \
+                const uint8_t* sample_bytes = &frame[s*PACKET_##P##_SAMPLE_LENGTH]; \
+                PACKET_##P##_FIELDS(PACKET_FIELD_DECODE, P) \
+            } \
+        }
+
+    PACKET_LIST(PACKET_DEFINE)
+
+#endif
+/* [] END OF FILE */
@@ -12,7 +12,8 @@
 // Include required header files
 #include "I2C_Interface.h"
 #include "project.h"
-#include "stdio.h"
+#include "Log.h"
+#include "PacketSchema.h"
 
 /**
 *   \brief 7-bit I2C address of the slave device.
@@ -73,17 +74,15 @@ int main(void)
     
     CyDelay(5); //"The boot procedure is complete about 5 milliseconds after device power-up."
     
-    // String to print out messages on the UART
-    char message[50];
-
     // Check which devices are present on the I2C bus
     for (int i = 0 ; i < 128; i++)
     {
         if (I2C_Peripheral_IsDeviceConnected(i))
         {
             // print out the address is hex format
-            sprintf(message, "Device 0x%02X is connected\r\n", i);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "Device 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, i);
+            LOG_STRING(LOG_LEVEL_INFO, " is connected\r\n");
         }
         
     }
@@ -99,12 +98,13 @@ int main(void)
                                                   &who_am_i_reg);
     if (error == NO_ERROR)
     {
-        sprintf(message, "WHO AM I REG: 0x%02X [Expected: 0x33]\r\n", who_am_i_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "WHO AM I REG: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, who_am_i_reg);
+        LOG_STRING(LOG_LEVEL_INFO, " [Expected: 0x33]\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm\r\n");   
     }
     
     /*      I2C Reading Status Register       */
@@ -116,12 +116,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "STATUS REGISTER: 0x%02X\r\n", status_register);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "STATUS REGISTER: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, status_register);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read status register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read status register\r\n");   
     }
     
     /******************************************/
@@ -134,12 +135,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
     /******************************************/
@@ -147,7 +149,7 @@ int main(void)
     /******************************************/
     
         
-    UART_Debug_PutString("\r\nWriting new values..\r\n");
+    LOG_STRING(LOG_LEVEL_INFO, "\r\nWriting new values..\r\n");
     
     if (ctrl_reg1 != LIS3DH_NORMAL_MODE_CTRL_REG1)
     {
@@ -159,12 +161,13 @@ int main(void)
     
         if (error == NO_ERROR)
         {
-            sprintf(message, "CONTROL REGISTER 1 successfully written as: 0x%02X\r\n", ctrl_reg1);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 successfully written as: 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+            LOG_STRING(LOG_LEVEL_INFO, "\r\n");
         }
         else
         {
-            UART_Debug_PutString("Error occurred during I2C comm to set control register 1\r\n");   
+            LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to set control register 1\r\n");   
         }
     }
     
@@ -178,12 +181,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1 after overwrite operation: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 after overwrite operation: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
      /******************************************/
@@ -198,12 +202,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "TEMPERATURE CONFIG REGISTER: 0x%02X\r\n", tmp_cfg_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "TEMPERATURE CONFIG REGISTER: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, tmp_cfg_reg);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read temperature config register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read temperature config register\r\n");   
     }
     
     
@@ -220,12 +225,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "TEMPERATURE CONFIG REGISTER after being updated: 0x%02X\r\n", tmp_cfg_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "TEMPERATURE CONFIG REGISTER after being updated: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, tmp_cfg_reg);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read temperature config register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read temperature config register\r\n");   
     }
     
     uint8_t ctrl_reg4;
@@ -236,12 +242,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
     
@@ -258,23 +265,19 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4 after being updated: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4 after being updated: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
-    int16_t OutTemp;
-    uint8_t header = 0xA0;
-    uint8_t footer = 0xC0;
-    uint8_t OutArray[4]; 
+    Packet_TEMP sample;
+    uint8_t OutArray[PACKET_TEMP_LENGTH];
     uint8_t TemperatureData[2];
     
-    OutArray[0] = header;
-    OutArray[3] = footer;
-    
     for(;;)
     {
         CyDelay(100);
@@ -285,10 +288,9 @@ int main(void)
         
         if(error == NO_ERROR)
         {
-            OutTemp = (int16)((TemperatureData[0] | (TemperatureData[1]<<8)))>>6;
-            OutArray[1] = (uint8_t)(OutTemp & 0xFF);
-            OutArray[2] = (uint8_t)(OutTemp >> 8);
-            UART_Debug_PutArray(OutArray, 4);
+            sample.temp = (int16)((TemperatureData[0] | (TemperatureData[1]<<8)))>>6;
+            Packet_Encode_TEMP(OutArray, &sample);
+            UART_Debug_PutArray(OutArray, PACKET_TEMP_LENGTH);
         }
     }
 }
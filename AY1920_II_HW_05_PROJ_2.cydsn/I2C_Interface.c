@@ -136,16 +136,14 @@
         uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
         if (error == I2C_Master_MSTR_NO_ERROR)
         {
-            // Write register address
-            error = I2C_Master_MasterWriteByte(register_address);
+            // Write address of first register with the MSB equal to 1 (auto-increment)
+            error = I2C_Master_MasterWriteByte(register_address | 0x80);
             if (error == I2C_Master_MSTR_NO_ERROR)
             {
                 // Continue writing until we have data to write
-                uint8_t counter = register_count;
-                while(counter >= 0)
+                for (uint8_t counter = 0; counter < register_count; counter++)
                 {
-                     error =
-                        I2C_Master_MasterWriteByte(data[register_count-counter]);
+                    error = I2C_Master_MasterWriteByte(data[counter]);
                     if (error != I2C_Master_MSTR_NO_ERROR)
                     {
                         // Send stop condition
@@ -153,7 +151,6 @@
                         // Return error code
                         return ERROR;
                     }
-                    counter--;
                 }
             }
         }
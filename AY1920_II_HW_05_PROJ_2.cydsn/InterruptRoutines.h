@@ -13,7 +13,6 @@
    #define __INTERRUPT_ROUTINES_H
 
     #include "cytypes.h"
-    #include "stdio.h"
 
     
     CY_ISR_PROTO(Custom_ISR_ADC);
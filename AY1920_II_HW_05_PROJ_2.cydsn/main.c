@@ -10,7 +10,8 @@
 // Include required header files
 #include "I2C_Interface.h"
 #include "project.h"
-#include "stdio.h"
+#include "Log.h"
+#include "PacketSchema.h"
 #include "InterruptRoutines.h"
 
 
@@ -79,17 +80,15 @@ int main(void)
     
     CyDelay(5); //"The boot procedure is complete about 5 milliseconds after device power-up."
     
-    // String to print out messages on the UART
-    char message[50];
-
     // Check which devices are present on the I2C bus
     for (int i = 0 ; i < 128; i++)
     {
         if (I2C_Peripheral_IsDeviceConnected(i))
         {
             // print out the address is hex format
-            sprintf(message, "Device 0x%02X is connected\r\n", i);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "Device 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, i);
+            LOG_STRING(LOG_LEVEL_INFO, " is connected\r\n");
         }
         
     }
@@ -105,12 +104,13 @@ int main(void)
                                                   &who_am_i_reg);
     if (error == NO_ERROR)
     {
-        sprintf(message, "WHO AM I REG: 0x%02X [Expected: 0x33]\r\n", who_am_i_reg);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "WHO AM I REG: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, who_am_i_reg);
+        LOG_STRING(LOG_LEVEL_INFO, " [Expected: 0x33]\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm\r\n");   
     }
     
     /*      I2C Reading Status Register       */
@@ -122,12 +122,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "STATUS REGISTER: 0x%02X\r\n", status_register);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "STATUS REGISTER: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, status_register);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read status register\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read status register\r\n");   
     }
     
     /******************************************/
@@ -140,12 +141,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
     /******************************************/
@@ -153,7 +155,7 @@ int main(void)
     /******************************************/
     
         
-    UART_Debug_PutString("\r\nWriting new values..\r\n");
+    LOG_STRING(LOG_LEVEL_INFO, "\r\nWriting new values..\r\n");
     
     if (ctrl_reg1 != LIS3DH_NORMAL_MODE_CTRL_REG1)
     {
@@ -165,12 +167,13 @@ int main(void)
     
         if (error == NO_ERROR)
         {
-            sprintf(message, "CONTROL REGISTER 1 successfully written as: 0x%02X\r\n", ctrl_reg1);
-            UART_Debug_PutString(message); 
+            LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 successfully written as: 0x");
+            LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+            LOG_STRING(LOG_LEVEL_INFO, "\r\n");
         }
         else
         {
-            UART_Debug_PutString("Error occurred during I2C comm to set control register 1\r\n");   
+            LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to set control register 1\r\n");   
         }
     }
     
@@ -184,12 +187,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 1 after overwrite operation: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 1 after overwrite operation: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg1);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register 1\r\n");   
     }
     
      /******************************************/
@@ -206,12 +210,13 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
     
@@ -228,26 +233,19 @@ int main(void)
     
     if (error == NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4 after being updated: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_STRING(LOG_LEVEL_INFO, "CONTROL REGISTER 4 after being updated: 0x");
+        LOG_HEX8(LOG_LEVEL_INFO, ctrl_reg4);
+        LOG_STRING(LOG_LEVEL_INFO, "\r\n");
     }
     else
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_STRING(LOG_LEVEL_ERROR, "Error occurred during I2C comm to read control register4\r\n");   
     }
     
-    int16_t Out_accX;
-    int16_t Out_accY;
-    int16_t Out_accZ;
-    uint8_t header = 0xA0;
-    uint8_t footer = 0xC0;
-    uint8_t OutArray[8]; 
+    Packet_ACC_MG sample;
+    uint8_t OutArray[PACKET_ACC_MG_LENGTH];
     uint8_t acc[6];
     
-    
-    OutArray[0] = header;
-    OutArray[7] = footer;
-    
     for(;;)
     {
         if(flag_ISR)
@@ -266,44 +264,16 @@ int main(void)
        
                 if(error == NO_ERROR)
                 {
-                    /******************************************/
-                    /*               Acc_X                    */
-                    /******************************************/
-                    Out_accX = (int16)((acc[0] | (acc[1]<<8)))>>6;
-                    
-                    /*scaling to mg (sensitivity=4mg/digit)*/
-                    Out_accX=Out_accX*SENSITIVITY;
-                    
-                    /*divide the int16 in 2 bytes*/
-                    OutArray[1] = (uint8_t)(Out_accX & 0xFF);
-                    OutArray[2] = (uint8_t)(Out_accX >> 8);
-                    
-                    /******************************************/
-                    /*               Acc_Y                    */
-                    /******************************************/
-                    Out_accY = (int16)((acc[2] | (acc[3]<<8)))>>6;
-                    
-                     /*scaling to mg (sensitivity=4mg/digit)*/
-                    Out_accY=Out_accY*SENSITIVITY;  
-                    
-                    /*divide the int16 in 2 bytes*/
-                    OutArray[3] = (uint8_t)(Out_accY & 0xFF);
-                    OutArray[4] = (uint8_t)(Out_accY >> 8);
-                   
-                    /******************************************/
-                    /*               Acc_Z                    */
-                    /******************************************/
-                    Out_accZ = (int16)((acc[4] | (acc[5]<<8)))>>6;
-                    
-                     /*scaling to mg (sensitivity=4mg/digit)*/
-                    Out_accZ=Out_accZ*SENSITIVITY;  
+                    /*10-bit left-justified outputs (normal mode), scaled to mg (sensitivity=4mg/digit)*/
+                    sample.accX = ((int16)((acc[0] | (acc[1]<<8)))>>6)*SENSITIVITY;
+                    sample.accY = ((int16)((acc[2] | (acc[3]<<8)))>>6)*SENSITIVITY;
+                    sample.accZ = ((int16)((acc[4] | (acc[5]<<8)))>>6)*SENSITIVITY;
                     
-                    /*divide the int16 in 2 bytes*/
-                    OutArray[5] = (uint8_t)(Out_accZ & 0xFF);
-                    OutArray[6] = (uint8_t)(Out_accZ >> 8);
+                    /*pack the frame plotted by Bridge Control Panel (PacketSchema.h)*/
+                    Packet_Encode_ACC_MG(OutArray, &sample);
                     
                     /*send bytes to be plotted to Bridge Contol Panel*/
-                    UART_Debug_PutArray(OutArray, 8);
+                    UART_Debug_PutArray(OutArray, PACKET_ACC_MG_LENGTH);
                 }    
             }
         }
@@ -0,0 +1,439 @@
+/*
+* This file includes the source code to read the accelerometer
+* outputs and pack them into the UART frame.
+*/
+
+#include "Acquisition.h"
+#include "I2C_Interface.h"
+#include "TempCompensation.h"
+#include "CycleCounter.h"
+
+#define G 9.81              //gravitational acceleration = 9.81 m/s^2
+#define DECIMALS 10000      //multiplication factor to keep 4 decimals
+
+/**
+*   \brief Sensitivity of each CTRL_REG4 FS[1:0] full scale, in g per 12-bit digit.
+*
+*   The outputs are left-justified: 12 bits in high resolution mode, 10 in
+*   normal mode and 8 in low-power mode. The samples are kept in 12-bit
+*   digits in every mode, so the sensitivity only depends on the full scale.
+*/
+static const float64 acquisition_sensitivity[4] = {0.001, 0.002, 0.004, 0.012};
+
+/**
+*   \brief Output scale of the applied configuration.
+*/
+static float64 sensitivity = 0.002;         ///< g per 12-bit digit
+static uint16 resolution_mask = 0xFFF0;     ///< Output bits carried by the operating mode
+
+/**
+*   \brief Layout of the burst read and of the frame.
+*/
+static uint8_t axis_mask;       ///< Enabled axes (CTRL_REG1 bits 2:0)
+static uint8_t axis_count;      ///< Number of enabled axes
+static uint8_t burst_length;    ///< Bytes of the status read of each device at each poll
+static uint8_t split_read;      ///< The enabled axes are read apart from the status
+static uint8_t frame_length;    ///< Bytes sent over UART for each frame
+
+/**
+*   \brief Devices read at each poll.
+*/
+static struct {
+    uint8_t address;                                    ///< 7-bit I2C address
+    uint8_t pending;                                    ///< New sample waiting for the frame
+    uint8_t sample[LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES]; ///< Output registers of the sample
+} sensors[ACQUISITION_MAX_SENSORS];
+static uint8_t sensor_count;
+static uint8_t failed_polls;    ///< Polls in a row with a failed device read
+
+/**
+*   \brief Timestamp of the multi-sensor frames, kept from the cycle counter.
+*/
+static uint32 timestamp_us;
+static uint32 timestamp_cycles;
+
+/**
+*   \brief Lost samples: since start and since the last marker.
+*/
+static Acquisition_LossStats loss_stats;
+static Acquisition_LossStats loss_marked;
+
+/**
+*   \brief Samples per frame sent.
+*/
+static uint8_t decimation = 1;
+static uint8_t decimation_count;
+
+/**
+*   \brief Per-axis gains (Q12).
+*/
+static int16_t axis_gain[LIS3DH_AXIS_COUNT] = {4096, 4096, 4096};
+
+/**
+*   \brief Sub-rate of the auxiliary ADC channels.
+*/
+static uint8_t aux_divider;     ///< Accelerometer samples between two auxiliary reads
+static uint8_t aux_count;       ///< Accelerometer samples since the last auxiliary read
+static uint8_t sample_polled;   ///< The last poll read a new sample from a device
+
+/**
+*   \brief The 0xA0 frame with all the axes must be the ACC packet plotted by Bridge Control Panel.
+*/
+typedef char Acquisition_AccLayoutCheck[(2 + LIS3DH_AXIS_COUNT*ACQUISITION_BYTES_PER_AXIS == PACKET_ACC_LENGTH) ? 1 : -1];
+
+    void Acquisition_Start(const uint8_t* addresses, uint8_t count, uint8_t ctrl_reg1, uint8_t ctrl_reg4,
+                           uint8_t* frame)
+    {
+        axis_mask = ctrl_reg1 & LIS3DH_CTRL_REG1_AXIS_MASK;
+        axis_count = 0;
+
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            if (axis_mask & (1 << axis))
+            {
+                axis_count++;
+            }
+        }
+
+        sensor_count = (count < ACQUISITION_MAX_SENSORS) ? count : ACQUISITION_MAX_SENSORS;
+        for (uint8_t s = 0; s < sensor_count; s++)
+        {
+            sensors[s].address = addresses[s];
+            sensors[s].pending = 0;
+        }
+
+        // Status and output registers are contiguous: read from STATUS_REG to the last enabled axis, or apart
+        burst_length = (axis_count && sensor_count) ? ACQUISITION_STATUS_READ_LENGTH(axis_mask) : 0;
+        split_read = ACQUISITION_SPLIT_READ(axis_mask);
+
+        if (sensor_count > 1)
+        {
+            frame_length = 2 + ACQUISITION_TIMESTAMP_BYTES + sensor_count*axis_count*ACQUISITION_BYTES_PER_AXIS;
+            frame[0] = ACQUISITION_MULTI_HEADER;
+        }
+        else
+        {
+            frame_length = 2 + axis_count*ACQUISITION_BYTES_PER_AXIS;
+            frame[0] = ACQUISITION_HEADER;
+        }
+        frame[frame_length-1] = ACQUISITION_FOOTER;
+
+        // Full scale and resolution as applied, the bits below the resolution of the mode are not data
+        sensitivity = acquisition_sensitivity[(ctrl_reg4 & LIS3DH_CTRL_REG4_FS_MASK) >> LIS3DH_CTRL_REG4_FS_SHIFT];
+        if (ctrl_reg1 & LIS3DH_CTRL_REG1_LPEN)
+        {
+            resolution_mask = 0xFF00;
+        }
+        else if (ctrl_reg4 & LIS3DH_CTRL_REG4_HR)
+        {
+            resolution_mask = 0xFFF0;
+        }
+        else
+        {
+            resolution_mask = 0xFFC0;
+        }
+
+        timestamp_cycles = CycleCounter_Read();
+        timestamp_us = CycleCounter_ToUs(timestamp_cycles);
+    }
+
+    void Acquisition_SetGain(const int16_t* gain)
+    {
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            axis_gain[axis] = gain[axis];
+        }
+    }
+
+    uint8_t Acquisition_IsDataReady(uint8_t status_register)
+    {
+        // ZYXDA (bit 3) or the XDA/YDA/ZDA bits of the enabled axes
+        return status_register & (LIS3DH_STATUS_ZYXDA | axis_mask);
+    }
+
+    /**
+    *   \brief Advance the timestamp to the current cycle count.
+    */
+    static void Acquisition_UpdateTimestamp(void)
+    {
+        uint32 now = CycleCounter_Read();
+        uint32 elapsed_us = CycleCounter_ToUs(now - timestamp_cycles);
+
+        // Keep the fraction of us in the cycle reference, so that the timestamp does not drift
+        timestamp_us += elapsed_us;
+        timestamp_cycles += elapsed_us*CYCLE_COUNTER_CYCLES_PER_US;
+    }
+
+    /**
+    *   \brief Convert the sample of a device and pack it into the frame.
+    */
+    static uint8_t Acquisition_PackSample(const uint8_t* acc, uint8_t* frame, uint8_t index)
+    {
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            if (axis_mask & (1 << axis))
+            {
+                uint8_t offset = axis*LIS3DH_AXIS_BYTES;
+
+                /*left-justified output, in 12-bit digits whatever the resolution of the mode*/
+                int16_t out_acc = (int16)((acc[offset] | (acc[offset+1]<<8)) & resolution_mask)>>4;
+
+                /*temperature-compensated zero-g offset*/
+                out_acc -= TempCompensation_GetOffset(axis);
+
+                /*per-axis gain calibration (Q12)*/
+                out_acc = (int16_t)(((int32)out_acc*axis_gain[axis]) >> 12);
+
+                /*cast to a floating point in m/s^2 units (sensitivity of the full scale)*/
+                float32 out_acc2 = (float32)out_acc*G*sensitivity;
+
+                /*multiplication by a factor of 10000 to keep 4 decimals and cast to int32*/
+                int32 intero = (int32) (out_acc2*DECIMALS);
+
+                /*divide the int32 in 4 bytes */
+                frame[index++] = (uint8_t)(intero & 0xFF);
+                frame[index++] = (uint8_t)((intero >> 8)& 0xFF);
+                frame[index++] = (uint8_t)((intero >> 16)& 0xFF);
+                frame[index++] = (uint8_t)(intero >> 24);
+            }
+        }
+        return index;
+    }
+
+    ErrorCode Acquisition_Poll(uint8_t* frame, uint8_t* frame_ready)
+    {
+        uint8_t burst[1 + LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES];
+        uint8_t complete = 1;
+        ErrorCode result = NO_ERROR;
+
+        *frame_ready = 0;
+        sample_polled = 0;
+        if (burst_length == 0)
+        {
+            return ERROR;
+        }
+
+        // Devices are read back-to-back, so that their samples fall in the same period
+        Acquisition_UpdateTimestamp();
+        for (uint8_t s = 0; s < sensor_count; s++)
+        {
+            if (!sensors[s].pending)
+            {
+                ErrorCode error = I2C_Peripheral_ReadRegisterMulti(sensors[s].address,
+                                                                   LIS3DH_STATUS_REG,
+                                                                   burst_length,
+                                                                   &burst[0]);
+                if (error != NO_ERROR)
+                {
+                    // The other devices are still read: their status and overruns stay up to date
+                    result = error;
+                    continue;
+                }
+                if (burst[0] & LIS3DH_STATUS_ZYXOR)
+                {
+                    loss_stats.sensor_overruns++;
+                }
+                if (Acquisition_IsDataReady(burst[0]))
+                {
+                    sample_polled = 1;
+                }
+                if (Acquisition_IsDataReady(burst[0]) && split_read)
+                {
+                    // Z alone, read once the status tells a new sample
+                    error = I2C_Peripheral_ReadRegisterMulti(sensors[s].address,
+                                                             LIS3DH_OUT_Z_L,
+                                                             ACQUISITION_AXIS_READ_LENGTH(axis_mask),
+                                                             &sensors[s].sample[2*LIS3DH_AXIS_BYTES]);
+                    if (error != NO_ERROR)
+                    {
+                        result = error;
+                        continue;
+                    }
+                    sensors[s].pending = 1;
+                }
+                else if (Acquisition_IsDataReady(burst[0]))
+                {
+                    for (uint8_t i = 0; i < burst_length - 1; i++)
+                    {
+                        sensors[s].sample[i] = burst[i+1];
+                    }
+                    sensors[s].pending = 1;
+                }
+            }
+            complete &= sensors[s].pending;
+        }
+
+        if (result != NO_ERROR)
+        {
+            // A device that no longer answers must not hold the samples of the others
+            if (++failed_polls >= ACQUISITION_MAX_FAILED_POLLS)
+            {
+                for (uint8_t s = 0; s < sensor_count; s++)
+                {
+                    sensors[s].pending = 0;
+                }
+                loss_stats.read_errors++;
+                failed_polls = 0;
+            }
+            return result;
+        }
+        failed_polls = 0;
+
+        if (complete && (++decimation_count < decimation))
+        {
+            // Sample set not sent
+            for (uint8_t s = 0; s < sensor_count; s++)
+            {
+                sensors[s].pending = 0;
+            }
+            aux_count++;
+        }
+        else if (complete)
+        {
+            uint8_t index = 1;
+
+            decimation_count = 0;
+
+            if (sensor_count > 1)
+            {
+                /*common timestamp of the devices, little endian like the axes*/
+                frame[index++] = (uint8_t)(timestamp_us & 0xFF);
+                frame[index++] = (uint8_t)((timestamp_us >> 8) & 0xFF);
+                frame[index++] = (uint8_t)((timestamp_us >> 16) & 0xFF);
+                frame[index++] = (uint8_t)(timestamp_us >> 24);
+            }
+            for (uint8_t s = 0; s < sensor_count; s++)
+            {
+                index = Acquisition_PackSample(sensors[s].sample, frame, index);
+                sensors[s].pending = 0;
+            }
+            aux_count++;
+            *frame_ready = 1;
+        }
+        return NO_ERROR;
+    }
+
+    void Acquisition_SetDecimation(uint8_t samples_per_frame)
+    {
+        decimation = samples_per_frame ? samples_per_frame : 1;
+        decimation_count = 0;
+    }
+
+    void Acquisition_StartAux(uint8_t divider, uint8_t* frame)
+    {
+        aux_divider = divider;
+        aux_count = 0;
+
+        frame[0] = ACQUISITION_AUX_HEADER;
+        frame[ACQUISITION_AUX_FRAME_LENGTH-1] = ACQUISITION_FOOTER;
+    }
+
+    uint8_t Acquisition_IsAuxDue(void)
+    {
+        return (aux_divider != 0) && (aux_count >= aux_divider);
+    }
+
+    void Acquisition_CountAuxSample(void)
+    {
+        aux_count++;
+    }
+
+    uint8_t Acquisition_IsSamplePolled(void)
+    {
+        return sample_polled;
+    }
+
+    void Acquisition_SetSamplePolled(uint8_t polled)
+    {
+        sample_polled = polled;
+    }
+
+    ErrorCode Acquisition_ReadAuxFrame(uint8_t* frame)
+    {
+        uint8_t adc[LIS3DH_ADC_COUNT*2];
+        Packet_AUX aux;
+
+        ErrorCode error = I2C_Peripheral_ReadRegisterMulti(sensors[0].address,
+                                                           LIS3DH_OUT_ADC1_L,
+                                                           LIS3DH_ADC_COUNT*2,
+                                                           &adc[0]);
+        if (error == NO_ERROR)
+        {
+            /*10-bit left-justified outputs*/
+            aux.adc1 = (int16)((adc[0] | (adc[1]<<8)))>>6;
+            aux.adc2 = (int16)((adc[2] | (adc[3]<<8)))>>6;
+            aux.temp = (int16)((adc[4] | (adc[5]<<8)))>>6;
+            Packet_Encode_AUX(frame, &aux);
+
+            /*ADC3 carries the temperature: update the offset model*/
+            TempCompensation_SetTemperature(aux.temp);
+            aux_count = 0;
+        }
+        return error;
+    }
+
+    void Acquisition_CountTickMerges(uint32 merges)
+    {
+        loss_stats.tick_merges += merges;
+    }
+
+    void Acquisition_CountUartDrop(void)
+    {
+        loss_stats.uart_drops++;
+    }
+
+    void Acquisition_CountSensorOverrun(void)
+    {
+        loss_stats.sensor_overruns++;
+    }
+
+    void Acquisition_CountReadError(void)
+    {
+        loss_stats.read_errors++;
+    }
+
+    uint8_t Acquisition_IsLossPending(void)
+    {
+        return (loss_stats.sensor_overruns != loss_marked.sensor_overruns) ||
+               (loss_stats.tick_merges != loss_marked.tick_merges) ||
+               (loss_stats.uart_drops != loss_marked.uart_drops) ||
+               (loss_stats.read_errors != loss_marked.read_errors);
+    }
+
+    /**
+    *   \brief Count since the last marker, saturated to a byte.
+    */
+    static uint8_t Acquisition_LossDelta(uint32 count, uint32 marked)
+    {
+        uint32 delta = count - marked;
+        return (delta > 0xFF) ? 0xFF : (uint8_t)delta;
+    }
+
+    void Acquisition_ReadLossFrame(uint8_t* frame)
+    {
+        Packet_LOSS loss;
+
+        loss.overruns = Acquisition_LossDelta(loss_stats.sensor_overruns, loss_marked.sensor_overruns);
+        loss.merges = Acquisition_LossDelta(loss_stats.tick_merges, loss_marked.tick_merges);
+        loss.drops = Acquisition_LossDelta(loss_stats.uart_drops, loss_marked.uart_drops);
+        loss.errors = Acquisition_LossDelta(loss_stats.read_errors, loss_marked.read_errors);
+        Packet_Encode_LOSS(frame, &loss);
+        loss_marked = loss_stats;
+    }
+
+    void Acquisition_GetLossStats(Acquisition_LossStats* stats)
+    {
+        *stats = loss_stats;
+    }
+
+    uint8_t Acquisition_GetBurstLength(void)
+    {
+        return burst_length + (split_read ? ACQUISITION_AXIS_READ_LENGTH(axis_mask) : 0);
+    }
+
+    uint8_t Acquisition_GetFrameLength(void)
+    {
+        return frame_length;
+    }
+
+/* [] END OF FILE */
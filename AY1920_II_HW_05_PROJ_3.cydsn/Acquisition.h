@@ -0,0 +1,310 @@
+/**
+*   \file Acquisition.h
+*   \brief Acquisition of the accelerometer outputs.
+*
+*   This module reads the output registers of the LIS3DH and packs them
+*   into the frame sent over UART. Only the axes enabled in CTRL_REG1
+*   are read and sent, so that burst length and frame length follow
+*   the axis enable mask.
+*
+*   Up to ACQUISITION_MAX_SENSORS devices, configured alike, are read
+*   back-to-back at each poll, each with a single burst from the status
+*   register to the last enabled axis (with Z alone, the status and then
+*   Z, see ACQUISITION_SPLIT_READ). Once every device has a new sample
+*   the samples are merged into one frame: with a single device the frame
+*   is the 0xA0 frame plotted by Bridge Control Panel, with more devices
+*   it is a 0xA2 frame carrying a common timestamp.
+*
+*   Samples lost on the way are counted by cause: overwritten in the
+*   device (ZYXOR), polls merged by the scheduler, frames dropped because
+*   the UART buffer was full, sample sets dropped because a device could
+*   not be read. The losses since the previous marker are
+*   sent in a 0xA3 frame queued right before the next data frame, so that
+*   the host knows where each gap is.
+*/
+
+#ifndef __ACQUISITION_H
+    #define __ACQUISITION_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+    #include "LIS3DH_Registers.h"
+    #include "PacketSchema.h"
+
+    /**
+    *   \brief Frame header and footer bytes.
+    */
+    #define ACQUISITION_HEADER PACKET_ACC_HEADER
+    #define ACQUISITION_FOOTER PACKET_ACC_FOOTER
+
+    /**
+    *   \brief Header of the multi-sensor frames.
+    *
+    *   The header is followed by the timestamp of the poll that completed
+    *   the frame (uint32, us) and by the axes of each device in order.
+    */
+    #define ACQUISITION_MULTI_HEADER 0xA2
+
+    /**
+    *   \brief Maximum number of devices: the LIS3DH has two I2C addresses.
+    */
+    #define ACQUISITION_MAX_SENSORS 2
+
+    /**
+    *   \brief Header of the loss markers.
+    *
+    *   The header is followed by the sensor overruns, tick merges and UART
+    *   drops since the previous marker (uint8 each, saturated at 255),
+    *   as laid out by the LOSS packet of PacketSchema.h.
+    */
+    #define ACQUISITION_LOSS_HEADER PACKET_LOSS_HEADER
+
+    /**
+    *   \brief Length of a loss marker.
+    */
+    #define ACQUISITION_LOSS_FRAME_LENGTH PACKET_LOSS_LENGTH
+
+    /**
+    *   \brief Header of the auxiliary ADC frames.
+    *
+    *   Auxiliary frames share the footer of the accelerometer frames and
+    *   carry ADC1, ADC2 and ADC3 (temperature) as int16 values, as laid
+    *   out by the AUX packet of PacketSchema.h.
+    */
+    #define ACQUISITION_AUX_HEADER PACKET_AUX_HEADER
+
+    /**
+    *   \brief Length of an auxiliary ADC frame.
+    */
+    #define ACQUISITION_AUX_FRAME_LENGTH PACKET_AUX_LENGTH
+
+    /**
+    *   \brief Number of bytes used for each axis in the frame (int32).
+    */
+    #define ACQUISITION_BYTES_PER_AXIS 4
+
+    /**
+    *   \brief Number of bytes of the timestamp of the multi-sensor frames.
+    */
+    #define ACQUISITION_TIMESTAMP_BYTES 4
+
+    /**
+    *   \brief Maximum length of a frame (all the devices and axes enabled).
+    */
+    #define ACQUISITION_MAX_FRAME_LENGTH (2 + ACQUISITION_TIMESTAMP_BYTES + \
+                                          ACQUISITION_MAX_SENSORS*LIS3DH_AXIS_COUNT*ACQUISITION_BYTES_PER_AXIS)
+
+    /**
+    *   \brief Highest axis enabled in a CTRL_REG1 axis mask (0 = X).
+    */
+    #define ACQUISITION_LAST_AXIS(mask) (((mask) & LIS3DH_CTRL_REG1_ZEN) ? 2 : (((mask) & LIS3DH_CTRL_REG1_YEN) ? 1 : 0))
+
+    /**
+    *   \brief Bytes of a single burst from STATUS_REG to the last enabled axis.
+    */
+    #define ACQUISITION_BURST_LENGTH(mask) (1 + (ACQUISITION_LAST_AXIS(mask) + 1)*LIS3DH_AXIS_BYTES)
+
+    /**
+    *   \brief Read the status alone, then the axes once it tells a new sample.
+    *
+    *   STATUS_REG and the output registers are contiguous, so a sample is
+    *   read with one burst from STATUS_REG through the last enabled axis.
+    *   With Z alone that burst would carry X and Y for nothing: the status
+    *   is read alone, and Z with a second burst, which is shorter on I2C and
+    *   SPI even on the polls that find a sample. With Y, Y+Z or X+Z the
+    *   second I2C transaction (address, register, repeated start: 3 bytes)
+    *   costs more than the registers it skips, so the single burst stays.
+    */
+    #define ACQUISITION_SPLIT_READ(mask) (((mask) & LIS3DH_CTRL_REG1_AXIS_MASK) == LIS3DH_CTRL_REG1_ZEN)
+
+    /**
+    *   \brief Bytes of the status read done at each poll, and of the axis read done once a sample is ready.
+    */
+    #define ACQUISITION_STATUS_READ_LENGTH(mask) \
+        (ACQUISITION_SPLIT_READ(mask) ? 1 : ACQUISITION_BURST_LENGTH(mask))
+    #define ACQUISITION_AXIS_READ_LENGTH(mask) (ACQUISITION_SPLIT_READ(mask) ? LIS3DH_AXIS_BYTES : 0)
+
+    /**
+    *   \brief Polls in a row with a failed device read after which the pending sample set is dropped.
+    *
+    *   A transient failure (NACK, arbitration loss) costs nothing: the
+    *   samples of the other devices wait for the next poll. A device that
+    *   keeps failing no longer holds them: 3 polls is one sample period at
+    *   100 Hz ODR with the 300 Hz tick.
+    */
+    #define ACQUISITION_MAX_FAILED_POLLS 3
+
+    /**
+    *   \brief Counters of the lost samples, since start.
+    */
+    typedef struct {
+        uint32 sensor_overruns;     ///< Reads with ZYXOR set: at least one sample overwritten in the device
+        uint32 tick_merges;         ///< Acquisition releases merged with a pending one
+        uint32 uart_drops;          ///< Frames dropped with the UART buffer full
+        uint32 read_errors;         ///< Sample sets dropped after ACQUISITION_MAX_FAILED_POLLS failed polls
+    } Acquisition_LossStats;
+
+    /**
+    *   \brief Set the devices, the enabled axes and the output scale.
+    *
+    *   This function computes the burst to be read and the frame layout
+    *   for the given devices and axis mask, and the sensitivity and
+    *   resolution of the full scale and mode applied to the devices. The
+    *   frame header and footer are written into the frame buffer.
+    *   \param addresses 7-bit I2C addresses of the devices.
+    *   \param sensor_count Number of devices, up to ACQUISITION_MAX_SENSORS.
+    *   \param ctrl_reg1 CTRL_REG1 applied to the devices: enabled axes (bits 2:0) and LPen.
+    *   \param ctrl_reg4 CTRL_REG4 applied to the devices: FS[1:0] and HR.
+    *   \param frame Buffer of at least ACQUISITION_MAX_FRAME_LENGTH bytes.
+    */
+    void Acquisition_Start(const uint8_t* addresses, uint8_t sensor_count, uint8_t ctrl_reg1, uint8_t ctrl_reg4,
+                           uint8_t* frame);
+
+    /**
+    *   \brief Set the per-axis gains.
+    *
+    *   \param gain Gains of X, Y and Z (Q12, 4096 = 1.0).
+    */
+    void Acquisition_SetGain(const int16_t* gain);
+
+    /**
+    *   \brief Check whether a new sample is available.
+    *
+    *   \param status_register Value of the LIS3DH status register.
+    *   \retval Returns true (>0) if new data is available on the enabled axes.
+    */
+    uint8_t Acquisition_IsDataReady(uint8_t status_register);
+
+    /**
+    *   \brief Read the devices and pack their samples into the frame.
+    *
+    *   Each device without a pending sample is read with a single burst
+    *   covering the status register and the enabled axes, or with a status
+    *   read and an axis read (ACQUISITION_SPLIT_READ). When every device
+    *   has a new sample, their values, in m/s^2 multiplied by 10000, are
+    *   written into the frame. Reads with the ZYXOR bit set are counted as
+    *   sensor overruns. A device that fails does not stop the others from
+    *   being read; after ACQUISITION_MAX_FAILED_POLLS failed polls in a row
+    *   the sample set is dropped and counted as a read error, so that a
+    *   device that no longer answers does not hold the samples of the
+    *   others.
+    *   \param frame Buffer previously initialized with Acquisition_Start.
+    *   \param frame_ready Set to 1 if the frame is complete and can be sent.
+    *   \retval Returns the error of the last device that failed.
+    */
+    ErrorCode Acquisition_Poll(uint8_t* frame, uint8_t* frame_ready);
+
+    /**
+    *   \brief Send one frame every given number of sample sets.
+    *
+    *   The devices are still read at each sample, the sample sets in
+    *   between are not converted nor sent (see LinkBudget_Admit).
+    *   \param samples_per_frame Sample sets per frame (0 and 1 send every sample set).
+    */
+    void Acquisition_SetDecimation(uint8_t samples_per_frame);
+
+    /**
+    *   \brief Set the sub-rate of the auxiliary ADC channels.
+    *
+    *   The auxiliary channels are read once every divider accelerometer
+    *   samples. The frame header and footer are written into the frame buffer.
+    *   \param divider Number of accelerometer samples between two auxiliary reads (0 disables them).
+    *   \param frame Buffer of at least ACQUISITION_AUX_FRAME_LENGTH bytes.
+    */
+    void Acquisition_StartAux(uint8_t divider, uint8_t* frame);
+
+    /**
+    *   \brief Check whether the auxiliary channels have to be read.
+    *
+    *   \retval Returns true (>0) if an auxiliary read is due.
+    */
+    uint8_t Acquisition_IsAuxDue(void);
+
+    /**
+    *   \brief Count a sample set acquired outside Acquisition_Poll towards the auxiliary sub-rate.
+    */
+    void Acquisition_CountAuxSample(void);
+
+    /**
+    *   \brief Check whether the last poll read a new sample.
+    *
+    *   A poll that finds no new sample only reads the status of each
+    *   device: its tick has room for the auxiliary read.
+    *   \retval Returns true (>0) if a device had a new sample.
+    */
+    uint8_t Acquisition_IsSamplePolled(void);
+
+    /**
+    *   \brief Record whether a poll done outside Acquisition_Poll read a new sample.
+    *
+    *   \param polled 1 if a device had a new sample.
+    */
+    void Acquisition_SetSamplePolled(uint8_t polled);
+
+    /**
+    *   \brief Read the auxiliary ADC channels and pack them into the frame.
+    *
+    *   This function reads ADC1..ADC3 of the first device with a single burst.
+    *   It should be called after a poll that read no sample
+    *   (Acquisition_IsSamplePolled), so that it does not lengthen the ticks
+    *   that read, convert and send a sample.
+    *   \param frame Buffer previously initialized with Acquisition_StartAux.
+    */
+    ErrorCode Acquisition_ReadAuxFrame(uint8_t* frame);
+
+    /**
+    *   \brief Count acquisition polls merged by the scheduler.
+    *
+    *   \param merges Releases of the acquisition merged since the last call.
+    */
+    void Acquisition_CountTickMerges(uint32 merges);
+
+    /**
+    *   \brief Count a frame dropped because the UART buffer was full.
+    */
+    void Acquisition_CountUartDrop(void);
+
+    /**
+    *   \brief Count a read with the ZYXOR bit set, for the reads done outside Acquisition_Poll.
+    */
+    void Acquisition_CountSensorOverrun(void);
+
+    /**
+    *   \brief Count a sample set dropped on failed device reads, for the reads done outside Acquisition_Poll.
+    */
+    void Acquisition_CountReadError(void);
+
+    /**
+    *   \brief Check whether samples were lost since the last marker.
+    *
+    *   \retval Returns true (>0) if a loss marker has to be sent.
+    */
+    uint8_t Acquisition_IsLossPending(void);
+
+    /**
+    *   \brief Pack the losses since the last marker into a loss marker.
+    *
+    *   The losses are cleared: the marker has to be sent.
+    *   \param frame Buffer of at least ACQUISITION_LOSS_FRAME_LENGTH bytes.
+    */
+    void Acquisition_ReadLossFrame(uint8_t* frame);
+
+    /**
+    *   \brief Get the counters of the lost samples.
+    *
+    *   \param stats Pointer to a structure where the counters will be saved.
+    */
+    void Acquisition_GetLossStats(Acquisition_LossStats* stats);
+
+    /**
+    *   \brief Number of bytes read over I2C for each sample of each device, status included.
+    */
+    uint8_t Acquisition_GetBurstLength(void);
+
+    /**
+    *   \brief Number of bytes of each frame sent over UART.
+    */
+    uint8_t Acquisition_GetFrameLength(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,178 @@
+/*
+* This file includes the source code of the throughput benchmark
+* of the accelerometer bus.
+*/
+
+#include "Benchmark.h"
+#include "I2C_Interface.h"
+#include "SPI_Interface.h"
+#include "LIS3DH_Registers.h"
+#include "Acquisition.h"
+#include "CycleCounter.h"
+#include "Log.h"
+#include "project.h"
+
+/**
+*   \brief Bus rates of the benchmark (Hz).
+*/
+static const uint32 benchmark_rates[] = {
+    I2C_PERIPHERAL_STANDARD_MODE_HZ,
+    I2C_PERIPHERAL_FAST_MODE_HZ,
+};
+
+/**
+*   \brief Burst reads of the benchmark.
+*
+*   The lockstep burst is the read of one device at each sample: status
+*   and the three axes (Acquisition_Poll). The FIFO burst drains the FIFO,
+*   enabled in stream mode for the burst only: with the FIFO enabled the
+*   address wraps from OUT_Z_H back to OUT_X_L, instead of running into
+*   FIFO_CTRL_REG and the interrupt source registers.
+*/
+static const struct {
+    uint8_t address;
+    uint8_t count;
+    uint8_t lockstep;
+    uint8_t fifo;
+} benchmark_bursts[] = {
+    {LIS3DH_STATUS_REG, 1, 0, 0},
+    {LIS3DH_OUT_X_L, LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES, 0, 0},
+    {LIS3DH_STATUS_REG, 1 + LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES, 1, 0},
+    {LIS3DH_OUT_X_L, LIS3DH_FIFO_DEPTH*LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES, 0, 1},
+};
+
+/**
+*   \brief Output data rates at which the devices fitting in a sample period are reported (Hz).
+*/
+static const uint16 benchmark_odrs[] = {100, 400, 1344};
+
+    /**
+    *   \brief Print out how many devices can be read back-to-back in a sample period.
+    *
+    *   \param elapsed_us Time taken by BENCHMARK_TRANSACTIONS lockstep bursts.
+    */
+    static void Benchmark_ReportLockstep(uint32 elapsed_us)
+    {
+        for (uint8_t o = 0; o < sizeof(benchmark_odrs)/sizeof(benchmark_odrs[0]); o++)
+        {
+            uint32 period_us = 1000000u/benchmark_odrs[o];
+
+            Log_PutString("  ");
+            Log_PutDecWidth(benchmark_odrs[o], 4);
+            Log_PutString(" Hz ODR: ");
+            Log_PutDec((uint32)((uint64_t)period_us*BENCHMARK_TRANSACTIONS/elapsed_us));
+            Log_PutString(" devices per sample period (");
+            Log_PutDec(ACQUISITION_MAX_SENSORS);
+            Log_PutString(" addressable)\r\n");
+        }
+    }
+
+    /**
+    *   \brief Restore the FIFO registers saved before the FIFO burst.
+    *
+    *   FIFO_CTRL_REG goes first: back to bypass mode, which also empties the FIFO.
+    */
+    static void Benchmark_RestoreFifo(uint8_t ctrl_reg5, uint8_t fifo_ctrl_reg)
+    {
+        I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_FIFO_CTRL_REG, fifo_ctrl_reg);
+        I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_CTRL_REG5, ctrl_reg5);
+    }
+
+    /**
+    *   \brief Time the bursts at the current bus rate and print out the throughput.
+    */
+    static void Benchmark_RunBursts(void)
+    {
+        static uint8_t data[LIS3DH_FIFO_DEPTH*LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES];
+
+        for (uint8_t b = 0; b < sizeof(benchmark_bursts)/sizeof(benchmark_bursts[0]); b++)
+        {
+            uint8_t ctrl_reg5 = 0;
+            uint8_t fifo_ctrl_reg = 0;
+            uint16 errors = 0;
+
+            if (benchmark_bursts[b].fifo)
+            {
+                // Stream mode keeps the FIFO full at any ODR; the registers are restored after the burst
+                if ((I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_CTRL_REG5, &ctrl_reg5) != NO_ERROR) ||
+                    (I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_FIFO_CTRL_REG, &fifo_ctrl_reg) != NO_ERROR))
+                {
+                    Log_PutString("FIFO registers not read, burst skipped\r\n");
+                    continue;
+                }
+                if ((I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_CTRL_REG5,
+                                                  ctrl_reg5 | LIS3DH_CTRL_REG5_FIFO_EN) != NO_ERROR) ||
+                    (I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS, LIS3DH_FIFO_CTRL_REG,
+                                                  LIS3DH_FIFO_CTRL_REG_STREAM) != NO_ERROR))
+                {
+                    Benchmark_RestoreFifo(ctrl_reg5, fifo_ctrl_reg);
+                    Log_PutString("FIFO not enabled, burst skipped\r\n");
+                    continue;
+                }
+            }
+
+            uint32 start = CycleCounter_Read();
+
+            for (uint16 n = 0; n < BENCHMARK_TRANSACTIONS; n++)
+            {
+                if (I2C_Peripheral_ReadRegisterMulti(LIS3DH_DEVICE_ADDRESS, benchmark_bursts[b].address,
+                                                     benchmark_bursts[b].count, data) != NO_ERROR)
+                {
+                    errors++;
+                }
+            }
+
+            uint32 elapsed_us = CycleCounter_ToUs(CycleCounter_Read() - start);
+            if (elapsed_us == 0)
+            {
+                elapsed_us = 1;
+            }
+
+            if (benchmark_bursts[b].fifo)
+            {
+                Benchmark_RestoreFifo(ctrl_reg5, fifo_ctrl_reg);
+            }
+
+            Log_PutDecWidth(benchmark_bursts[b].count, 3);
+            Log_PutString(benchmark_bursts[b].fifo ? "-byte FIFO burst: " : "-byte burst: ");
+            Log_PutDec((uint32)((uint64_t)benchmark_bursts[b].count*BENCHMARK_TRANSACTIONS*1000000u/elapsed_us));
+            Log_PutString(" bytes/s, ");
+            Log_PutDec((uint32)((uint64_t)BENCHMARK_TRANSACTIONS*1000000u/elapsed_us));
+            Log_PutString(" transactions/s, ");
+            Log_PutDec(errors);
+            Log_PutString(" errors\r\n");
+
+            if (benchmark_bursts[b].lockstep)
+            {
+                Benchmark_ReportLockstep(elapsed_us);
+            }
+        }
+    }
+
+    void Benchmark_Run(void)
+    {
+        uint32 bus_hz = I2C_Peripheral_GetBusRate();
+
+        // The SPI bit rate is fixed by the SPIM component: a single run, no rate sweep
+        if (I2C_Peripheral_GetTransport() == I2C_PERIPHERAL_TRANSPORT_SPI)
+        {
+            Log_PutString("SPI bus at ");
+            Log_PutDec(SPI_PERIPHERAL_BIT_RATE_HZ);
+            Log_PutString(" Hz\r\n");
+            Benchmark_RunBursts();
+            return;
+        }
+
+        for (uint8_t r = 0; r < sizeof(benchmark_rates)/sizeof(benchmark_rates[0]); r++)
+        {
+            I2C_Peripheral_SetBusRate(benchmark_rates[r]);
+            Log_PutString("I2C bus at ");
+            Log_PutDec(I2C_Peripheral_GetBusRate());
+            Log_PutString(" Hz\r\n");
+            Benchmark_RunBursts();
+        }
+
+        I2C_Peripheral_SetBusRate(bus_hz);
+    }
+
+/* [] END OF FILE */
@@ -0,0 +1,41 @@
+/**
+*   \file Benchmark.h
+*   \brief Throughput benchmark of the accelerometer bus.
+*
+*   The benchmark runs on request, when BENCHMARK_COMMAND is received
+*   over UART: burst reads of the LIS3DH are timed with the cycle counter
+*   at each of the bus rates in benchmark_rates[] (Benchmark.c), the
+*   standard and fast mode rates. Over SPI the bit rate is fixed, and the
+*   bursts are timed once at SPI_PERIPHERAL_BIT_RATE_HZ.
+*/
+
+#ifndef __BENCHMARK_H
+    #define __BENCHMARK_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Character received over UART that starts the benchmark.
+    */
+    #define BENCHMARK_COMMAND 'b'
+
+    /**
+    *   \brief Transactions timed for each burst length.
+    */
+    #define BENCHMARK_TRANSACTIONS 50
+
+    /**
+    *   \brief Print out the throughput of the bus.
+    *
+    *   This function reports bytes/s and transactions/s of single-register,
+    *   6-byte (one sample of the three axes), 7-byte (status and sample, as
+    *   read from each device in lockstep) and 192-byte (full FIFO, enabled
+    *   in stream mode for that burst only) burst reads, then restores the
+    *   bus rate in use. For the 7-byte burst it
+    *   also reports how many devices fit in a sample period at 100, 400
+    *   and 1344 Hz ODR; the LIS3DH has two I2C addresses (SA0 pin).
+    */
+    void Benchmark_Run(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,151 @@
+/*
+* This file includes the source code to keep the configuration and
+* calibration record in emulated EEPROM.
+*/
+
+#include "ConfigStore.h"
+#include "I2C_Interface.h"
+#include "cy_em_eeprom.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+*   \brief Wear-levelling factor and redundant copy of the emulated EEPROM.
+*/
+#define CONFIG_STORE_WEAR_LEVELING 4u
+#define CONFIG_STORE_REDUNDANT_COPY 1u
+
+/**
+*   \brief Flash storage of the emulated EEPROM (aligned to a flash row).
+*/
+static const uint8_t eeprom_storage[CY_EM_EEPROM_GET_PHYSICAL_SIZE(sizeof(ConfigStore_Record),
+                                                                   CONFIG_STORE_WEAR_LEVELING,
+                                                                   CONFIG_STORE_REDUNDANT_COPY)]
+    CY_ALIGN(CY_EM_EEPROM_FLASH_SIZEOF_ROW) = {0u};
+
+static cy_stc_eeprom_config_t eeprom_config =
+{
+    .eepromSize = sizeof(ConfigStore_Record),
+    .wearLevelingFactor = CONFIG_STORE_WEAR_LEVELING,
+    .redundantCopy = CONFIG_STORE_REDUNDANT_COPY,
+    .blockingWrite = 1u,
+};
+
+/**
+*   \brief Bits compared when verifying the registers written.
+*
+*   The BOOT bit of CTRL_REG5 clears itself at the end of the reboot.
+*/
+static const uint8_t config_store_verify_mask[CONFIG_STORE_REG_COUNT] =
+{
+    [CONFIG_STORE_REG(LIS3DH_TEMP_CFG_REG)] = 0xFF,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG1)] = 0xFF,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG2)] = 0xFF,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG3)] = 0xFF,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG4)] = 0xFF,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG5)] = (uint8_t)~LIS3DH_CTRL_REG5_BOOT,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG6)] = 0xFF,
+};
+
+static cy_stc_eeprom_context_t eeprom_context;
+static uint8_t eeprom_started;
+
+/**
+*   \brief CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+*/
+static uint16_t ConfigStore_Crc(const uint8_t* data, uint16_t length)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (length--)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static ErrorCode ConfigStore_Start(void)
+{
+    if (!eeprom_started)
+    {
+        eeprom_config.userFlashStartAddr = (uint32)(uintptr_t)eeprom_storage;
+        if (Cy_Em_EEPROM_Init(&eeprom_config, &eeprom_context) != CY_EM_EEPROM_SUCCESS)
+        {
+            return ERROR;
+        }
+        eeprom_started = 1;
+    }
+    return NO_ERROR;
+}
+
+    ErrorCode ConfigStore_Load(ConfigStore_Record* record)
+    {
+        if ((ConfigStore_Start() != NO_ERROR) ||
+            (Cy_Em_EEPROM_Read(0u, record, sizeof(ConfigStore_Record), &eeprom_context) != CY_EM_EEPROM_SUCCESS))
+        {
+            return ERROR;
+        }
+
+        // Blank, outdated or corrupted records are discarded
+        if ((record->version != CONFIG_STORE_VERSION) ||
+            (record->length != sizeof(ConfigStore_Record)) ||
+            (record->crc != ConfigStore_Crc((const uint8_t*)record, offsetof(ConfigStore_Record, crc))))
+        {
+            return ERROR;
+        }
+        return NO_ERROR;
+    }
+
+    ErrorCode ConfigStore_Save(ConfigStore_Record* record)
+    {
+        record->version = CONFIG_STORE_VERSION;
+        record->length = sizeof(ConfigStore_Record);
+        record->crc = ConfigStore_Crc((const uint8_t*)record, offsetof(ConfigStore_Record, crc));
+
+        if ((ConfigStore_Start() != NO_ERROR) ||
+            (Cy_Em_EEPROM_Write(0u, record, sizeof(ConfigStore_Record), &eeprom_context) != CY_EM_EEPROM_SUCCESS))
+        {
+            return ERROR;
+        }
+        return NO_ERROR;
+    }
+
+    ErrorCode ConfigStore_Apply(const ConfigStore_Record* record, RegisterShadow* shadow)
+    {
+        uint8_t readback[CONFIG_STORE_REG_COUNT];
+
+        for (uint8_t i = 0; i < CONFIG_STORE_REG_COUNT; i++)
+        {
+            RegisterShadow_Set(shadow, CONFIG_STORE_FIRST_REG + i, record->reg[i]);
+        }
+
+        ErrorCode error = RegisterShadow_Flush(shadow);
+        if (error == NO_ERROR)
+        {
+            error = I2C_Peripheral_ReadRegisterMulti(shadow->device_address,
+                                                     CONFIG_STORE_FIRST_REG,
+                                                     CONFIG_STORE_REG_COUNT,
+                                                     readback);
+        }
+        if (error != NO_ERROR)
+        {
+            return error;
+        }
+
+        // The shadow follows the device, also when the verify fails
+        RegisterShadow_Update(shadow, CONFIG_STORE_FIRST_REG, CONFIG_STORE_REG_COUNT, readback);
+        for (uint8_t i = 0; i < CONFIG_STORE_REG_COUNT; i++)
+        {
+            if ((readback[i] ^ record->reg[i]) & config_store_verify_mask[i])
+            {
+                return ERROR;
+            }
+        }
+        return NO_ERROR;
+    }
+
+/* [] END OF FILE */
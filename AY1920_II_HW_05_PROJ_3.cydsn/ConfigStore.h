@@ -0,0 +1,90 @@
+/**
+*   \file ConfigStore.h
+*   \brief Persistent configuration and calibration record.
+*
+*   The configuration of the LIS3DH (ODR, FSR, filters, auxiliary ADC)
+*   and the calibration of the accelerometer (per-axis gains and offset
+*   model) are kept in a single record in emulated EEPROM. The record is
+*   versioned and protected by a CRC; the emulated EEPROM is wear-levelled
+*   and keeps a redundant copy.
+*/
+
+#ifndef __CONFIG_STORE_H
+    #define __CONFIG_STORE_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+    #include "LIS3DH_Registers.h"
+    #include "TempCompensation.h"
+    #include "RegisterShadow.h"
+
+    /**
+    *   \brief Version of the record layout.
+    *
+    *   Must be increased whenever ConfigStore_Record changes, so that
+    *   records written by older firmware are discarded.
+    */
+    #define CONFIG_STORE_VERSION 1
+
+    /**
+    *   \brief Registers written at boot with a single burst.
+    *
+    *   TEMP_CFG_REG and CTRL_REG1..CTRL_REG6 are contiguous (0x1F..0x25).
+    */
+    #define CONFIG_STORE_FIRST_REG LIS3DH_TEMP_CFG_REG
+    #define CONFIG_STORE_REG_COUNT (LIS3DH_CTRL_REG6 - LIS3DH_TEMP_CFG_REG + 1)
+
+    /**
+    *   \brief Index of a register in ConfigStore_Record.reg.
+    */
+    #define CONFIG_STORE_REG(address) ((address) - CONFIG_STORE_FIRST_REG)
+
+    /**
+    *   \brief Unity gain (Q12).
+    */
+    #define CONFIG_STORE_GAIN_ONE 4096
+
+    /**
+    *   \brief Configuration and calibration record.
+    */
+    typedef struct {
+        uint16_t version;                           ///< CONFIG_STORE_VERSION
+        uint16_t length;                            ///< sizeof(ConfigStore_Record)
+        uint8_t reg[CONFIG_STORE_REG_COUNT];        ///< TEMP_CFG_REG, CTRL_REG1..CTRL_REG6
+        uint8_t aux_divider;                        ///< Sub-rate of the auxiliary ADC frames
+        int16_t gain[LIS3DH_AXIS_COUNT];            ///< Per-axis gain (Q12)
+        TempCompensation_Coefficients compensation; ///< Per-axis offset model
+        uint16_t crc;                               ///< CRC-16/CCITT of the previous fields
+    } ConfigStore_Record;
+
+    /**
+    *   \brief Load the record from emulated EEPROM.
+    *
+    *   \param record Record to be filled.
+    *   \retval ERROR if no valid record is stored (blank, wrong version or bad CRC).
+    */
+    ErrorCode ConfigStore_Load(ConfigStore_Record* record);
+
+    /**
+    *   \brief Store the record into emulated EEPROM.
+    *
+    *   Version, length and CRC are filled in by this function.
+    *   \param record Record to be stored.
+    */
+    ErrorCode ConfigStore_Save(ConfigStore_Record* record);
+
+    /**
+    *   \brief Apply the record to the device.
+    *
+    *   TEMP_CFG_REG and CTRL_REG1..CTRL_REG6 are set in the register shadow
+    *   and flushed: the registers that differ from the shadow are written
+    *   with a single auto-increment burst, then all of them are verified
+    *   with a single burst read, which also refreshes the shadow.
+    *   \param record Record to be applied.
+    *   \param shadow Register shadow of the device.
+    *   \retval ERROR if a register reads back differently, or the I2C error.
+    */
+    ErrorCode ConfigStore_Apply(const ConfigStore_Record* record, RegisterShadow* shadow);
+
+#endif
+/* [] END OF FILE */
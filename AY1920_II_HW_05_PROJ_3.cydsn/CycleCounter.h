@@ -0,0 +1,54 @@
+/**
+*   \file CycleCounter.h
+*   \brief CPU cycle counter of the Cortex-M3 (DWT CYCCNT).
+*
+*   The counter runs at the CPU clock (BUS_CLK) and wraps around every
+*   2^32 cycles (about 178 s at 24 MHz); differences of two readings
+*   are correct across a single wrap-around.
+*/
+
+#ifndef __CYCLE_COUNTER_H
+    #define __CYCLE_COUNTER_H
+
+    #include "cytypes.h"
+    #include "cyfitter.h"
+
+    /**
+    *   \brief Debug and trace registers of the Cortex-M3.
+    */
+    #define CYCLE_COUNTER_DEMCR_REG     ((reg32 *) 0xE000EDFCu)
+    #define CYCLE_COUNTER_DWT_CTRL_REG  ((reg32 *) 0xE0001000u)
+    #define CYCLE_COUNTER_DWT_CYCCNT_REG ((reg32 *) 0xE0001004u)
+
+    #define CYCLE_COUNTER_DEMCR_TRCENA  0x01000000u
+    #define CYCLE_COUNTER_DWT_CYCCNTENA 0x00000001u
+
+    /**
+    *   \brief Number of cycles in a microsecond.
+    */
+    #define CYCLE_COUNTER_CYCLES_PER_US (BCLK__BUS_CLK__HZ / 1000000u)
+
+    /**
+    *   \brief Reset and start the cycle counter.
+    */
+    #define CycleCounter_Start()                                                        \
+        do {                                                                            \
+            CY_SET_REG32(CYCLE_COUNTER_DEMCR_REG,                                       \
+                         CY_GET_REG32(CYCLE_COUNTER_DEMCR_REG) | CYCLE_COUNTER_DEMCR_TRCENA); \
+            CY_SET_REG32(CYCLE_COUNTER_DWT_CYCCNT_REG, 0u);                             \
+            CY_SET_REG32(CYCLE_COUNTER_DWT_CTRL_REG,                                    \
+                         CY_GET_REG32(CYCLE_COUNTER_DWT_CTRL_REG) | CYCLE_COUNTER_DWT_CYCCNTENA); \
+        } while (0)
+
+    /**
+    *   \brief Current value of the cycle counter.
+    */
+    #define CycleCounter_Read() CY_GET_REG32(CYCLE_COUNTER_DWT_CYCCNT_REG)
+
+    /**
+    *   \brief Conversion from cycles to microseconds.
+    */
+    #define CycleCounter_ToUs(cycles) ((uint32)(cycles) / CYCLE_COUNTER_CYCLES_PER_US)
+
+#endif
+/* [] END OF FILE */
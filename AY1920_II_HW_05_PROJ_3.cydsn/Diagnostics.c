@@ -0,0 +1,84 @@
+/*
+* This file includes the source code of the verbose diagnostics
+* of the I2C bus and of the LIS3DH.
+*/
+
+#include "Diagnostics.h"
+#include "I2C_Interface.h"
+#include "LIS3DH_Registers.h"
+#include "Scheduler.h"
+#include "Acquisition.h"
+#include "LogEvent.h"
+#include "project.h"
+
+/**
+*   \brief Registers printed out by the diagnostics.
+*/
+static const uint8_t diagnostics_registers[] = {
+    LIS3DH_WHO_AM_I_REG_ADDR,
+    LIS3DH_STATUS_REG,
+    LIS3DH_TEMP_CFG_REG,
+    LIS3DH_CTRL_REG1,
+    LIS3DH_CTRL_REG2,
+    LIS3DH_CTRL_REG4,
+    LIS3DH_CTRL_REG5,
+};
+
+    void Diagnostics_Run(uint32 first_sample_us, const RegisterShadow* shadows, uint8_t device_count)
+    {
+        // Check which devices are present on the I2C bus
+        for (int i = 0 ; i < 128; i++)
+        {
+            if (I2C_Peripheral_IsDeviceConnected(i))
+            {
+                LOG_EVENT(LOG_DIAG_DEVICE_CONNECTED, i);
+            }
+        }
+
+        for (uint8_t device = 0; device < device_count; device++)
+        {
+            const RegisterShadow* shadow = &shadows[device];
+
+            LOG_EVENT(LOG_DIAG_LIS3DH, shadow->device_address);
+
+            for (uint8_t i = 0; i < sizeof(diagnostics_registers); i++)
+            {
+                uint8_t address = diagnostics_registers[i];
+                uint8_t value;
+                ErrorCode error = I2C_Peripheral_ReadRegister(shadow->device_address, address, &value);
+
+                if ((error == NO_ERROR) && RegisterShadow_IsValid(shadow, address))
+                {
+                    LOG_EVENT(LOG_DIAG_REGISTER_SHADOW, address, value,
+                              RegisterShadow_Get(shadow, address));
+                }
+                else if (error == NO_ERROR)
+                {
+                    LOG_EVENT(LOG_DIAG_REGISTER, address, value);
+                }
+                else
+                {
+                    LOG_EVENT(LOG_DIAG_REGISTER_ERROR, address);
+                }
+            }
+        }
+
+        LOG_EVENT(LOG_DIAG_FIRST_SAMPLE, first_sample_us);
+
+        Acquisition_LossStats loss;
+
+        Acquisition_GetLossStats(&loss);
+        LOG_EVENT(LOG_DIAG_LOSSES, loss.sensor_overruns, loss.tick_merges, loss.uart_drops,
+                  loss.read_errors);
+
+        for (uint8_t i = 0; i < Scheduler_GetTaskCount(); i++)
+        {
+            Scheduler_TaskStats stats;
+
+            Scheduler_GetStats(i, &stats);
+            LOG_EVENT(LOG_DIAG_TASK, i, stats.runs, stats.skipped, stats.overruns, stats.max_us,
+                      Scheduler_GetTask(i)->wcet_us);
+        }
+    }
+
+/* [] END OF FILE */
@@ -0,0 +1,37 @@
+/**
+*   \file Diagnostics.h
+*   \brief Verbose diagnostics of the I2C bus and of the LIS3DH.
+*
+*   The bus scan and the register dump are not part of the boot path:
+*   they run on request, when DIAGNOSTICS_COMMAND is received over UART,
+*   or at boot when BOOT_MODE_PRODUCTION is 0.
+*/
+
+#ifndef __DIAGNOSTICS_H
+    #define __DIAGNOSTICS_H
+
+    #include "cytypes.h"
+    #include "RegisterShadow.h"
+
+    /**
+    *   \brief Character received over UART that starts the diagnostics.
+    */
+    #define DIAGNOSTICS_COMMAND 'd'
+
+    /**
+    *   \brief Print out the diagnostics.
+    *
+    *   This function scans the I2C bus, prints out the identification,
+    *   status and configuration registers of each LIS3DH, next to their
+    *   shadow value when valid, the time from the top of main() to the
+    *   first sample, the counters of the lost samples and the statistics of the
+    *   scheduler tasks. The lines are log events (LogEvent.h): in binary
+    *   mode they are queued and sent between the accelerometer frames.
+    *   \param first_sample_us Time to first sample (us), 0 if not available yet.
+    *   \param shadows Register shadows of the devices.
+    *   \param device_count Number of devices.
+    */
+    void Diagnostics_Run(uint32 first_sample_us, const RegisterShadow* shadows, uint8_t device_count);
+
+#endif
+/* [] END OF FILE */
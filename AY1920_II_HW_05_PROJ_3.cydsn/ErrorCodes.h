@@ -19,8 +19,16 @@
     #define __ERRORCODES_H
     
     typedef enum {
-        NO_ERROR,           ///< No error generated
-        ERROR               ///< Error generated
+        NO_ERROR,               ///< No error generated
+        ERROR,                  ///< Error generated
+        ERROR_I2C_ADDR_NAK,     ///< I2C slave address not acknowledged
+        ERROR_I2C_DATA_NAK,     ///< I2C data byte not acknowledged (short transfer)
+        ERROR_I2C_ARB_LOST,     ///< I2C arbitration lost
+        ERROR_I2C_BUS_BUSY,     ///< I2C bus busy until the deadline
+        ERROR_I2C_NOT_READY,    ///< I2C block not ready to start a transfer
+        ERROR_I2C_TIMEOUT,      ///< I2C transfer not completed before the deadline
+        ERROR_SPI_TIMEOUT,      ///< SPI transfer not completed before the deadline
+        ERROR_CODE_COUNT        ///< Number of error codes
     } ErrorCode;
 
 #endif
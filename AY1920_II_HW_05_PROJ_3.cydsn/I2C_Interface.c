@@ -1,6 +1,13 @@
 /*
 * This file includes all the required source code to interface
 * the I2C peripheral.
+*
+* Every transaction runs on the interrupt-driven buffer API of the
+* I2C_Master component and polls its status against a deadline, so
+* that a stuck bus can not block the caller forever. The status of a
+* failed attempt is mapped to an ErrorCode, and the action table below
+* decides whether the attempt is retried (up to the policy set with
+* I2C_Peripheral_SetPolicy) and whether the bus is recovered first.
 */
 
 /**
@@ -17,19 +24,88 @@
     #define DEVICE_UNCONNECTED 0
 #endif
 
-#include "I2C_Interface.h" 
+/**
+*   \brief Actions taken after a failed attempt.
+*/
+#define ACTION_FAIL 0x00
+#define ACTION_RETRY 0x01
+#define ACTION_RECOVER 0x02
+
+/**
+*   \brief Oversampling of SCL in the fixed-function I2C block.
+*
+*   The block samples 16 times per bit in standard mode and 32 times in
+*   fast mode, selected by the CLK_RATE bit of its CFG register.
+*/
+#define I2C_PERIPHERAL_OVERSAMPLING_STANDARD 16
+#define I2C_PERIPHERAL_OVERSAMPLING_FAST 32
+
+/**
+*   \brief Half period of the SCL pulses generated by the bus recovery, in us.
+*/
+#define I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US 5
+
+#include "I2C_Interface.h"
+#include "SPI_Interface.h"
 #include "I2C_Master.h"
+#include "SCL_1.h"
+#include "SDA_1.h"
+#include "CyLib.h"
+#include "CycleCounter.h"
+#include "cyfitter.h"
+
+static I2C_Peripheral_Policy policy =
+{
+    I2C_PERIPHERAL_DEFAULT_TIMEOUT_US,
+    I2C_PERIPHERAL_DEFAULT_RETRIES,
+    I2C_PERIPHERAL_DEFAULT_RECOVER,
+};
+
+static I2C_Peripheral_Stats stats;
+
+static I2C_Peripheral_Transport transport = I2C_PERIPHERAL_TRANSPORT_I2C;
+
+static uint16 clock_divider = I2C_Master_DEFAULT_DIVIDE_FACTOR;
+
+/**
+*   \brief Fast mode (CFG CLK_RATE set), as left by I2C_Master_DEFAULT_CFG for the 100 kHz design.
+*/
+static uint8_t fast_mode = 0;
+
+/**
+*   \brief Duration of a byte (9 clock cycles) at the current bus rate, in us.
+*/
+static uint16 byte_us = 90;
+
+/**
+*   \brief Action taken for each error of an attempt.
+*
+*   A NACK means that the device is absent, booting or refusing the
+*   register: the caller is told at once instead of repeating the transfer.
+*   An arbitration loss is transient and retried on the spot. Only a bus
+*   that stays busy or a transfer that hits its deadline pay for a recovery.
+*/
+static const uint8_t error_action[ERROR_CODE_COUNT] =
+{
+    [NO_ERROR] = ACTION_FAIL,
+    [ERROR] = ACTION_RETRY,
+    [ERROR_I2C_ADDR_NAK] = ACTION_FAIL,
+    [ERROR_I2C_DATA_NAK] = ACTION_FAIL,
+    [ERROR_I2C_ARB_LOST] = ACTION_RETRY,
+    [ERROR_I2C_BUS_BUSY] = ACTION_RETRY | ACTION_RECOVER,
+    [ERROR_I2C_NOT_READY] = ACTION_RETRY | ACTION_RECOVER,
+    [ERROR_I2C_TIMEOUT] = ACTION_RETRY | ACTION_RECOVER,
+};
 
-    ErrorCode I2C_Peripheral_Start(void) 
+    ErrorCode I2C_Peripheral_Start(uint32 bus_hz)
     {
         // Start I2C peripheral
-        I2C_Master_Start();  
-        
-        // Return no error since start function does not return any error
-        return NO_ERROR;
+        I2C_Master_Start();
+
+        return I2C_Peripheral_SetBusRate(bus_hz);
     }
-    
-    
+
+
     ErrorCode I2C_Peripheral_Stop(void)
     {
         // Stop I2C peripheral
@@ -38,143 +114,384 @@
         return NO_ERROR;
     }
 
-    ErrorCode I2C_Peripheral_ReadRegister(uint8_t device_address, 
-                                            uint8_t register_address,
-                                            uint8_t* data)
+    ErrorCode I2C_Peripheral_SetTransport(I2C_Peripheral_Transport new_transport)
+    {
+        if ((new_transport == I2C_PERIPHERAL_TRANSPORT_SPI) && (SPI_Peripheral_Start() != NO_ERROR))
+        {
+            return ERROR;
+        }
+        transport = new_transport;
+        return NO_ERROR;
+    }
+
+    I2C_Peripheral_Transport I2C_Peripheral_GetTransport(void)
+    {
+        return transport;
+    }
+
+    /**
+    *   \brief Oversampling of SCL in the current mode.
+    */
+    static uint32 I2C_Peripheral_GetOversampling(void)
+    {
+        return fast_mode ? I2C_PERIPHERAL_OVERSAMPLING_FAST : I2C_PERIPHERAL_OVERSAMPLING_STANDARD;
+    }
+
+    /**
+    *   \brief Write the clock divider and the clock rate bit to the I2C block, disabled.
+    */
+    static void I2C_Peripheral_WriteClock(void)
     {
-        // Send start condition
-        uint8_t error = I2C_Master_MasterSendStart(device_address,I2C_Master_WRITE_XFER_MODE);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        I2C_Master_CLKDIV1_REG = LO8(clock_divider);
+        I2C_Master_CLKDIV2_REG = HI8(clock_divider);
+        if (fast_mode)
         {
-            // Write address of register to be read
-            error = I2C_Master_MasterWriteByte(register_address);
-            if (error == I2C_Master_MSTR_NO_ERROR)
+            I2C_Master_CFG_REG |= I2C_Master_CFG_CLK_RATE_MSK;
+        }
+        else
+        {
+            I2C_Master_CFG_REG &= (uint8)~I2C_Master_CFG_CLK_RATE_MSK;
+        }
+    }
+
+    ErrorCode I2C_Peripheral_SetBusRate(uint32 bus_hz)
+    {
+        if ((bus_hz == 0) || (bus_hz > I2C_PERIPHERAL_MAX_BUS_HZ))
+        {
+            return ERROR;
+        }
+
+        fast_mode = (bus_hz > I2C_PERIPHERAL_STANDARD_MODE_HZ);
+
+        uint32 oversampling = I2C_Peripheral_GetOversampling();
+        uint32 divider = (BCLK__BUS_CLK__HZ + oversampling*bus_hz - 1)/(oversampling*bus_hz);
+        clock_divider = (uint16)((divider > 0) ? divider : 1);
+
+        // The divider and the mode are changed with the block disabled; Stop also disables the interrupt, which Start restores
+        I2C_Master_Stop();
+        I2C_Peripheral_WriteClock();
+        I2C_Master_Start();
+
+        uint32 rate = I2C_Peripheral_GetBusRate();
+        byte_us = (uint16)((9*1000000 + rate - 1)/rate);
+        return NO_ERROR;
+    }
+
+    uint32 I2C_Peripheral_GetBusRate(void)
+    {
+        return BCLK__BUS_CLK__HZ/(I2C_Peripheral_GetOversampling()*(uint32)clock_divider);
+    }
+
+    void I2C_Peripheral_SetPolicy(const I2C_Peripheral_Policy* new_policy)
+    {
+        policy = *new_policy;
+    }
+
+    uint32 I2C_Peripheral_GetWorstCaseUs(uint8_t byte_count)
+    {
+        // Every attempt may run until its deadline and be followed by a recovery
+        uint32 attempt_us = policy.timeout_us + (uint32)(byte_count + 2)*byte_us;
+        if (policy.recover)
+        {
+            attempt_us += I2C_PERIPHERAL_RECOVERY_US;
+        }
+        return attempt_us*(policy.retries + 1);
+    }
+
+    void I2C_Peripheral_GetStats(I2C_Peripheral_Stats* current_stats)
+    {
+        *current_stats = stats;
+    }
+
+    ErrorCode I2C_Peripheral_Recover(void)
+    {
+        stats.recoveries++;
+
+        // The pins are hardware-connected to the I2C block: out of bypass, their data registers drive the lines
+        I2C_Master_Stop();
+        SDA_1_Write(1);
+        SCL_1_Write(1);
+        SCL_1_BYP &= (uint8)~SCL_1_MASK;
+        SDA_1_BYP &= (uint8)~SDA_1_MASK;
+        CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+
+        // Clock out up to 9 bits until the slave releases SDA
+        for (uint8_t pulse = 0; (pulse < 9) && !SDA_1_Read(); pulse++)
+        {
+            SCL_1_Write(0);
+            CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+            SCL_1_Write(1);
+            CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+        }
+
+        // Stop condition: SDA rising while SCL is high
+        SCL_1_Write(0);
+        SDA_1_Write(0);
+        CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+        SCL_1_Write(1);
+        CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+        SDA_1_Write(1);
+        CyDelayUs(I2C_PERIPHERAL_RECOVERY_HALF_PERIOD_US);
+
+        // Both lines released: the pins go back to the I2C block
+        SCL_1_BYP |= SCL_1_MASK;
+        SDA_1_BYP |= SDA_1_MASK;
+
+        // Re-initialize the I2C block and its state machine, at the current bus rate
+        I2C_Master_Init();
+        I2C_Peripheral_WriteClock();
+        I2C_Master_Start();
+
+        return SDA_1_Read() ? NO_ERROR : ERROR;
+    }
+
+    /**
+    *   \brief Map the error status of a transfer to an error code.
+    */
+    static ErrorCode I2C_Peripheral_StatusError(uint8_t status)
+    {
+        if (status & I2C_Master_MSTAT_ERR_ADDR_NAK)
+        {
+            return ERROR_I2C_ADDR_NAK;
+        }
+        if (status & I2C_Master_MSTAT_ERR_ARB_LOST)
+        {
+            return ERROR_I2C_ARB_LOST;
+        }
+        if (status & I2C_Master_MSTAT_ERR_SHORT_XFER)
+        {
+            return ERROR_I2C_DATA_NAK;
+        }
+        return ERROR;
+    }
+    
+    /**
+    *   \brief Map the value returned when starting a transfer to an error code.
+    */
+    static ErrorCode I2C_Peripheral_StartError(uint8_t error)
+    {
+        switch (error)
+        {
+            case I2C_Master_MSTR_NO_ERROR:
+                return NO_ERROR;
+            case I2C_Master_MSTR_BUS_BUSY:
+            case I2C_Master_MSTR_ERR_ABORT_START_GEN:
+                return ERROR_I2C_BUS_BUSY;
+            case I2C_Master_MSTR_NOT_READY:
+                return ERROR_I2C_NOT_READY;
+            case I2C_Master_MSTR_ERR_LB_NAK:
+                return ERROR_I2C_DATA_NAK;
+            case I2C_Master_MSTR_ERR_ARB_LOST:
+                return ERROR_I2C_ARB_LOST;
+            default:
+                return ERROR;
+        }
+    }
+    
+    /**
+    *   \brief Wait for the end of a transfer started with the buffer API.
+    */
+    static ErrorCode I2C_Peripheral_Wait(uint8_t complete_mask, uint32 start, uint32 deadline_cycles)
+    {
+        for(;;)
+        {
+            uint8_t status = I2C_Master_MasterStatus();
+            if (status & I2C_Master_MSTAT_ERR_XFER)
+            {
+                return I2C_Peripheral_StatusError(status);
+            }
+            if (status & complete_mask)
+            {
+                return NO_ERROR;
+            }
+            if ((uint32)(CycleCounter_Read() - start) > deadline_cycles)
+            {
+                return ERROR_I2C_TIMEOUT;
+            }
+        }
+    }
+    
+    /**
+    *   \brief Start a transfer, waiting until the deadline while the bus is busy.
+    */
+    static ErrorCode I2C_Peripheral_StartTransfer(uint8_t read,
+                                                  uint8_t device_address,
+                                                  uint8_t* data,
+                                                  uint8_t count,
+                                                  uint8_t mode,
+                                                  uint32 start,
+                                                  uint32 deadline_cycles)
+    {
+        for(;;)
+        {
+            I2C_Master_MasterClearStatus();
+            uint8_t error = read ? I2C_Master_MasterReadBuf(device_address, data, count, mode)
+                                 : I2C_Master_MasterWriteBuf(device_address, data, count, mode);
+            if ((error != I2C_Master_MSTR_BUS_BUSY) ||
+                ((uint32)(CycleCounter_Read() - start) > deadline_cycles))
+            {
+                return I2C_Peripheral_StartError(error);
+            }
+        }
+    }
+    
+    /**
+    *   \brief Single attempt of a write transfer, optionally followed by a
+    *   repeated start and a read transfer.
+    */
+    static ErrorCode I2C_Peripheral_Attempt(uint8_t device_address,
+                                            uint8_t* write_data,
+                                            uint8_t write_count,
+                                            uint8_t* read_data,
+                                            uint8_t read_count)
+    {
+        uint32 start = CycleCounter_Read();
+        uint32 deadline_cycles = (policy.timeout_us + (uint32)(write_count + read_count + 2)*byte_us)
+                                 *CYCLE_COUNTER_CYCLES_PER_US;
+        
+        // Write register address (and data), without stop if a read follows
+        ErrorCode error = I2C_Peripheral_StartTransfer(0, device_address, write_data, write_count,
+                                                       read_count ? I2C_Master_MODE_NO_STOP : I2C_Master_MODE_COMPLETE_XFER,
+                                                       start, deadline_cycles);
+        if (error == NO_ERROR)
+        {
+            error = I2C_Peripheral_Wait(I2C_Master_MSTAT_WR_CMPLT, start, deadline_cycles);
+        }
+        
+        if ((error == NO_ERROR) && read_count)
+        {
+            // Send restart condition and read data
+            error = I2C_Peripheral_StartTransfer(1, device_address, read_data, read_count,
+                                                 I2C_Master_MODE_REPEAT_START, start, deadline_cycles);
+            if (error == NO_ERROR)
+            {
+                error = I2C_Peripheral_Wait(I2C_Master_MSTAT_RD_CMPLT, start, deadline_cycles);
+            }
+        }
+        return error;
+    }
+    
+    /**
+    *   \brief Complete transaction: attempts, retries and bus recovery.
+    */
+    static ErrorCode I2C_Peripheral_Transaction(uint8_t device_address,
+                                                uint8_t* write_data,
+                                                uint8_t write_count,
+                                                uint8_t* read_data,
+                                                uint8_t read_count)
+    {
+        uint32 start = CycleCounter_Read();
+        ErrorCode error;
+        
+        stats.transactions++;
+        for (uint8_t attempt = 0; ; attempt++)
+        {
+            error = I2C_Peripheral_Attempt(device_address, write_data, write_count, read_data, read_count);
+            if (error == NO_ERROR)
+            {
+                break;
+            }
+            
+            stats.errors[error]++;
+            uint8_t action = error_action[error];
+            if ((action & ACTION_RECOVER) && policy.recover)
             {
-                // Send restart condition
-                error = I2C_Master_MasterSendRestart(device_address, I2C_Master_READ_XFER_MODE);
-                if (error == I2C_Master_MSTR_NO_ERROR)
-                {
-                    // Read data without acknowledgement
-                    *data = I2C_Master_MasterReadByte(I2C_Master_NAK_DATA);
-                    // Send stop condition and return no error
-                    I2C_Master_MasterSendStop();
-                }
+                I2C_Peripheral_Recover();
             }
+            if (!(action & ACTION_RETRY) || (attempt >= policy.retries))
+            {
+                break;
+            }
+            stats.retries++;
+        }
+        
+        uint32 latency_us = CycleCounter_ToUs(CycleCounter_Read() - start);
+        if (latency_us > stats.max_latency_us)
+        {
+            stats.max_latency_us = latency_us;
         }
-        // Send stop condition if something went wrong
-        I2C_Master_MasterSendStop();
-        // Return error code
-        return error ? ERROR : NO_ERROR;
+        if (error != NO_ERROR)
+        {
+            stats.failures++;
+        }
+        return error;
     }
     
+    ErrorCode I2C_Peripheral_ReadRegister(uint8_t device_address,
+                                            uint8_t register_address,
+                                            uint8_t* data)
+    {
+        if (transport == I2C_PERIPHERAL_TRANSPORT_SPI)
+        {
+            return SPI_Peripheral_ReadRegisterMulti(register_address, 1, data);
+        }
+        return I2C_Peripheral_Transaction(device_address, &register_address, 1, data, 1);
+    }
+
     ErrorCode I2C_Peripheral_ReadRegisterMulti(uint8_t device_address,
                                                 uint8_t register_address,
                                                 uint8_t register_count,
                                                 uint8_t* data)
     {
-        // Send start condition
-        uint8_t error = I2C_Master_MasterSendStart(device_address,I2C_Master_WRITE_XFER_MODE);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        if (transport == I2C_PERIPHERAL_TRANSPORT_SPI)
         {
-            // Write address of register to be read with the MSB equal to 1
-            register_address |= 0x80;
-            error = I2C_Master_MasterWriteByte(register_address);
-            if (error == I2C_Master_MSTR_NO_ERROR)
-            {
-                // Send restart condition
-                error = I2C_Master_MasterSendRestart(device_address, I2C_Master_READ_XFER_MODE);
-                if (error == I2C_Master_MSTR_NO_ERROR)
-                {
-                    // Continue reading until we have register to read
-                    uint8_t counter = register_count;
-                    while(counter>1)
-                    {
-                        data[register_count-counter] =
-                            I2C_Master_MasterReadByte(I2C_Master_ACK_DATA);
-                        counter--;
-                    }
-                    // Read last data without acknowledgement
-                    data[register_count-1]
-                        = I2C_Master_MasterReadByte(I2C_Master_NAK_DATA);
-                }
-            }
+            return SPI_Peripheral_ReadRegisterMulti(register_address, register_count, data);
         }
-        // Send stop condition
-        I2C_Master_MasterSendStop();
-        // Return error code
-        return error ? ERROR : NO_ERROR;
+
+        // Write address of register to be read with the MSB equal to 1
+        register_address |= 0x80;
+        return I2C_Peripheral_Transaction(device_address, &register_address, 1, data, register_count);
     }
-    
+
     ErrorCode I2C_Peripheral_WriteRegister(uint8_t device_address,
                                             uint8_t register_address,
                                             uint8_t data)
     {
-        // Send start condition
-        uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        uint8_t buffer[2] = {register_address, data};
+
+        if (transport == I2C_PERIPHERAL_TRANSPORT_SPI)
         {
-            // Write register address
-            error = I2C_Master_MasterWriteByte(register_address);
-            if (error == I2C_Master_MSTR_NO_ERROR)
-            {
-                // Write byte of interest
-                error = I2C_Master_MasterWriteByte(data);
-            }
+            return SPI_Peripheral_WriteRegisterMulti(register_address, 1, &data);
         }
-        // Send stop condition
-        I2C_Master_MasterSendStop();
-        // Return error code
-        return error ? ERROR : NO_ERROR;
+        return I2C_Peripheral_Transaction(device_address, buffer, 2, NULL, 0);
     }
-    
+
     ErrorCode I2C_Peripheral_WriteRegisterMulti(uint8_t device_address,
                                             uint8_t register_address,
                                             uint8_t register_count,
                                             uint8_t* data)
     {
-        // Send start condition
-        uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        uint8_t buffer[I2C_PERIPHERAL_MAX_WRITE_COUNT + 1];
+
+        if (transport == I2C_PERIPHERAL_TRANSPORT_SPI)
         {
-            // Write register address
-            error = I2C_Master_MasterWriteByte(register_address);
-            if (error == I2C_Master_MSTR_NO_ERROR)
-            {
-                // Continue writing until we have data to write
-                uint8_t counter = register_count;
-                while(counter >= 0)
-                {
-                     error =
-                        I2C_Master_MasterWriteByte(data[register_count-counter]);
-                    if (error != I2C_Master_MSTR_NO_ERROR)
-                    {
-                        // Send stop condition
-                        I2C_Master_MasterSendStop();
-                        // Return error code
-                        return ERROR;
-                    }
-                    counter--;
-                }
-            }
+            return SPI_Peripheral_WriteRegisterMulti(register_address, register_count, data);
+        }
+        if (register_count > I2C_PERIPHERAL_MAX_WRITE_COUNT)
+        {
+            return ERROR;
+        }
+
+        // Write address of first register with the MSB equal to 1 (auto-increment)
+        buffer[0] = register_address | 0x80;
+        for (uint8_t i = 0; i < register_count; i++)
+        {
+            buffer[i+1] = data[i];
         }
-        // Send stop condition in case something didn't work out correctly
-        I2C_Master_MasterSendStop();
-        // Return error code
-        return error ? ERROR : NO_ERROR;
+        return I2C_Peripheral_Transaction(device_address, buffer, register_count + 1, NULL, 0);
     }
-    
-    
+
+
     uint8_t I2C_Peripheral_IsDeviceConnected(uint8_t device_address)
     {
-        // Send a start condition followed by a stop condition
-        uint8_t error = I2C_Master_MasterSendStart(device_address, I2C_Master_WRITE_XFER_MODE);
-        I2C_Master_MasterSendStop();
-        // If no error generated during stop, device is connected
-        if (error == I2C_Master_MSTR_NO_ERROR)
+        // Send the address followed by a stop condition, with a single attempt
+        uint8_t dummy;
+        if ((transport == I2C_PERIPHERAL_TRANSPORT_I2C) &&
+            (I2C_Peripheral_Attempt(device_address, &dummy, 0, NULL, 0) == NO_ERROR))
         {
             return DEVICE_CONNECTED;
         }
         return DEVICE_UNCONNECTED;
     }
 
-/* [] END OF FILE */
\ No newline at end of file
+/* [] END OF FILE */
@@ -16,11 +16,81 @@
     #include "cytypes.h"
     #include "ErrorCodes.h"
     
+    /**
+    *   \brief Default deadline of a transaction attempt, on top of the bus time of its bytes (us).
+    */
+    #define I2C_PERIPHERAL_DEFAULT_TIMEOUT_US 1000
+    
+    /**
+    *   \brief Default number of retries after a failed attempt.
+    */
+    #define I2C_PERIPHERAL_DEFAULT_RETRIES 2
+    
+    /**
+    *   \brief Default bus recovery after a timed-out attempt (1 = enabled).
+    */
+    #define I2C_PERIPHERAL_DEFAULT_RECOVER 1
+    
+    /**
+    *   \brief Upper bound of the duration of the bus recovery (us).
+    */
+    #define I2C_PERIPHERAL_RECOVERY_US 150
+    
+    /**
+    *   \brief Standard and fast mode bus rates (Hz).
+    */
+    #define I2C_PERIPHERAL_STANDARD_MODE_HZ 100000
+    #define I2C_PERIPHERAL_FAST_MODE_HZ 400000
+    
+    /**
+    *   \brief Highest bus rate of the fixed-function I2C block (Hz).
+    */
+    #define I2C_PERIPHERAL_MAX_BUS_HZ 1000000
+    
+    /**
+    *   \brief Maximum number of registers written by I2C_Peripheral_WriteRegisterMulti.
+    */
+    #define I2C_PERIPHERAL_MAX_WRITE_COUNT 16
+    
+    /**
+    *   \brief Transport of the register transfers.
+    *
+    *   With the SPI transport the register functions below run over the
+    *   SPI backend (SPI_Interface.h) and the device address is ignored;
+    *   bus rate, policy, statistics and recovery only apply to I2C.
+    */
+    typedef enum {
+        I2C_PERIPHERAL_TRANSPORT_I2C,   ///< I2C_Master component
+        I2C_PERIPHERAL_TRANSPORT_SPI    ///< SPIM component and CS_1 pin
+    } I2C_Peripheral_Transport;
+    
+    /**
+    *   \brief Deadline and retry policy of the transactions.
+    */
+    typedef struct {
+        uint16_t timeout_us;    ///< Deadline of an attempt, on top of the bus time of its bytes
+        uint8_t retries;        ///< Attempts after the first failed one
+        uint8_t recover;        ///< Bus recovery after a timed-out attempt (0 = disabled)
+    } I2C_Peripheral_Policy;
+    
+    /**
+    *   \brief Statistics of the transactions.
+    */
+    typedef struct {
+        uint32 transactions;    ///< Transactions started
+        uint32 retries;         ///< Attempts repeated after a failure
+        uint32 errors[ERROR_CODE_COUNT]; ///< Failed attempts, per error code
+        uint32 recoveries;      ///< Bus recoveries
+        uint32 failures;        ///< Transactions failed after all the retries
+        uint32 max_latency_us;  ///< Longest transaction, retries and recoveries included
+    } I2C_Peripheral_Stats;
+    
     /** \brief Start the I2C peripheral.
     *   
     *   This function starts the I2C peripheral so that it is ready to work.
+    *   \param bus_hz Target bus rate (Hz), see I2C_Peripheral_SetBusRate.
     */
-    ErrorCode I2C_Peripheral_Start(void);
+    ErrorCode I2C_Peripheral_Start(uint32 bus_hz);
     
     /** \brief Stop the I2C peripheral.
     *   
@@ -28,6 +98,78 @@
     */
     ErrorCode I2C_Peripheral_Stop(void);
     
+    /** \brief Select the transport of the register transfers.
+    *
+    *   The SPI peripheral is started when selected.
+    *   \param transport Transport used by the following transfers.
+    *   \retval Returns ERROR if the SPI backend is not available.
+    */
+    ErrorCode I2C_Peripheral_SetTransport(I2C_Peripheral_Transport transport);
+    
+    /** \brief Get the transport of the register transfers.
+    *
+    *   \retval Transport used by the transfers.
+    */
+    I2C_Peripheral_Transport I2C_Peripheral_GetTransport(void);
+    
+    /** \brief Set the bus rate.
+    *
+    *   This function reprograms the clock divider and the mode of the I2C
+    *   block. Up to I2C_PERIPHERAL_STANDARD_MODE_HZ the block runs in
+    *   standard mode and SCL is BUS_CLK/(16*divider); above it, in fast
+    *   mode and SCL is BUS_CLK/(32*divider). The divider is rounded up, so
+    *   the rate obtained is the closest one not above the target. The rate
+    *   is kept across bus recoveries.
+    *   \param bus_hz Target bus rate (Hz), up to I2C_PERIPHERAL_MAX_BUS_HZ.
+    *   \retval Returns ERROR if the rate is out of range.
+    */
+    ErrorCode I2C_Peripheral_SetBusRate(uint32 bus_hz);
+    
+    /** \brief Get the bus rate.
+    *
+    *   \retval Bus rate obtained with the current clock divider (Hz).
+    */
+    uint32 I2C_Peripheral_GetBusRate(void);
+    
+    /** \brief Set the deadline and retry policy.
+    *
+    *   \param policy Policy applied to the following transactions.
+    */
+    void I2C_Peripheral_SetPolicy(const I2C_Peripheral_Policy* policy);
+    
+    /** \brief Worst-case duration of a transaction.
+    *
+    *   This function returns the upper bound of the duration of a transaction
+    *   under the current policy: every attempt running until its deadline,
+    *   followed by a bus recovery.
+    *   \param byte_count Number of bytes transferred (address excluded).
+    *   \retval Worst-case duration in us.
+    */
+    uint32 I2C_Peripheral_GetWorstCaseUs(uint8_t byte_count);
+    
+    /** \brief Get the statistics of the transactions.
+    *
+    *   \param stats Pointer to a structure where the statistics will be saved.
+    */
+    void I2C_Peripheral_GetStats(I2C_Peripheral_Stats* stats);
+    
+    /** \brief Recover a stuck bus.
+    *
+    *   This function takes SCL_1 and SDA_1 from the I2C block (bypass
+    *   cleared), clocks out up to 9 SCL pulses until the slave releases
+    *   SDA, generates a stop condition, gives the pins back to the block
+    *   and re-initializes the I2C peripheral.
+    *   \retval Returns ERROR if SDA is still held low.
+    */
+    ErrorCode I2C_Peripheral_Recover(void);
+    
+    /*
+    *   The transfer functions below return NO_ERROR or the ErrorCode of the
+    *   last failed attempt: an address or data NACK is returned after a single
+    *   attempt, an arbitration loss is retried, a busy or stuck bus is
+    *   recovered before being retried.
+    */
+    
     /**
     *   \brief Read one byte over I2C.
     *   
@@ -87,6 +229,7 @@
     *   \brief Check if device is connected over I2C.
     *
     *   This function checks if a device is connected over the I2C lines.
+    *   Devices on SPI are not addressed and are never reported.
     *   \param device_address I2C address of the device to be checked.
     *   \retval Returns true (>0) if device is connected.
     */
@@ -14,12 +14,13 @@
 
 //Include required header files
 #include "project.h"
+#include "Scheduler.h"
 
 CY_ISR(Custom_ISR_ADC)
 {
     Timer_ReadStatusRegister();
     
-    flag_ISR=1;  
+    Scheduler_Tick();
 }   
 
 
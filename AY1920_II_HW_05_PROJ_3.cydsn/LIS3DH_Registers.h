@@ -0,0 +1,200 @@
+/**
+*   \file LIS3DH_Registers.h
+*   \brief Register map of the LIS3DH accelerometer.
+*
+*   This file collects the addresses and bit definitions of the LIS3DH
+*   registers used throughout the project, so that every module refers
+*   to the same values.
+*/
+
+#ifndef __LIS3DH_REGISTERS_H
+    #define __LIS3DH_REGISTERS_H
+
+    /**
+    *   \brief 7-bit I2C address of the slave device.
+    */
+    #define LIS3DH_DEVICE_ADDRESS 0x18
+
+    /**
+    *   \brief 7-bit I2C address of a second device, with SA0 pulled high.
+    */
+    #define LIS3DH_DEVICE_ADDRESS_SA0_HIGH 0x19
+
+    /**
+    *   \brief Address of the WHO AM I register
+    */
+    #define LIS3DH_WHO_AM_I_REG_ADDR 0x0F
+
+    /**
+    *   \brief Address of the Status register
+    */
+    #define LIS3DH_STATUS_REG 0x27
+
+    /**
+    *   \brief New data available bits of the Status register
+    */
+    #define LIS3DH_STATUS_ZYXDA 0x08
+
+    /**
+    *   \brief Data overrun bit of the Status register: a sample was overwritten before being read
+    */
+    #define LIS3DH_STATUS_ZYXOR 0x80
+
+    /**
+    *   \brief Address of the Control register 0 (SDO/SA0 pull-up)
+    */
+    #define LIS3DH_CTRL_REG0 0x1E
+
+    /**
+    *   \brief Address of the Temperature Sensor Configuration register
+    */
+    #define LIS3DH_TEMP_CFG_REG 0x1F
+
+    /**
+    *   \brief ADC and temperature sensor enable bits of TEMP_CFG_REG
+    */
+    #define LIS3DH_TEMP_CFG_REG_ADC_EN 0x80
+    #define LIS3DH_TEMP_CFG_REG_TEMP_EN 0x40
+
+    /**
+    *   \brief Address of the first auxiliary ADC output register
+    *
+    *   OUT_ADC1_L..OUT_ADC3_H are contiguous; ADC3 carries the temperature
+    *   when LIS3DH_TEMP_CFG_REG_TEMP_EN is set.
+    */
+    #define LIS3DH_OUT_ADC1_L 0x08
+    #define LIS3DH_OUT_ADC3_L 0x0C
+
+    /**
+    *   \brief Number of auxiliary ADC channels
+    */
+    #define LIS3DH_ADC_COUNT 3
+
+    /**
+    *   \brief Depth of the FIFO, in samples of the three axes
+    */
+    #define LIS3DH_FIFO_DEPTH 32
+
+    /**
+    *   \brief Address of the Control register 1
+    */
+    #define LIS3DH_CTRL_REG1 0x20
+
+    /**
+    *   \brief Output data rate field of the Control register 1
+    */
+    #define LIS3DH_CTRL_REG1_ODR_100HZ 0x50
+
+    /**
+    *   \brief Low-power mode enable bit of the Control register 1
+    */
+    #define LIS3DH_CTRL_REG1_LPEN 0x08
+
+    /**
+    *   \brief Axis enable bits of the Control register 1 (Xen, Yen, Zen)
+    */
+    #define LIS3DH_CTRL_REG1_XEN 0x01
+    #define LIS3DH_CTRL_REG1_YEN 0x02
+    #define LIS3DH_CTRL_REG1_ZEN 0x04
+    #define LIS3DH_CTRL_REG1_AXIS_MASK 0x07
+
+    /**
+    *   \brief Address of the Control register 2 (high-pass filter)
+    */
+    #define LIS3DH_CTRL_REG2 0x21
+
+    /**
+    *   \brief Address of the Control register 3 (INT1 routing)
+    */
+    #define LIS3DH_CTRL_REG3 0x22
+
+    /**
+    *   \brief Address of the Control register 4
+    */
+    #define LIS3DH_CTRL_REG4 0x23
+
+    /**
+    *   \brief Full scale field and high resolution bit of the Control register 4
+    */
+    #define LIS3DH_CTRL_REG4_FS_MASK 0x30
+    #define LIS3DH_CTRL_REG4_FS_SHIFT 4
+    #define LIS3DH_CTRL_REG4_HR 0x08
+
+    /**
+    *   \brief Address of the Control register 5
+    */
+    #define LIS3DH_CTRL_REG5 0x24
+
+    /**
+    *   \brief Reboot memory content bit of the Control register 5
+    *
+    *   Cleared by the device when the boot procedure is complete.
+    */
+    #define LIS3DH_CTRL_REG5_BOOT 0x80
+
+    /**
+    *   \brief FIFO enable bit of the Control register 5
+    */
+    #define LIS3DH_CTRL_REG5_FIFO_EN 0x40
+
+    /**
+    *   \brief Address of the Control register 6
+    */
+    #define LIS3DH_CTRL_REG6 0x25
+
+    /**
+    *   \brief Address of the Reference register (interrupt generation)
+    */
+    #define LIS3DH_REFERENCE_REG 0x26
+
+    /**
+    *   \brief Address of the FIFO control register
+    */
+    #define LIS3DH_FIFO_CTRL_REG 0x2E
+
+    /**
+    *   \brief Stream mode of the FIFO control register (FM[1:0] = 10, bypass = 00)
+    */
+    #define LIS3DH_FIFO_CTRL_REG_STREAM 0x80
+
+    /**
+    *   \brief Addresses of the interrupt, click and activity registers
+    *
+    *   INT1_SRC (0x31), INT2_SRC (0x35) and CLICK_SRC (0x39) are read-only.
+    */
+    #define LIS3DH_INT1_CFG 0x30
+    #define LIS3DH_INT1_THS 0x32
+    #define LIS3DH_INT1_DURATION 0x33
+    #define LIS3DH_INT2_CFG 0x34
+    #define LIS3DH_INT2_THS 0x36
+    #define LIS3DH_INT2_DURATION 0x37
+    #define LIS3DH_CLICK_CFG 0x38
+    #define LIS3DH_CLICK_THS 0x3A
+    #define LIS3DH_TIME_LIMIT 0x3B
+    #define LIS3DH_TIME_LATENCY 0x3C
+    #define LIS3DH_TIME_WINDOW 0x3D
+    #define LIS3DH_ACT_THS 0x3E
+    #define LIS3DH_ACT_DUR 0x3F
+
+    /**
+    *   \brief Addresses of the Output registers
+    */
+    #define LIS3DH_OUT_X_L 0x28
+    #define LIS3DH_OUT_X_H 0x29
+    #define LIS3DH_OUT_Y_L 0x2A
+    #define LIS3DH_OUT_Y_H 0x2B
+    #define LIS3DH_OUT_Z_L 0x2C
+    #define LIS3DH_OUT_Z_H 0x2D
+
+    /**
+    *   \brief Number of output bytes of each axis
+    */
+    #define LIS3DH_AXIS_BYTES 2
+
+    /**
+    *   \brief Number of axes of the accelerometer
+    */
+    #define LIS3DH_AXIS_COUNT 3
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,186 @@
+/*
+* This file includes the source code of the link budget
+* of an acquisition configuration.
+*/
+
+#include "LinkBudget.h"
+#include "Acquisition.h"
+#include "cyfitter.h"
+
+/**
+*   \brief Estimated CPU cycles of the acquisition steps.
+*/
+#define LINK_BUDGET_CYCLES_PER_POLL 500         ///< Scheduler release and task call
+#define LINK_BUDGET_CYCLES_PER_AXIS 300         ///< Compensation, gain and float conversion of an axis
+#define LINK_BUDGET_CYCLES_PER_UART_BYTE 30     ///< Byte queued in the UART buffer
+#define LINK_BUDGET_CYCLES_PER_DMA_FRAME 200    ///< Header, sequence number and DMA channel start of a raw frame
+
+/**
+*   \brief Bus overhead of a register read besides the data bytes.
+*
+*   I2C: device address (write), register address and device address
+*   (read), 9 bits each, plus start, repeated start and stop.
+*   SPI: the register address byte.
+*/
+#define LINK_BUDGET_I2C_OVERHEAD_BYTES 3
+#define LINK_BUDGET_I2C_CONDITION_BITS 3
+#define LINK_BUDGET_SPI_OVERHEAD_BYTES 1
+
+/**
+*   \brief Output data rates of CTRL_REG1 ODR[3:0] (normal and high resolution modes).
+*/
+static const uint16 link_budget_odr[16] = {0, 1, 10, 25, 50, 100, 200, 400, 1600, 1344, 0, 0, 0, 0, 0, 0};
+
+    uint16 LinkBudget_GetOdr(uint8_t ctrl_reg1)
+    {
+        uint8_t odr = ctrl_reg1 >> 4;
+
+        // ODR 1001 is 5376 Hz in low-power mode
+        if ((odr == 9) && (ctrl_reg1 & LIS3DH_CTRL_REG1_LPEN))
+        {
+            return 5376;
+        }
+        return link_budget_odr[odr];
+    }
+
+    uint8_t LinkBudget_GetAxisCount(uint8_t ctrl_reg1)
+    {
+        uint8_t axis_count = 0;
+
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            if (ctrl_reg1 & (1 << axis))
+            {
+                axis_count++;
+            }
+        }
+        return axis_count;
+    }
+
+    /**
+    *   \brief Bus time of a register read (ns).
+    */
+    static uint32 LinkBudget_ReadNs(const LinkBudget_Config* config, uint8_t byte_count)
+    {
+        uint32 bits;
+
+        if (config->transport == LINK_BUDGET_TRANSPORT_SPI)
+        {
+            bits = (uint32)(byte_count + LINK_BUDGET_SPI_OVERHEAD_BYTES)*8;
+        }
+        else
+        {
+            bits = (uint32)(byte_count + LINK_BUDGET_I2C_OVERHEAD_BYTES)*9 + LINK_BUDGET_I2C_CONDITION_BITS;
+        }
+        return (uint32)(((uint64_t)bits*1000000000u + config->bus_hz - 1)/config->bus_hz);
+    }
+
+    uint8_t LinkBudget_Compute(const LinkBudget_Config* config, LinkBudget_Result* result)
+    {
+        uint8_t axis_mask = config->axis_mask & LIS3DH_CTRL_REG1_AXIS_MASK;
+        uint8_t axis_count = LinkBudget_GetAxisCount(axis_mask);
+        uint8_t frame_length = (config->sensor_count > 1) ?
+            2 + ACQUISITION_TIMESTAMP_BYTES + config->sensor_count*axis_count*ACQUISITION_BYTES_PER_AXIS :
+            2 + axis_count*ACQUISITION_BYTES_PER_AXIS;
+        uint8_t decimation = config->decimation ? config->decimation : 1;
+        uint64_t bus_ns = 0;        // per second
+        uint64_t uart_bytes = 0;    // per second
+        uint64_t cycles = 0;        // per second
+
+        *result = (LinkBudget_Result){0};
+        if ((config->odr_hz == 0) || (config->sensor_count == 0) || (axis_count == 0))
+        {
+            return LINK_BUDGET_OK;
+        }
+
+        if (config->format == LINK_BUDGET_FORMAT_RAW)
+        {
+            // As in Passthrough_Start: each poll reads every device from the status register to the last axis
+            bus_ns += (uint64_t)config->tick_hz*config->sensor_count*
+                      LinkBudget_ReadNs(config, ACQUISITION_BURST_LENGTH(axis_mask));
+        }
+        else
+        {
+            // As in Acquisition_Start: the status burst at each poll, then Z apart once a sample is ready
+            bus_ns += (uint64_t)config->tick_hz*config->sensor_count*
+                      LinkBudget_ReadNs(config, ACQUISITION_STATUS_READ_LENGTH(axis_mask));
+            if (ACQUISITION_SPLIT_READ(axis_mask))
+            {
+                bus_ns += (uint64_t)config->odr_hz*config->sensor_count*
+                          LinkBudget_ReadNs(config, ACQUISITION_AXIS_READ_LENGTH(axis_mask));
+            }
+        }
+        cycles += (uint64_t)config->tick_hz*LINK_BUDGET_CYCLES_PER_POLL;
+
+        // Frames sent, one every decimation samples
+        if (config->format == LINK_BUDGET_FORMAT_RAW)
+        {
+            // Header, sequence number, the bursts as read and the footer, moved by DMA
+            frame_length = 3 + config->sensor_count*ACQUISITION_BURST_LENGTH(axis_mask);
+            cycles += (uint64_t)config->odr_hz*LINK_BUDGET_CYCLES_PER_DMA_FRAME/decimation;
+        }
+        else
+        {
+            cycles += (uint64_t)config->odr_hz*
+                      (config->sensor_count*axis_count*LINK_BUDGET_CYCLES_PER_AXIS +
+                       frame_length*LINK_BUDGET_CYCLES_PER_UART_BYTE)/decimation;
+        }
+        uart_bytes += (uint64_t)frame_length*config->odr_hz/decimation;
+
+        // Auxiliary frames, one every aux_divider samples
+        if (config->aux_divider)
+        {
+            bus_ns += (uint64_t)config->odr_hz*LinkBudget_ReadNs(config, LIS3DH_ADC_COUNT*2)/config->aux_divider;
+            uart_bytes += (uint64_t)ACQUISITION_AUX_FRAME_LENGTH*config->odr_hz/config->aux_divider;
+            cycles += (uint64_t)config->odr_hz*ACQUISITION_AUX_FRAME_LENGTH*LINK_BUDGET_CYCLES_PER_UART_BYTE/
+                      config->aux_divider;
+        }
+
+        // Transfers are blocking: the CPU waits for the bus
+        cycles += bus_ns*(BCLK__BUS_CLK__HZ/1000000u)/1000u;
+
+        result->bus_us_per_sample = (uint32)(bus_ns/1000u/config->odr_hz);
+        result->uart_bytes_per_s = (uint32)uart_bytes;
+        result->cpu_cycles_per_sample = (uint32)(cycles/config->odr_hz);
+        result->bus_load_permille = (uint16)((bus_ns/1000000u < 65535u) ? bus_ns/1000000u : 65535u);
+        result->uart_load_permille = (uint16)((uart_bytes*10000u/config->baud < 65535u) ?
+                                              uart_bytes*10000u/config->baud : 65535u);
+        result->cpu_load_permille = (uint16)((cycles*1000u/BCLK__BUS_CLK__HZ < 65535u) ?
+                                             cycles*1000u/BCLK__BUS_CLK__HZ : 65535u);
+
+        if (config->odr_hz > config->tick_hz)
+        {
+            result->violations |= LINK_BUDGET_ODR_ABOVE_TICK;
+        }
+        if (result->bus_load_permille > LINK_BUDGET_MAX_LOAD_PERCENT*10)
+        {
+            result->violations |= LINK_BUDGET_BUS;
+        }
+        if (result->uart_load_permille > LINK_BUDGET_MAX_LOAD_PERCENT*10)
+        {
+            result->violations |= LINK_BUDGET_UART;
+        }
+        if (result->cpu_load_permille > LINK_BUDGET_MAX_LOAD_PERCENT*10)
+        {
+            result->violations |= LINK_BUDGET_CPU;
+        }
+        return result->violations;
+    }
+
+    ErrorCode LinkBudget_Admit(LinkBudget_Config* config, LinkBudget_Result* result)
+    {
+        if (config->decimation == 0)
+        {
+            config->decimation = 1;
+        }
+
+        // Decimation only relieves the UART and the CPU
+        while ((LinkBudget_Compute(config, result) & (LINK_BUDGET_UART | LINK_BUDGET_CPU)) &&
+               (config->decimation < LINK_BUDGET_MAX_DECIMATION))
+        {
+            config->decimation++;
+        }
+        return (result->violations == LINK_BUDGET_OK) ? NO_ERROR : ERROR;
+    }
+
+/* [] END OF FILE */
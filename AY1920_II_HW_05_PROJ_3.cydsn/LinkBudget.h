@@ -0,0 +1,124 @@
+/**
+*   \file LinkBudget.h
+*   \brief Link budget of an acquisition configuration.
+*
+*   The model estimates, for a given ODR, number of devices, enabled axes,
+*   transport, bus rate and UART baud rate, the bus time, UART bytes and
+*   CPU cycles needed by the acquisition, and checks them against the
+*   capacity of each resource. It has no hardware dependency, so that the
+*   same code runs in the firmware at configuration time and on the host
+*   (Host/LinkBudget) to plan deployments.
+*
+*   The acquisition task polls every device at each scheduler tick, with
+*   blocking transfers: the bus time of the polls is also CPU time. The
+*   reads are those of Acquisition_Poll for the axis mask: from STATUS_REG
+*   to the last enabled axis (X+Z also reads Y), or the status alone and
+*   Z apart once a sample is ready for Z only. The
+*   CPU cycles of conversion and UART queueing are estimates for the
+*   Cortex-M3 without FPU at BUS_CLK.
+*/
+
+#ifndef __LINK_BUDGET_H
+    #define __LINK_BUDGET_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+
+    /**
+    *   \brief Highest load accepted on the bus, the UART and the CPU (percent).
+    */
+    #define LINK_BUDGET_MAX_LOAD_PERCENT 80
+
+    /**
+    *   \brief Highest decimation applied by LinkBudget_Admit.
+    */
+    #define LINK_BUDGET_MAX_DECIMATION 64
+
+    /**
+    *   \brief Transport of the accelerometer reads.
+    */
+    #define LINK_BUDGET_TRANSPORT_I2C 0
+    #define LINK_BUDGET_TRANSPORT_SPI 1
+
+    /**
+    *   \brief Format of the frames.
+    */
+    #define LINK_BUDGET_FORMAT_CONVERTED 0      ///< Samples converted by the CPU (Acquisition.h)
+    #define LINK_BUDGET_FORMAT_RAW 1            ///< Raw bursts sent by DMA (Passthrough.h)
+
+    /**
+    *   \brief Resources exceeded by a configuration.
+    */
+    #define LINK_BUDGET_OK 0x00
+    #define LINK_BUDGET_ODR_ABOVE_TICK 0x01     ///< More samples than polls: samples overwritten in the device
+    #define LINK_BUDGET_BUS 0x02                ///< Bus load above the limit
+    #define LINK_BUDGET_UART 0x04               ///< UART load above the limit
+    #define LINK_BUDGET_CPU 0x08                ///< CPU load above the limit
+
+    /**
+    *   \brief Acquisition configuration.
+    */
+    typedef struct {
+        uint16 odr_hz;          ///< Output data rate of the devices
+        uint8_t sensor_count;   ///< Devices read in lockstep
+        uint8_t axis_mask;      ///< Enabled axes, as CTRL_REG1 bits 2:0
+        uint8_t transport;      ///< LINK_BUDGET_TRANSPORT_I2C or LINK_BUDGET_TRANSPORT_SPI
+        uint32 bus_hz;          ///< Bus rate
+        uint32 baud;            ///< UART baud rate (8N1)
+        uint16 tick_hz;         ///< Rate of the acquisition polls
+        uint8_t aux_divider;    ///< Samples between two auxiliary frames (0 = no auxiliary frames)
+        uint8_t decimation;     ///< Samples per frame sent (1 = every sample)
+        uint8_t format;         ///< LINK_BUDGET_FORMAT_CONVERTED or LINK_BUDGET_FORMAT_RAW
+    } LinkBudget_Config;
+
+    /**
+    *   \brief Resources used by a configuration.
+    */
+    typedef struct {
+        uint32 bus_us_per_sample;       ///< Bus time per sample period, all devices and polls
+        uint32 uart_bytes_per_s;        ///< UART bytes of the frames
+        uint32 cpu_cycles_per_sample;   ///< CPU cycles per sample period
+        uint16 bus_load_permille;       ///< Bus time over elapsed time
+        uint16 uart_load_permille;      ///< UART bytes over UART capacity
+        uint16 cpu_load_permille;       ///< CPU cycles over BUS_CLK
+        uint8_t violations;             ///< Resources exceeded (LINK_BUDGET_BUS, ...)
+    } LinkBudget_Result;
+
+    /**
+    *   \brief Output data rate selected by CTRL_REG1.
+    *
+    *   \param ctrl_reg1 Value of CTRL_REG1.
+    *   \retval Output data rate (Hz), 0 in power-down mode.
+    */
+    uint16 LinkBudget_GetOdr(uint8_t ctrl_reg1);
+
+    /**
+    *   \brief Number of axes enabled by CTRL_REG1.
+    *
+    *   \param ctrl_reg1 Value of CTRL_REG1.
+    */
+    uint8_t LinkBudget_GetAxisCount(uint8_t ctrl_reg1);
+
+    /**
+    *   \brief Compute the resources used by a configuration.
+    *
+    *   \param config Configuration to be evaluated.
+    *   \param result Pointer to a structure where the result will be saved.
+    *   \retval Resources exceeded, LINK_BUDGET_OK if the configuration is feasible.
+    */
+    uint8_t LinkBudget_Compute(const LinkBudget_Config* config, LinkBudget_Result* result);
+
+    /**
+    *   \brief Admit a configuration, decimating the frames if the UART cannot carry them.
+    *
+    *   The decimation of the configuration is raised, up to
+    *   LINK_BUDGET_MAX_DECIMATION, until the UART and CPU loads fit. The bus
+    *   load and the ODR are not affected by the decimation.
+    *   \param config Configuration to be admitted, its decimation is updated.
+    *   \param result Pointer to a structure where the result of the admitted configuration will be saved.
+    *   \retval Returns ERROR if the configuration cannot be made feasible.
+    */
+    ErrorCode LinkBudget_Admit(LinkBudget_Config* config, LinkBudget_Result* result);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/*
+* This file includes the source code of the lightweight
+* text output on UART_Debug.
+*/
+
+#include "Log.h"
+#include "UartTx.h"
+
+/**
+*   \brief Decimal digits of a uint32.
+*/
+#define LOG_DEC_DIGITS 10
+
+static const char log_hex_digits[16] = "0123456789ABCDEF";
+
+    void Log_PutString(const char* string)
+    {
+        while (*string)
+        {
+            UartTx_PutChar((uint8_t)*string++);
+        }
+    }
+
+    void Log_PutStringN(const char* string, uint8_t max_length)
+    {
+        while (max_length-- && *string)
+        {
+            UartTx_PutChar((uint8)*string++);
+        }
+    }
+
+    void Log_PutHex8(uint8_t value)
+    {
+        UartTx_PutChar(log_hex_digits[value >> 4]);
+        UartTx_PutChar(log_hex_digits[value & 0x0F]);
+    }
+
+    void Log_PutDecWidth(uint32 value, uint8_t width)
+    {
+        char digits[LOG_DEC_DIGITS];
+        uint8_t count = 0;
+
+        // Least significant digit first
+        do
+        {
+            digits[count++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value);
+
+        while (width > count)
+        {
+            UartTx_PutChar(' ');
+            width--;
+        }
+        while (count)
+        {
+            UartTx_PutChar((uint8)digits[--count]);
+        }
+    }
+
+    void Log_PutDec(uint32 value)
+    {
+        Log_PutDecWidth(value, 0);
+    }
+
+/* [] END OF FILE */
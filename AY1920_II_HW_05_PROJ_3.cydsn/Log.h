@@ -0,0 +1,82 @@
+/**
+*   \file Log.h
+*   \brief Lightweight text output on UART_Debug.
+*
+*   The emitters write strings and numbers into the UART transmit buffer
+*   (UartTx.h) as they are converted: no intermediate message buffer, no
+*   heap and none of the newlib printf code. A message is built from a few calls, e.g.
+*
+*       Log_PutString("CONTROL REGISTER 1: 0x");
+*       Log_PutHex8(ctrl_reg1);
+*       Log_PutString("\r\n");
+*
+*   Messages are filtered at compile time: a message written with
+*   LOG_STRING and LOG_HEX8, or guarded by LOG_ENABLED(level), with a
+*   level above LOG_LEVEL is removed by the compiler, strings included.
+*/
+
+#ifndef __LOG_H
+    #define __LOG_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Levels of the messages.
+    */
+    #define LOG_LEVEL_NONE 0
+    #define LOG_LEVEL_ERROR 1       ///< Failures the firmware cannot recover from
+    #define LOG_LEVEL_WARNING 2     ///< Fallbacks to a default or to a degraded mode
+    #define LOG_LEVEL_INFO 3        ///< Configuration applied at boot
+    #define LOG_LEVEL_DEBUG 4
+
+    /**
+    *   \brief Highest level of the messages compiled in.
+    */
+    #ifndef LOG_LEVEL
+        #define LOG_LEVEL LOG_LEVEL_INFO
+    #endif
+
+    /**
+    *   \brief Check at compile time whether the messages of a level are compiled in.
+    */
+    #define LOG_ENABLED(level) ((level) <= LOG_LEVEL)
+
+    /**
+    *   \brief Print out a string of a given level.
+    */
+    #define LOG_STRING(level, string) \
+        do { if (LOG_ENABLED(level)) { Log_PutString(string); } } while (0)
+
+    /**
+    *   \brief Print out a byte in hexadecimal, of a given level.
+    */
+    #define LOG_HEX8(level, value) \
+        do { if (LOG_ENABLED(level)) { Log_PutHex8(value); } } while (0)
+
+    /**
+    *   \brief Write a NUL-terminated string.
+    */
+    void Log_PutString(const char* string);
+
+    /**
+    *   \brief Write at most max_length characters of a string.
+    */
+    void Log_PutStringN(const char* string, uint8_t max_length);
+
+    /**
+    *   \brief Write a byte as two uppercase hexadecimal digits.
+    */
+    void Log_PutHex8(uint8_t value);
+
+    /**
+    *   \brief Write an unsigned integer in decimal.
+    */
+    void Log_PutDec(uint32 value);
+
+    /**
+    *   \brief Write an unsigned integer in decimal, right-aligned on width characters.
+    */
+    void Log_PutDecWidth(uint32 value, uint8_t width);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,183 @@
+/*
+* This file includes the source code of the deferred
+* log events.
+*/
+
+#include "LogEvent.h"
+#include "ErrorCodes.h"
+#include "Acquisition.h"
+#include "UartTx.h"
+#include "project.h"
+
+#if LOG_EVENT_BINARY
+
+/**
+*   \brief Frames waiting to be sent, as a circular buffer.
+*/
+static uint8_t log_buffer[LOG_EVENT_BUFFER_SIZE];
+static uint16 log_head;         ///< Next byte written
+static uint16 log_tail;         ///< First byte of the oldest frame
+static uint16 log_used;         ///< Bytes in the buffer
+static uint32 log_dropped_pending;  ///< Events dropped since the last LOG_EVENTS_DROPPED event
+
+#else
+
+/**
+*   \brief Formats of the messages, for the expansion on the device.
+*/
+static const char* const log_formats[LOG_MESSAGE_COUNT] = {
+    #define LOG_MESSAGE(id, level, format) format,
+    LOG_MESSAGES
+    #undef LOG_MESSAGE
+};
+
+#endif
+
+/**
+*   \brief Events dropped because the buffer was full.
+*/
+static uint32 log_dropped;
+
+#if LOG_EVENT_BINARY
+
+    /**
+    *   \brief Encode an event into a frame.
+    *
+    *   \retval Length of the frame.
+    */
+    static uint8_t LogEvent_Encode(LogEvent_Id id, const uint32* args, uint8_t arg_count, uint8_t* frame)
+    {
+        uint8_t index = 3;
+
+        frame[0] = LOG_EVENT_HEADER;
+        frame[1] = (uint8_t)id;
+        for (uint8_t a = 0; (a < arg_count) && (a < LOG_EVENT_MAX_ARGS); a++)
+        {
+            uint32 value = args[a];
+
+            // LEB128: small values, the most frequent ones, take a single byte
+            while (value >= 0x80)
+            {
+                frame[index++] = (uint8_t)(value | 0x80);
+                value >>= 7;
+            }
+            frame[index++] = (uint8_t)value;
+        }
+        frame[2] = index - 3;
+        frame[index++] = ACQUISITION_FOOTER;
+        return index;
+    }
+
+    /**
+    *   \brief Copy a frame into the circular buffer.
+    *
+    *   \retval Returns ERROR if the buffer has no room for the frame.
+    */
+    static ErrorCode LogEvent_Queue(const uint8_t* frame, uint8_t length)
+    {
+        if (log_used + length > LOG_EVENT_BUFFER_SIZE)
+        {
+            return ERROR;
+        }
+        for (uint8_t i = 0; i < length; i++)
+        {
+            log_buffer[log_head] = frame[i];
+            log_head = (log_head + 1) % LOG_EVENT_BUFFER_SIZE;
+        }
+        log_used += length;
+        return NO_ERROR;
+    }
+
+    void LogEvent_Put(LogEvent_Id id, const uint32* args, uint8_t arg_count)
+    {
+        uint8_t frame[LOG_EVENT_MAX_FRAME_LENGTH];
+
+        // The drops are reported before the first event queued after them
+        if (log_dropped_pending)
+        {
+            uint8_t length = LogEvent_Encode(LOG_EVENTS_DROPPED, &log_dropped_pending, 1, frame);
+
+            if (LogEvent_Queue(frame, length) == NO_ERROR)
+            {
+                log_dropped_pending = 0;
+            }
+        }
+
+        uint8_t length = LogEvent_Encode(id, args, arg_count, frame);
+
+        if ((log_dropped_pending != 0) || (LogEvent_Queue(frame, length) != NO_ERROR))
+        {
+            log_dropped++;
+            log_dropped_pending++;
+        }
+    }
+
+    void LogEvent_Flush(uint8_t room)
+    {
+        uint8_t frame[LOG_EVENT_MAX_FRAME_LENGTH];
+
+        while (log_used)
+        {
+            uint8_t length = log_buffer[(log_tail + 2) % LOG_EVENT_BUFFER_SIZE] + 4;
+
+            if (length > room)
+            {
+                return;
+            }
+            for (uint8_t i = 0; i < length; i++)
+            {
+                frame[i] = log_buffer[log_tail];
+                log_tail = (log_tail + 1) % LOG_EVENT_BUFFER_SIZE;
+            }
+            log_used -= length;
+            room -= length;
+            UartTx_PutArray(frame, length);
+        }
+    }
+
+#else
+
+    void LogEvent_Put(LogEvent_Id id, const uint32* args, uint8_t arg_count)
+    {
+        const char* format = log_formats[id];
+        uint8_t a = 0;
+
+        // Text mode: the event is printed out at once
+        for (; *format; format++)
+        {
+            if ((format[0] == '%') && ((format[1] == 'u') || (format[1] == 'x')))
+            {
+                uint32 value = (a < arg_count) ? args[a] : 0;
+
+                if (format[1] == 'x')
+                {
+                    Log_PutHex8((uint8_t)value);
+                }
+                else
+                {
+                    Log_PutDec(value);
+                }
+                a++;
+                format++;
+            }
+            else
+            {
+                UartTx_PutChar((uint8_t)*format);
+            }
+        }
+        Log_PutString("\r\n");
+    }
+
+    void LogEvent_Flush(uint8_t room)
+    {
+        (void)room;
+    }
+
+#endif
+
+    uint32 LogEvent_GetDropped(void)
+    {
+        return log_dropped;
+    }
+
+/* [] END OF FILE */
@@ -0,0 +1,113 @@
+/**
+*   \file LogEvent.h
+*   \brief Deferred log events, sent as tagged binary frames.
+*
+*   A log event is a message identifier from the string table
+*   (LogMessages.h) and its raw arguments: no text is formatted or
+*   stored in the firmware. The frame is queued in a RAM buffer and
+*   sent later by LogEvent_Flush, between the accelerometer frames and
+*   only when the UART transmit buffer (UartTx.h) has room for it, so
+*   that logging does not delay the samples. Events that find the
+*   buffer full are dropped and counted; the count is logged once there
+*   is room again.
+*
+*   With LOG_EVENT_BINARY set to 0 the events are expanded on the
+*   device and printed out at once as text lines, as with the Log.h
+*   emitters, for use with a plain terminal.
+*/
+
+#ifndef __LOG_EVENT_H
+    #define __LOG_EVENT_H
+
+    #include "cytypes.h"
+    #include "LogMessages.h"
+
+    /**
+    *   \brief Send the events as binary frames (1) or as text lines (0).
+    */
+    #ifndef LOG_EVENT_BINARY
+        #define LOG_EVENT_BINARY 1
+    #endif
+
+    /**
+    *   \brief Header of the log frames.
+    *
+    *   The header is followed by the message identifier, the length of
+    *   the arguments and the arguments, each one as an unsigned LEB128
+    *   varint (7 bits per byte, least significant first, bit 7 set on
+    *   all bytes but the last), then the footer.
+    */
+    #define LOG_EVENT_HEADER 0xA5
+
+    /**
+    *   \brief Maximum number of arguments of an event.
+    */
+    #define LOG_EVENT_MAX_ARGS 6
+
+    /**
+    *   \brief Maximum length of a log frame: header, identifier, length, arguments and footer.
+    */
+    #define LOG_EVENT_MAX_FRAME_LENGTH (4 + LOG_EVENT_MAX_ARGS*5)
+
+    /**
+    *   \brief Size of the buffer of the frames waiting to be sent.
+    */
+    #define LOG_EVENT_BUFFER_SIZE 256
+
+    /**
+    *   \brief Identifiers of the messages.
+    */
+    typedef enum {
+        #define LOG_MESSAGE(id, level, format) id,
+        LOG_MESSAGES
+        #undef LOG_MESSAGE
+        LOG_MESSAGE_COUNT
+    } LogEvent_Id;
+
+    /**
+    *   \brief Levels of the messages, as <id>_LEVEL.
+    */
+    typedef enum {
+        #define LOG_MESSAGE(id, level, format) id##_LEVEL = (level),
+        LOG_MESSAGES
+        #undef LOG_MESSAGE
+    } LogEvent_Level;
+
+    /**
+    *   \brief Log an event, if the level given to it in LogMessages.h is compiled in.
+    *
+    *   The arguments are converted to uint32, e.g.
+    *   LOG_EVENT(LOG_CONFIG_DECIMATED, decimation).
+    */
+    #define LOG_EVENT(id, ...) \
+        do { \
+            if (LOG_ENABLED(id##_LEVEL)) \
+            { \
+                const uint32 log_event_args[] = {0, ##__VA_ARGS__}; \
+                LogEvent_Put((id), &log_event_args[1], sizeof(log_event_args)/sizeof(log_event_args[0]) - 1); \
+            } \
+        } while (0)
+
+    /**
+    *   \brief Queue an event, or print it out in text mode.
+    *
+    *   \param id Identifier of the message.
+    *   \param args Arguments of the message.
+    *   \param arg_count Number of arguments, up to LOG_EVENT_MAX_ARGS.
+    */
+    void LogEvent_Put(LogEvent_Id id, const uint32* args, uint8_t arg_count);
+
+    /**
+    *   \brief Queue the frames that fit in a budget into the UART transmit buffer.
+    *
+    *   \param room Bytes of UartTx the frames may take, at most UartTx_GetRoom().
+    */
+    void LogEvent_Flush(uint8_t room);
+
+    /**
+    *   \brief Number of events dropped because the buffer was full.
+    */
+    uint32 LogEvent_GetDropped(void);
+
+#endif
+/* [] END OF FILE */
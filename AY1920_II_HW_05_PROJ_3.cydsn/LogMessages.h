@@ -0,0 +1,41 @@
+/**
+*   \file LogMessages.h
+*   \brief String table of the log events.
+*
+*   Each entry gives the identifier, the level and the format of a
+*   message. LOG_EVENT filters the events on this level, and the host
+*   expander prints it out. The firmware only compiles the identifiers in (LogEvent.h);
+*   the host expander (Host/LogExpand) compiles the same list into its
+*   string table, so both sides must be built from the same revision.
+*
+*   Formats take %u (decimal) and %x (byte in hexadecimal) specifiers,
+*   one per argument of the event.
+*/
+
+#ifndef __LOG_MESSAGES_H
+    #define __LOG_MESSAGES_H
+
+    #include "Log.h"
+
+    #define LOG_MESSAGES \
+        LOG_MESSAGE(LOG_EVENTS_DROPPED, LOG_LEVEL_WARNING, "%u log events dropped") \
+        LOG_MESSAGE(LOG_SPI_NOT_AVAILABLE, LOG_LEVEL_WARNING, "SPI transport not available, using I2C") \
+        LOG_MESSAGE(LOG_BOOT_TIMEOUT, LOG_LEVEL_ERROR, "Timeout occurred while waiting for the LIS3DH 0x%x boot") \
+        LOG_MESSAGE(LOG_CONFIG_DEFAULTS, LOG_LEVEL_WARNING, "No valid configuration stored, writing defaults") \
+        LOG_MESSAGE(LOG_CONFIG_STORE_ERROR, LOG_LEVEL_ERROR, "Error occurred while storing the configuration") \
+        LOG_MESSAGE(LOG_CONFIG_OVER_BUDGET, LOG_LEVEL_WARNING, "Configuration exceeds the link budget, using defaults") \
+        LOG_MESSAGE(LOG_CONFIG_DECIMATED, LOG_LEVEL_INFO, "Frames decimated by %u to fit the link budget") \
+        LOG_MESSAGE(LOG_CONFIG_APPLY_ERROR, LOG_LEVEL_ERROR, "Error occurred while writing or verifying the LIS3DH 0x%x configuration") \
+        LOG_MESSAGE(LOG_PASSTHROUGH_NOT_AVAILABLE, LOG_LEVEL_WARNING, "DMA passthrough not available, sending converted frames") \
+        LOG_MESSAGE(LOG_TASKS_NOT_SCHEDULABLE, LOG_LEVEL_ERROR, "Task table not schedulable") \
+        LOG_MESSAGE(LOG_DIAG_DEVICE_CONNECTED, LOG_LEVEL_INFO, "Device 0x%x is connected") \
+        LOG_MESSAGE(LOG_DIAG_LIS3DH, LOG_LEVEL_INFO, "LIS3DH 0x%x") \
+        LOG_MESSAGE(LOG_DIAG_REGISTER, LOG_LEVEL_INFO, "Register 0x%x: 0x%x") \
+        LOG_MESSAGE(LOG_DIAG_REGISTER_SHADOW, LOG_LEVEL_INFO, "Register 0x%x: 0x%x (shadow 0x%x)") \
+        LOG_MESSAGE(LOG_DIAG_REGISTER_ERROR, LOG_LEVEL_INFO, "Register 0x%x: error occurred during I2C comm") \
+        LOG_MESSAGE(LOG_DIAG_FIRST_SAMPLE, LOG_LEVEL_INFO, "Time to first sample: %u us") \
+        LOG_MESSAGE(LOG_DIAG_LOSSES, LOG_LEVEL_INFO, "Losses: %u sensor overruns, %u tick merges, %u UART drops, %u read errors") \
+        LOG_MESSAGE(LOG_DIAG_TASK, LOG_LEVEL_INFO, "Task %u: %u runs, %u skipped, %u overruns, max %u us (WCET %u us)")
+
+#endif
+/* [] END OF FILE */
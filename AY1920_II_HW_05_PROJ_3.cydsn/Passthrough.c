@@ -0,0 +1,238 @@
+/*
+* This file includes the source code of the raw passthrough
+* of the accelerometer bursts to the UART.
+*
+* The bursts are read in place into the frame buffer, at the offset of
+* each device, and the frame is handed to the DMA channel as it is: no
+* byte of the samples is moved by the CPU after the bus transfer.
+*/
+
+#include "Passthrough.h"
+
+#if PASSTHROUGH_ENABLED
+
+#include "I2C_Interface.h"
+#include "UartTx.h"
+#include "project.h"
+#include "DMA_UART_TX.h"
+#include <stdint.h>
+
+/**
+*   \brief DMA requests: one byte per request, each request raised by the TX FIFO not full.
+*/
+#define PASSTHROUGH_DMA_BYTES_PER_BURST 1
+#define PASSTHROUGH_DMA_REQUEST_PER_BURST 1
+
+/**
+*   \brief Offset of the first burst in the frame: header and sequence number.
+*/
+#define PASSTHROUGH_PAYLOAD_OFFSET 2
+
+/**
+*   \brief Frame buffers used in turn, with their transaction descriptors.
+*/
+static uint8_t frames[2][PASSTHROUGH_MAX_FRAME_LENGTH];
+static uint8_t frame_tds[2] = {CY_DMA_INVALID_TD, CY_DMA_INVALID_TD};
+static uint8_t fill;            ///< Buffer being filled with the bursts
+static uint8_t dma_channel;
+
+/**
+*   \brief Devices read at each poll.
+*/
+static struct {
+    uint8_t address;            ///< 7-bit I2C address
+    uint8_t pending;            ///< New sample in the frame buffer
+} devices[ACQUISITION_MAX_SENSORS];
+static uint8_t device_count;
+static uint8_t failed_polls;    ///< Polls in a row with a failed device read
+
+/**
+*   \brief Layout of the bursts and of the frame.
+*/
+static uint8_t axis_mask;
+static uint8_t burst_length;
+static uint8_t frame_length;
+
+/**
+*   \brief Sequence number and decimation of the sample sets.
+*/
+static uint8_t sequence;
+static uint8_t decimation;
+static uint8_t decimation_count;
+
+    ErrorCode Passthrough_Start(const uint8_t* addresses, uint8_t sensor_count, uint8_t mask,
+                                uint8_t samples_per_frame)
+    {
+        axis_mask = mask & LIS3DH_CTRL_REG1_AXIS_MASK;
+        if (axis_mask == 0)
+        {
+            return ERROR;
+        }
+
+        device_count = (sensor_count < ACQUISITION_MAX_SENSORS) ? sensor_count : ACQUISITION_MAX_SENSORS;
+        for (uint8_t d = 0; d < device_count; d++)
+        {
+            devices[d].address = addresses[d];
+            devices[d].pending = 0;
+        }
+
+        // Status and output registers are contiguous: read from STATUS_REG to the last enabled axis
+        burst_length = ACQUISITION_BURST_LENGTH(axis_mask);
+        frame_length = PASSTHROUGH_PAYLOAD_OFFSET + device_count*burst_length + 1;
+        sequence = 0;
+        decimation = samples_per_frame ? samples_per_frame : 1;
+        decimation_count = 0;
+        fill = 0;
+
+        dma_channel = DMA_UART_TX_DmaInitialize(PASSTHROUGH_DMA_BYTES_PER_BURST, PASSTHROUGH_DMA_REQUEST_PER_BURST,
+                                                HI16(CYDEV_SRAM_BASE), HI16(CYDEV_PERIPH_BASE));
+
+        // One descriptor per buffer, set once: the frame length does not change
+        for (uint8_t b = 0; b < 2; b++)
+        {
+            frames[b][0] = PASSTHROUGH_HEADER;
+            frames[b][frame_length - 1] = ACQUISITION_FOOTER;
+
+            if (frame_tds[b] == CY_DMA_INVALID_TD)
+            {
+                frame_tds[b] = CyDmaTdAllocate();
+                if (frame_tds[b] == CY_DMA_INVALID_TD)
+                {
+                    return ERROR;
+                }
+            }
+            CyDmaTdSetConfiguration(frame_tds[b], frame_length, CY_DMA_DISABLE_TD, CY_DMA_TD_INC_SRC_ADR);
+            CyDmaTdSetAddress(frame_tds[b], LO16((uint32)(uintptr_t)frames[b]), LO16((uint32)(uintptr_t)UART_Debug_TXDATA_PTR));
+        }
+        return NO_ERROR;
+    }
+
+    uint8_t Passthrough_IsBusy(void)
+    {
+        uint8 td;
+        uint8 state;
+
+        CyDmaChStatus(dma_channel, &td, &state);
+        return state & (CY_DMA_STATUS_CHAIN_ACTIVE | CY_DMA_STATUS_TD_ACTIVE);
+    }
+
+    ErrorCode Passthrough_Poll(uint8_t* frame_sent)
+    {
+        uint8_t* frame = frames[fill];
+        uint8_t complete = 1;
+        ErrorCode result = NO_ERROR;
+
+        *frame_sent = 0;
+        Acquisition_SetSamplePolled(0);
+
+        // Devices are read back-to-back, each burst lands at its place in the frame
+        for (uint8_t d = 0; d < device_count; d++)
+        {
+            uint8_t* burst = &frame[PASSTHROUGH_PAYLOAD_OFFSET + d*burst_length];
+
+            if (!devices[d].pending)
+            {
+                ErrorCode error = I2C_Peripheral_ReadRegisterMulti(devices[d].address,
+                                                                   LIS3DH_STATUS_REG,
+                                                                   burst_length,
+                                                                   burst);
+                if (error != NO_ERROR)
+                {
+                    result = error;
+                    continue;
+                }
+                if (burst[0] & LIS3DH_STATUS_ZYXOR)
+                {
+                    Acquisition_CountSensorOverrun();
+                }
+                devices[d].pending = (burst[0] & (LIS3DH_STATUS_ZYXDA | axis_mask)) ? 1 : 0;
+                if (devices[d].pending)
+                {
+                    Acquisition_SetSamplePolled(1);
+                }
+            }
+            complete &= devices[d].pending;
+        }
+        if (result != NO_ERROR)
+        {
+            // As in Acquisition_Poll: the sample set is not held for long by a failed device
+            if (++failed_polls >= ACQUISITION_MAX_FAILED_POLLS)
+            {
+                for (uint8_t d = 0; d < device_count; d++)
+                {
+                    devices[d].pending = 0;
+                }
+                Acquisition_CountReadError();
+                failed_polls = 0;
+            }
+            return result;
+        }
+        failed_polls = 0;
+        if (!complete)
+        {
+            return NO_ERROR;
+        }
+
+        for (uint8_t d = 0; d < device_count; d++)
+        {
+            devices[d].pending = 0;
+        }
+        frame[1] = sequence++;
+        Acquisition_CountAuxSample();
+        if (++decimation_count < decimation)
+        {
+            return NO_ERROR;
+        }
+        decimation_count = 0;
+
+        // The frame must not interleave with the previous one nor with queued strings
+        if (Passthrough_IsBusy() || UartTx_GetUsed())
+        {
+            Acquisition_CountUartDrop();
+            return NO_ERROR;
+        }
+        CyDmaChSetInitialTd(dma_channel, frame_tds[fill]);
+        CyDmaChEnable(dma_channel, 1);
+        *frame_sent = 1;
+
+        // The next sample set goes into the other buffer while this one is sent
+        fill ^= 1;
+        return NO_ERROR;
+    }
+
+    uint8_t Passthrough_GetFrameLength(void)
+    {
+        return frame_length;
+    }
+
+#else
+
+    ErrorCode Passthrough_Start(const uint8_t* addresses, uint8_t sensor_count, uint8_t mask,
+                                uint8_t samples_per_frame)
+    {
+        (void)addresses;
+        (void)sensor_count;
+        (void)mask;
+        (void)samples_per_frame;
+        return ERROR;
+    }
+
+    uint8_t Passthrough_IsBusy(void)
+    {
+        return 0;
+    }
+
+    ErrorCode Passthrough_Poll(uint8_t* frame_sent)
+    {
+        *frame_sent = 0;
+        return ERROR;
+    }
+
+    uint8_t Passthrough_GetFrameLength(void)
+    {
+        return 0;
+    }
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,88 @@
+/**
+*   \file Passthrough.h
+*   \brief Raw passthrough of the accelerometer bursts to the UART.
+*
+*   In passthrough mode the samples are not converted: the burst of each
+*   device, status register included, is read straight into a framed UART
+*   transmit buffer, and a DMA channel moves the frame into the TX FIFO of
+*   UART_Debug. The CPU only stamps the header and the sequence number;
+*   gain, offset and unit conversion are left to the host.
+*
+*   Two frame buffers are used in turn, each with its own transaction
+*   descriptor: the devices are read into one buffer while the other one
+*   is being transmitted.
+*/
+
+#ifndef __PASSTHROUGH_H
+    #define __PASSTHROUGH_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+    #include "Acquisition.h"
+
+    /**
+    *   \brief DMA channel available in the design.
+    *
+    *   Set to 1 once a DMA component named DMA_UART_TX is placed in the
+    *   schematic, with its drq connected to the tx_interrupt of UART_Debug
+    *   set on TX FIFO not full. With 0 the passthrough can not be started.
+    */
+    #ifndef PASSTHROUGH_ENABLED
+        #define PASSTHROUGH_ENABLED 0
+    #endif
+
+    /**
+    *   \brief Header of the passthrough frames.
+    *
+    *   The header is followed by the sequence number of the sample set
+    *   (uint8, counting the sample sets not sent too) and by the burst of
+    *   each device: status register and output registers of the enabled
+    *   axes, as read from the device (left-justified int16, little endian).
+    */
+    #define PASSTHROUGH_HEADER 0xA4
+
+    /**
+    *   \brief Maximum length of a passthrough frame.
+    */
+    #define PASSTHROUGH_MAX_FRAME_LENGTH (3 + ACQUISITION_MAX_SENSORS*(1 + LIS3DH_AXIS_COUNT*LIS3DH_AXIS_BYTES))
+
+    /**
+    *   \brief Start the passthrough.
+    *
+    *   This function sets up the DMA channel and the descriptors of the two
+    *   frame buffers for the given devices and axes.
+    *   \param addresses 7-bit I2C addresses of the devices.
+    *   \param sensor_count Number of devices, up to ACQUISITION_MAX_SENSORS.
+    *   \param axis_mask Enabled axes, with the same encoding of CTRL_REG1 bits 2:0.
+    *   \param samples_per_frame Sample sets per frame sent (see Acquisition_SetDecimation).
+    *   \retval Returns ERROR if the DMA channel is not available.
+    */
+    ErrorCode Passthrough_Start(const uint8_t* addresses, uint8_t sensor_count, uint8_t axis_mask,
+                                uint8_t samples_per_frame);
+
+    /**
+    *   \brief Read the devices and send the frame once every device has a new sample.
+    *
+    *   Each device without a pending sample is read into the free frame
+    *   buffer. A complete frame that finds the previous one still being
+    *   transmitted, or bytes in the UART software buffer, is dropped and
+    *   counted as a UART drop; the sequence number shows the gap.
+    *   \param frame_sent Set to 1 if a frame has been handed to the DMA channel.
+    */
+    ErrorCode Passthrough_Poll(uint8_t* frame_sent);
+
+    /**
+    *   \brief Check whether a frame is being transmitted by the DMA channel.
+    *
+    *   Other UART output must wait for the end of the frame.
+    *   \retval Returns true (>0) if the channel is active.
+    */
+    uint8_t Passthrough_IsBusy(void);
+
+    /**
+    *   \brief Number of bytes of each passthrough frame.
+    */
+    uint8_t Passthrough_GetFrameLength(void);
+
+#endif
+/* [] END OF FILE */
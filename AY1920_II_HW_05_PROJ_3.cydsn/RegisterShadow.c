@@ -0,0 +1,141 @@
+/*
+* This file includes the source code of the RAM shadow of the writable
+* LIS3DH registers.
+*/
+
+#include "RegisterShadow.h"
+#include "I2C_Interface.h"
+
+/**
+*   \brief Bit of a register in the valid and dirty masks.
+*/
+#define REGISTER_SHADOW_BIT(address) (1ull << ((address) - REGISTER_SHADOW_FIRST))
+
+/**
+*   \brief Writable registers in the shadow range.
+*/
+static const uint64_t register_shadow_writable =
+    REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG0) | REGISTER_SHADOW_BIT(LIS3DH_TEMP_CFG_REG) |
+    REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG1) | REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG2) |
+    REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG3) | REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG4) |
+    REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG5) | REGISTER_SHADOW_BIT(LIS3DH_CTRL_REG6) |
+    REGISTER_SHADOW_BIT(LIS3DH_REFERENCE_REG) | REGISTER_SHADOW_BIT(LIS3DH_FIFO_CTRL_REG) |
+    REGISTER_SHADOW_BIT(LIS3DH_INT1_CFG) | REGISTER_SHADOW_BIT(LIS3DH_INT1_THS) |
+    REGISTER_SHADOW_BIT(LIS3DH_INT1_DURATION) | REGISTER_SHADOW_BIT(LIS3DH_INT2_CFG) |
+    REGISTER_SHADOW_BIT(LIS3DH_INT2_THS) | REGISTER_SHADOW_BIT(LIS3DH_INT2_DURATION) |
+    REGISTER_SHADOW_BIT(LIS3DH_CLICK_CFG) | REGISTER_SHADOW_BIT(LIS3DH_CLICK_THS) |
+    REGISTER_SHADOW_BIT(LIS3DH_TIME_LIMIT) | REGISTER_SHADOW_BIT(LIS3DH_TIME_LATENCY) |
+    REGISTER_SHADOW_BIT(LIS3DH_TIME_WINDOW) | REGISTER_SHADOW_BIT(LIS3DH_ACT_THS) |
+    REGISTER_SHADOW_BIT(LIS3DH_ACT_DUR);
+
+    void RegisterShadow_Init(RegisterShadow* shadow, uint8_t device_address)
+    {
+        shadow->device_address = device_address;
+        for (uint8_t i = 0; i < REGISTER_SHADOW_COUNT; i++)
+        {
+            shadow->reg[i] = 0;
+        }
+        shadow->valid = 0;
+        shadow->dirty = 0;
+    }
+
+    uint8_t RegisterShadow_IsWritable(uint8_t address)
+    {
+        return (address >= REGISTER_SHADOW_FIRST) && (address <= REGISTER_SHADOW_LAST) &&
+               (register_shadow_writable & REGISTER_SHADOW_BIT(address)) ? 1 : 0;
+    }
+
+    ErrorCode RegisterShadow_Set(RegisterShadow* shadow, uint8_t address, uint8_t value)
+    {
+        if (!RegisterShadow_IsWritable(address))
+        {
+            return ERROR;
+        }
+
+        uint64_t bit = REGISTER_SHADOW_BIT(address);
+        uint8_t index = address - REGISTER_SHADOW_FIRST;
+        if (!(shadow->valid & bit) || (shadow->reg[index] != value))
+        {
+            shadow->reg[index] = value;
+            shadow->valid |= bit;
+            shadow->dirty |= bit;
+        }
+        return NO_ERROR;
+    }
+
+    ErrorCode RegisterShadow_Modify(RegisterShadow* shadow, uint8_t address, uint8_t mask, uint8_t value)
+    {
+        if (!RegisterShadow_IsValid(shadow, address))
+        {
+            return ERROR;
+        }
+
+        uint8_t current = shadow->reg[address - REGISTER_SHADOW_FIRST];
+        return RegisterShadow_Set(shadow, address, (uint8_t)((current & ~mask) | (value & mask)));
+    }
+
+    uint8_t RegisterShadow_Get(const RegisterShadow* shadow, uint8_t address)
+    {
+        if ((address < REGISTER_SHADOW_FIRST) || (address > REGISTER_SHADOW_LAST))
+        {
+            return 0;
+        }
+        return shadow->reg[address - REGISTER_SHADOW_FIRST];
+    }
+
+    uint8_t RegisterShadow_IsValid(const RegisterShadow* shadow, uint8_t address)
+    {
+        return RegisterShadow_IsWritable(address) && (shadow->valid & REGISTER_SHADOW_BIT(address)) ? 1 : 0;
+    }
+
+    void RegisterShadow_Update(RegisterShadow* shadow, uint8_t first_address, uint8_t count, const uint8_t* values)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t address = first_address + i;
+            if (RegisterShadow_IsWritable(address))
+            {
+                uint64_t bit = REGISTER_SHADOW_BIT(address);
+                shadow->reg[address - REGISTER_SHADOW_FIRST] = values[i];
+                shadow->valid |= bit;
+                shadow->dirty &= ~bit;
+            }
+        }
+    }
+
+    ErrorCode RegisterShadow_Flush(RegisterShadow* shadow)
+    {
+        uint8_t index = 0;
+
+        while (shadow->dirty && (index < REGISTER_SHADOW_COUNT))
+        {
+            if (!(shadow->dirty & (1ull << index)))
+            {
+                index++;
+                continue;
+            }
+
+            // Run of contiguous dirty registers, written with a single burst
+            uint8_t first = index;
+            uint64_t run = 0;
+            while ((index < REGISTER_SHADOW_COUNT) && (shadow->dirty & (1ull << index)) &&
+                   (index - first < I2C_PERIPHERAL_MAX_WRITE_COUNT))
+            {
+                run |= 1ull << index;
+                index++;
+            }
+
+            ErrorCode error = I2C_Peripheral_WriteRegisterMulti(shadow->device_address,
+                                                                REGISTER_SHADOW_FIRST + first,
+                                                                index - first,
+                                                                &shadow->reg[first]);
+            if (error != NO_ERROR)
+            {
+                return error;
+            }
+            shadow->dirty &= ~run;
+        }
+        return NO_ERROR;
+    }
+
+/* [] END OF FILE */
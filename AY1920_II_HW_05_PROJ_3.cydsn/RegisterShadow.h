@@ -0,0 +1,113 @@
+/**
+*   \file RegisterShadow.h
+*   \brief RAM shadow of the writable LIS3DH registers.
+*
+*   The shadow holds the value of every writable register from CTRL_REG0
+*   (0x1E) to ACT_DUR (0x3F), so that registers are never read back over
+*   I2C to be compared or modified. Changed registers are marked dirty and
+*   written by RegisterShadow_Flush, which merges contiguous dirty
+*   registers into auto-increment bursts.
+*
+*   A register is valid when its shadow value is known to match the
+*   device: registers are invalid until they are written or loaded with
+*   the value read from the device.
+*/
+
+#ifndef __REGISTER_SHADOW_H
+    #define __REGISTER_SHADOW_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+    #include "LIS3DH_Registers.h"
+
+    /**
+    *   \brief Range of registers held in the shadow.
+    */
+    #define REGISTER_SHADOW_FIRST LIS3DH_CTRL_REG0
+    #define REGISTER_SHADOW_LAST LIS3DH_ACT_DUR
+    #define REGISTER_SHADOW_COUNT (REGISTER_SHADOW_LAST - REGISTER_SHADOW_FIRST + 1)
+
+    /**
+    *   \brief Shadow of the registers of a device.
+    */
+    typedef struct {
+        uint8_t device_address;             ///< 7-bit I2C address of the device
+        uint8_t reg[REGISTER_SHADOW_COUNT]; ///< Register values
+        uint64_t valid;                     ///< One bit per register: value matches the device (or is dirty)
+        uint64_t dirty;                     ///< One bit per register: value to be written
+    } RegisterShadow;
+
+    /**
+    *   \brief Initialize the shadow of a device, with every register invalid.
+    *
+    *   \param shadow Shadow to be initialized.
+    *   \param device_address 7-bit I2C address of the device.
+    */
+    void RegisterShadow_Init(RegisterShadow* shadow, uint8_t device_address);
+
+    /**
+    *   \brief Whether a register is writable and held in the shadow.
+    */
+    uint8_t RegisterShadow_IsWritable(uint8_t address);
+
+    /**
+    *   \brief Set the value of a register.
+    *
+    *   The register is marked dirty unless the shadow already holds a
+    *   valid copy of the same value. Nothing is sent over I2C.
+    *   \param shadow Shadow of the device.
+    *   \param address Address of the register.
+    *   \param value Value of the register.
+    *   \retval ERROR if the register is not writable.
+    */
+    ErrorCode RegisterShadow_Set(RegisterShadow* shadow, uint8_t address, uint8_t value);
+
+    /**
+    *   \brief Change a bitfield of a register.
+    *
+    *   \param shadow Shadow of the device.
+    *   \param address Address of the register.
+    *   \param mask Bits of the field.
+    *   \param value New value of the field (already shifted into position).
+    *   \retval ERROR if the register is not writable or its value is not known.
+    */
+    ErrorCode RegisterShadow_Modify(RegisterShadow* shadow, uint8_t address, uint8_t mask, uint8_t value);
+
+    /**
+    *   \brief Get the value of a register from the shadow.
+    *
+    *   \param shadow Shadow of the device.
+    *   \param address Address of the register.
+    *   \retval Shadow value, 0 if the register is not held in the shadow.
+    */
+    uint8_t RegisterShadow_Get(const RegisterShadow* shadow, uint8_t address);
+
+    /**
+    *   \brief Whether the shadow value of a register matches the device or is pending.
+    */
+    uint8_t RegisterShadow_IsValid(const RegisterShadow* shadow, uint8_t address);
+
+    /**
+    *   \brief Load values read from the device into the shadow.
+    *
+    *   The registers become valid and clean; addresses that are not
+    *   writable are skipped.
+    *   \param shadow Shadow of the device.
+    *   \param first_address Address of the first register read.
+    *   \param count Number of registers read.
+    *   \param values Values read from the device.
+    */
+    void RegisterShadow_Update(RegisterShadow* shadow, uint8_t first_address, uint8_t count, const uint8_t* values);
+
+    /**
+    *   \brief Write the dirty registers to the device.
+    *
+    *   Each run of contiguous dirty registers is written with a single
+    *   auto-increment burst.
+    *   \param shadow Shadow of the device.
+    *   \retval NO_ERROR, or the I2C error; registers not written stay dirty.
+    */
+    ErrorCode RegisterShadow_Flush(RegisterShadow* shadow);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,158 @@
+/*
+* This file includes all the required source code to interface
+* the LIS3DH over SPI.
+*
+* The transfer keeps the TX FIFO of SPIM fed while draining the RX FIFO,
+* with no more bytes in flight than the hardware FIFO holds, so that no
+* byte is lost whatever the size of the software buffers. The transfer is
+* bounded by a deadline measured with the cycle counter.
+*/
+
+#include "SPI_Interface.h"
+
+#if SPI_PERIPHERAL_ENABLED
+
+#include "SPIM.h"
+#include "CS_1.h"
+#include "CycleCounter.h"
+
+/**
+*   \brief Bits of the first byte of a transfer.
+*/
+#define SPI_PERIPHERAL_READ 0x80
+#define SPI_PERIPHERAL_AUTO_INCREMENT 0x40
+#define SPI_PERIPHERAL_ADDRESS_MASK 0x3F
+
+/**
+*   \brief Depth of the hardware FIFOs of SPIM.
+*/
+#define SPI_PERIPHERAL_FIFO_DEPTH 4
+
+/**
+*   \brief Value shifted out while reading.
+*/
+#define SPI_PERIPHERAL_DUMMY 0x00
+
+/**
+*   \brief Duration of a byte, in ns.
+*/
+#define SPI_PERIPHERAL_BYTE_NS (8u*1000000u/(SPI_PERIPHERAL_BIT_RATE_HZ/1000u))
+
+    ErrorCode SPI_Peripheral_Start(void)
+    {
+        CS_1_Write(1);
+        SPIM_Start();
+        return NO_ERROR;
+    }
+
+    ErrorCode SPI_Peripheral_Stop(void)
+    {
+        SPIM_Stop();
+        CS_1_Write(1);
+        return NO_ERROR;
+    }
+
+    /**
+    *   \brief Single transfer: command byte followed by count data bytes.
+    */
+    static ErrorCode SPI_Peripheral_Transfer(uint8_t command, uint8_t* read_data,
+                                             const uint8_t* write_data, uint8_t count)
+    {
+        uint32 start = CycleCounter_Read();
+        uint32 deadline_cycles = (SPI_PERIPHERAL_TIMEOUT_US + ((uint32)(count + 1)*SPI_PERIPHERAL_BYTE_NS)/1000u)
+                                 *CYCLE_COUNTER_CYCLES_PER_US;
+        uint8_t sent = 0;
+        uint8_t received = 0;
+
+        SPIM_ClearRxBuffer();
+        CS_1_Write(0);
+        SPIM_WriteTxData(command);
+
+        // The first byte received is clocked in during the command byte
+        while (received < (uint8_t)(count + 1))
+        {
+            if ((sent < count) && ((uint8_t)(sent + 1 - received) < SPI_PERIPHERAL_FIFO_DEPTH) &&
+                (SPIM_ReadTxStatus() & SPIM_STS_TX_FIFO_NOT_FULL))
+            {
+                SPIM_WriteTxData(write_data ? write_data[sent] : SPI_PERIPHERAL_DUMMY);
+                sent++;
+            }
+            if (SPIM_GetRxBufferSize())
+            {
+                uint8_t value = SPIM_ReadRxData();
+                if (received && read_data)
+                {
+                    read_data[received - 1] = value;
+                }
+                received++;
+            }
+            else if ((uint32)(CycleCounter_Read() - start) > deadline_cycles)
+            {
+                CS_1_Write(1);
+                return ERROR_SPI_TIMEOUT;
+            }
+        }
+
+        CS_1_Write(1);
+        return NO_ERROR;
+    }
+
+    ErrorCode SPI_Peripheral_ReadRegisterMulti(uint8_t register_address,
+                                               uint8_t register_count,
+                                               uint8_t* data)
+    {
+        uint8_t command = SPI_PERIPHERAL_READ | (register_address & SPI_PERIPHERAL_ADDRESS_MASK);
+        if (register_count > 1)
+        {
+            command |= SPI_PERIPHERAL_AUTO_INCREMENT;
+        }
+        return SPI_Peripheral_Transfer(command, data, NULL, register_count);
+    }
+
+    ErrorCode SPI_Peripheral_WriteRegisterMulti(uint8_t register_address,
+                                                uint8_t register_count,
+                                                const uint8_t* data)
+    {
+        uint8_t command = register_address & SPI_PERIPHERAL_ADDRESS_MASK;
+        if (register_count > 1)
+        {
+            command |= SPI_PERIPHERAL_AUTO_INCREMENT;
+        }
+        return SPI_Peripheral_Transfer(command, NULL, data, register_count);
+    }
+
+#else
+
+    ErrorCode SPI_Peripheral_Start(void)
+    {
+        return ERROR;
+    }
+
+    ErrorCode SPI_Peripheral_Stop(void)
+    {
+        return ERROR;
+    }
+
+    ErrorCode SPI_Peripheral_ReadRegisterMulti(uint8_t register_address,
+                                               uint8_t register_count,
+                                               uint8_t* data)
+    {
+        (void)register_address;
+        (void)register_count;
+        (void)data;
+        return ERROR;
+    }
+
+    ErrorCode SPI_Peripheral_WriteRegisterMulti(uint8_t register_address,
+                                                uint8_t register_count,
+                                                const uint8_t* data)
+    {
+        (void)register_address;
+        (void)register_count;
+        (void)data;
+        return ERROR;
+    }
+
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,74 @@
+/** 
+ * \file SPI_Interface.h
+ * \brief Hardware specific SPI interface to the LIS3DH.
+ *
+ * SPI backend of the transport selected with I2C_Peripheral_SetTransport:
+ * register transfers run over a SPI Master component named SPIM, with
+ * the chip select of the LIS3DH driven by the CS_1 pin for the whole
+ * transfer. The first byte of a transfer carries the RW bit (bit 7), the
+ * MS bit (bit 6, address auto-increment) and the register address.
+ *
+ * There is one chip select, so one device: the I2C address passed to
+ * the register functions is ignored.
+*/
+
+#ifndef SPI_Interface_H
+    #define SPI_Interface_H
+    
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+    
+    /**
+    *   \brief SPI backend available in the design.
+    *
+    *   Set to 1 once a SPI Master component named SPIM (mode 3, 8-bit,
+    *   MSB first) and a digital output pin named CS_1 are placed in the
+    *   schematic. With 0 the SPI transport can not be selected.
+    */
+    #ifndef SPI_PERIPHERAL_ENABLED
+        #define SPI_PERIPHERAL_ENABLED 0
+    #endif
+    
+    /**
+    *   \brief Bit rate of the SPIM component (Hz), half of its input clock.
+    *
+    *   The LIS3DH accepts up to 10 MHz; 6 MHz comes from a 12 MHz clock
+    *   derived from the 24 MHz BUS_CLK.
+    */
+    #define SPI_PERIPHERAL_BIT_RATE_HZ 6000000
+    
+    /**
+    *   \brief Deadline of a transfer, on top of the time of its bytes (us).
+    */
+    #define SPI_PERIPHERAL_TIMEOUT_US 100
+    
+    /** \brief Start the SPI peripheral, with the chip select released. */
+    ErrorCode SPI_Peripheral_Start(void);
+    
+    /** \brief Stop the SPI peripheral. */
+    ErrorCode SPI_Peripheral_Stop(void);
+    
+    /**
+    *   \brief Read consecutive registers with a single transfer.
+    *
+    *   \param register_address Address of the first register to be read.
+    *   \param register_count Number of registers to be read.
+    *   \param data Pointer to an array where data will be saved.
+    */
+    ErrorCode SPI_Peripheral_ReadRegisterMulti(uint8_t register_address,
+                                               uint8_t register_count,
+                                               uint8_t* data);
+    
+    /**
+    *   \brief Write consecutive registers with a single transfer.
+    *
+    *   \param register_address Address of the first register to be written.
+    *   \param register_count Number of registers to be written.
+    *   \param data Array of data to be written.
+    */
+    ErrorCode SPI_Peripheral_WriteRegisterMulti(uint8_t register_address,
+                                                uint8_t register_count,
+                                                const uint8_t* data);
+    
+#endif // SPI_Interface_H
+/* [] END OF FILE */
@@ -0,0 +1,158 @@
+/*
+* This file includes the source code of the cyclic executive
+* driven by the Timer interrupt.
+*/
+
+#include "Scheduler.h"
+#include "CycleCounter.h"
+#include "project.h"
+
+/**
+*   \brief Task table and its run-time state.
+*/
+static const Scheduler_Task* scheduler_tasks;
+static uint8_t scheduler_task_count;
+static uint8_t scheduler_pending[SCHEDULER_MAX_TASKS];
+static Scheduler_TaskStats scheduler_stats[SCHEDULER_MAX_TASKS];
+
+/**
+*   \brief Ticks raised by the Timer interrupt and ticks whose jobs have been released.
+*/
+static volatile uint32 scheduler_ticks;
+static uint32 scheduler_released_ticks;
+
+/**
+*   \brief Background work run when no job is pending.
+*/
+static uint8_t (*scheduler_idle)(void);
+
+    ErrorCode Scheduler_Start(const Scheduler_Task* tasks, uint8_t task_count)
+    {
+        uint32 load_ns = 0;
+
+        if ((task_count == 0) || (task_count > SCHEDULER_MAX_TASKS))
+        {
+            return ERROR;
+        }
+
+        // Average busy time per tick of the whole table, in ns so that no task rounds down to 0
+        for (uint8_t i = 0; i < task_count; i++)
+        {
+            if (tasks[i].period == 0)
+            {
+                return ERROR;
+            }
+            load_ns += (uint32)tasks[i].wcet_us*1000u/tasks[i].period;
+        }
+        if (load_ns > SCHEDULER_TICK_US*1000u)
+        {
+            return ERROR;
+        }
+
+        for (uint8_t i = 0; i < task_count; i++)
+        {
+            scheduler_pending[i] = 0;
+            scheduler_stats[i] = (Scheduler_TaskStats){0};
+        }
+        scheduler_tasks = tasks;
+        scheduler_task_count = task_count;
+        scheduler_ticks = 0;
+        scheduler_released_ticks = 0;
+
+        return NO_ERROR;
+    }
+
+    void Scheduler_Tick(void)
+    {
+        scheduler_ticks++;
+    }
+
+    void Scheduler_Run(void)
+    {
+        uint8_t next = SCHEDULER_MAX_TASKS;
+
+        // Release the jobs of every tick elapsed since the last call
+        while (scheduler_released_ticks != scheduler_ticks)
+        {
+            uint32 tick = scheduler_released_ticks++;
+
+            for (uint8_t i = 0; i < scheduler_task_count; i++)
+            {
+                const Scheduler_Task* task = &scheduler_tasks[i];
+
+                if ((tick >= task->phase) && ((tick - task->phase) % task->period == 0))
+                {
+                    scheduler_stats[i].releases++;
+                    if (scheduler_pending[i])
+                    {
+                        scheduler_stats[i].skipped++;
+                    }
+                    scheduler_pending[i] = 1;
+                }
+            }
+        }
+
+        // Highest priority pending job, table order between equal priorities
+        for (uint8_t i = 0; i < scheduler_task_count; i++)
+        {
+            if (scheduler_pending[i] &&
+                ((next == SCHEDULER_MAX_TASKS) || (scheduler_tasks[i].priority < scheduler_tasks[next].priority)))
+            {
+                next = i;
+            }
+        }
+        if (next == SCHEDULER_MAX_TASKS)
+        {
+            // Background work pending: no sleep, the releases are checked again on the next call
+            if (scheduler_idle && scheduler_idle())
+            {
+                return;
+            }
+            // Sleep until the next interrupt, unless a tick came in after the releases
+            CyGlobalIntDisable;
+            if (scheduler_released_ticks == scheduler_ticks)
+            {
+                CY_PM_WFI;
+            }
+            CyGlobalIntEnable;
+            return;
+        }
+
+        scheduler_pending[next] = 0;
+
+        uint32 start = CycleCounter_Read();
+        scheduler_tasks[next].run();
+        uint32 elapsed_us = CycleCounter_ToUs(CycleCounter_Read() - start);
+
+        scheduler_stats[next].runs++;
+        if (elapsed_us > scheduler_stats[next].max_us)
+        {
+            scheduler_stats[next].max_us = elapsed_us;
+        }
+        if (elapsed_us > scheduler_tasks[next].wcet_us)
+        {
+            scheduler_stats[next].overruns++;
+        }
+    }
+
+    void Scheduler_SetIdle(uint8_t (*idle)(void))
+    {
+        scheduler_idle = idle;
+    }
+
+    uint8_t Scheduler_GetTaskCount(void)
+    {
+        return scheduler_task_count;
+    }
+
+    const Scheduler_Task* Scheduler_GetTask(uint8_t index)
+    {
+        return &scheduler_tasks[index];
+    }
+
+    void Scheduler_GetStats(uint8_t index, Scheduler_TaskStats* stats)
+    {
+        *stats = scheduler_stats[index];
+    }
+
+/* [] END OF FILE */
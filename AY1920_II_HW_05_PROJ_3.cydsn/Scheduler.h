@@ -0,0 +1,120 @@
+/**
+*   \file Scheduler.h
+*   \brief Cyclic executive driven by the Timer interrupt.
+*
+*   The tasks are described by a constant table: each task is released
+*   every period ticks from its phase, and the pending jobs are run to
+*   completion from the main loop, highest priority first. A job never
+*   preempts another one, so a released job waits for the longest WCET of
+*   the tasks below it (the job already running), then for every job of
+*   the tasks above it released before it starts, then runs for its own
+*   WCET: that sum bounds its latency.
+*
+*   Each run is timed with the cycle counter. A run longer than the WCET
+*   of its task is counted as an overrun; a release that finds the
+*   previous job of the task still pending is counted as skipped, since
+*   the two releases are merged into a single run.
+*/
+
+#ifndef __SCHEDULER_H
+    #define __SCHEDULER_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+
+    /**
+    *   \brief Rate of the Timer interrupt (Hz), as configured in TopDesign.
+    */
+    #define SCHEDULER_TICK_HZ 300
+
+    /**
+    *   \brief Period of the Timer interrupt (us).
+    */
+    #define SCHEDULER_TICK_US (1000000u/SCHEDULER_TICK_HZ)
+
+    /**
+    *   \brief Maximum number of tasks in the table.
+    */
+    #define SCHEDULER_MAX_TASKS 8
+
+    /**
+    *   \brief Entry of the task table.
+    */
+    typedef struct {
+        const char* name;       ///< Name printed out by the diagnostics
+        void (*run)(void);      ///< Job of the task, run to completion
+        uint16_t period;        ///< Ticks between two releases
+        uint16_t phase;         ///< Tick of the first release
+        uint8_t priority;       ///< Lower value runs first
+        uint16_t wcet_us;       ///< Worst-case execution time of a job (us)
+    } Scheduler_Task;
+
+    /**
+    *   \brief Run-time statistics of a task.
+    */
+    typedef struct {
+        uint32 releases;        ///< Jobs released by the ticks
+        uint32 runs;            ///< Jobs run
+        uint32 skipped;         ///< Releases merged with a job still pending
+        uint32 overruns;        ///< Runs longer than the WCET
+        uint32 max_us;          ///< Longest run
+    } Scheduler_TaskStats;
+
+    /**
+    *   \brief Start the scheduler on a task table.
+    *
+    *   The table is checked before being used: every period must be at
+    *   least one tick and the sum of WCET/period of the tasks must fit in
+    *   the tick period.
+    *   \param tasks Task table, kept by the scheduler.
+    *   \param task_count Number of tasks, up to SCHEDULER_MAX_TASKS.
+    *   \retval Returns ERROR if the table is not schedulable.
+    */
+    ErrorCode Scheduler_Start(const Scheduler_Task* tasks, uint8_t task_count);
+
+    /**
+    *   \brief Count a tick, called by the Timer interrupt.
+    */
+    void Scheduler_Tick(void);
+
+    /**
+    *   \brief Release the jobs of the elapsed ticks and run the highest priority pending one.
+    *
+    *   This function is called repeatedly from the main loop: new releases
+    *   are taken into account between two jobs. With no job pending, the
+    *   CPU sleeps until the next interrupt.
+    */
+    void Scheduler_Run(void);
+
+    /**
+    *   \brief Set the background work run when no job is pending.
+    *
+    *   While the function returns nonzero, e.g. with bytes still waiting
+    *   for the UART FIFO, Scheduler_Run returns instead of sleeping and
+    *   the function is called again from the main loop.
+    *   \param idle Background work, NULL for none.
+    */
+    void Scheduler_SetIdle(uint8_t (*idle)(void));
+
+    /**
+    *   \brief Number of tasks in the table.
+    */
+    uint8_t Scheduler_GetTaskCount(void);
+
+    /**
+    *   \brief Entry of the task table.
+    *
+    *   \param index Index of the task in the table.
+    */
+    const Scheduler_Task* Scheduler_GetTask(uint8_t index);
+
+    /**
+    *   \brief Get the statistics of a task.
+    *
+    *   \param index Index of the task in the table.
+    *   \param stats Pointer to a structure where the statistics will be saved.
+    */
+    void Scheduler_GetStats(uint8_t index, Scheduler_TaskStats* stats);
+
+#endif
+/* [] END OF FILE */
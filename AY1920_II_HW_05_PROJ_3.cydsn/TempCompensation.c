@@ -0,0 +1,33 @@
+/*
+* This file includes the source code of the temperature compensation
+* of the accelerometer zero-g offset.
+*/
+
+#include "TempCompensation.h"
+
+static TempCompensation_Coefficients coefficients;
+static int16_t offset[LIS3DH_AXIS_COUNT];
+
+    void TempCompensation_Start(const TempCompensation_Coefficients* new_coefficients)
+    {
+        coefficients = *new_coefficients;
+
+        TempCompensation_SetTemperature(coefficients.t_ref);
+    }
+
+    void TempCompensation_SetTemperature(int16_t temperature)
+    {
+        int32 delta = (int32)temperature - coefficients.t_ref;
+
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            offset[axis] = coefficients.offset_ref[axis] + (int16_t)((coefficients.slope[axis]*delta) >> 8);
+        }
+    }
+
+    int16_t TempCompensation_GetOffset(uint8_t axis)
+    {
+        return offset[axis];
+    }
+
+/* [] END OF FILE */
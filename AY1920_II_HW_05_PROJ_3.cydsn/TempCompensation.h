@@ -0,0 +1,57 @@
+/**
+*   \file TempCompensation.h
+*   \brief Temperature compensation of the accelerometer zero-g offset.
+*
+*   The zero-g offset of each axis is modelled as a linear function of
+*   the temperature read on ADC3:
+*
+*       offset(t) = offset_ref + (slope * (t - t_ref)) / 256
+*
+*   with offsets in 12-bit output digits at the applied full scale, the
+*   temperature in ADC3 digits and the slope in 1/256 digit per ADC3 digit.
+*   The coefficients are kept in the configuration record (ConfigStore.h).
+*/
+
+#ifndef __TEMP_COMPENSATION_H
+    #define __TEMP_COMPENSATION_H
+
+    #include "cytypes.h"
+    #include "LIS3DH_Registers.h"
+
+    /**
+    *   \brief Coefficients of the offset model.
+    */
+    typedef struct {
+        int16_t t_ref;                          ///< Reference temperature (ADC3 digits)
+        int16_t offset_ref[LIS3DH_AXIS_COUNT];  ///< Offset at t_ref (digits)
+        int16_t slope[LIS3DH_AXIS_COUNT];       ///< Offset drift (1/256 digit per ADC3 digit)
+    } TempCompensation_Coefficients;
+
+    /**
+    *   \brief Set the coefficients of the model.
+    *
+    *   The offsets are computed at the reference temperature until the
+    *   first temperature reading.
+    *   \param coefficients Coefficients of the offset model.
+    */
+    void TempCompensation_Start(const TempCompensation_Coefficients* coefficients);
+
+    /**
+    *   \brief Update the temperature used by the model.
+    *
+    *   The per-axis offsets are recomputed here, so that the correction
+    *   of each sample costs a single subtraction.
+    *   \param temperature Last ADC3 reading (right-justified).
+    */
+    void TempCompensation_SetTemperature(int16_t temperature);
+
+    /**
+    *   \brief Current offset of an axis.
+    *
+    *   \param axis Axis index (0 = X, 1 = Y, 2 = Z).
+    *   \retval Offset to be subtracted from the output (digits).
+    */
+    int16_t TempCompensation_GetOffset(uint8_t axis);
+
+#endif
+/* [] END OF FILE */
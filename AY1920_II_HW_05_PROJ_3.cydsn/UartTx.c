@@ -0,0 +1,65 @@
+/*
+* This file includes the source code of the software
+* transmit buffer of UART_Debug.
+*/
+
+#include "UartTx.h"
+#include "project.h"
+
+/**
+*   \brief Bytes waiting for the hardware FIFO, as a circular buffer.
+*/
+static uint8_t uart_tx_buffer[UART_TX_BUFFER_SIZE];
+static uint8_t uart_tx_head;    ///< Next byte written
+static uint8_t uart_tx_tail;    ///< Next byte sent
+static uint8_t uart_tx_used;    ///< Bytes in the buffer
+
+    void UartTx_Start(void)
+    {
+        uart_tx_head = 0;
+        uart_tx_tail = 0;
+        uart_tx_used = 0;
+    }
+
+    uint8_t UartTx_GetRoom(void)
+    {
+        return UART_TX_BUFFER_SIZE - uart_tx_used;
+    }
+
+    uint8_t UartTx_GetUsed(void)
+    {
+        return uart_tx_used;
+    }
+
+    void UartTx_PutChar(uint8_t byte)
+    {
+        // A full buffer waits for the FIFO, as the blocking UART_Debug_PutChar does
+        while (uart_tx_used == UART_TX_BUFFER_SIZE)
+        {
+            UartTx_Service();
+        }
+        uart_tx_buffer[uart_tx_head] = byte;
+        uart_tx_head = (uart_tx_head + 1) % UART_TX_BUFFER_SIZE;
+        uart_tx_used++;
+    }
+
+    void UartTx_PutArray(const uint8_t* data, uint8_t length)
+    {
+        for (uint8_t i = 0; i < length; i++)
+        {
+            UartTx_PutChar(data[i]);
+        }
+    }
+
+    uint8_t UartTx_Service(void)
+    {
+        while (uart_tx_used && (UART_Debug_ReadTxStatus() & UART_Debug_TX_STS_FIFO_NOT_FULL))
+        {
+            UART_Debug_WriteTxData(uart_tx_buffer[uart_tx_tail]);
+            uart_tx_tail = (uart_tx_tail + 1) % UART_TX_BUFFER_SIZE;
+            uart_tx_used--;
+        }
+        return uart_tx_used;
+    }
+
+/* [] END OF FILE */
@@ -0,0 +1,61 @@
+/**
+*   \file UartTx.h
+*   \brief Software transmit buffer of UART_Debug.
+*
+*   UART_Debug is placed in TopDesign with a 4-byte TX buffer, i.e. the
+*   hardware FIFO only and no TX interrupt: UART_Debug_PutArray blocks
+*   until all but the last 4 bytes of the array are shifted out, 5 ms for
+*   a 14-byte frame at 19200 baud. The frames are instead copied into a
+*   RAM buffer, and UartTx_Service moves them into the FIFO while it is
+*   not full. The service is run by the scheduler between the jobs and
+*   instead of sleeping, so the line is kept busy with no interrupt.
+*
+*   All the output of the firmware goes through this buffer, so that the
+*   text lines never interleave with a frame.
+*/
+
+#ifndef __UART_TX_H
+    #define __UART_TX_H
+
+    #include "cytypes.h"
+    #include "ErrorCodes.h"
+
+    /**
+    *   \brief Size of the software transmit buffer.
+    */
+    #define UART_TX_BUFFER_SIZE 64
+
+    /**
+    *   \brief Empty the buffer.
+    */
+    void UartTx_Start(void);
+
+    /**
+    *   \brief Free bytes in the buffer: a frame of up to this length is queued without waiting.
+    */
+    uint8_t UartTx_GetRoom(void);
+
+    /**
+    *   \brief Bytes in the buffer, not yet in the hardware FIFO.
+    */
+    uint8_t UartTx_GetUsed(void);
+
+    /**
+    *   \brief Queue a byte, waiting for room if the buffer is full.
+    */
+    void UartTx_PutChar(uint8_t byte);
+
+    /**
+    *   \brief Queue an array, waiting for room if the buffer is full.
+    */
+    void UartTx_PutArray(const uint8_t* data, uint8_t length);
+
+    /**
+    *   \brief Move the queued bytes into the hardware FIFO while it is not full.
+    *
+    *   \retval Bytes left in the buffer: 0 once all of them are in the FIFO.
+    */
+    uint8_t UartTx_Service(void);
+
+#endif
+/* [] END OF FILE */
@@ -10,327 +10,519 @@
 // Include required header files
 #include "I2C_Interface.h"
 #include "project.h"
-#include "stdio.h"
 #include "InterruptRoutines.h"
+#include "LIS3DH_Registers.h"
+#include "Acquisition.h"
+#include "TempCompensation.h"
+#include "ConfigStore.h"
+#include "RegisterShadow.h"
+#include "Diagnostics.h"
+#include "Benchmark.h"
+#include "Scheduler.h"
+#include "LinkBudget.h"
+#include "Passthrough.h"
+#include "SPI_Interface.h"
+#include "CycleCounter.h"
+#include "UartTx.h"
+#include "LogEvent.h"
+#include "string.h"
 
 /**
-*   \brief 7-bit I2C address of the slave device.
+*   \brief Production boot mode.
+*
+*   When 1, the boot path only polls the LIS3DH BOOT bit and writes the
+*   stored configuration; the bus scan and the register dump are deferred
+*   to the diagnostics command. When 0, they are also run at boot.
+*
+*   In the simulator the first 0xA0 frame leaves 51.6 ms after the top of
+*   main() with 1, 70.4 ms with 0, and 254.5 ms with 0 and the log events
+*   printed as text (LOG_EVENT_BINARY 0), as the former boot path did.
 */
-#define LIS3DH_DEVICE_ADDRESS 0x18
+#ifndef BOOT_MODE_PRODUCTION
+    #define BOOT_MODE_PRODUCTION 1
+#endif
 
 /**
-*   \brief Address of the WHO AM I register
+*   \brief I2C bus rate: the LIS3DH supports fast mode.
 */
-#define LIS3DH_WHO_AM_I_REG_ADDR 0x0F
+#define I2C_BUS_RATE_HZ I2C_PERIPHERAL_FAST_MODE_HZ
 
 /**
-*   \brief Address of the Status register
+*   \brief Transport of the LIS3DH register transfers.
+*
+*   I2C_PERIPHERAL_TRANSPORT_SPI requires the SPI backend in the schematic
+*   (SPI_PERIPHERAL_ENABLED in SPI_Interface.h) and a single device.
 */
-#define LIS3DH_STATUS_REG 0x27
+#ifndef LIS3DH_TRANSPORT
+    #define LIS3DH_TRANSPORT I2C_PERIPHERAL_TRANSPORT_I2C
+#endif
 
 /**
-*   \brief Address of the Control register 1
+*   \brief Number of LIS3DH sampled in lockstep on the I2C bus.
+*
+*   The devices share the configuration and are told apart by the SA0 pin
+*   (lis3dh_addresses); with more than one, the frames carry all of them
+*   with a common timestamp (ACQUISITION_MULTI_HEADER).
 */
-#define LIS3DH_CTRL_REG1 0x20
+#ifndef LIS3DH_SENSOR_COUNT
+    #define LIS3DH_SENSOR_COUNT 1
+#endif
 
 /**
-*   \brief Hex value to set normal mode to the accelerator
+*   \brief Baud rate of UART_Debug, as configured in TopDesign.
 */
-#define LIS3DH_HR_MODE_CTRL_REG1 0x57  //High resolution mode, 100 Hz
+#ifndef UART_BAUD_RATE
+    #define UART_BAUD_RATE 19200
+#endif
 
+/**
+*   \brief Send the raw bursts by DMA (PASSTHROUGH_HEADER) instead of the converted samples.
+*
+*   Requires the DMA channel in the schematic (PASSTHROUGH_ENABLED in
+*   Passthrough.h); gain and temperature compensation are then left to
+*   the host.
+*/
+#ifndef LIS3DH_PASSTHROUGH
+    #define LIS3DH_PASSTHROUGH 0
+#endif
 
+/**
+*   \brief Upper bound and polling period of the wait for the LIS3DH boot.
+*/
+#define LIS3DH_BOOT_TIMEOUT_US 10000
+#define LIS3DH_BOOT_POLL_US 100
+
+/**
+*   \brief Axes to be acquired (CTRL_REG1 Xen/Yen/Zen bits).
+*
+*   Only the enabled axes are read and sent, e.g. LIS3DH_CTRL_REG1_XEN
+*   alone for a single-axis vibration probe.
+*/
+#define ACQUISITION_AXIS_MASK (LIS3DH_CTRL_REG1_XEN | LIS3DH_CTRL_REG1_YEN | LIS3DH_CTRL_REG1_ZEN)
 
 /**
-*   \brief Address of the Control register 4
+*   \brief Default value of CTRL_REG1: normal mode of the accelerator
 */
-#define LIS3DH_CTRL_REG4 0x23
+#define LIS3DH_HR_MODE_CTRL_REG1 (LIS3DH_CTRL_REG1_ODR_100HZ | ACQUISITION_AXIS_MASK)  //High resolution mode, 100 Hz
 
 /**
-*   \brief Hex value to set the FSR and activate the BDU
+*   \brief Default value of CTRL_REG4: FSR and BDU
 */
 #define LIS3DH_CTRL_REG4_BDU_ACTIVE 0x98 // [-4.0g, +4.0g] FSR, BDU active
 
 /**
-*   \brief Addresses of the Output registers 
+*   \brief Default value of TEMP_CFG_REG: auxiliary ADC and temperature sensor on ADC3
 */
-#define LIS3DH_OUT_X_L 0x28 
-#define LIS3DH_OUT_X_H 0x29 
-#define LIS3DH_OUT_Y_L 0x2A 
-#define LIS3DH_OUT_Y_H 0x2B 
-#define LIS3DH_OUT_Z_L 0x2C 
-#define LIS3DH_OUT_Z_H 0x2D 
+#define LIS3DH_TEMP_CFG_REG_ACTIVE (LIS3DH_TEMP_CFG_REG_ADC_EN | LIS3DH_TEMP_CFG_REG_TEMP_EN)
 
-#define SENSITIVITY 0.002   // senitivity = 0.002g/digit
-#define G 9.81              //gravitational acceleration = 9.81 m/s^2
-#define DECIMALS 10000      //multiplication factor to keep 4 decimals
+/**
+*   \brief Default accelerometer samples between two auxiliary ADC/temperature frames (0 disables them)
+*/
+#define ACQUISITION_AUX_DIVIDER 10  //10 Hz with ODR 100 Hz
 
+/**
+*   \brief Default configuration of the LIS3DH, from TEMP_CFG_REG to CTRL_REG6.
+*
+*   Written with a single burst and verified with a single burst read
+*   (ConfigStore_Apply).
+*/
+static const uint8_t lis3dh_default_registers[CONFIG_STORE_REG_COUNT] =
+{
+    [CONFIG_STORE_REG(LIS3DH_TEMP_CFG_REG)] = LIS3DH_TEMP_CFG_REG_ACTIVE,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG1)] = LIS3DH_HR_MODE_CTRL_REG1,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG2)] = 0x00, // high-pass filter bypassed
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG3)] = 0x00,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG4)] = LIS3DH_CTRL_REG4_BDU_ACTIVE,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG5)] = 0x00,
+    [CONFIG_STORE_REG(LIS3DH_CTRL_REG6)] = 0x00,
+};
 
-int main(void)
+/**
+*   \brief I2C addresses of the devices, SA0 low first.
+*/
+static const uint8_t lis3dh_addresses[ACQUISITION_MAX_SENSORS] =
 {
-    CyGlobalIntEnable; /* Enable global interrupts. */
+    LIS3DH_DEVICE_ADDRESS,
+    LIS3DH_DEVICE_ADDRESS_SA0_HIGH,
+};
 
-    /* Place your initialization/startup code here (e.g. MyInst_Start()) */
-    Timer_Start();
-    isr_ADC_StartEx(Custom_ISR_ADC);
-    I2C_Peripheral_Start();
-    UART_Debug_Start();
+/**
+*   \brief The SPI backend drives a single chip select (CS_1): it can not tell the devices apart.
+*/
+typedef char Main_SpiSensorCountCheck[((LIS3DH_TRANSPORT != I2C_PERIPHERAL_TRANSPORT_SPI) || (LIS3DH_SENSOR_COUNT == 1)) ? 1 : -1];
+
+/**
+*   \brief Worst-case execution times of the tasks (us).
+*
+*   Acquisition: one lockstep burst per device in fast mode, conversion
+*   and frame queued in the UART buffer. Commands: check of the UART
+*   receive buffer; the diagnostics and the benchmark run on request and
+*   are expected to overrun. Log: a few queued frames copied to the UART
+*   buffer.
+*/
+#define ACQUISITION_TASK_WCET_US (LIS3DH_SENSOR_COUNT*400)
+#define AUX_TASK_WCET_US 400
+#define COMMAND_TASK_WCET_US 100
+#define LOG_TASK_WCET_US 200
+
+/**
+*   \brief Ticks an auxiliary read due waits for a poll that read no sample: 10 ms.
+*
+*   With several devices drifting apart every poll may read a sample,
+*   the read then goes in the same tick as the accelerometer frame.
+*/
+#define AUX_MAX_POSTPONED_TICKS 3
+
+/**
+*   \brief Period of the command task: 100 ms.
+*/
+#define COMMAND_TASK_PERIOD (SCHEDULER_TICK_HZ/10)
+
+/**
+*   \brief Ticks between two loss markers sent without a data frame: 100 ms.
+*/
+#define LOSS_MARKER_PERIOD (SCHEDULER_TICK_HZ/10)
+
+/**
+*   \brief State shared by the tasks.
+*/
+static RegisterShadow lis3dh_shadow[LIS3DH_SENSOR_COUNT];
+static uint8_t OutArray[ACQUISITION_MAX_FRAME_LENGTH];
+static uint8_t AuxArray[ACQUISITION_AUX_FRAME_LENGTH];
+static uint8_t LossArray[ACQUISITION_LOSS_FRAME_LENGTH];
+static uint32 acquisition_skipped = 0;
+static uint32 first_sample_us = 0;
+static uint8_t passthrough = 0;
+static uint16_t loss_marker_wait = 0;
+static uint8_t aux_postponed = 0;
+
+
+/**
+*   \brief Admission control of a configuration against the link budget.
+*
+*   \param config Configuration record to be checked.
+*   \param transport_spi 1 if the devices are read over SPI.
+*   \param budget Pointer to a structure where the admitted link configuration will be saved.
+*   \retval Returns ERROR if the configuration cannot be carried, even decimating the frames.
+*/
+static ErrorCode LIS3DH_AdmitConfig(const ConfigStore_Record* config, uint8_t transport_spi, LinkBudget_Config* budget)
+{
+    LinkBudget_Result result;
+    uint8_t ctrl_reg1 = config->reg[CONFIG_STORE_REG(LIS3DH_CTRL_REG1)];
     
-    flag_ISR=0; //initialization of flag_ISR
+    budget->odr_hz = LinkBudget_GetOdr(ctrl_reg1);
+    budget->sensor_count = LIS3DH_SENSOR_COUNT;
+    budget->axis_mask = ctrl_reg1 & LIS3DH_CTRL_REG1_AXIS_MASK;
+    budget->transport = transport_spi ? LINK_BUDGET_TRANSPORT_SPI : LINK_BUDGET_TRANSPORT_I2C;
+    budget->bus_hz = transport_spi ? SPI_PERIPHERAL_BIT_RATE_HZ : I2C_Peripheral_GetBusRate();
+    budget->baud = UART_BAUD_RATE;
+    budget->tick_hz = SCHEDULER_TICK_HZ;
+    budget->aux_divider = (config->reg[CONFIG_STORE_REG(LIS3DH_TEMP_CFG_REG)] & LIS3DH_TEMP_CFG_REG_ADC_EN) ?
+                          config->aux_divider : 0;
+    budget->decimation = 1;
+    budget->format = (LIS3DH_PASSTHROUGH && PASSTHROUGH_ENABLED) ? LINK_BUDGET_FORMAT_RAW : LINK_BUDGET_FORMAT_CONVERTED;
     
-    CyDelay(5); //"The boot procedure is complete about 5 milliseconds after device power-up."
+    return LinkBudget_Admit(budget, &result);
+}
+
+/**
+*   \brief Wait for the end of the LIS3DH boot procedure.
+*
+*   The device does not acknowledge its address while booting, and the
+*   BOOT bit of CTRL_REG5 is cleared once the trimming parameters are loaded.
+*/
+static ErrorCode LIS3DH_WaitBoot(uint8_t device_address)
+{
+    uint8_t ctrl_reg5;
     
-    // String to print out messages on the UART
-    char message[50];
+    for (uint16_t elapsed = 0; elapsed < LIS3DH_BOOT_TIMEOUT_US; elapsed += LIS3DH_BOOT_POLL_US)
+    {
+        if ((I2C_Peripheral_ReadRegister(device_address, LIS3DH_CTRL_REG5, &ctrl_reg5) == NO_ERROR) &&
+            !(ctrl_reg5 & LIS3DH_CTRL_REG5_BOOT))
+        {
+            return NO_ERROR;
+        }
+        CyDelayUs(LIS3DH_BOOT_POLL_US);
+    }
+    return ERROR;
+}
+
+/**
+*   \brief Background work of the scheduler: the queued bytes into the UART FIFO.
+*
+*   The FIFO is left to the DMA channel while a passthrough frame is sent.
+*/
+static uint8_t UART_Service(void)
+{
+    return Passthrough_IsBusy() ? 0 : UartTx_Service();
+}
 
-    // Check which devices are present on the I2C bus
-    for (int i = 0 ; i < 128; i++)
+/**
+*   \brief Acquisition task: lockstep read of the devices and frame sent once all of them have a sample.
+*
+*   Frames are dropped rather than waiting for the UART; the losses are
+*   reported by a marker sent right before the next frame. While a device
+*   can not be read there is no next frame: the marker is then sent alone,
+*   at most every LOSS_MARKER_PERIOD ticks.
+*/
+static void Acquisition_Task(void)
+{
+    Scheduler_TaskStats stats;
+    uint8_t frame_ready;
+    
+    /*releases merged by the scheduler since the last run (acquisition is the first task)*/
+    Scheduler_GetStats(0, &stats);
+    Acquisition_CountTickMerges(stats.skipped - acquisition_skipped);
+    acquisition_skipped = stats.skipped;
+    
+    if (passthrough)
     {
-        if (I2C_Peripheral_IsDeviceConnected(i))
+        /*bursts read in place and sent by DMA, the sequence number shows the losses*/
+        if ((Passthrough_Poll(&frame_ready) == NO_ERROR) && frame_ready && (first_sample_us == 0))
         {
-            // print out the address is hex format
-            sprintf(message, "Device 0x%02X is connected\r\n", i);
-            UART_Debug_PutString(message); 
+            first_sample_us = CycleCounter_ToUs(CycleCounter_Read());
         }
-        
+        return;
     }
     
-    /******************************************/
-    /*            I2C Reading                 */
-    /******************************************/
+    /*status and samples of each device in one burst, the frame is sent once all of them are in*/
+    ErrorCode error = Acquisition_Poll(&OutArray[0], &frame_ready);
     
-    /* Read WHO AM I REGISTER register */
-    uint8_t who_am_i_reg;
-    ErrorCode error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                                  LIS3DH_WHO_AM_I_REG_ADDR, 
-                                                  &who_am_i_reg);
-    if (error == NO_ERROR)
+    if (loss_marker_wait)
     {
-        sprintf(message, "WHO AM I REG: 0x%02X [Expected: 0x33]\r\n", who_am_i_reg);
-        UART_Debug_PutString(message); 
+        loss_marker_wait--;
     }
-    else
+    if ((error != NO_ERROR) && (loss_marker_wait == 0) && Acquisition_IsLossPending() &&
+        (UartTx_GetRoom() >= ACQUISITION_LOSS_FRAME_LENGTH))
     {
-        UART_Debug_PutString("Error occurred during I2C comm\r\n");   
+        /*no data frame to carry the marker while a device fails*/
+        Acquisition_ReadLossFrame(&LossArray[0]);
+        UartTx_PutArray(LossArray, ACQUISITION_LOSS_FRAME_LENGTH);
+        loss_marker_wait = LOSS_MARKER_PERIOD;
+        return;
     }
     
-    /*      I2C Reading Status Register       */
-     
-    uint8_t status_register;
-    error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_STATUS_REG,
-                                        &status_register);
-    
-    if (error == NO_ERROR)
+    if ((error == NO_ERROR) && frame_ready)
     {
-        sprintf(message, "STATUS REGISTER: 0x%02X\r\n", status_register);
-        UART_Debug_PutString(message); 
+        uint8_t marker_length = Acquisition_IsLossPending() ? ACQUISITION_LOSS_FRAME_LENGTH : 0;
+        
+        if (UartTx_GetRoom() < marker_length + Acquisition_GetFrameLength())
+        {
+            Acquisition_CountUartDrop();
+            return;
+        }
+        if (marker_length)
+        {
+            Acquisition_ReadLossFrame(&LossArray[0]);
+            UartTx_PutArray(LossArray, ACQUISITION_LOSS_FRAME_LENGTH);
+        }
+        
+        /*send bytes to be plotted to Bridge Contol Panel*/
+        UartTx_PutArray(OutArray, Acquisition_GetFrameLength());
+        
+        if (first_sample_us == 0)
+        {
+            first_sample_us = CycleCounter_ToUs(CycleCounter_Read());
+        }
     }
-    else
+}
+
+/**
+*   \brief Auxiliary task: ADC and temperature frame, at the sub-rate of the accelerometer frames.
+*
+*   The read goes in a tick whose poll read no sample, so that it does not
+*   add to the longest acquisition ticks, unless it already waited
+*   AUX_MAX_POSTPONED_TICKS. It is also postponed while the UART buffer has
+*   no room for the frame or a passthrough frame is being transmitted.
+*/
+static void Aux_Task(void)
+{
+    if (!Acquisition_IsAuxDue())
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read status register\r\n");   
+        aux_postponed = 0;
+        return;
     }
+    if (Acquisition_IsSamplePolled() && (aux_postponed < AUX_MAX_POSTPONED_TICKS))
+    {
+        aux_postponed++;
+        return;
+    }
+    if ((UartTx_GetRoom() >= ACQUISITION_AUX_FRAME_LENGTH) && !Passthrough_IsBusy() &&
+        (Acquisition_ReadAuxFrame(&AuxArray[0]) == NO_ERROR))
+    {
+        UartTx_PutArray(AuxArray, ACQUISITION_AUX_FRAME_LENGTH);
+    }
+}
+
+/**
+*   \brief Command task: diagnostics and benchmark requested over UART.
+*/
+static void Command_Task(void)
+{
+    uint8_t command = UART_Debug_GetChar();
     
-    /******************************************/
-    /*        Read Control Register 1         */
-    /******************************************/
-    uint8_t ctrl_reg1; 
-    error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_CTRL_REG1,
-                                        &ctrl_reg1);
-    
-    if (error == NO_ERROR)
+    if (command == DIAGNOSTICS_COMMAND)
     {
-        sprintf(message, "CONTROL REGISTER 1: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
+        Diagnostics_Run(first_sample_us, lis3dh_shadow, LIS3DH_SENSOR_COUNT);
     }
-    else
+    else if (command == BENCHMARK_COMMAND)
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        Benchmark_Run();
     }
+}
+
+/**
+*   \brief Log task: queued log frames, in the room left in the UART transmit buffer by the data frames.
+*
+*   The budget is the free space of UartTx minus room for a loss marker
+*   and the next accelerometer frame, so that logging never causes a UART
+*   drop. The FIFO of UART_Debug is not counted: the service fills it.
+*/
+static void Log_Task(void)
+{
+    uint8_t room = UartTx_GetRoom();
+    uint8_t reserved = ACQUISITION_LOSS_FRAME_LENGTH + Acquisition_GetFrameLength();
     
-    /******************************************/
-    /*            I2C Writing                 */
-    /******************************************/
+    if (!Passthrough_IsBusy() && (room > reserved))
+    {
+        LogEvent_Flush(room - reserved);
+    }
+}
+
+/**
+*   \brief Task table: every tick the acquisition runs first, the auxiliary frame after it, the log last.
+*/
+static const Scheduler_Task lis3dh_tasks[] =
+{
+    {"acquisition", Acquisition_Task, 1, 0, 0, ACQUISITION_TASK_WCET_US},
+    {"aux", Aux_Task, 1, 0, 1, AUX_TASK_WCET_US},
+    {"command", Command_Task, COMMAND_TASK_PERIOD, 1, 2, COMMAND_TASK_WCET_US},
+    {"log", Log_Task, 1, 0, 3, LOG_TASK_WCET_US},
+};
+
+int main(void)
+{
+    CycleCounter_Start(); /* Time to first sample is counted from here, not from reset */
     
-        
-    UART_Debug_PutString("\r\nWriting new values..\r\n");
+    CyGlobalIntEnable; /* Enable global interrupts. */
+
+    /* Place your initialization/startup code here (e.g. MyInst_Start()) */
+    Timer_Start();
+    isr_ADC_StartEx(Custom_ISR_ADC);
+    I2C_Peripheral_Start(I2C_BUS_RATE_HZ);
+    UART_Debug_Start();
+    UartTx_Start();
+    
+    uint8_t transport_spi = (LIS3DH_TRANSPORT == I2C_PERIPHERAL_TRANSPORT_SPI);
     
-    if (ctrl_reg1 != LIS3DH_HR_MODE_CTRL_REG1)
+    if (I2C_Peripheral_SetTransport(LIS3DH_TRANSPORT) != NO_ERROR)
     {
-        ctrl_reg1 = LIS3DH_HR_MODE_CTRL_REG1;
+        LOG_EVENT(LOG_SPI_NOT_AVAILABLE);
+        transport_spi = 0;
+    }
     
-        error = I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS,
-                                             LIS3DH_CTRL_REG1,
-                                             ctrl_reg1);
+    ErrorCode error;
     
-        if (error == NO_ERROR)
-        {
-            sprintf(message, "CONTROL REGISTER 1 successfully written as: 0x%02X\r\n", ctrl_reg1);
-            UART_Debug_PutString(message); 
-        }
-        else
+    /*poll the BOOT bit instead of waiting the worst-case 5 ms boot time*/
+    for (uint8_t sensor = 0; sensor < LIS3DH_SENSOR_COUNT; sensor++)
+    {
+        if (LIS3DH_WaitBoot(lis3dh_addresses[sensor]) != NO_ERROR)
         {
-            UART_Debug_PutString("Error occurred during I2C comm to set control register 1\r\n");   
+            LOG_EVENT(LOG_BOOT_TIMEOUT, lis3dh_addresses[sensor]);
         }
     }
     
     /******************************************/
-    /*     Read Control Register 1 again      */
+    /*   Configuration from emulated EEPROM   */
     /******************************************/
-
-    error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_CTRL_REG1,
-                                        &ctrl_reg1);
     
-    if (error == NO_ERROR)
-    {
-        sprintf(message, "CONTROL REGISTER 1 after overwrite operation: 0x%02X\r\n", ctrl_reg1);
-        UART_Debug_PutString(message); 
-    }
-    else
+    ConfigStore_Record config;
+    
+    if (ConfigStore_Load(&config) != NO_ERROR)
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register 1\r\n");   
+        LOG_EVENT(LOG_CONFIG_DEFAULTS);
+        
+        memcpy(config.reg, lis3dh_default_registers, sizeof(config.reg));
+        config.aux_divider = ACQUISITION_AUX_DIVIDER;
+        config.compensation.t_ref = 0;
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            config.gain[axis] = CONFIG_STORE_GAIN_ONE;
+            config.compensation.offset_ref[axis] = 0;
+            config.compensation.slope[axis] = 0;
+        }
+        
+        if (ConfigStore_Save(&config) != NO_ERROR)
+        {
+            LOG_EVENT(LOG_CONFIG_STORE_ERROR);
+        }
     }
     
-     /******************************************/
-     /* I2C Reading Temperature sensor CFG reg */
-     /******************************************/
-
-    
-    
-    uint8_t ctrl_reg4;
-
-    error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_CTRL_REG4,
-                                        &ctrl_reg4);
+    /*admission control: frames are decimated if the UART cannot carry them, infeasible configurations are rejected*/
+    LinkBudget_Config budget;
     
-    if (error == NO_ERROR)
+    if (LIS3DH_AdmitConfig(&config, transport_spi, &budget) != NO_ERROR)
     {
-        sprintf(message, "CONTROL REGISTER 4: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        LOG_EVENT(LOG_CONFIG_OVER_BUDGET);
+        memcpy(config.reg, lis3dh_default_registers, sizeof(config.reg));
+        LIS3DH_AdmitConfig(&config, transport_spi, &budget);
     }
-    else
+    if (budget.decimation > 1)
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_EVENT(LOG_CONFIG_DECIMATED, budget.decimation);
     }
     
+    /*known-good configuration: TEMP_CFG_REG and CTRL_REG1..CTRL_REG6 in a single burst, verified with a single burst read*/
+    for (uint8_t sensor = 0; sensor < LIS3DH_SENSOR_COUNT; sensor++)
+    {
+        RegisterShadow_Init(&lis3dh_shadow[sensor], lis3dh_addresses[sensor]);
+        error = ConfigStore_Apply(&config, &lis3dh_shadow[sensor]);
+        
+        if (error != NO_ERROR)
+        {
+            LOG_EVENT(LOG_CONFIG_APPLY_ERROR, lis3dh_addresses[sensor]);
+        }
+    }
     
-    ctrl_reg4 = LIS3DH_CTRL_REG4_BDU_ACTIVE; // must be changed to the appropriate value
-    
-    error = I2C_Peripheral_WriteRegister(LIS3DH_DEVICE_ADDRESS,
-                                         LIS3DH_CTRL_REG4,
-                                         ctrl_reg4);
-    
-    error = I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_CTRL_REG4,
-                                        &ctrl_reg4);
+#if !BOOT_MODE_PRODUCTION
+    Diagnostics_Run(0, lis3dh_shadow, LIS3DH_SENSOR_COUNT);
+#endif
     
+    /*calibration: per-axis gains and temperature-compensated offsets*/
+    Acquisition_SetGain(config.gain);
+    TempCompensation_Start(&config.compensation);
     
-    if (error == NO_ERROR)
+    /*burst and frame layout follow the axes enabled in the devices, the conversion their full scale and mode*/
+    Acquisition_Start(lis3dh_addresses, LIS3DH_SENSOR_COUNT,
+                      RegisterShadow_Get(&lis3dh_shadow[0], LIS3DH_CTRL_REG1),
+                      RegisterShadow_Get(&lis3dh_shadow[0], LIS3DH_CTRL_REG4), &OutArray[0]);
+    Acquisition_SetDecimation(budget.decimation);
+    if (LIS3DH_PASSTHROUGH)
     {
-        sprintf(message, "CONTROL REGISTER 4 after being updated: 0x%02X\r\n", ctrl_reg4);
-        UART_Debug_PutString(message); 
+        if (Passthrough_Start(lis3dh_addresses, LIS3DH_SENSOR_COUNT,
+                              RegisterShadow_Get(&lis3dh_shadow[0], LIS3DH_CTRL_REG1) & LIS3DH_CTRL_REG1_AXIS_MASK,
+                              budget.decimation) == NO_ERROR)
+        {
+            passthrough = 1;
+        }
+        else
+        {
+            LOG_EVENT(LOG_PASSTHROUGH_NOT_AVAILABLE);
+        }
     }
-    else
+    Acquisition_StartAux((RegisterShadow_Get(&lis3dh_shadow[0], LIS3DH_TEMP_CFG_REG) & LIS3DH_TEMP_CFG_REG_ADC_EN) ?
+                         config.aux_divider : 0, &AuxArray[0]);
+    
+    Scheduler_SetIdle(UART_Service);
+    if (Scheduler_Start(lis3dh_tasks, sizeof(lis3dh_tasks)/sizeof(lis3dh_tasks[0])) != NO_ERROR)
     {
-        UART_Debug_PutString("Error occurred during I2C comm to read control register4\r\n");   
+        LOG_EVENT(LOG_TASKS_NOT_SCHEDULABLE);
+        LogEvent_Flush(UartTx_GetRoom());
     }
     
-    int16_t Out_accX;
-    float32 Out_accX2;
-    int16_t Out_accY;
-    float32 Out_accY2;
-    int16_t Out_accZ;
-    float32 Out_accZ2;
-    uint8_t header = 0xA0;
-    uint8_t footer = 0xC0;
-    uint8_t OutArray[14]; 
-    uint8_t acc[6];
-    
-    int32 interoX;
-    int32 interoY;
-    int32 interoZ;
-    
-    OutArray[0] = header;
-    OutArray[13] = footer;
-    
     for(;;)
     {
-        if(flag_ISR)
-        { 
-            error=I2C_Peripheral_ReadRegister(LIS3DH_DEVICE_ADDRESS,
-                                        LIS3DH_STATUS_REG,
-                                        &status_register);
-            
-            if ((error == NO_ERROR) && ((status_register) & (DATA_AVAILABLE)))
-            {
-             
-            error = I2C_Peripheral_ReadRegisterMulti(LIS3DH_DEVICE_ADDRESS,
-                                                 LIS3DH_OUT_X_L,6,
-                                                 &acc[0]);
-        
-       
-                if(error == NO_ERROR)
-                {
-                    /******************************************/
-                    /*               Acc_X                    */
-                    /******************************************/
-                    Out_accX = (int16)((acc[0] | (acc[1]<<8)))>>4;
-                    
-                    /*cast to a floating point in m/s^2 units (sensitivity=2mg/digit)*/
-                    Out_accX2= (float32)Out_accX*G*SENSITIVITY;
-                    
-                    /*multiplication by a factor of 10000 to keep 4 decimals and cast to int32*/
-                    interoX=(int32) (Out_accX2*DECIMALS);    
-                    
-                    /*divide the int32 in 4 bytes */ 
-                    OutArray[1]=(uint8_t)(interoX & 0xFF);
-                    OutArray[2]=(uint8_t)((interoX >> 8)& 0xFF);
-                    OutArray[3]=(uint8_t)((interoX >> 16)& 0xFF);
-                    OutArray[4]=(uint8_t)(interoX >> 24);
-                    
-                    /******************************************/
-                    /*               Acc_Y                    */
-                    /******************************************/
-                    Out_accY = (int16)((acc[2] | (acc[3]<<8)))>>4;
-                    
-                    /*cast to a floating point in m/s^2 units (sensitivity=2mg/digit)*/
-                    Out_accY2= (float32)Out_accY*G*SENSITIVITY;
-                    
-                    /*multiplication by a factor of 10000 to keep 4 decimals and cast to int32*/
-                    interoY=(int32) (Out_accY2*DECIMALS); 
-                    
-                    /*divide the int32 in 4 bytes */
-                    OutArray[5]=(uint8_t)(interoY & 0xFF);
-                    OutArray[6]=(uint8_t)((interoY >> 8)& 0xFF);
-                    OutArray[7]=(uint8_t)((interoY >> 16)& 0xFF);
-                    OutArray[8]=(uint8_t)(interoY >> 24);
-                    
-                    /******************************************/
-                    /*               Acc_Z                    */
-                    /******************************************/
-                    Out_accZ = (int16)((acc[4] | (acc[5]<<8)))>>4;
-                    
-                    /*cast to a floating point in m/s^2 units (sensitivity=2mg/digit)*/
-                    Out_accZ2= (float32)Out_accZ*G*SENSITIVITY;
-                    
-                    /*multiplication by a factor of 10000 to keep 4 decimals and cast to int32*/
-                    interoZ=(int32) (Out_accZ2*DECIMALS);
-                    
-                    /*divide the int32 in 4 bytes */
-                    OutArray[9]=(uint8_t)(interoZ & 0xFF);
-                    OutArray[10]=(uint8_t)((interoZ >> 8)& 0xFF);
-                    OutArray[11]=(uint8_t)((interoZ >> 16)& 0xFF);
-                    OutArray[12]=(uint8_t)(interoZ >> 24);
-                    
-                    /*send bytes to be plotted to Bridge Contol Panel*/
-                    UART_Debug_PutArray(OutArray, 14);
-                    
-                    
-                }
-            }
-        }
-        flag_ISR=0;
+        Scheduler_Run();
     }
 }
 
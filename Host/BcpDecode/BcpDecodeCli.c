@@ -0,0 +1,953 @@
+/*
+* This file includes the headless decoder of the Bridge Control Panel
+* definitions: the packets of an .iic script and the variables of an
+* .ini file are compiled into a decoding plan, and the captures are
+* decoded into CSV or binary records without the Windows GUI.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 Host/BcpDecode/BcpDecodeCli.c -o lis3dh_bcp
+*
+* The packets are the "rx8" lines of the .iic script, e.g.
+*
+*   rx8 [h=A0] @0accX @1accX @2accX @3accX ... [t=C0]
+*
+* where @N<name> is byte N (0 = least significant) of a variable and x
+* is a byte to be ignored. The .ini file gives Type (byte, int, long
+* int, float), Sign, Scale, Offset and Active of each variable: the
+* value is raw*Scale + Offset, as plotted by Bridge Control Panel.
+*
+* Output: one CSV line per packet with the active variables, or with
+* --binary one record of float64 per packet (NaN for the variables not
+* in the packet), in the column order of the CSV header.
+*/
+
+#include <getopt.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*   \brief Limits of the definitions.
+*/
+#define BCP_MAX_PACKETS 8
+#define BCP_MAX_VARIABLES 32
+#define BCP_MAX_FIELDS 32
+#define BCP_MAX_MARKER 8            ///< Bytes of a header or footer
+#define BCP_MAX_PACKET_LENGTH 128
+#define BCP_MAX_VALUE_BYTES 4
+#define BCP_NAME_LENGTH 32
+#define BCP_LINE_LENGTH 1024
+
+/**
+*   \brief Size of the input chunks and of the output buffer.
+*/
+#define BCP_CHUNK_SIZE 65536
+#define BCP_OUTPUT_SIZE (1 << 20)
+
+/**
+*   \brief Variable of the .ini file.
+*/
+typedef struct {
+    char name[BCP_NAME_LENGTH];
+    uint8_t type_bytes;             ///< 1 byte, 2 int, 4 long int and float
+    uint8_t is_float;
+    uint8_t sign;
+    uint8_t active;
+    double scale;
+    double offset;
+    int8_t decimals;                ///< Scale is 10^-decimals and offset is 0, -1 otherwise
+    int column;                     ///< Output column, -1 if not printed
+} Bcp_Variable;
+
+/**
+*   \brief Variable of a packet, compiled from its @N bytes.
+*/
+typedef struct {
+    uint8_t variable;
+    uint8_t width;                  ///< Highest byte index + 1
+    uint8_t contiguous;             ///< Bytes in order at position[0]: a little endian load
+    uint8_t position[BCP_MAX_VALUE_BYTES];
+} Bcp_Field;
+
+/**
+*   \brief Packet of the .iic script.
+*/
+typedef struct {
+    uint8_t header[BCP_MAX_MARKER];
+    uint8_t header_length;
+    uint8_t footer[BCP_MAX_MARKER];
+    uint8_t footer_length;
+    uint8_t length;                 ///< Bytes of the packet, header and footer included
+    Bcp_Field fields[BCP_MAX_FIELDS];
+    uint8_t field_count;
+} Bcp_Packet;
+
+/**
+*   \brief Definitions and decoding state.
+*/
+typedef struct {
+    Bcp_Variable variables[BCP_MAX_VARIABLES];
+    uint8_t variable_count;
+    Bcp_Packet packets[BCP_MAX_PACKETS];
+    uint8_t packet_count;
+    uint8_t first_bytes[256];       ///< Packets starting with a byte, as a bit mask
+    int first_byte;                 ///< Only first byte of the headers, -1 if more
+    int column_count;
+    uint64_t packets_decoded;
+    uint64_t skipped_bytes;
+} Bcp_Decoder;
+
+/**
+*   \brief Output options and buffer.
+*/
+typedef struct {
+    FILE* file;
+    uint8_t binary;
+    uint8_t index;                  ///< Packet number in the first column
+    char* buffer;
+    size_t length;
+} Bcp_Output;
+
+/**
+*   \brief Strip the trailing whitespace of a line.
+*/
+static void Cli_Chomp(char* line)
+{
+    size_t length = strlen(line);
+
+    while (length && ((line[length - 1] == '\n') || (line[length - 1] == '\r') || (line[length - 1] == ' ') ||
+                      (line[length - 1] == '\t')))
+    {
+        line[--length] = '\0';
+    }
+}
+
+/**
+*   \brief Index of a variable, added with the Bridge Control Panel defaults if not found.
+*
+*   \retval Index, -1 if the table is full.
+*/
+static int Cli_FindVariable(Bcp_Decoder* decoder, const char* name, size_t length)
+{
+    Bcp_Variable* variable;
+
+    if (length >= BCP_NAME_LENGTH)
+    {
+        length = BCP_NAME_LENGTH - 1;
+    }
+    for (int i = 0; i < decoder->variable_count; i++)
+    {
+        if ((strlen(decoder->variables[i].name) == length) && (strncmp(decoder->variables[i].name, name, length) == 0))
+        {
+            return i;
+        }
+    }
+    if (decoder->variable_count == BCP_MAX_VARIABLES)
+    {
+        return -1;
+    }
+    variable = &decoder->variables[decoder->variable_count];
+    memset(variable, 0, sizeof(*variable));
+    memcpy(variable->name, name, length);
+    variable->scale = 1.0;
+    variable->active = 1;
+    variable->column = -1;
+    return decoder->variable_count++;
+}
+
+/**
+*   \brief Parse the variables of an .ini file.
+*
+*   Only the VarN.* keys of [VARIABLES_SETTINGS] are used; the keys of a
+*   variable are applied once its VariableName is known.
+*   \retval 0 on success, -1 if the file can not be read.
+*/
+static int Cli_ParseIni(const char* path, Bcp_Decoder* decoder)
+{
+    FILE* file = fopen(path, "r");
+    char line[BCP_LINE_LENGTH];
+    char keys[BCP_MAX_VARIABLES + 1][6][BCP_NAME_LENGTH];      // Type, Sign, Scale, Offset, Active, VariableName
+    static const char* const key_names[6] = {"Type", "Sign", "Scale", "Offset", "Active", "VariableName"};
+    uint8_t in_variables = 0;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    memset(keys, 0, sizeof(keys));
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned number;
+        char key[BCP_NAME_LENGTH];
+        char* value;
+
+        Cli_Chomp(line);
+        if (line[0] == '[')
+        {
+            in_variables = (strcmp(line, "[VARIABLES_SETTINGS]") == 0);
+            continue;
+        }
+        value = strchr(line, '=');
+        if (!in_variables || (value == NULL) || (sscanf(line, "Var%u.%31[^=]", &number, key) != 2) ||
+            (number == 0) || (number > BCP_MAX_VARIABLES))
+        {
+            continue;
+        }
+        value++;
+        for (int k = 0; k < 6; k++)
+        {
+            if (strcmp(key, key_names[k]) == 0)
+            {
+                snprintf(keys[number][k], BCP_NAME_LENGTH, "%s", value);
+            }
+        }
+    }
+    fclose(file);
+
+    for (unsigned number = 1; number <= BCP_MAX_VARIABLES; number++)
+    {
+        const char* type = keys[number][0];
+        Bcp_Variable* variable;
+        int index;
+
+        if (keys[number][5][0] == '\0')
+        {
+            continue;
+        }
+        index = Cli_FindVariable(decoder, keys[number][5], strlen(keys[number][5]));
+        if (index < 0)
+        {
+            break;
+        }
+        variable = &decoder->variables[index];
+        variable->type_bytes = (strcmp(type, "byte") == 0) ? 1 :
+                               (strcmp(type, "int") == 0) ? 2 :
+                               ((strcmp(type, "long int") == 0) || (strcmp(type, "long") == 0) ||
+                                (strcmp(type, "float") == 0)) ? 4 : 0;
+        variable->is_float = (strcmp(type, "float") == 0);
+        variable->sign = (strcmp(keys[number][1], "True") == 0);
+        variable->scale = keys[number][2][0] ? atof(keys[number][2]) : 1.0;
+        variable->offset = atof(keys[number][3]);
+        variable->active = (strcmp(keys[number][4], "False") != 0);
+    }
+    return 0;
+}
+
+/**
+*   \brief Parse the hexadecimal bytes of a [h=..] or [t=..] marker.
+*
+*   \retval Number of bytes, -1 if malformed.
+*/
+static int Cli_ParseMarker(const char* text, size_t length, uint8_t* bytes)
+{
+    int count = 0;
+    size_t i = 0;
+
+    while (i < length)
+    {
+        char digits[3] = {0};
+        char* end;
+
+        if ((text[i] == ' ') || (text[i] == ','))
+        {
+            i++;
+            continue;
+        }
+        if ((i + 1 >= length) || (count == BCP_MAX_MARKER))
+        {
+            return -1;
+        }
+        digits[0] = text[i];
+        digits[1] = text[i + 1];
+        bytes[count++] = (uint8_t)strtoul(digits, &end, 16);
+        if (*end)
+        {
+            return -1;
+        }
+        i += 2;
+    }
+    return count;
+}
+
+/**
+*   \brief Compile an rx8 line of the .iic script into a packet.
+*
+*   \retval 0 on success, -1 if malformed.
+*/
+static int Cli_CompilePacket(Bcp_Decoder* decoder, const char* line, Bcp_Packet* packet)
+{
+    const char* p = line + 3;
+    uint8_t position = 0;
+    // Byte positions of each variable, by byte index
+    int16_t positions[BCP_MAX_VARIABLES][BCP_MAX_VALUE_BYTES];
+
+    memset(packet, 0, sizeof(*packet));
+    memset(positions, 0xFF, sizeof(positions));
+    while (*p)
+    {
+        const char* token;
+        size_t length;
+
+        while ((*p == ' ') || (*p == '\t'))
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+        token = p;
+        if (*p == '[')
+        {
+            const char* close = strchr(p, ']');
+            int count;
+
+            if ((close == NULL) || (close - p < 3) || (p[2] != '=') || ((p[1] != 'h') && (p[1] != 't')))
+            {
+                return -1;
+            }
+            if (p[1] == 'h')
+            {
+                if (position != 0)
+                {
+                    return -1;
+                }
+                count = Cli_ParseMarker(p + 3, (size_t)(close - p - 3), packet->header);
+                packet->header_length = (uint8_t)count;
+                position = (uint8_t)count;
+            }
+            else
+            {
+                count = Cli_ParseMarker(p + 3, (size_t)(close - p - 3), packet->footer);
+                packet->footer_length = (uint8_t)count;
+            }
+            if (count <= 0)
+            {
+                return -1;
+            }
+            p = close + 1;
+            continue;
+        }
+
+        while (*p && (*p != ' ') && (*p != '\t'))
+        {
+            p++;
+        }
+        length = (size_t)(p - token);
+        if (packet->footer_length || (position >= BCP_MAX_PACKET_LENGTH - BCP_MAX_MARKER))
+        {
+            // Data bytes after the footer, or too many bytes
+            return -1;
+        }
+        if ((length == 1) && ((token[0] == 'x') || (token[0] == 'X')))
+        {
+            position++;
+        }
+        else if ((length >= 3) && (token[0] == '@') && (token[1] >= '0') && (token[1] < '0' + BCP_MAX_VALUE_BYTES))
+        {
+            int variable = Cli_FindVariable(decoder, token + 2, length - 2);
+
+            if (variable < 0)
+            {
+                return -1;
+            }
+            positions[variable][token[1] - '0'] = position++;
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    if ((packet->header_length == 0) || (position == packet->header_length))
+    {
+        return -1;
+    }
+    packet->length = position + packet->footer_length;
+
+    // One field per variable of the packet, in the order of the variables
+    for (uint8_t v = 0; v < decoder->variable_count; v++)
+    {
+        Bcp_Field* field = &packet->fields[packet->field_count];
+
+        field->width = 0;
+        for (uint8_t b = 0; b < BCP_MAX_VALUE_BYTES; b++)
+        {
+            if (positions[v][b] >= 0)
+            {
+                field->width = b + 1;
+            }
+        }
+        if (field->width == 0)
+        {
+            continue;
+        }
+        field->variable = v;
+        field->contiguous = 1;
+        for (uint8_t b = 0; b < field->width; b++)
+        {
+            if (positions[v][b] < 0)
+            {
+                fprintf(stderr, "%s: byte %u of %s is missing\n", line, b, decoder->variables[v].name);
+                return -1;
+            }
+            field->position[b] = (uint8_t)positions[v][b];
+            if (field->position[b] != field->position[0] + b)
+            {
+                field->contiguous = 0;
+            }
+        }
+        packet->field_count++;
+    }
+    return 0;
+}
+
+/**
+*   \brief Parse the packets of an .iic script.
+*
+*   \retval 0 on success, -1 if the script has no valid packet.
+*/
+static int Cli_ParseIic(const char* path, Bcp_Decoder* decoder)
+{
+    FILE* file = fopen(path, "r");
+    char buffer[4*BCP_LINE_LENGTH];
+    size_t length;
+    char* line;
+
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    length = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[length] = '\0';
+
+    // Bridge Control Panel saves the script with or without a line end
+    for (line = strtok(buffer, "\r\n"); line; line = strtok(NULL, "\r\n"))
+    {
+        while ((*line == ' ') || (*line == '\t'))
+        {
+            line++;
+        }
+        Cli_Chomp(line);
+        if ((line[0] == '\0') || (line[0] == ';') || (line[0] == '#'))
+        {
+            continue;
+        }
+        if ((strncmp(line, "rx8", 3) != 0) || ((line[3] != ' ') && (line[3] != '\t')))
+        {
+            fprintf(stderr, "%s: skipped, not an rx8 packet: %s\n", path, line);
+            continue;
+        }
+        if (decoder->packet_count == BCP_MAX_PACKETS)
+        {
+            fprintf(stderr, "%s: more than %d packets\n", path, BCP_MAX_PACKETS);
+            return -1;
+        }
+        if (Cli_CompilePacket(decoder, line, &decoder->packets[decoder->packet_count]) < 0)
+        {
+            fprintf(stderr, "%s: malformed packet: %s\n", path, line);
+            return -1;
+        }
+        decoder->packet_count++;
+    }
+    if (decoder->packet_count == 0)
+    {
+        fprintf(stderr, "%s: no rx8 packet\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+*   \brief Finish the decoding plan: output columns, header lookup and fixed-point formats.
+*/
+static void Cli_Prepare(Bcp_Decoder* decoder, uint8_t all)
+{
+    decoder->first_byte = decoder->packets[0].header[0];
+    for (uint8_t p = 0; p < decoder->packet_count; p++)
+    {
+        const Bcp_Packet* packet = &decoder->packets[p];
+
+        decoder->first_bytes[packet->header[0]] |= (uint8_t)(1 << p);
+        if (packet->header[0] != decoder->first_byte)
+        {
+            decoder->first_byte = -1;
+        }
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            Bcp_Variable* variable = &decoder->variables[packet->fields[f].variable];
+
+            if ((variable->active || all) && (variable->column < 0))
+            {
+                variable->column = decoder->column_count++;
+            }
+        }
+    }
+
+    for (uint8_t v = 0; v < decoder->variable_count; v++)
+    {
+        Bcp_Variable* variable = &decoder->variables[v];
+        double power = 1.0;
+
+        variable->decimals = -1;
+        for (int8_t decimals = 0; (decimals <= 9) && !variable->is_float && (variable->offset == 0.0); decimals++)
+        {
+            if (fabs(variable->scale*power - 1.0) < 1e-9)
+            {
+                variable->decimals = decimals;
+                break;
+            }
+            power *= 10.0;
+        }
+    }
+}
+
+/**
+*   \brief Raw value of a field, sign extended from its width.
+*/
+static inline int64_t Cli_ReadField(const Bcp_Field* field, const Bcp_Variable* variable, const uint8_t* packet)
+{
+    uint32_t raw = 0;
+
+    if (field->contiguous)
+    {
+        const uint8_t* bytes = &packet[field->position[0]];
+
+        switch (field->width)
+        {
+            case 4: raw = (uint32_t)bytes[3] << 24; // fall through
+            case 3: raw |= (uint32_t)bytes[2] << 16; // fall through
+            case 2: raw |= (uint32_t)bytes[1] << 8; // fall through
+            default: raw |= bytes[0]; break;
+        }
+    }
+    else
+    {
+        for (uint8_t b = 0; b < field->width; b++)
+        {
+            raw |= (uint32_t)packet[field->position[b]] << (8*b);
+        }
+    }
+    if (variable->sign && (raw & (1u << (8*field->width - 1))))
+    {
+        return (int64_t)raw - ((int64_t)1 << (8*field->width));
+    }
+    return raw;
+}
+
+/**
+*   \brief Value of a field as plotted by Bridge Control Panel.
+*/
+static inline double Cli_FieldValue(const Bcp_Field* field, const Bcp_Variable* variable, const uint8_t* packet)
+{
+    int64_t raw = Cli_ReadField(field, variable, packet);
+
+    if (variable->is_float && (field->width == 4))
+    {
+        uint32_t bits = (uint32_t)raw;
+        float value;
+
+        memcpy(&value, &bits, sizeof(value));
+        return value*variable->scale + variable->offset;
+    }
+    return (double)raw*variable->scale + variable->offset;
+}
+
+/**
+*   \brief Write out the output buffer.
+*/
+static void Cli_Flush(Bcp_Output* output)
+{
+    if (output->length)
+    {
+        fwrite(output->buffer, 1, output->length, output->file);
+        output->length = 0;
+    }
+}
+
+/**
+*   \brief Append an integer as decimal text with the given number of decimals.
+*/
+static char* Cli_PutFixed(char* p, int64_t value, int8_t decimals)
+{
+    char digits[24];
+    int count = 0;
+    uint64_t magnitude = (value < 0) ? (uint64_t)(-value) : (uint64_t)value;
+
+    if (value < 0)
+    {
+        *p++ = '-';
+    }
+    do
+    {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude || (count <= decimals));
+    while (count)
+    {
+        *p++ = digits[--count];
+        if (count && (count == decimals))
+        {
+            *p++ = '.';
+        }
+    }
+    return p;
+}
+
+/**
+*   \brief Write out a decoded packet.
+*/
+static void Cli_Emit(const Bcp_Decoder* decoder, const Bcp_Packet* packet, const uint8_t* bytes, Bcp_Output* output)
+{
+    if (output->binary)
+    {
+        double record[BCP_MAX_VARIABLES + 1];
+        int column_offset = output->index ? 1 : 0;
+
+        if (output->index)
+        {
+            record[0] = (double)decoder->packets_decoded;
+        }
+        for (int c = 0; c < decoder->column_count; c++)
+        {
+            record[column_offset + c] = NAN;
+        }
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            const Bcp_Field* field = &packet->fields[f];
+            const Bcp_Variable* variable = &decoder->variables[field->variable];
+
+            if (variable->column >= 0)
+            {
+                record[column_offset + variable->column] = Cli_FieldValue(field, variable, bytes);
+            }
+        }
+        memcpy(&output->buffer[output->length], record, (size_t)(column_offset + decoder->column_count)*sizeof(double));
+        output->length += (size_t)(column_offset + decoder->column_count)*sizeof(double);
+    }
+    else
+    {
+        char* line = &output->buffer[output->length];
+        char* p = line;
+        int column = 0;
+
+        if (output->index)
+        {
+            p = Cli_PutFixed(p, (int64_t)decoder->packets_decoded, 0);
+            *p++ = ',';
+        }
+        // Fields are in the order of the variables, like the columns
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            const Bcp_Field* field = &packet->fields[f];
+            const Bcp_Variable* variable = &decoder->variables[field->variable];
+
+            if (variable->column < 0)
+            {
+                continue;
+            }
+            for (; column < variable->column; column++)
+            {
+                *p++ = ',';
+            }
+            if (variable->decimals >= 0)
+            {
+                p = Cli_PutFixed(p, Cli_ReadField(field, variable, bytes), variable->decimals);
+            }
+            else
+            {
+                p += sprintf(p, "%.10g", Cli_FieldValue(field, variable, bytes));
+            }
+        }
+        for (; column < decoder->column_count - 1; column++)
+        {
+            *p++ = ',';
+        }
+        *p++ = '\n';
+        output->length += (size_t)(p - line);
+    }
+    // Room for the next record: up to 24 characters per column
+    if (output->length > BCP_OUTPUT_SIZE - 32*(BCP_MAX_VARIABLES + 1))
+    {
+        Cli_Flush(output);
+    }
+}
+
+/**
+*   \brief Packet starting at a byte, with its footer in place.
+*
+*   \retval Packet, NULL if none; *undecided is set if more bytes are needed.
+*/
+static const Bcp_Packet* Cli_Match(const Bcp_Decoder* decoder, const uint8_t* data, size_t available,
+                                   uint8_t* undecided)
+{
+    uint8_t candidates = decoder->first_bytes[data[0]];
+
+    *undecided = 0;
+    for (uint8_t p = 0; candidates; p++, candidates >>= 1)
+    {
+        const Bcp_Packet* packet = &decoder->packets[p];
+
+        if (!(candidates & 1))
+        {
+            continue;
+        }
+        if (available < packet->length)
+        {
+            *undecided = 1;
+            continue;
+        }
+        if ((memcmp(data, packet->header, packet->header_length) == 0) &&
+            (memcmp(&data[packet->length - packet->footer_length], packet->footer, packet->footer_length) == 0))
+        {
+            return packet;
+        }
+    }
+    return NULL;
+}
+
+/**
+*   \brief Decode the packets of a buffer.
+*
+*   \retval Bytes consumed: the bytes after it may be the start of a packet.
+*/
+static size_t Cli_Decode(Bcp_Decoder* decoder, const uint8_t* data, size_t length, Bcp_Output* output)
+{
+    size_t position = 0;
+
+    while (position < length)
+    {
+        uint8_t undecided;
+        const Bcp_Packet* packet = Cli_Match(decoder, &data[position], length - position, &undecided);
+        size_t next;
+
+        if (packet)
+        {
+            Cli_Emit(decoder, packet, &data[position], output);
+            decoder->packets_decoded++;
+            position += packet->length;
+            continue;
+        }
+        if (undecided)
+        {
+            break;
+        }
+
+        // Skip to the next byte that may start a header
+        next = position + 1;
+        if (decoder->first_byte >= 0)
+        {
+            const uint8_t* found = memchr(&data[next], decoder->first_byte, length - next);
+
+            next = found ? (size_t)(found - data) : length;
+        }
+        else
+        {
+            while ((next < length) && !decoder->first_bytes[data[next]])
+            {
+                next++;
+            }
+        }
+        decoder->skipped_bytes += next - position;
+        position = next;
+    }
+    return position;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s --iic FILE [--ini FILE] [options] [CAPTURE...]\n"
+            "  --iic FILE        Bridge Control Panel script with the rx8 packets\n"
+            "  --ini FILE        Bridge Control Panel variable settings (type, sign, scale, offset)\n"
+            "  --output FILE     output file (default stdout)\n"
+            "  --binary          float64 records instead of CSV lines\n"
+            "  --index           packet number in the first column\n"
+            "  --all             the inactive variables too\n"
+            "  --plan            print out the compiled packets and exit\n"
+            "Without a capture, the stream is read from stdin (a serial port can be given as a capture).\n",
+            program);
+}
+
+/**
+*   \brief Print out the compiled packets.
+*/
+static void Cli_PrintPlan(const Bcp_Decoder* decoder)
+{
+    for (uint8_t p = 0; p < decoder->packet_count; p++)
+    {
+        const Bcp_Packet* packet = &decoder->packets[p];
+
+        printf("packet %u: %u bytes, header", p, packet->length);
+        for (uint8_t i = 0; i < packet->header_length; i++)
+        {
+            printf(" %02X", packet->header[i]);
+        }
+        printf(", footer");
+        for (uint8_t i = 0; i < packet->footer_length; i++)
+        {
+            printf(" %02X", packet->footer[i]);
+        }
+        printf("\n");
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            const Bcp_Field* field = &packet->fields[f];
+            const Bcp_Variable* variable = &decoder->variables[field->variable];
+
+            char bytes[4*BCP_MAX_VALUE_BYTES + 1];
+            int length = 0;
+
+            // Positions from the least significant byte
+            for (uint8_t b = 0; b < field->width; b++)
+            {
+                length += sprintf(&bytes[length], "%s%u", b ? "," : "", field->position[b]);
+            }
+            printf("  %-12s bytes %-11s %-8s %-6s x %g + %g%s\n", variable->name, bytes,
+                   variable->sign ? "signed" : "unsigned", field->contiguous ? "load" : "gather", variable->scale,
+                   variable->offset, (variable->column >= 0) ? "" : " (inactive)");
+            if (variable->type_bytes && (variable->type_bytes != field->width))
+            {
+                printf("  warning: %s is %u bytes in the packet, %u in the .ini type\n", variable->name, field->width,
+                       variable->type_bytes);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"iic", required_argument, NULL, 'i'},
+        {"ini", required_argument, NULL, 'n'},
+        {"output", required_argument, NULL, 'o'},
+        {"binary", no_argument, NULL, 'b'},
+        {"index", no_argument, NULL, 'x'},
+        {"all", no_argument, NULL, 'a'},
+        {"plan", no_argument, NULL, 'p'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    static Bcp_Decoder decoder;
+    Bcp_Output output = {stdout, 0, 0, NULL, 0};
+    const char* iic_path = NULL;
+    const char* ini_path = NULL;
+    const char* output_path = NULL;
+    uint8_t all = 0;
+    uint8_t plan = 0;
+    uint8_t* chunk;
+    size_t carry = 0;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'i': iic_path = optarg; break;
+            case 'n': ini_path = optarg; break;
+            case 'o': output_path = optarg; break;
+            case 'b': output.binary = 1; break;
+            case 'x': output.index = 1; break;
+            case 'a': all = 1; break;
+            case 'p': plan = 1; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (iic_path == NULL)
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    // The .ini first: it sets the order of the variables, as in the plot
+    if ((ini_path && (Cli_ParseIni(ini_path, &decoder) < 0)) || (Cli_ParseIic(iic_path, &decoder) < 0))
+    {
+        return 2;
+    }
+    Cli_Prepare(&decoder, all);
+    if (plan)
+    {
+        Cli_PrintPlan(&decoder);
+        return 0;
+    }
+
+    if (output_path && ((output.file = fopen(output_path, output.binary ? "wb" : "w")) == NULL))
+    {
+        perror(output_path);
+        return 2;
+    }
+    output.buffer = malloc(BCP_OUTPUT_SIZE);
+    chunk = malloc(BCP_MAX_PACKET_LENGTH + BCP_CHUNK_SIZE);
+
+    if (!output.binary)
+    {
+        const char* separator = "";
+
+        if (output.index)
+        {
+            fprintf(output.file, "packet");
+            separator = ",";
+        }
+        for (int c = 0; c < decoder.column_count; c++)
+        {
+            for (uint8_t v = 0; v < decoder.variable_count; v++)
+            {
+                if (decoder.variables[v].column == c)
+                {
+                    fprintf(output.file, "%s%s", separator, decoder.variables[v].name);
+                    separator = ",";
+                }
+            }
+        }
+        fprintf(output.file, "\n");
+    }
+
+    for (int i = optind; (i < argc) || (i == optind); i++)
+    {
+        FILE* input = (i < argc) ? fopen(argv[i], "rb") : stdin;
+        size_t length;
+
+        if (input == NULL)
+        {
+            perror(argv[i]);
+            return 2;
+        }
+        // The bytes of a packet not yet complete are kept at the start of the chunk
+        while ((length = fread(&chunk[carry], 1, BCP_CHUNK_SIZE, input)) > 0)
+        {
+            size_t used = Cli_Decode(&decoder, chunk, carry + length, &output);
+
+            carry = carry + length - used;
+            memmove(chunk, &chunk[used], carry);
+        }
+        if (input != stdin)
+        {
+            fclose(input);
+        }
+    }
+    Cli_Flush(&output);
+    if (output.file != stdout)
+    {
+        fclose(output.file);
+    }
+
+    fprintf(stderr, "%llu packets, %llu bytes skipped, %zu bytes left in a partial packet\n",
+            (unsigned long long)decoder.packets_decoded, (unsigned long long)decoder.skipped_bytes, carry);
+    if (output.binary)
+    {
+        fprintf(stderr, "records of %d float64 (little endian)\n", decoder.column_count + output.index);
+    }
+    free(chunk);
+    free(output.buffer);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,315 @@
+/*
+* This file includes the benchmark of the stream decoder (StreamDecoder.h)
+* on recorded captures: the decode rate in GB/s and frames/s.
+*
+* Build from the repository root (add -mavx2 for the 32-byte header scan):
+*
+*   g++ -std=c++17 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn -IHost/Decoder \
+*       Host/Decoder/StreamDecoder.cpp Host/Decoder/DecoderBenchCli.cpp -o lis3dh_decode_bench
+*
+* The captures are raw UART streams, e.g. from lis3dh_sim --capture or a
+* serial terminal log. Without a capture, a synthetic stream of the
+* selected format is generated. The captures are decoded again and again,
+* fed in chunks like reads from a serial port, until --bytes are decoded.
+*/
+
+#include "StreamDecoder.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <vector>
+
+static const char* const frame_names[] = {"accel", "aux", "multi", "loss", "raw", "log"};
+
+/**
+*   \brief Append a file to the stream.
+*
+*   \retval false if the file can not be read.
+*/
+static bool Cli_Load(const char* path, std::vector<uint8_t>& stream)
+{
+    FILE* file = std::fopen(path, "rb");
+    uint8_t buffer[65536];
+    size_t length;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        stream.insert(stream.end(), buffer, buffer + length);
+    }
+    std::fclose(file);
+    return true;
+}
+
+/**
+*   \brief Append a little endian value to the stream.
+*/
+static void Cli_PutLittleEndian(std::vector<uint8_t>& stream, uint32_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+    {
+        stream.push_back(static_cast<uint8_t>(value >> (8*i)));
+    }
+}
+
+/**
+*   \brief Generate a stream of the given format: one 1 g tilt sweep, an auxiliary frame every 10 samples.
+*/
+static void Cli_Synthesize(const Decoder::Config& config, uint32_t sample_count, std::vector<uint8_t>& stream)
+{
+    for (uint32_t sample = 0; sample < sample_count; sample++)
+    {
+        double angle = 2*M_PI*sample/1000.0;
+        double axes[LIS3DH_AXIS_COUNT] = {std::sin(angle), std::cos(angle), 0.1};
+
+        stream.push_back(ACQUISITION_HEADER);
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            if (config.format == Decoder::Format::Proj2)
+            {
+                Cli_PutLittleEndian(stream, static_cast<uint32_t>(static_cast<int32_t>(axes[axis]*1000)), 2);
+            }
+            else if (config.axis_mask & (1 << axis))
+            {
+                Cli_PutLittleEndian(stream, static_cast<uint32_t>(static_cast<int32_t>(axes[axis]*98066.5)), 4);
+            }
+        }
+        stream.push_back(ACQUISITION_FOOTER);
+
+        if ((config.format == Decoder::Format::Proj3) && (sample % 10 == 9))
+        {
+            stream.push_back(ACQUISITION_AUX_HEADER);
+            for (uint8_t channel = 0; channel < LIS3DH_ADC_COUNT; channel++)
+            {
+                Cli_PutLittleEndian(stream, 0x4000 + 16*channel, 2);
+            }
+            stream.push_back(ACQUISITION_FOOTER);
+        }
+    }
+}
+
+/**
+*   \brief Replace bytes of the stream with random values, the same ones at each run.
+*/
+static void Cli_AddNoise(std::vector<uint8_t>& stream, uint32_t permille)
+{
+    uint32_t state = 0x12345678;
+
+    for (uint8_t& byte : stream)
+    {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        if (state % 1000 < permille)
+        {
+            byte = static_cast<uint8_t>(state >> 24);
+        }
+    }
+}
+
+/**
+*   \brief Print out a decoded frame.
+*/
+static void Cli_PrintFrame(const Decoder::Frame& frame, double scale)
+{
+    std::printf("%-5s", frame_names[static_cast<size_t>(frame.type)]);
+    switch (frame.type)
+    {
+        case Decoder::FrameType::MultiAccel:
+            std::printf(" t=%u us", frame.timestamp_us);
+            // fall through
+        case Decoder::FrameType::Accel:
+            for (uint8_t sensor = 0; sensor < frame.sensor_count; sensor++)
+            {
+                std::printf(" [%.4f %.4f %.4f] m/s^2", frame.values[sensor][0]*scale, frame.values[sensor][1]*scale,
+                            frame.values[sensor][2]*scale);
+            }
+            break;
+        case Decoder::FrameType::Raw:
+            std::printf(" seq=%u", frame.sequence);
+            for (uint8_t sensor = 0; sensor < frame.sensor_count; sensor++)
+            {
+                std::printf(" [%d %d %d]", frame.values[sensor][0], frame.values[sensor][1], frame.values[sensor][2]);
+            }
+            break;
+        case Decoder::FrameType::Log:
+            std::printf(" id=%u", frame.log_id);
+            break;
+        case Decoder::FrameType::Loss:
+            for (uint8_t cause = 0; cause < Decoder::LOSS_CAUSE_COUNT; cause++)
+            {
+                std::printf(" %u", frame.losses[cause]);
+            }
+            break;
+        default:
+            std::printf(" %d %d %d", frame.values[0][0], frame.values[0][1], frame.values[0][2]);
+            break;
+    }
+    std::printf("\n");
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options] [CAPTURE...]\n"
+                 "  --format proj2|proj3   frame format (default proj3)\n"
+                 "  --axis-mask MASK       enabled axes, CTRL_REG1 bits 2:0 (default 7)\n"
+                 "  --sensors N            devices of the 0xA2 and 0xA4 frames (default 1)\n"
+                 "  --synthetic SAMPLES    generate a stream when no capture is given (default 100000)\n"
+                 "  --noise PERMILLE       replace bytes of the stream with random values\n"
+                 "  --chunk BYTES          bytes fed per call (default 65536)\n"
+                 "  --bytes N              bytes to decode, the stream is repeated (default 1 GB)\n"
+                 "  --scalar               search the headers one byte at a time\n"
+                 "  --dump N               print out the first N frames and exit\n",
+                 program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"format", required_argument, nullptr, 'f'},
+        {"axis-mask", required_argument, nullptr, 'a'},
+        {"sensors", required_argument, nullptr, 's'},
+        {"synthetic", required_argument, nullptr, 'y'},
+        {"noise", required_argument, nullptr, 'n'},
+        {"chunk", required_argument, nullptr, 'c'},
+        {"bytes", required_argument, nullptr, 'b'},
+        {"scalar", no_argument, nullptr, 'l'},
+        {"dump", required_argument, nullptr, 'd'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    Decoder::Config config;
+    uint32_t synthetic_samples = 100000;
+    uint32_t noise_permille = 0;
+    size_t chunk = 65536;
+    uint64_t target_bytes = 1000000000ull;
+    uint32_t dump = 0;
+    std::vector<uint8_t> stream;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                if (std::strcmp(optarg, "proj2") == 0)
+                {
+                    config.format = Decoder::Format::Proj2;
+                }
+                else if (std::strcmp(optarg, "proj3") == 0)
+                {
+                    config.format = Decoder::Format::Proj3;
+                }
+                else
+                {
+                    Cli_Usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'a': config.axis_mask = static_cast<uint8_t>(std::strtoul(optarg, nullptr, 0)); break;
+            case 's': config.sensor_count = static_cast<uint8_t>(std::atoi(optarg)); break;
+            case 'y': synthetic_samples = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'n': noise_permille = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'c': chunk = static_cast<size_t>(std::atol(optarg)); break;
+            case 'b': target_bytes = std::strtoull(optarg, nullptr, 0); break;
+            case 'l': config.simd = false; break;
+            case 'd': dump = static_cast<uint32_t>(std::atoi(optarg)); break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (chunk == 0)
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    for (int i = optind; i < argc; i++)
+    {
+        if (!Cli_Load(argv[i], stream))
+        {
+            return 2;
+        }
+    }
+    if (optind == argc)
+    {
+        Cli_Synthesize(config, synthetic_samples, stream);
+    }
+    Cli_AddNoise(stream, noise_permille);
+    if (stream.empty())
+    {
+        std::fprintf(stderr, "empty stream\n");
+        return 2;
+    }
+
+    Decoder::StreamDecoder decoder(config);
+
+    if (dump)
+    {
+        double scale = decoder.GetScale();
+
+        decoder.Feed(stream.data(), stream.size(), [&](const Decoder::Frame& frame)
+        {
+            if (dump)
+            {
+                Cli_PrintFrame(frame, scale);
+                dump--;
+            }
+        });
+        return 0;
+    }
+
+    // The sum of the values keeps the decoding from being optimized out
+    int64_t checksum = 0;
+    auto handler = [&checksum](const Decoder::Frame& frame)
+    {
+        checksum += frame.values[0][0] + frame.values[0][1] + frame.values[0][2];
+    };
+    uint64_t decoded = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (decoded < target_bytes)
+    {
+        for (size_t offset = 0; offset < stream.size(); offset += chunk)
+        {
+            size_t length = (stream.size() - offset < chunk) ? stream.size() - offset : chunk;
+
+            decoder.Feed(&stream[offset], length, handler);
+        }
+        decoded += stream.size();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const Decoder::Stats& stats = decoder.GetStats();
+    uint64_t frames = 0;
+
+    std::printf("stream   %zu bytes, decoded %llu times in chunks of %zu bytes, %s header scan\n", stream.size(),
+                static_cast<unsigned long long>(decoded/stream.size()), chunk, config.simd ? "SIMD" : "scalar");
+    for (size_t type = 0; type < static_cast<size_t>(Decoder::FrameType::Count); type++)
+    {
+        if (stats.frames[type])
+        {
+            std::printf("frames   %-5s %llu\n", frame_names[type], static_cast<unsigned long long>(stats.frames[type]));
+            frames += stats.frames[type];
+        }
+    }
+    std::printf("skipped  %llu bytes, %llu resyncs\n", static_cast<unsigned long long>(stats.skipped_bytes),
+                static_cast<unsigned long long>(stats.resyncs));
+    std::printf("rate     %.3f GB/s, %.1f Mframes/s (%.3f s, checksum %lld)\n", stats.bytes/seconds/1e9,
+                frames/seconds/1e6, seconds, static_cast<long long>(checksum));
+    return 0;
+}
+
+/* [] END OF FILE */
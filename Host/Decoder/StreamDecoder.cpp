@@ -0,0 +1,261 @@
+/*
+* This file includes the source code of the incremental decoder
+* of the UART stream of PROJ_2 and PROJ_3.
+*/
+
+#include "StreamDecoder.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+namespace Decoder
+{
+/**
+*   \brief Frame of PROJ_2: header, X, Y, Z as int16 (mg), footer.
+*/
+constexpr uint8_t PROJ2_FRAME_LENGTH = 8;
+
+/**
+*   \brief Units of the axes: mg for PROJ_2, m/s^2 x 10000 for PROJ_3.
+*/
+constexpr double PROJ2_SCALE = 9.80665e-3;
+constexpr double PROJ3_SCALE = 1e-4;
+
+/**
+*   \brief Little endian reads of the frame fields.
+*/
+static inline int32_t ReadInt16(const uint8_t* bytes)
+{
+    return static_cast<int16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static inline uint32_t ReadUint32(const uint8_t* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+    StreamDecoder::StreamDecoder(const Config& decoder_config) : config(decoder_config)
+    {
+        uint8_t last_axis = 0;
+        uint8_t low = 0xFF;
+        uint8_t high = 0;
+
+        config.axis_mask &= LIS3DH_CTRL_REG1_AXIS_MASK;
+        if (config.axis_mask == 0)
+        {
+            config.axis_mask = LIS3DH_CTRL_REG1_AXIS_MASK;
+        }
+        if ((config.sensor_count == 0) || (config.sensor_count > ACQUISITION_MAX_SENSORS))
+        {
+            config.sensor_count = 1;
+        }
+        axis_count = 0;
+        for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+        {
+            if (config.axis_mask & (1 << axis))
+            {
+                axis_count++;
+                last_axis = axis;
+            }
+        }
+        burst_length = 1 + (last_axis + 1)*LIS3DH_AXIS_BYTES;
+
+        std::memset(header_length, 0, sizeof(header_length));
+        if (config.format == Format::Proj2)
+        {
+            header_length[ACQUISITION_HEADER] = PROJ2_FRAME_LENGTH;
+        }
+        else
+        {
+            header_length[ACQUISITION_HEADER] = 2 + axis_count*ACQUISITION_BYTES_PER_AXIS;
+            header_length[ACQUISITION_AUX_HEADER] = ACQUISITION_AUX_FRAME_LENGTH;
+            header_length[ACQUISITION_MULTI_HEADER] = 2 + ACQUISITION_TIMESTAMP_BYTES +
+                                                      config.sensor_count*axis_count*ACQUISITION_BYTES_PER_AXIS;
+            header_length[ACQUISITION_LOSS_HEADER] = ACQUISITION_LOSS_FRAME_LENGTH;
+            header_length[PASSTHROUGH_HEADER] = 3 + config.sensor_count*burst_length;
+            header_length[LOG_EVENT_HEADER] = LOG_FRAME_VARIABLE;
+        }
+        for (unsigned byte = 0; byte < 256; byte++)
+        {
+            if (header_length[byte])
+            {
+                low = (byte < low) ? byte : low;
+                high = (byte > high) ? byte : high;
+            }
+        }
+        header_low = low;
+        header_span = high - low;
+        Reset();
+    }
+
+    void StreamDecoder::Reset()
+    {
+        carry_length = 0;
+        locked = false;
+        stats = Stats();
+    }
+
+    double StreamDecoder::GetScale() const
+    {
+        return (config.format == Format::Proj2) ? PROJ2_SCALE : PROJ3_SCALE;
+    }
+
+    const uint8_t* StreamDecoder::FindCandidate(const uint8_t* begin, const uint8_t* end) const
+    {
+        const uint8_t* p = begin;
+
+        // A byte is a candidate if (byte - header_low) <= header_span, unsigned
+        if (config.simd)
+        {
+#if defined(__AVX2__)
+            const __m256i low = _mm256_set1_epi8(static_cast<char>(header_low));
+            const __m256i span = _mm256_set1_epi8(static_cast<char>(header_span));
+
+            for (; end - p >= 32; p += 32)
+            {
+                __m256i offset = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), low);
+                uint32_t mask = static_cast<uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(offset, span), offset)));
+
+                if (mask)
+                {
+                    return p + __builtin_ctz(mask);
+                }
+            }
+#elif defined(__SSE2__)
+            const __m128i low = _mm_set1_epi8(static_cast<char>(header_low));
+            const __m128i span = _mm_set1_epi8(static_cast<char>(header_span));
+
+            for (; end - p >= 16; p += 16)
+            {
+                __m128i offset = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), low);
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(offset, span),
+                                                                                      offset)));
+
+                if (mask)
+                {
+                    return p + __builtin_ctz(mask);
+                }
+            }
+#elif defined(__ARM_NEON)
+            const uint8x16_t low = vdupq_n_u8(header_low);
+            const uint8x16_t span = vdupq_n_u8(header_span);
+
+            for (; end - p >= 16; p += 16)
+            {
+                uint8x16_t hit = vcleq_u8(vsubq_u8(vld1q_u8(p), low), span);
+                // Narrow each byte to 4 bits: 64-bit mask, 4 bits per byte
+                uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+
+                if (mask)
+                {
+                    return p + (__builtin_ctzll(mask) >> 2);
+                }
+            }
+#endif
+        }
+        for (; p < end; p++)
+        {
+            if (static_cast<uint8_t>(*p - header_low) <= header_span)
+            {
+                return p;
+            }
+        }
+        return end;
+    }
+
+    void StreamDecoder::DecodeFrame(const uint8_t* bytes, uint8_t length, Frame& frame) const
+    {
+        const uint8_t* field = &bytes[1];
+
+        frame.length = length;
+        frame.bytes = bytes;
+        frame.sensor_count = 1;
+        frame.sequence = 0;
+        frame.log_id = 0;
+        frame.timestamp_us = 0;
+        std::memset(frame.values, 0, sizeof(frame.values));
+
+        if (config.format == Format::Proj2)
+        {
+            frame.type = FrameType::Accel;
+            for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+            {
+                frame.values[0][axis] = ReadInt16(&field[axis*2]);
+            }
+            return;
+        }
+
+        switch (bytes[0])
+        {
+            case ACQUISITION_MULTI_HEADER:
+                frame.timestamp_us = ReadUint32(field);
+                field += ACQUISITION_TIMESTAMP_BYTES;
+                frame.sensor_count = config.sensor_count;
+                // fall through
+            case ACQUISITION_HEADER:
+                frame.type = (bytes[0] == ACQUISITION_HEADER) ? FrameType::Accel : FrameType::MultiAccel;
+                for (uint8_t sensor = 0; sensor < frame.sensor_count; sensor++)
+                {
+                    for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+                    {
+                        if (config.axis_mask & (1 << axis))
+                        {
+                            frame.values[sensor][axis] = static_cast<int32_t>(ReadUint32(field));
+                            field += ACQUISITION_BYTES_PER_AXIS;
+                        }
+                    }
+                }
+                break;
+
+            case ACQUISITION_AUX_HEADER:
+                frame.type = FrameType::Aux;
+                for (uint8_t channel = 0; channel < LIS3DH_ADC_COUNT; channel++)
+                {
+                    frame.values[0][channel] = ReadInt16(&field[channel*2]);
+                }
+                break;
+
+            case ACQUISITION_LOSS_HEADER:
+                frame.type = FrameType::Loss;
+                frame.lost = 0;
+                for (uint8_t cause = 0; cause < LOSS_CAUSE_COUNT; cause++)
+                {
+                    frame.losses[cause] = field[cause];
+                    frame.lost += field[cause];
+                }
+                break;
+
+            case PASSTHROUGH_HEADER:
+                // Sequence number, then status register and output registers of each device
+                frame.type = FrameType::Raw;
+                frame.sequence = field[0];
+                frame.sensor_count = config.sensor_count;
+                for (uint8_t sensor = 0; sensor < frame.sensor_count; sensor++)
+                {
+                    const uint8_t* burst = &field[1 + sensor*burst_length];
+
+                    for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+                    {
+                        if (config.axis_mask & (1 << axis))
+                        {
+                            frame.values[sensor][axis] = ReadInt16(&burst[1 + axis*LIS3DH_AXIS_BYTES]);
+                        }
+                    }
+                }
+                break;
+
+            default:
+                frame.type = FrameType::Log;
+                frame.log_id = field[0];
+                break;
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,269 @@
+/**
+*   \file StreamDecoder.h
+*   \brief Incremental decoder of the UART stream of PROJ_2 and PROJ_3.
+*
+*   The decoder is fed with the stream in chunks of any size, as read from
+*   a serial port or a capture file, and calls a handler for each frame
+*   found. Frame lengths and constants come from the firmware headers of
+*   PROJ_3 (Acquisition.h, Passthrough.h, LogEvent.h), so the decoder is
+*   built from the same revision as the firmware.
+*
+*   A frame is accepted when its header is followed, at the length given
+*   by the header, by the 0xC0 footer. Any other byte is skipped: the next
+*   candidate header is searched with SIMD compares (SSE2/AVX2 on x86,
+*   NEON on ARM), 16 or 32 bytes at a time. A frame split between two
+*   chunks is completed in a small fixed buffer; nothing is allocated
+*   while decoding.
+*/
+
+#ifndef __STREAM_DECODER_H
+    #define __STREAM_DECODER_H
+
+    #include "Acquisition.h"
+    #include "Passthrough.h"
+    #include "LogEvent.h"
+    #include <cstddef>
+    #include <cstdint>
+    #include <cstring>
+
+    namespace Decoder
+    {
+        /**
+        *   \brief Wire format of the accelerometer frames.
+        */
+        enum class Format : uint8_t
+        {
+            Proj2,      ///< 0xA0, X, Y, Z as int16 (mg), 0xC0
+            Proj3,      ///< 0xA0..0xA5 frames of Acquisition.h, axes as int32 (m/s^2 x 10000)
+        };
+
+        /**
+        *   \brief Frames recognized in the stream.
+        */
+        enum class FrameType : uint8_t
+        {
+            Accel,      ///< 0xA0, a sample of one device
+            Aux,        ///< 0xA1, ADC1..ADC3
+            MultiAccel, ///< 0xA2, timestamp and a sample of each device
+            Loss,       ///< 0xA3, sensor overruns, tick merges, UART drops, read errors
+            Raw,        ///< 0xA4, sequence number and the bursts as read
+            Log,        ///< 0xA5, log event (expanded by Host/LogExpand)
+            Count
+        };
+
+        /**
+        *   \brief Layout of the stream, as configured on the device.
+        */
+        struct Config
+        {
+            Format format = Format::Proj3;
+            uint8_t axis_mask = 0x07;       ///< Enabled axes, CTRL_REG1 bits 2:0 (PROJ_3)
+            uint8_t sensor_count = 1;       ///< Devices of the 0xA2 and 0xA4 frames (PROJ_3)
+            bool simd = true;               ///< Search the headers with SIMD compares
+        };
+
+        /**
+        *   \brief Causes counted by the loss markers (PROJ_3), one byte each.
+        */
+        constexpr uint8_t LOSS_CAUSE_COUNT = PACKET_LOSS_SAMPLE_LENGTH;
+
+        /**
+        *   \brief Frame decoded, valid during the call of the handler.
+        */
+        struct Frame
+        {
+            FrameType type;
+            uint8_t length;                 ///< Bytes of the frame, header and footer included
+            const uint8_t* bytes;           ///< Frame as received
+            uint8_t sensor_count;           ///< Devices in values
+            uint8_t sequence;               ///< Sequence number (Raw)
+            uint8_t log_id;                 ///< Message identifier (Log)
+            uint32_t timestamp_us;          ///< Timestamp of the poll (MultiAccel)
+
+            /**
+            *   Accel, MultiAccel: axes in mg (PROJ_2) or m/s^2 x 10000 (PROJ_3),
+            *   0 for the disabled axes. Raw: output registers as read
+            *   (left-justified). Aux: ADC1..ADC3.
+            */
+            int32_t values[ACQUISITION_MAX_SENSORS][LIS3DH_AXIS_COUNT];
+            uint8_t losses[LOSS_CAUSE_COUNT];   ///< Loss: samples lost by cause, in the order of PACKET_LOSS_FIELDS
+            uint32_t lost;                      ///< Loss: sum of the causes
+        };
+
+        /**
+        *   \brief Counters of the decoder, since start or the last Reset.
+        */
+        struct Stats
+        {
+            uint64_t bytes;                 ///< Bytes fed
+            uint64_t frames[static_cast<size_t>(FrameType::Count)];
+            uint64_t skipped_bytes;         ///< Bytes outside the frames
+            uint64_t resyncs;               ///< Times the decoder lost the frame boundary
+        };
+
+        /**
+        *   \brief Longest frame of any format.
+        */
+        constexpr size_t MAX_FRAME_LENGTH = 64;
+
+        static_assert(ACQUISITION_MAX_FRAME_LENGTH <= MAX_FRAME_LENGTH, "frame buffer too small");
+        static_assert(PASSTHROUGH_MAX_FRAME_LENGTH <= MAX_FRAME_LENGTH, "frame buffer too small");
+        static_assert(LOG_EVENT_MAX_FRAME_LENGTH <= MAX_FRAME_LENGTH, "frame buffer too small");
+
+        /**
+        *   \brief Decoder of one stream.
+        */
+        class StreamDecoder
+        {
+        public:
+            explicit StreamDecoder(const Config& config);
+
+            /**
+            *   \brief Decode a chunk of the stream.
+            *
+            *   The handler is called with a const Frame& for each complete
+            *   frame. The bytes of a frame not yet complete are kept until
+            *   the next call.
+            */
+            template <typename Handler>
+            void Feed(const uint8_t* data, size_t length, Handler&& handler);
+
+            /**
+            *   \brief Forget the partial frame and clear the counters.
+            */
+            void Reset();
+
+            const Stats& GetStats() const { return stats; }
+
+            /**
+            *   \brief Acceleration of one unit of Frame::values (m/s^2).
+            */
+            double GetScale() const;
+
+            /**
+            *   \brief First byte in [begin, end) that may be a header, end if none.
+            *
+            *   Only the range of the header bytes is compared; the caller
+            *   checks the byte found against the header table.
+            */
+            const uint8_t* FindCandidate(const uint8_t* begin, const uint8_t* end) const;
+
+        private:
+            /**
+            *   \brief Decode the frames of a buffer.
+            *
+            *   \retval Bytes consumed: the bytes after it may be the start of a frame.
+            */
+            template <typename Handler>
+            size_t Parse(const uint8_t* data, size_t length, Handler& handler);
+
+            void DecodeFrame(const uint8_t* bytes, uint8_t length, Frame& frame) const;
+
+            Config config;
+            uint8_t header_length[256];     ///< Frame length by header byte, 0 if not a header
+            uint8_t header_low;             ///< Lowest header byte
+            uint8_t header_span;            ///< Highest minus lowest header byte
+            uint8_t axis_count;
+            uint8_t burst_length;           ///< Status and output registers of a Raw burst
+            uint8_t carry[2*MAX_FRAME_LENGTH];
+            size_t carry_length;
+            bool locked;                    ///< Last byte consumed ended a frame
+            Stats stats;
+        };
+
+        /**
+        *   \brief Entry of the header table for the log events, whose length is in the frame.
+        */
+        constexpr uint8_t LOG_FRAME_VARIABLE = 0xFF;
+
+        template <typename Handler>
+        size_t StreamDecoder::Parse(const uint8_t* data, size_t length, Handler& handler)
+        {
+            size_t position = 0;
+
+            while (position < length)
+            {
+                uint8_t header = data[position];
+                size_t frame_length = header_length[header];
+
+                if (frame_length == LOG_FRAME_VARIABLE)
+                {
+                    // 0xA5, identifier, argument length, arguments, 0xC0
+                    if (length - position < 3)
+                    {
+                        break;
+                    }
+                    frame_length = 4u + data[position + 2];
+                    if (frame_length > LOG_EVENT_MAX_FRAME_LENGTH)
+                    {
+                        frame_length = 0;
+                    }
+                }
+                if (frame_length)
+                {
+                    if (length - position < frame_length)
+                    {
+                        break;
+                    }
+                    if (data[position + frame_length - 1] == ACQUISITION_FOOTER)
+                    {
+                        Frame frame;
+
+                        DecodeFrame(&data[position], static_cast<uint8_t>(frame_length), frame);
+                        stats.frames[static_cast<size_t>(frame.type)]++;
+                        handler(static_cast<const Frame&>(frame));
+                        position += frame_length;
+                        locked = true;
+                        continue;
+                    }
+                }
+
+                // Not a frame: skip to the next candidate header
+                const uint8_t* next = FindCandidate(&data[position + 1], &data[length]);
+                size_t skipped = static_cast<size_t>(next - &data[position]);
+
+                if (locked)
+                {
+                    stats.resyncs++;
+                    locked = false;
+                }
+                stats.skipped_bytes += skipped;
+                position += skipped;
+            }
+            return position;
+        }
+
+        template <typename Handler>
+        void StreamDecoder::Feed(const uint8_t* data, size_t length, Handler&& handler)
+        {
+            stats.bytes += length;
+
+            if (carry_length)
+            {
+                // Complete the partial frame with the head of the chunk
+                size_t taken = (length < MAX_FRAME_LENGTH) ? length : MAX_FRAME_LENGTH;
+                size_t used;
+
+                std::memcpy(&carry[carry_length], data, taken);
+                used = Parse(carry, carry_length + taken, handler);
+                if (used < carry_length)
+                {
+                    // Still undecided: the whole chunk is in the carry buffer
+                    carry_length += taken - used;
+                    std::memmove(carry, &carry[used], carry_length);
+                    return;
+                }
+                data += used - carry_length;
+                length -= used - carry_length;
+                carry_length = 0;
+            }
+
+            size_t used = Parse(data, length, handler);
+
+            carry_length = length - used;
+            std::memcpy(carry, &data[used], carry_length);
+        }
+    }
+
+#endif
+/* [] END OF FILE */
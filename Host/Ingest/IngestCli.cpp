@@ -0,0 +1,526 @@
+/*
+* This file includes the ingestion service of many boards
+* (IngestService.h) and its benchmark on simulated boards.
+*
+* Build from the repository root:
+*
+*   g++ -std=c++17 -O2 -pthread -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn \
+*       -IHost/Decoder -IHost/Recorder -IHost/Replay -IHost/Ingest \
+*       Host/Decoder/StreamDecoder.cpp Host/Recorder/CaptureFile.cpp Host/Replay/VirtualSerial.cpp \
+*       Host/Ingest/IngestService.cpp Host/Ingest/IngestCli.cpp -o lis3dh_ingest
+*
+* The arguments are the serial ports of the boards (/dev/ttyACM0...),
+* all sending the same format. The service runs until every port is
+* closed, SIGINT/SIGTERM or --duration-ms, and prints a line per port:
+* bytes, samples, resyncs, samples lost, and the latency from the read
+* to the merge. --output-dir records a capture file per port; --merged
+* writes the samples of all the ports, in time order, as CSV.
+*
+* --bench N replaces the ports with N ptys fed in the same process, as
+* lis3dh_replay does: captures given as arguments, or 0xA2 frames with
+* a timestamp of a different origin per board (one near the uint32
+* wrap). --scaling runs the benchmark with 1, 2, 4... N boards.
+*/
+
+#include "IngestService.h"
+#include "VirtualSerial.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+static volatile sig_atomic_t cli_stop = 0;
+
+/**
+*   \brief Options of a run.
+*/
+struct Cli_Options
+{
+    Ingest::DeviceConfig device;
+    unsigned threads = 2;
+    const char* output_dir = nullptr;
+    const char* merged_path = nullptr;
+    uint32_t report_ms = 0;
+    uint32_t duration_ms = 0;
+    uint32_t merge_ms = 10;
+    double speed = 1.0;
+    uint32_t bench_seconds = 10;
+    size_t ring_samples = Ingest::DEFAULT_RING_SAMPLES;
+    bool verbose = false;
+};
+
+/**
+*   \brief Results of a run, for the summary.
+*/
+struct Cli_Totals
+{
+    double seconds = 0.0;
+    double cpu_seconds = 0.0;
+    uint64_t bytes = 0;
+    uint64_t samples = 0;
+    uint64_t merged = 0;
+    uint64_t order_errors = 0;      ///< Merged samples earlier than the previous one
+    uint64_t resyncs = 0;
+    uint64_t ring_overflows = 0;
+    Ingest::LatencyHistogram latency;
+};
+
+static void Cli_Signal(int)
+{
+    cli_stop = 1;
+}
+
+/**
+*   \brief CPU time of the process or of the calling thread.
+*/
+static double Cli_CpuSeconds(int who)
+{
+    struct rusage usage;
+
+    getrusage(who, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1e6;
+}
+
+/**
+*   \brief Append a little endian value to the stream.
+*/
+static void Cli_PutLittleEndian(std::vector<uint8_t>& stream, uint32_t value, uint8_t bytes)
+{
+    for (uint8_t i = 0; i < bytes; i++)
+    {
+        stream.push_back(static_cast<uint8_t>(value >> (8*i)));
+    }
+}
+
+/**
+*   \brief Generate the 0xA2 frames of a board: a 1 g tilt sweep, timestamps from an origin.
+*/
+static void Cli_Synthesize(const Ingest::DeviceConfig& config, uint32_t sample_count, uint32_t origin_us,
+                           double phase, std::vector<uint8_t>& stream)
+{
+    uint32_t period_us = 1000000/std::max<uint32_t>(config.odr_hz, 1);
+
+    for (uint32_t sample = 0; sample < sample_count; sample++)
+    {
+        double angle = 2*M_PI*sample/1000.0 + phase;
+        double axes[LIS3DH_AXIS_COUNT] = {std::sin(angle), std::cos(angle), 0.1};
+
+        stream.push_back(ACQUISITION_MULTI_HEADER);
+        Cli_PutLittleEndian(stream, origin_us + sample*period_us, ACQUISITION_TIMESTAMP_BYTES);
+        for (uint8_t sensor = 0; sensor < config.decoder.sensor_count; sensor++)
+        {
+            for (uint8_t axis = 0; axis < LIS3DH_AXIS_COUNT; axis++)
+            {
+                if (config.decoder.axis_mask & (1 << axis))
+                {
+                    Cli_PutLittleEndian(stream, static_cast<uint32_t>(static_cast<int32_t>(axes[axis]*98066.5)),
+                                        ACQUISITION_BYTES_PER_AXIS);
+                }
+            }
+        }
+        stream.push_back(ACQUISITION_FOOTER);
+    }
+}
+
+/**
+*   \brief Print the line of a port.
+*/
+static void Cli_PrintDevice(const Ingest::Service& service, size_t device, double seconds)
+{
+    Ingest::DeviceStats stats = service.GetStats(device);
+    const Ingest::LatencyHistogram& latency = service.GetLatency(device);
+
+    std::printf("%-14s %8.1f kB/s %9llu samples %9llu merged %4llu resyncs %4llu lost %4llu overflows"
+                "  latency p50 %.2f p99 %.2f max %.2f ms%s\n",
+                service.GetPath(device).c_str(), seconds > 0 ? stats.bytes/seconds/1e3 : 0.0,
+                static_cast<unsigned long long>(stats.samples), static_cast<unsigned long long>(stats.merged),
+                static_cast<unsigned long long>(stats.resyncs), static_cast<unsigned long long>(stats.losses),
+                static_cast<unsigned long long>(stats.ring_overflows), latency.GetPercentileMs(0.5),
+                latency.GetPercentileMs(0.99), latency.GetMaxMs(), stats.open ? "" : " (closed)");
+}
+
+/**
+*   \brief Merge until the ports are closed, a signal or the duration; then report.
+*/
+static bool Cli_Ingest(Ingest::Service& service, const Cli_Options& options, Cli_Totals& totals)
+{
+    FILE* merged_file = nullptr;
+    int64_t last_time_us = INT64_MIN;
+    auto start = std::chrono::steady_clock::now();
+    auto next_report = start + std::chrono::milliseconds(options.report_ms);
+    double cpu_start = Cli_CpuSeconds(RUSAGE_SELF);
+
+    if (options.merged_path)
+    {
+        merged_file = std::fopen(options.merged_path, "w");
+        if (merged_file == nullptr)
+        {
+            std::perror(options.merged_path);
+            return false;
+        }
+    }
+
+    auto handler = [&](const Ingest::Sample& sample)
+    {
+        if (sample.time_us < last_time_us)
+        {
+            totals.order_errors++;
+        }
+        last_time_us = sample.time_us;
+        if (merged_file)
+        {
+            std::fprintf(merged_file, "%lld,%u", static_cast<long long>(sample.time_us), sample.device);
+            for (uint8_t value = 0; value < sample.sensor_count*LIS3DH_AXIS_COUNT; value++)
+            {
+                std::fprintf(merged_file, ",%d", sample.values[value]);
+            }
+            std::fputc('\n', merged_file);
+        }
+    };
+
+    if (!service.Start(options.threads))
+    {
+        std::perror("epoll");
+        return false;
+    }
+    while (service.IsRunning() && !cli_stop)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.merge_ms));
+        totals.merged += service.Merge(handler);
+
+        auto now = std::chrono::steady_clock::now();
+        if (options.report_ms && (now >= next_report))
+        {
+            for (size_t device = 0; device < service.GetDeviceCount(); device++)
+            {
+                Cli_PrintDevice(service, device, std::chrono::duration<double>(now - start).count());
+            }
+            std::fflush(stdout);
+            next_report += std::chrono::milliseconds(options.report_ms);
+        }
+        if (options.duration_ms && (now - start >= std::chrono::milliseconds(options.duration_ms)))
+        {
+            break;
+        }
+    }
+    service.Stop();
+    totals.merged += service.Merge(handler, true);
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    totals.cpu_seconds = Cli_CpuSeconds(RUSAGE_SELF) - cpu_start;
+    if (merged_file)
+    {
+        std::fclose(merged_file);
+    }
+
+    for (size_t device = 0; device < service.GetDeviceCount(); device++)
+    {
+        Ingest::DeviceStats stats = service.GetStats(device);
+
+        totals.bytes += stats.bytes;
+        totals.samples += stats.samples;
+        totals.resyncs += stats.resyncs;
+        totals.ring_overflows += stats.ring_overflows;
+        totals.latency.Add(service.GetLatency(device));
+        if (options.verbose)
+        {
+            Cli_PrintDevice(service, device, totals.seconds);
+        }
+    }
+    return true;
+}
+
+/**
+*   \brief Run the service on N ptys fed from the same process; print one line.
+*/
+static bool Cli_Bench(uint32_t board_count, const std::vector<uint8_t>& capture, const Cli_Options& options)
+{
+    std::vector<std::unique_ptr<Replay::VirtualSerial>> boards;
+    std::vector<std::vector<uint8_t>> streams(board_count);
+    Ingest::Service service(options.ring_samples);
+    Cli_Options run = options;
+    double rate = options.speed*(options.device.baud ? options.device.baud : 19200)/Replay::BITS_PER_BYTE;
+
+    for (uint32_t board = 0; board < board_count; board++)
+    {
+        std::string error;
+
+        boards.emplace_back(new Replay::VirtualSerial());
+        if (!boards.back()->Open())
+        {
+            std::perror("pty");
+            return false;
+        }
+        if (capture.empty())
+        {
+            // Board 1 wraps its timestamp 1 s after the start
+            uint32_t origin_us = (board == 1) ? 0xFFFFFFFFu - 1000000u : board*7919u*1000u;
+            Cli_Synthesize(options.device, options.bench_seconds*options.device.odr_hz, origin_us, board*0.1,
+                           streams[board]);
+        }
+        else
+        {
+            streams[board] = capture;
+        }
+        run.device.path = boards.back()->GetSlavePath();
+        if (options.output_dir)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/board%02u.lcap", board);
+            run.device.record_path = std::string(options.output_dir) + name;
+        }
+        if (!service.AddDevice(run.device, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return false;
+        }
+    }
+
+    // The boards: one thread writes the bytes due on every pty, then closes them
+    double writer_cpu_seconds = 0.0;
+    std::thread writer([&]()
+    {
+        Replay::Pacer pacer(rate);
+        size_t longest = 0;
+
+        for (const std::vector<uint8_t>& stream : streams)
+        {
+            longest = std::max(longest, stream.size());
+        }
+        pacer.Start();
+        for (size_t sent = 0; (sent < longest) && !cli_stop; )
+        {
+            size_t previous = sent;
+
+            sent = std::min(longest, sent + pacer.GetSliceBytes());
+            if (pacer.IsPaced())
+            {
+                std::this_thread::sleep_until(pacer.DueTime(sent - 1));
+            }
+            for (uint32_t board = 0; board < board_count; board++)
+            {
+                const std::vector<uint8_t>& stream = streams[board];
+                if (previous < stream.size())
+                {
+                    boards[board]->Write(&stream[previous], std::min(sent, stream.size()) - previous);
+                }
+            }
+        }
+        // All drained before any is closed: a board still open holds back the merge of the others
+        for (std::unique_ptr<Replay::VirtualSerial>& board : boards)
+        {
+            board->Drain(std::chrono::milliseconds(5000));
+        }
+        for (std::unique_ptr<Replay::VirtualSerial>& board : boards)
+        {
+            board->Close();
+        }
+        writer_cpu_seconds = Cli_CpuSeconds(RUSAGE_THREAD);
+    });
+
+    Cli_Totals totals;
+    bool ingested = Cli_Ingest(service, run, totals);
+
+    cli_stop = cli_stop || !ingested;
+    writer.join();
+    if (!ingested)
+    {
+        return false;
+    }
+    // The CPU of the writer thread is the boards', not the service's
+    totals.cpu_seconds -= writer_cpu_seconds;
+    std::printf("%3u boards %2u threads  %8.1f kB/s %8.0f samples/s  merged %llu of %llu, %llu out of order, "
+                "%llu resyncs, %llu overflows  latency p50 %.2f p99 %.2f max %.2f ms  CPU %.1f%%\n",
+                board_count, run.threads, totals.bytes/totals.seconds/1e3, totals.merged/totals.seconds,
+                static_cast<unsigned long long>(totals.merged), static_cast<unsigned long long>(totals.samples),
+                static_cast<unsigned long long>(totals.order_errors), static_cast<unsigned long long>(totals.resyncs),
+                static_cast<unsigned long long>(totals.ring_overflows), totals.latency.GetPercentileMs(0.5),
+                totals.latency.GetPercentileMs(0.99), totals.latency.GetMaxMs(),
+                100.0*totals.cpu_seconds/totals.seconds);
+    std::fflush(stdout);
+    return true;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options] PORT...\n"
+                 "       %s --bench N [options] [CAPTURE...]\n"
+                 "  --format proj2|proj3   frame format (default proj3)\n"
+                 "  --axis-mask MASK       enabled axes, CTRL_REG1 bits 2:0 (default 7)\n"
+                 "  --sensors N            devices of the 0xA2 frames (default 1)\n"
+                 "  --odr-hz HZ            rate of the 0xA0 frames, for their time (default 100)\n"
+                 "  --baud BAUD            line rate of the ports and of the benchmark (default 19200)\n"
+                 "  --threads N            threads decoding the ports (default 2)\n"
+                 "  --output-dir DIR       record a capture file per port into DIR\n"
+                 "  --raw                  store the columns of the capture files uncompressed\n"
+                 "  --merged FILE          write the merged samples as CSV: time_us, port, axes\n"
+                 "  --merge-ms MS          period of the merge (default 10)\n"
+                 "  --ring-samples N       samples queued per port for the merge (default %zu)\n"
+                 "  --report-ms MS         print the ports every MS (default at the end only)\n"
+                 "  --duration-ms MS       stop after MS\n"
+                 "  --bench N              N simulated boards on ptys\n"
+                 "  --bench-seconds S      stream of each simulated board (default 10)\n"
+                 "  --speed N              boards N times faster than the line, 0 as fast as possible (default 1)\n"
+                 "  --scaling              run the benchmark with 1, 2, 4... N boards\n"
+                 "  --verbose              print every port of the benchmark\n",
+                 program, program, Ingest::DEFAULT_RING_SAMPLES);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"format", required_argument, nullptr, 'f'},
+        {"axis-mask", required_argument, nullptr, 'a'},
+        {"sensors", required_argument, nullptr, 's'},
+        {"odr-hz", required_argument, nullptr, 'r'},
+        {"baud", required_argument, nullptr, 'b'},
+        {"threads", required_argument, nullptr, 't'},
+        {"output-dir", required_argument, nullptr, 'o'},
+        {"raw", no_argument, nullptr, 'w'},
+        {"merged", required_argument, nullptr, 'm'},
+        {"merge-ms", required_argument, nullptr, 'g'},
+        {"ring-samples", required_argument, nullptr, 'q'},
+        {"report-ms", required_argument, nullptr, 'p'},
+        {"duration-ms", required_argument, nullptr, 'd'},
+        {"bench", required_argument, nullptr, 'B'},
+        {"bench-seconds", required_argument, nullptr, 'S'},
+        {"speed", required_argument, nullptr, 'x'},
+        {"scaling", no_argument, nullptr, 'L'},
+        {"verbose", no_argument, nullptr, 'v'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    Cli_Options options;
+    uint32_t bench = 0;
+    bool scaling = false;
+    int option;
+
+    options.device.baud = 19200;
+    while ((option = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                if (std::strcmp(optarg, "proj2") == 0)
+                {
+                    options.device.decoder.format = Decoder::Format::Proj2;
+                }
+                else if (std::strcmp(optarg, "proj3") == 0)
+                {
+                    options.device.decoder.format = Decoder::Format::Proj3;
+                }
+                else
+                {
+                    Cli_Usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'a': options.device.decoder.axis_mask = static_cast<uint8_t>(std::strtoul(optarg, nullptr, 0)); break;
+            case 's': options.device.decoder.sensor_count = static_cast<uint8_t>(std::atoi(optarg)); break;
+            case 'r': options.device.odr_hz = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'b': options.device.baud = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 't': options.threads = static_cast<unsigned>(std::atoi(optarg)); break;
+            case 'o': options.output_dir = optarg; break;
+            case 'w': options.device.compress = false; break;
+            case 'm': options.merged_path = optarg; break;
+            case 'g': options.merge_ms = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'q': options.ring_samples = static_cast<size_t>(std::atol(optarg)); break;
+            case 'p': options.report_ms = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'd': options.duration_ms = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'B': bench = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'S': options.bench_seconds = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'x': options.speed = std::atof(optarg); break;
+            case 'L': scaling = true; break;
+            case 'v': options.verbose = true; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if ((options.device.odr_hz == 0) || (options.merge_ms == 0) || (options.speed < 0) || (options.ring_samples == 0) ||
+        (options.device.decoder.sensor_count < 1) || (options.device.decoder.sensor_count > ACQUISITION_MAX_SENSORS) ||
+        ((bench == 0) && (optind == argc)) || (bench > 1024))
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+    std::signal(SIGINT, Cli_Signal);
+    std::signal(SIGTERM, Cli_Signal);
+
+    if (bench)
+    {
+        std::vector<uint8_t> capture;
+
+        for (int i = optind; i < argc; i++)
+        {
+            FILE* file = std::fopen(argv[i], "rb");
+            uint8_t buffer[65536];
+            size_t length;
+
+            if (file == nullptr)
+            {
+                std::perror(argv[i]);
+                return 2;
+            }
+            while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                capture.insert(capture.end(), buffer, buffer + length);
+            }
+            std::fclose(file);
+        }
+        for (uint32_t boards = scaling ? 1 : bench; ; boards = std::min(2*boards, bench))
+        {
+            if (!Cli_Bench(boards, capture, options))
+            {
+                return 1;
+            }
+            if ((boards == bench) || cli_stop)
+            {
+                return 0;
+            }
+        }
+    }
+
+    Ingest::Service service(options.ring_samples);
+    Cli_Totals totals;
+
+    for (int i = optind; i < argc; i++)
+    {
+        std::string error;
+
+        options.device.path = argv[i];
+        if (options.output_dir)
+        {
+            const char* name = std::strrchr(argv[i], '/');
+            options.device.record_path = std::string(options.output_dir) + "/" + (name ? name + 1 : argv[i]) + ".lcap";
+        }
+        if (!service.AddDevice(options.device, error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+    options.verbose = true;
+    if (!Cli_Ingest(service, options, totals))
+    {
+        return 1;
+    }
+    std::printf("total          %8.1f kB/s %9llu samples %9llu merged, %llu out of order, %.3f s, CPU %.1f%%\n",
+                totals.bytes/totals.seconds/1e3, static_cast<unsigned long long>(totals.samples),
+                static_cast<unsigned long long>(totals.merged), static_cast<unsigned long long>(totals.order_errors),
+                totals.seconds, 100.0*totals.cpu_seconds/totals.seconds);
+    return 0;
+}
+
+/* [] END OF FILE */
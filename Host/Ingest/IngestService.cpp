@@ -0,0 +1,509 @@
+/*
+* This file includes the source code of the ingestion service: the
+* ports, the epoll loop of the threads and the merge of the samples.
+*/
+
+#include "IngestService.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <queue>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace Ingest
+{
+/**
+*   \brief Epoll data of the stop event; the ports have their index.
+*/
+static constexpr uint64_t STOP_EVENT = UINT64_MAX;
+
+/**
+*   \brief Reads of a port before the thread takes the next ready one.
+*/
+static constexpr uint32_t READS_PER_WAKEUP = 16;
+
+/**
+*   \brief Termios speed of a baud rate, B0 if not a standard one.
+*/
+static speed_t BaudConstant(uint32_t baud)
+{
+    static const struct { uint32_t baud; speed_t speed; } speeds[] =
+    {
+        {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+        {115200, B115200}, {230400, B230400}, {460800, B460800}, {921600, B921600},
+    };
+
+    for (const auto& entry : speeds)
+    {
+        if (entry.baud == baud)
+        {
+            return entry.speed;
+        }
+    }
+    return B0;
+}
+
+/**
+*   \brief State of a port.
+*
+*   The decoder, the clock and the capture file are only used by the
+*   thread holding the port (EPOLLONESHOT); the counters shared with the
+*   other threads are atomic; the histogram belongs to Merge.
+*/
+struct Service::Device
+{
+    Device(const DeviceConfig& config, size_t ring_samples) :
+        config(config), decoder(config.decoder), ring(ring_samples)
+    {
+    }
+
+    DeviceConfig config;
+    uint16_t index = 0;
+    int fd = -1;
+    Decoder::StreamDecoder decoder;
+    Recorder::Writer writer;
+    bool recording = false;
+    uint8_t sensor_count = 1;
+    SampleRing ring;
+
+    // Clock: device time unwrapped, then aligned on the host at the first sample
+    uint32_t period_us = 10000;
+    uint64_t accel_samples = 0;
+    bool clock_started = false;
+    uint32_t last_timestamp = 0;
+    int64_t base_us = 0;
+    int64_t last_device_us = 0;
+    int64_t offset_us = 0;
+
+    // Shared with Merge and GetStats
+    std::atomic<bool> open{true};
+    std::atomic<int64_t> last_time_us{INT64_MIN};
+    std::atomic<int64_t> last_arrival_ns{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> losses{0};
+    std::atomic<uint64_t> ring_overflows{0};
+    std::atomic<uint64_t> resyncs{0};
+    std::atomic<uint64_t> skipped_bytes{0};
+
+    // Merge side
+    uint64_t merged = 0;
+    LatencyHistogram latency;
+};
+
+    void LatencyHistogram::Add(int64_t ns)
+    {
+        uint64_t value = (ns > 0) ? static_cast<uint64_t>(ns) : 0;
+        uint32_t bucket;
+
+        if (value < SUB_BUCKETS)
+        {
+            bucket = static_cast<uint32_t>(value);
+        }
+        else
+        {
+            uint32_t exponent = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+            bucket = (exponent - 3)*SUB_BUCKETS + static_cast<uint32_t>((value >> (exponent - 4)) & (SUB_BUCKETS - 1));
+        }
+        buckets[bucket]++;
+        count++;
+        max_ns = std::max(max_ns, static_cast<int64_t>(value));
+    }
+
+    void LatencyHistogram::Add(const LatencyHistogram& other)
+    {
+        for (uint32_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+        {
+            buckets[bucket] += other.buckets[bucket];
+        }
+        count += other.count;
+        max_ns = std::max(max_ns, other.max_ns);
+    }
+
+    double LatencyHistogram::GetPercentileMs(double fraction) const
+    {
+        uint64_t rank = static_cast<uint64_t>(fraction*count);
+        uint64_t seen = 0;
+
+        for (uint32_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+        {
+            seen += buckets[bucket];
+            if (seen > rank)
+            {
+                if (bucket < SUB_BUCKETS)
+                {
+                    return bucket/1e6;
+                }
+                uint32_t exponent = bucket/SUB_BUCKETS + 3;
+                return static_cast<double>(static_cast<uint64_t>(SUB_BUCKETS + bucket%SUB_BUCKETS) << (exponent - 4))/1e6;
+            }
+        }
+        return GetMaxMs();
+    }
+
+    SampleRing::SampleRing(size_t capacity)
+    {
+        size_t size = 1;
+
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        samples.resize(size);
+        mask = size - 1;
+    }
+
+    Service::Service(size_t ring_samples) : start(std::chrono::steady_clock::now()), ring_samples(ring_samples)
+    {
+    }
+
+    Service::~Service()
+    {
+        Stop();
+    }
+
+    bool Service::AddDevice(const DeviceConfig& config, std::string& error)
+    {
+        std::unique_ptr<Device> device(new Device(config, ring_samples));
+        struct termios settings;
+
+        device->index = static_cast<uint16_t>(devices.size());
+        device->fd = ::open(config.path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (device->fd < 0)
+        {
+            error = config.path + ": " + std::strerror(errno);
+            return false;
+        }
+        // A serial port as the USB-UART bridge: raw bytes, at the baud rate of the firmware
+        if (isatty(device->fd) && (tcgetattr(device->fd, &settings) == 0))
+        {
+            // VMIN 1: a read with no byte fails with EAGAIN, as 0 would be taken for the end of the port
+            cfmakeraw(&settings);
+            settings.c_cc[VMIN] = 1;
+            settings.c_cc[VTIME] = 0;
+            if (config.baud && (BaudConstant(config.baud) != B0))
+            {
+                cfsetispeed(&settings, BaudConstant(config.baud));
+                cfsetospeed(&settings, BaudConstant(config.baud));
+            }
+            tcsetattr(device->fd, TCSANOW, &settings);
+        }
+        device->sensor_count = (config.decoder.format == Decoder::Format::Proj3) ? config.decoder.sensor_count : 1;
+        device->period_us = 1000000/std::max<uint32_t>(config.odr_hz, 1);
+        if (!config.record_path.empty())
+        {
+            if (!device->writer.Open(config.record_path, device->sensor_count, device->decoder.GetScale(),
+                                     Recorder::DEFAULT_CHUNK_ROWS, config.compress))
+            {
+                error = config.record_path + ": " + std::strerror(errno);
+                ::close(device->fd);
+                return false;
+            }
+            device->recording = true;
+            device->sensor_count = device->writer.GetHeader().sensor_count;
+        }
+        devices.push_back(std::move(device));
+        open_devices++;
+        return true;
+    }
+
+    bool Service::Start(unsigned thread_count)
+    {
+        struct epoll_event event = {};
+
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if ((epoll_fd < 0) || (stop_fd < 0))
+        {
+            return false;
+        }
+        // Level-triggered: once written, every thread sees it
+        event.events = EPOLLIN;
+        event.data.u64 = STOP_EVENT;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_fd, &event) != 0)
+        {
+            return false;
+        }
+        for (std::unique_ptr<Device>& device : devices)
+        {
+            event.events = EPOLLIN | EPOLLONESHOT;
+            event.data.u64 = device->index;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, device->fd, &event) != 0)
+            {
+                return false;
+            }
+        }
+        for (unsigned i = 0; i < std::max(thread_count, 1u); i++)
+        {
+            threads.emplace_back(&Service::Work, this);
+        }
+        return true;
+    }
+
+    void Service::Work()
+    {
+        for (;;)
+        {
+            struct epoll_event event;
+            int count = epoll_wait(epoll_fd, &event, 1, -1);
+
+            if (count <= 0)
+            {
+                if ((count < 0) && (errno != EINTR))
+                {
+                    return;
+                }
+                continue;
+            }
+            if (event.data.u64 == STOP_EVENT)
+            {
+                return;
+            }
+            Device& device = *devices[event.data.u64];
+            ReadDevice(device);
+            if (device.open.load(std::memory_order_relaxed))
+            {
+                // Handed back to the pool: the next event goes to any thread
+                event.events = EPOLLIN | EPOLLONESHOT;
+                epoll_ctl(epoll_fd, EPOLL_CTL_MOD, device.fd, &event);
+            }
+        }
+    }
+
+    void Service::ReadDevice(Device& device)
+    {
+        uint8_t buffer[4096];
+
+        auto handler = [&](const Decoder::Frame& frame, int64_t arrival_ns)
+        {
+            int64_t device_us;
+
+            switch (frame.type)
+            {
+                case Decoder::FrameType::Accel:
+                    device_us = static_cast<int64_t>(device.accel_samples*1000000/std::max<uint32_t>(device.config.odr_hz, 1));
+                    device.accel_samples++;
+                    break;
+                case Decoder::FrameType::MultiAccel:
+                    // Unwrapped as by lis3dh_record: uint32 wraps, restarts go on one period later
+                    if (!device.clock_started)
+                    {
+                        device.base_us = -static_cast<int64_t>(frame.timestamp_us);
+                        device.clock_started = true;
+                    }
+                    else if (frame.timestamp_us < device.last_timestamp)
+                    {
+                        if (device.last_timestamp - frame.timestamp_us > 0x80000000u)
+                        {
+                            device.base_us += 0x100000000ll;
+                        }
+                        else
+                        {
+                            device.base_us = device.last_device_us + device.period_us - frame.timestamp_us;
+                        }
+                    }
+                    device.last_timestamp = frame.timestamp_us;
+                    device_us = device.base_us + frame.timestamp_us;
+                    break;
+                case Decoder::FrameType::Loss:
+                    device.writer.CountLosses(frame.lost);
+                    device.losses.fetch_add(frame.lost, std::memory_order_relaxed);
+                    return;
+                default:
+                    return;
+            }
+            device.last_device_us = device_us;
+
+            Sample sample;
+            if (device.samples.load(std::memory_order_relaxed) == 0)
+            {
+                device.offset_us = arrival_ns/1000 - device_us;
+            }
+            sample.time_us = device.offset_us + device_us;
+            sample.device_time_us = device_us;
+            sample.arrival_ns = arrival_ns;
+            sample.device = device.index;
+            sample.sensor_count = device.sensor_count;
+            std::memcpy(sample.values, frame.values, sizeof(int32_t)*device.sensor_count*LIS3DH_AXIS_COUNT);
+            if (device.recording)
+            {
+                device.writer.Append(device_us, sample.values);
+            }
+            if (!device.ring.Push(sample))
+            {
+                device.ring_overflows.fetch_add(1, std::memory_order_relaxed);
+            }
+            device.samples.fetch_add(1, std::memory_order_relaxed);
+            device.last_time_us.store(sample.time_us, std::memory_order_release);
+        };
+
+        for (uint32_t i = 0; i < READS_PER_WAKEUP; i++)
+        {
+            ssize_t length = ::read(device.fd, buffer, sizeof(buffer));
+
+            if (length > 0)
+            {
+                int64_t arrival_ns = GetNowNs();
+
+                device.decoder.Feed(buffer, static_cast<size_t>(length),
+                                    [&](const Decoder::Frame& frame) { handler(frame, arrival_ns); });
+                device.bytes.fetch_add(static_cast<uint64_t>(length), std::memory_order_relaxed);
+                device.reads.fetch_add(1, std::memory_order_relaxed);
+                device.resyncs.store(device.decoder.GetStats().resyncs, std::memory_order_relaxed);
+                device.skipped_bytes.store(device.decoder.GetStats().skipped_bytes, std::memory_order_relaxed);
+                device.last_arrival_ns.store(arrival_ns, std::memory_order_release);
+            }
+            else if ((length < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            else if ((length < 0) && (errno == EAGAIN))
+            {
+                return;
+            }
+            else
+            {
+                // EOF, or EIO from a pty whose master was closed: the board is gone
+                CloseDevice(device);
+                return;
+            }
+        }
+    }
+
+    void Service::CloseDevice(Device& device)
+    {
+        if (!device.open.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (epoll_fd >= 0)
+        {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, device.fd, nullptr);
+        }
+        ::close(device.fd);
+        if (device.recording)
+        {
+            device.writer.Close();
+        }
+        device.open.store(false, std::memory_order_release);
+        open_devices--;
+    }
+
+    size_t Service::Merge(const std::function<void(const Sample&)>& handler, bool flush)
+    {
+        int64_t now_ns = GetNowNs();
+        int64_t watermark = INT64_MAX;
+        size_t merged = 0;
+
+        // The samples still to come from an active port are later than its last one
+        if (!flush)
+        {
+            for (std::unique_ptr<Device>& device : devices)
+            {
+                int64_t last_time_us = device->last_time_us.load(std::memory_order_acquire);
+
+                if (device->open.load(std::memory_order_acquire) && (last_time_us != INT64_MIN) &&
+                    (now_ns - device->last_arrival_ns.load(std::memory_order_acquire) < IDLE_TIMEOUT_US*1000))
+                {
+                    watermark = std::min(watermark, last_time_us);
+                }
+            }
+        }
+
+        typedef std::pair<int64_t, size_t> Head;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+
+        for (size_t index = 0; index < devices.size(); index++)
+        {
+            const Sample* sample = devices[index]->ring.Peek();
+            if (sample && (sample->time_us <= watermark))
+            {
+                heads.emplace(sample->time_us, index);
+            }
+        }
+        while (!heads.empty())
+        {
+            Device& device = *devices[heads.top().second];
+            const Sample* sample = device.ring.Peek();
+
+            heads.pop();
+            handler(*sample);
+            device.latency.Add(now_ns - sample->arrival_ns);
+            device.merged++;
+            device.ring.Pop();
+            merged++;
+            sample = device.ring.Peek();
+            if (sample && (sample->time_us <= watermark))
+            {
+                heads.emplace(sample->time_us, device.index);
+            }
+        }
+        return merged;
+    }
+
+    void Service::Stop()
+    {
+        if (!threads.empty())
+        {
+            uint64_t one = 1;
+            if (::write(stop_fd, &one, sizeof(one)) != sizeof(one))
+            {
+                // The threads also stop on an epoll error once the fds are closed
+            }
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+            threads.clear();
+        }
+        for (std::unique_ptr<Device>& device : devices)
+        {
+            CloseDevice(*device);
+        }
+        if (epoll_fd >= 0)
+        {
+            ::close(epoll_fd);
+            epoll_fd = -1;
+        }
+        if (stop_fd >= 0)
+        {
+            ::close(stop_fd);
+            stop_fd = -1;
+        }
+    }
+
+    const std::string& Service::GetPath(size_t device) const
+    {
+        return devices[device]->config.path;
+    }
+
+    DeviceStats Service::GetStats(size_t device) const
+    {
+        const Device& source = *devices[device];
+        DeviceStats stats;
+
+        stats.bytes = source.bytes.load(std::memory_order_relaxed);
+        stats.reads = source.reads.load(std::memory_order_relaxed);
+        stats.samples = source.samples.load(std::memory_order_relaxed);
+        stats.merged = source.merged;
+        stats.resyncs = source.resyncs.load(std::memory_order_relaxed);
+        stats.skipped_bytes = source.skipped_bytes.load(std::memory_order_relaxed);
+        stats.losses = source.losses.load(std::memory_order_relaxed);
+        stats.ring_overflows = source.ring_overflows.load(std::memory_order_relaxed);
+        stats.open = source.open.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    const LatencyHistogram& Service::GetLatency(size_t device) const
+    {
+        return devices[device]->latency;
+    }
+}
+
+/* [] END OF FILE */
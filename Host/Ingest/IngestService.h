@@ -0,0 +1,241 @@
+/**
+*   \file IngestService.h
+*   \brief Ingestion of the UART streams of many boards at once.
+*
+*   The service opens N serial ports (or ptys), sets them to raw and
+*   non-blocking, and waits on all of them with one epoll set. A small
+*   pool of threads takes the ready ports: each port is armed with
+*   EPOLLONESHOT, so that a single thread at a time reads and decodes it,
+*   and its decoder, clock and recorder file need no lock.
+*
+*   The decoded samples of a port are appended to its capture file
+*   (Host/Recorder) and pushed into its ring, a single-producer
+*   single-consumer queue. Merge pops the rings in the order of the time
+*   of the samples: the device time, unwrapped as in lis3dh_record and
+*   aligned on the host clock at the first sample of the port. A sample
+*   is merged once every active port has gone past its time (the
+*   watermark); a port silent for a while stops holding the others back.
+*
+*   The latency of a sample is the time from the read that completed its
+*   frame to its merge, kept in a log-linear histogram per port.
+*/
+
+#ifndef __INGEST_SERVICE_H
+    #define __INGEST_SERVICE_H
+
+    #include "CaptureFile.h"
+    #include "StreamDecoder.h"
+    #include <atomic>
+    #include <chrono>
+    #include <cstdint>
+    #include <functional>
+    #include <memory>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+    namespace Ingest
+    {
+        /**
+        *   \brief Default samples of a ring.
+        */
+        constexpr size_t DEFAULT_RING_SAMPLES = 4096;
+
+        /**
+        *   \brief Time after which a silent port no longer holds the merge back.
+        */
+        constexpr int64_t IDLE_TIMEOUT_US = 500000;
+
+        /**
+        *   \brief Decoded sample of a port.
+        */
+        struct Sample
+        {
+            int64_t time_us;            ///< Device time aligned on the host clock, from the start of the service
+            int64_t device_time_us;     ///< Device time, from 0 at the first sample of the port
+            int64_t arrival_ns;         ///< Host time of the read that completed the frame
+            uint16_t device;            ///< Index of the port
+            uint8_t sensor_count;
+            int32_t values[ACQUISITION_MAX_SENSORS*LIS3DH_AXIS_COUNT];
+        };
+
+        /**
+        *   \brief Queue of the samples of a port: pushed by the thread reading it, popped by Merge.
+        */
+        class SampleRing
+        {
+        public:
+            /**
+            *   \param capacity Samples, rounded up to a power of 2.
+            */
+            explicit SampleRing(size_t capacity);
+
+            /**
+            *   \retval false if the ring is full: the sample is not queued.
+            */
+            bool Push(const Sample& sample)
+            {
+                uint64_t tail_now = tail.load(std::memory_order_relaxed);
+
+                if (tail_now - head.load(std::memory_order_acquire) > mask)
+                {
+                    return false;
+                }
+                samples[tail_now & mask] = sample;
+                tail.store(tail_now + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+            *   \brief Oldest sample, nullptr if empty.
+            */
+            const Sample* Peek() const
+            {
+                uint64_t head_now = head.load(std::memory_order_relaxed);
+                return (head_now == tail.load(std::memory_order_acquire)) ? nullptr : &samples[head_now & mask];
+            }
+
+            void Pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+            size_t GetSize() const
+            {
+                return static_cast<size_t>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+            }
+
+        private:
+            std::vector<Sample> samples;
+            uint64_t mask;
+            alignas(64) std::atomic<uint64_t> head{0};
+            alignas(64) std::atomic<uint64_t> tail{0};
+        };
+
+        /**
+        *   \brief Histogram of latencies: 16 buckets per power of 2, about 6% of resolution.
+        */
+        class LatencyHistogram
+        {
+        public:
+            LatencyHistogram() : buckets(BUCKET_COUNT, 0) {}
+
+            void Add(int64_t ns);
+            void Add(const LatencyHistogram& other);
+
+            uint64_t GetCount() const { return count; }
+            double GetMaxMs() const { return max_ns/1e6; }
+
+            /**
+            *   \brief Lower bound of the bucket holding the fraction of the values.
+            */
+            double GetPercentileMs(double fraction) const;
+
+        private:
+            static constexpr uint32_t SUB_BUCKETS = 16;
+            static constexpr uint32_t BUCKET_COUNT = 64*SUB_BUCKETS;
+
+            std::vector<uint64_t> buckets;
+            uint64_t count = 0;
+            int64_t max_ns = 0;
+        };
+
+        /**
+        *   \brief Port to ingest.
+        */
+        struct DeviceConfig
+        {
+            std::string path;
+            Decoder::Config decoder;
+            uint32_t baud = 0;              ///< Line rate of a serial port, 0 to keep its setting
+            uint32_t odr_hz = 100;          ///< Rate of the 0xA0 frames, for their time
+            std::string record_path;        ///< Capture file, empty for none
+            bool compress = true;           ///< Delta-varint columns in the capture file
+        };
+
+        /**
+        *   \brief Counters of a port.
+        */
+        struct DeviceStats
+        {
+            uint64_t bytes;
+            uint64_t reads;
+            uint64_t samples;               ///< Accelerometer frames decoded
+            uint64_t merged;                ///< Samples out of Merge
+            uint64_t resyncs;
+            uint64_t skipped_bytes;
+            uint64_t losses;                ///< Samples reported lost by the device (0xA3)
+            uint64_t ring_overflows;        ///< Samples not queued, the ring full
+            bool open;
+        };
+
+        /**
+        *   \brief Ingestion of many ports with epoll and a pool of threads.
+        */
+        class Service
+        {
+        public:
+            explicit Service(size_t ring_samples = DEFAULT_RING_SAMPLES);
+            ~Service();
+
+            /**
+            *   \brief Open a port and its capture file, before Start.
+            *
+            *   \retval false on error, described in error.
+            */
+            bool AddDevice(const DeviceConfig& config, std::string& error);
+
+            /**
+            *   \brief Start the threads reading the ports.
+            */
+            bool Start(unsigned thread_count);
+
+            /**
+            *   \brief Pop the samples up to the watermark, in time order, into the handler.
+            *
+            *   Called from one thread. With flush, all the queued samples
+            *   are popped, e.g. once the ports are closed.
+            *
+            *   \retval Samples merged.
+            */
+            size_t Merge(const std::function<void(const Sample&)>& handler, bool flush = false);
+
+            /**
+            *   \brief Whether a port is still open: the others have been closed by the device (EOF, EIO).
+            */
+            bool IsRunning() const { return open_devices.load(std::memory_order_acquire) > 0; }
+
+            /**
+            *   \brief Stop the threads, close the ports and the capture files.
+            */
+            void Stop();
+
+            size_t GetDeviceCount() const { return devices.size(); }
+            const std::string& GetPath(size_t device) const;
+            DeviceStats GetStats(size_t device) const;
+            const LatencyHistogram& GetLatency(size_t device) const;
+
+            /**
+            *   \brief Host time since the creation of the service, the time base of the samples.
+            */
+            int64_t GetNowNs() const
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+
+        private:
+            struct Device;
+
+            void Work();
+            void ReadDevice(Device& device);
+            void CloseDevice(Device& device);
+
+            std::chrono::steady_clock::time_point start;
+            size_t ring_samples;
+            int epoll_fd = -1;
+            int stop_fd = -1;
+            std::vector<std::unique_ptr<Device>> devices;
+            std::vector<std::thread> threads;
+            std::atomic<size_t> open_devices{0};
+        };
+    }
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,220 @@
+/*
+* This file includes the host command line front end of the link budget
+* of PROJ_3 (LinkBudget.h), to plan deployments.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn \
+*       Host/LinkBudget/LinkBudgetCli.c AY1920_II_HW_05_PROJ_3.cydsn/LinkBudget.c \
+*       -o lis3dh_budget
+*/
+
+#include "LinkBudget.h"
+#include "Scheduler.h"
+#include "I2C_Interface.h"
+#include "Acquisition.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*   \brief Output data rates and baud rates of the sweep table.
+*/
+static const uint16 cli_odrs[] = {1, 10, 25, 50, 100, 200, 400, 1344};
+static const uint32 cli_bauds[] = {9600, 19200, 57600, 115200};
+
+/**
+*   \brief Print out the resources exceeded.
+*/
+static void Cli_PrintViolations(uint8_t violations)
+{
+    if (violations & LINK_BUDGET_ODR_ABOVE_TICK) printf(" ODR above tick rate");
+    if (violations & LINK_BUDGET_BUS) printf(" bus");
+    if (violations & LINK_BUDGET_UART) printf(" UART");
+    if (violations & LINK_BUDGET_CPU) printf(" CPU");
+}
+
+/**
+*   \brief Print out the budget of a configuration and its admission.
+*/
+static int Cli_Report(LinkBudget_Config* config)
+{
+    LinkBudget_Result result;
+    uint8_t violations = LinkBudget_Compute(config, &result);
+
+    uint8_t axis_mask = config->axis_mask & LIS3DH_CTRL_REG1_AXIS_MASK;
+
+    printf("ODR %u Hz, %u device(s), axis mask 0x%X, %s at %u Hz, UART %u baud, tick %u Hz, aux divider %u, %s frames\n",
+           config->odr_hz, config->sensor_count, axis_mask,
+           (config->transport == LINK_BUDGET_TRANSPORT_SPI) ? "SPI" : "I2C", config->bus_hz,
+           config->baud, config->tick_hz, config->aux_divider,
+           (config->format == LINK_BUDGET_FORMAT_RAW) ? "raw" : "converted");
+    if (config->format == LINK_BUDGET_FORMAT_RAW)
+    {
+        printf("reads        %u bytes per device and poll\n", ACQUISITION_BURST_LENGTH(axis_mask));
+    }
+    else if (ACQUISITION_SPLIT_READ(axis_mask))
+    {
+        printf("reads        %u byte per device and poll, %u more per sample\n",
+               ACQUISITION_STATUS_READ_LENGTH(axis_mask), ACQUISITION_AXIS_READ_LENGTH(axis_mask));
+    }
+    else
+    {
+        printf("reads        %u bytes per device and poll\n", ACQUISITION_STATUS_READ_LENGTH(axis_mask));
+    }
+    printf("bus time     %u us per sample, %u.%u%% load\n", result.bus_us_per_sample,
+           result.bus_load_permille/10, result.bus_load_permille%10);
+    printf("UART         %u bytes/s, %u.%u%% load\n", result.uart_bytes_per_s,
+           result.uart_load_permille/10, result.uart_load_permille%10);
+    printf("CPU          %u cycles per sample, %u.%u%% load\n", result.cpu_cycles_per_sample,
+           result.cpu_load_permille/10, result.cpu_load_permille%10);
+    if (violations == LINK_BUDGET_OK)
+    {
+        printf("feasible\n");
+        return 0;
+    }
+    printf("exceeds the %u%% limit:", LINK_BUDGET_MAX_LOAD_PERCENT);
+    Cli_PrintViolations(violations);
+    printf("\n");
+
+    if (LinkBudget_Admit(config, &result) == NO_ERROR)
+    {
+        printf("admitted with decimation %u: %u bytes/s, %u.%u%% UART load\n", config->decimation,
+               result.uart_bytes_per_s, result.uart_load_permille/10, result.uart_load_permille%10);
+        return 0;
+    }
+    printf("rejected:");
+    Cli_PrintViolations(result.violations);
+    printf("\n");
+    return 1;
+}
+
+/**
+*   \brief Print out the decimation needed for each ODR and baud rate.
+*/
+static void Cli_Sweep(const LinkBudget_Config* base)
+{
+    printf("decimation needed (- = rejected)\n%8s", "ODR\\baud");
+    for (uint8_t b = 0; b < sizeof(cli_bauds)/sizeof(cli_bauds[0]); b++)
+    {
+        printf("%8u", cli_bauds[b]);
+    }
+    printf("\n");
+    for (uint8_t o = 0; o < sizeof(cli_odrs)/sizeof(cli_odrs[0]); o++)
+    {
+        printf("%8u", cli_odrs[o]);
+        for (uint8_t b = 0; b < sizeof(cli_bauds)/sizeof(cli_bauds[0]); b++)
+        {
+            LinkBudget_Config config = *base;
+            LinkBudget_Result result;
+
+            config.odr_hz = cli_odrs[o];
+            config.baud = cli_bauds[b];
+            config.decimation = 1;
+            if (LinkBudget_Admit(&config, &result) == NO_ERROR)
+            {
+                printf("%8u", config.decimation);
+            }
+            else
+            {
+                printf("%8s", "-");
+            }
+        }
+        printf("\n");
+    }
+}
+
+static void Cli_Usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --odr HZ             output data rate (default 100)\n"
+            "  --sensors N          devices read in lockstep (default 1)\n"
+            "  --axes MASK          enabled axes as CTRL_REG1 bits 2:0, X = 0x1, Y = 0x2, Z = 0x4 (default 0x7)\n"
+            "  --spi                read the devices over SPI\n"
+            "  --bus-hz HZ          bus rate (default 375000 on I2C, 6000000 on SPI)\n"
+            "  --baud BAUD          UART baud rate (default 19200)\n"
+            "  --tick-hz HZ         scheduler tick rate (default 300)\n"
+            "  --aux-divider N      samples between two auxiliary frames, 0 = none (default 10)\n"
+            "  --raw                raw bursts sent by DMA instead of converted samples\n"
+            "  --sweep              print the decimation needed for each ODR and baud rate\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"odr", required_argument, NULL, 'o'},
+        {"sensors", required_argument, NULL, 's'},
+        {"axes", required_argument, NULL, 'a'},
+        {"spi", no_argument, NULL, 'p'},
+        {"bus-hz", required_argument, NULL, 'z'},
+        {"baud", required_argument, NULL, 'b'},
+        {"tick-hz", required_argument, NULL, 't'},
+        {"aux-divider", required_argument, NULL, 'x'},
+        {"raw", no_argument, NULL, 'r'},
+        {"sweep", no_argument, NULL, 'w'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    LinkBudget_Config config =
+    {
+        .odr_hz = 100,
+        .sensor_count = 1,
+        .axis_mask = LIS3DH_CTRL_REG1_AXIS_MASK,
+        .transport = LINK_BUDGET_TRANSPORT_I2C,
+        .bus_hz = 0,
+        .baud = 19200,
+        .tick_hz = SCHEDULER_TICK_HZ,
+        .aux_divider = 10,
+        .decimation = 1,
+        .format = LINK_BUDGET_FORMAT_CONVERTED,
+    };
+    uint8_t sweep = 0;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'o': config.odr_hz = (uint16)atoi(optarg); break;
+            case 's': config.sensor_count = (uint8_t)atoi(optarg); break;
+            case 'a': config.axis_mask = (uint8_t)strtol(optarg, NULL, 0); break;
+            case 'p': config.transport = LINK_BUDGET_TRANSPORT_SPI; break;
+            case 'z': config.bus_hz = (uint32)atoi(optarg); break;
+            case 'b': config.baud = (uint32)atoi(optarg); break;
+            case 't': config.tick_hz = (uint16)atoi(optarg); break;
+            case 'x': config.aux_divider = (uint8_t)atoi(optarg); break;
+            case 'r': config.format = LINK_BUDGET_FORMAT_RAW; break;
+            case 'w': sweep = 1; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (config.bus_hz == 0)
+    {
+        // Fast mode gives 375 kHz with BUS_CLK at 24 MHz (I2C_Peripheral_SetBusRate)
+        config.bus_hz = (config.transport == LINK_BUDGET_TRANSPORT_SPI) ? 6000000u : 375000u;
+    }
+    if ((config.sensor_count < 1) || (config.axis_mask == 0) || (config.axis_mask & ~LIS3DH_CTRL_REG1_AXIS_MASK) ||
+        (config.baud == 0) || (config.tick_hz == 0))
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+    if ((config.axis_mask + (config.axis_mask & -config.axis_mask)) & config.axis_mask)
+    {
+        // X+Z: the burst from STATUS_REG to Z also carries Y, which is read and not sent
+        fprintf(stderr, "axis mask 0x%X is not contiguous: the reads also carry the axes in between\n",
+                config.axis_mask);
+    }
+
+    if (sweep)
+    {
+        Cli_Sweep(&config);
+        return 0;
+    }
+    return Cli_Report(&config);
+}
+
+/* [] END OF FILE */
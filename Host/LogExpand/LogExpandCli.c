@@ -0,0 +1,197 @@
+/*
+* This file includes the host expander of the log frames of PROJ_3
+* (LogEvent.h): the string table is generated at compile time from
+* the same LogMessages.h as the firmware.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn \
+*       Host/LogExpand/LogExpandCli.c -o lis3dh_log
+*
+* The input is the raw UART stream (a capture file, or stdin): the log
+* frames are expanded into text lines, the other frames are skipped.
+*/
+
+#include "LogEvent.h"
+#include "Acquisition.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*   \brief String table generated from LogMessages.h.
+*/
+static const struct {
+    const char* name;
+    uint8_t level;
+    const char* format;
+} log_table[LOG_MESSAGE_COUNT] = {
+    #define LOG_MESSAGE(id, level, format) {#id, level, format},
+    LOG_MESSAGES
+    #undef LOG_MESSAGE
+};
+
+static const char* const level_names[] = {"", "E", "W", "I", "D"};
+
+/**
+*   \brief Print out the string table, one message per line.
+*/
+static void Cli_PrintTable(void)
+{
+    for (uint8_t id = 0; id < LOG_MESSAGE_COUNT; id++)
+    {
+        printf("%3u %s %-32s \"%s\"\n", id, level_names[log_table[id].level], log_table[id].name, log_table[id].format);
+    }
+}
+
+/**
+*   \brief Decode the LEB128 arguments of a frame.
+*
+*   \retval Number of arguments, -1 if the payload is malformed.
+*/
+static int Cli_DecodeArgs(const uint8_t* payload, uint8_t length, uint32* args)
+{
+    int count = 0;
+    uint8_t shift = 0;
+    uint32 value = 0;
+
+    for (uint8_t i = 0; i < length; i++)
+    {
+        if ((shift > 28) || (count == LOG_EVENT_MAX_ARGS))
+        {
+            return -1;
+        }
+        value |= (uint32)(payload[i] & 0x7F) << shift;
+        shift += 7;
+        if (!(payload[i] & 0x80))
+        {
+            args[count++] = value;
+            value = 0;
+            shift = 0;
+        }
+    }
+    return shift ? -1 : count;
+}
+
+/**
+*   \brief Print out a message with its arguments.
+*/
+static void Cli_Expand(uint8_t id, const uint32* args, int arg_count)
+{
+    int a = 0;
+
+    printf("%s ", level_names[log_table[id].level]);
+    for (const char* format = log_table[id].format; *format; format++)
+    {
+        if ((format[0] == '%') && ((format[1] == 'u') || (format[1] == 'x')))
+        {
+            uint32 value = (a < arg_count) ? args[a] : 0;
+
+            printf((format[1] == 'x') ? "%02X" : "%u", value);
+            a++;
+            format++;
+        }
+        else
+        {
+            putchar(*format);
+        }
+    }
+    putchar('\n');
+}
+
+/**
+*   \brief Scan a stream for log frames and expand them.
+*
+*   \retval Number of log frames expanded.
+*/
+static unsigned Cli_Scan(FILE* input, uint8_t min_level)
+{
+    uint8_t frame[LOG_EVENT_MAX_FRAME_LENGTH];
+    size_t count = 0;
+    unsigned expanded = 0;
+    int c;
+
+    while ((c = fgetc(input)) != EOF)
+    {
+        frame[count++] = (uint8_t)c;
+
+        // Resynchronise on the next header whenever the bytes cannot be a log frame
+        while (count)
+        {
+            uint8_t valid = (frame[0] == LOG_EVENT_HEADER) &&
+                            ((count < 2) || (frame[1] < LOG_MESSAGE_COUNT)) &&
+                            ((count < 3) || (frame[2] + 4u <= LOG_EVENT_MAX_FRAME_LENGTH)) &&
+                            ((count < 3) || (count < frame[2] + 4u) ||
+                             (frame[frame[2] + 3] == ACQUISITION_FOOTER));
+            if (valid)
+            {
+                break;
+            }
+            memmove(frame, frame + 1, --count);
+        }
+        if ((count >= 3) && (count == frame[2] + 4u))
+        {
+            uint32 args[LOG_EVENT_MAX_ARGS];
+            int arg_count = Cli_DecodeArgs(&frame[3], frame[2], args);
+
+            if ((arg_count >= 0) && (log_table[frame[1]].level <= min_level))
+            {
+                Cli_Expand(frame[1], args, arg_count);
+                expanded++;
+            }
+            count = 0;
+        }
+    }
+    return expanded;
+}
+
+static void Cli_Usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [options] [capture]\n"
+            "  --level N            highest level printed out: 1 error, 2 warning, 3 info, 4 debug (default 4)\n"
+            "  --table              print the string table and exit\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"level", required_argument, NULL, 'l'},
+        {"table", no_argument, NULL, 't'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    uint8_t min_level = LOG_LEVEL_DEBUG;
+    FILE* input = stdin;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'l': min_level = (uint8_t)atoi(optarg); break;
+            case 't': Cli_PrintTable(); return 0;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (optind < argc)
+    {
+        input = fopen(argv[optind], "rb");
+        if (!input)
+        {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    Cli_Scan(input, min_level);
+    if (input != stdin)
+    {
+        fclose(input);
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,1129 @@
+/*
+* This file includes the host footprint report of the PSoC Creator
+* linker maps (CortexM3/ARM_GCC_541/<config>/<project>.map): flash and
+* RAM per object, per group and per symbol, the difference between two
+* builds and the check against a budget file.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 Host/MapFootprint/MapFootprintCli.c -o lis3dh_footprint
+*
+* Flash is every allocated section placed in the rom region plus the
+* initial values of .data (load address in rom); RAM is every section
+* placed in the ram region, heap and stack included. The bytes of an
+* output section not claimed by an input section (alignment, linker
+* data, heap and stack reservations) are counted to the (linker) object.
+*
+* Exit code: 0 within budget, 1 over budget, 2 usage or parse error.
+*/
+
+#include <ctype.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*   \brief Regions of the footprint.
+*/
+#define FOOTPRINT_FLASH 0
+#define FOOTPRINT_RAM 1
+#define FOOTPRINT_REGION_COUNT 2
+
+/**
+*   \brief Longest line of a map and longest name kept.
+*/
+#define FOOTPRINT_LINE_LENGTH 1024
+#define FOOTPRINT_NAME_LENGTH 96
+
+/**
+*   \brief Most symbols of an input section split by address.
+*/
+#define FOOTPRINT_MAX_SECTION_SYMBOLS 64
+
+/**
+*   \brief Groups of objects.
+*/
+typedef enum {
+    GROUP_APP,              ///< Sources of the project
+    GROUP_PSOC,             ///< Generated components and startup of PSoC Creator
+    GROUP_SOFTFLOAT,        ///< Floating point emulation of libgcc
+    GROUP_LIBGCC,           ///< Other libgcc helpers
+    GROUP_NEWLIB,           ///< C library (newlib nano)
+    GROUP_CRT,              ///< C runtime startup files
+    GROUP_LINKER,           ///< Alignment, linker data, heap and stack
+    GROUP_COUNT
+} Footprint_Group;
+
+static const char* const group_names[GROUP_COUNT] = {"app", "psoc", "softfloat", "libgcc", "newlib", "crt", "linker"};
+static const char* const region_names[FOOTPRINT_REGION_COUNT] = {"flash", "ram"};
+
+/**
+*   \brief Object (or archive member) linked in the image.
+*/
+typedef struct {
+    char name[FOOTPRINT_NAME_LENGTH];
+    Footprint_Group group;
+    uint32_t size[FOOTPRINT_REGION_COUNT];
+} Footprint_Object;
+
+/**
+*   \brief Symbol of an object, or input section without symbols.
+*/
+typedef struct {
+    char name[FOOTPRINT_NAME_LENGTH];
+    int object;
+    uint32_t size[FOOTPRINT_REGION_COUNT];
+} Footprint_Symbol;
+
+/**
+*   \brief Footprint of a map.
+*/
+typedef struct {
+    const char* path;
+    uint32_t region_origin[FOOTPRINT_REGION_COUNT];
+    uint32_t region_length[FOOTPRINT_REGION_COUNT];
+    uint32_t total[FOOTPRINT_REGION_COUNT];
+    uint32_t group[GROUP_COUNT][FOOTPRINT_REGION_COUNT];
+    Footprint_Object* objects;
+    int object_count;
+    Footprint_Symbol* symbols;
+    int symbol_count;
+} Footprint_Map;
+
+/**
+*   \brief Input section being parsed, with the symbols defined in it.
+*/
+typedef struct {
+    char name[FOOTPRINT_NAME_LENGTH];
+    int object;
+    uint32_t address;
+    uint32_t size;
+    uint8_t in_region[FOOTPRINT_REGION_COUNT];
+    int symbol_count;
+    uint32_t symbol_address[FOOTPRINT_MAX_SECTION_SYMBOLS];
+    char symbol_name[FOOTPRINT_MAX_SECTION_SYMBOLS][FOOTPRINT_NAME_LENGTH];
+} Footprint_Section;
+
+/**
+*   \brief Output section being parsed.
+*/
+typedef struct {
+    char name[FOOTPRINT_NAME_LENGTH];
+    uint8_t in_region[FOOTPRINT_REGION_COUNT];
+    uint32_t size;
+    uint32_t claimed;       ///< Bytes of the input sections
+} Footprint_Output;
+
+/**
+*   \brief Line of the budget file.
+*/
+typedef struct {
+    char kind[16];          ///< total, growth, group or object
+    char name[FOOTPRINT_NAME_LENGTH];
+    int region;
+    uint32_t limit;
+} Footprint_Limit;
+
+/**
+*   \brief Copy a name, truncated to the size of the destination.
+*/
+static void Cli_CopyName(char* destination, const char* source, size_t length)
+{
+    size_t n = (length < FOOTPRINT_NAME_LENGTH - 1) ? length : FOOTPRINT_NAME_LENGTH - 1;
+
+    memcpy(destination, source, n);
+    destination[n] = '\0';
+}
+
+/**
+*   \brief Check whether a token is a hexadecimal number (0x...).
+*/
+static int Cli_IsHex(const char* token)
+{
+    return (token != NULL) && (token[0] == '0') && (token[1] == 'x') && isxdigit((unsigned char)token[2]);
+}
+
+/**
+*   \brief Split a line into whitespace separated tokens, up to max_tokens.
+*
+*   \param rest Set to the text after the tokens, NULL if the line has no more text.
+*   \retval Number of tokens.
+*/
+static int Cli_Tokenize(char* line, char** tokens, int max_tokens, char** rest)
+{
+    int count = 0;
+    char* p = line;
+
+    *rest = NULL;
+    while (count < max_tokens)
+    {
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            return count;
+        }
+        tokens[count++] = p;
+        while (*p && !isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (*p)
+        {
+            *p++ = '\0';
+        }
+    }
+    while (isspace((unsigned char)*p))
+    {
+        p++;
+    }
+    if (*p)
+    {
+        *rest = p;
+    }
+    return count;
+}
+
+/**
+*   \brief Strip the trailing whitespace of a line.
+*/
+static void Cli_Chomp(char* line)
+{
+    size_t length = strlen(line);
+
+    while (length && isspace((unsigned char)line[length - 1]))
+    {
+        line[--length] = '\0';
+    }
+}
+
+/**
+*   \brief Name and group of the object of an input section.
+*
+*   Archive members are named after the member, plain objects after the
+*   file name; the group follows from the archive or the file name.
+*/
+static void Cli_ClassifyObject(const char* file, char* name, Footprint_Group* group)
+{
+    size_t file_length = strlen(file);
+    // "archive.a(member.o)": the path itself may have parentheses, "c:/program files (x86)/..."
+    const char* open = (file_length && (file[file_length - 1] == ')')) ? strrchr(file, '(') : NULL;
+    const char* base;
+    const char* archive = NULL;
+    size_t archive_length = 0;
+
+    if (strcmp(file, "linker stubs") == 0)
+    {
+        strcpy(name, "(linker)");
+        *group = GROUP_LINKER;
+        return;
+    }
+
+    if (open)
+    {
+        const char* close = strchr(open, ')');
+
+        for (base = open; (base > file) && (base[-1] != '/') && (base[-1] != '\\'); base--)
+        {
+        }
+        archive = base;
+        archive_length = (size_t)(open - base);
+        Cli_CopyName(name, open + 1, close ? (size_t)(close - open - 1) : strlen(open + 1));
+    }
+    else
+    {
+        base = file + strlen(file);
+        while ((base > file) && (base[-1] != '/') && (base[-1] != '\\'))
+        {
+            base--;
+        }
+        Cli_CopyName(name, base, strlen(base));
+    }
+
+    if (archive == NULL)
+    {
+        if (strncmp(name, "crt", 3) == 0)
+        {
+            *group = GROUP_CRT;
+        }
+        else if ((strncmp(name, "cy", 2) == 0) || (strncmp(name, "Cm3Start", 8) == 0))
+        {
+            *group = GROUP_PSOC;
+        }
+        else
+        {
+            *group = GROUP_APP;
+        }
+    }
+    else if ((archive_length == 8) && (strncmp(archive, "libgcc.a", 8) == 0))
+    {
+        // _arm_addsubdf3.o, _arm_muldivsf3.o, _arm_fixsfsi.o, _arm_truncdfsf2.o...
+        *group = ((strncmp(name, "_arm_", 5) == 0) && (strstr(name, "df") || strstr(name, "sf"))) ?
+                 GROUP_SOFTFLOAT : GROUP_LIBGCC;
+    }
+    else if ((strncmp(archive, "libc", 4) == 0) || (strncmp(archive, "libg", 4) == 0) ||
+             (strncmp(archive, "libm", 4) == 0) || (strncmp(archive, "libnosys", 8) == 0))
+    {
+        *group = GROUP_NEWLIB;
+    }
+    else
+    {
+        // Project archive of the generated components, CyComponentLibrary.a
+        *group = GROUP_PSOC;
+    }
+}
+
+/**
+*   \brief Index of an object, added if not found.
+*/
+static int Cli_FindObject(Footprint_Map* map, const char* name, Footprint_Group group)
+{
+    for (int i = 0; i < map->object_count; i++)
+    {
+        if (strcmp(map->objects[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    map->objects = realloc(map->objects, (size_t)(map->object_count + 1)*sizeof(Footprint_Object));
+    memset(&map->objects[map->object_count], 0, sizeof(Footprint_Object));
+    Cli_CopyName(map->objects[map->object_count].name, name, strlen(name));
+    map->objects[map->object_count].group = group;
+    return map->object_count++;
+}
+
+/**
+*   \brief Count bytes to a symbol of an object and to the totals.
+*/
+static void Cli_AddBytes(Footprint_Map* map, int object, const char* symbol, const uint8_t* in_region,
+                         uint32_t size)
+{
+    Footprint_Symbol* entry = NULL;
+
+    if (size == 0)
+    {
+        return;
+    }
+    for (int i = 0; i < map->symbol_count; i++)
+    {
+        if ((map->symbols[i].object == object) && (strcmp(map->symbols[i].name, symbol) == 0))
+        {
+            entry = &map->symbols[i];
+            break;
+        }
+    }
+    if (entry == NULL)
+    {
+        map->symbols = realloc(map->symbols, (size_t)(map->symbol_count + 1)*sizeof(Footprint_Symbol));
+        entry = &map->symbols[map->symbol_count++];
+        memset(entry, 0, sizeof(*entry));
+        Cli_CopyName(entry->name, symbol, strlen(symbol));
+        entry->object = object;
+    }
+    for (int region = 0; region < FOOTPRINT_REGION_COUNT; region++)
+    {
+        if (in_region[region])
+        {
+            entry->size[region] += size;
+            map->objects[object].size[region] += size;
+            map->group[map->objects[object].group][region] += size;
+            map->total[region] += size;
+        }
+    }
+}
+
+/**
+*   \brief Name of the bytes of an input section not covered by a symbol.
+*
+*   With -ffunction-sections and -fdata-sections the section is named
+*   after its function or variable (.text.main), which also covers the
+*   static ones that have no symbol line in the map.
+*/
+static void Cli_SectionSymbolName(const char* section, char* name)
+{
+    static const char* const prefixes[] = {".text.", ".rodata.", ".data.", ".bss."};
+
+    for (size_t i = 0; i < sizeof(prefixes)/sizeof(prefixes[0]); i++)
+    {
+        size_t length = strlen(prefixes[i]);
+
+        if ((strncmp(section, prefixes[i], length) == 0) && (strncmp(section + length, "str1.", 5) != 0) &&
+            section[length])
+        {
+            Cli_CopyName(name, section + length, strlen(section + length));
+            return;
+        }
+    }
+    Cli_CopyName(name, section, strlen(section));
+}
+
+/**
+*   \brief Count an input section, split among its symbols by address.
+*/
+static void Cli_CloseSection(Footprint_Map* map, Footprint_Section* section)
+{
+    char name[FOOTPRINT_NAME_LENGTH];
+    uint32_t covered = section->address;
+
+    if ((section->object < 0) || (section->size == 0))
+    {
+        section->object = -1;
+        return;
+    }
+
+    // Symbols are listed by increasing address; aliases share the size of the first name
+    Cli_SectionSymbolName(section->name, name);
+    for (int i = 0; i < section->symbol_count; i++)
+    {
+        uint32_t start = section->symbol_address[i];
+        uint32_t end = section->address + section->size;
+
+        if (start < covered)
+        {
+            continue;
+        }
+        Cli_AddBytes(map, section->object, name, section->in_region, start - covered);
+        for (int j = i + 1; j < section->symbol_count; j++)
+        {
+            if (section->symbol_address[j] > start)
+            {
+                end = section->symbol_address[j];
+                break;
+            }
+        }
+        Cli_AddBytes(map, section->object, section->symbol_name[i], section->in_region, end - start);
+        covered = end;
+    }
+    Cli_AddBytes(map, section->object, name, section->in_region, section->address + section->size - covered);
+    section->object = -1;
+}
+
+/**
+*   \brief Count the bytes of an output section not claimed by its input sections.
+*/
+static void Cli_CloseOutput(Footprint_Map* map, Footprint_Output* output)
+{
+    if (output->size > output->claimed)
+    {
+        int object = Cli_FindObject(map, "(linker)", GROUP_LINKER);
+
+        Cli_AddBytes(map, object, output->name, output->in_region, output->size - output->claimed);
+    }
+    memset(output, 0, sizeof(*output));
+}
+
+/**
+*   \brief Check whether an address lies in a region.
+*/
+static int Cli_InRegion(const Footprint_Map* map, int region, uint32_t address)
+{
+    return map->region_length[region] && (address >= map->region_origin[region]) &&
+           (address - map->region_origin[region] < map->region_length[region]);
+}
+
+/**
+*   \brief Check whether an output section is loaded in the target.
+*/
+static int Cli_IsAllocated(const char* name)
+{
+    static const char* const skipped[] = {".debug", ".stab", ".comment", ".line", ".ARM.attributes", ".note"};
+
+    for (size_t i = 0; i < sizeof(skipped)/sizeof(skipped[0]); i++)
+    {
+        if (strncmp(name, skipped[i], strlen(skipped[i])) == 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+*   \brief Parse a linker map.
+*
+*   \retval 0 on success, -1 if the file can not be read or is not a map.
+*/
+static int Cli_ParseMap(const char* path, Footprint_Map* map)
+{
+    FILE* file = fopen(path, "r");
+    char line[FOOTPRINT_LINE_LENGTH];
+    char pending[FOOTPRINT_NAME_LENGTH] = "";       // Section name wrapped to the next line
+    int pending_output = 0;
+    int in_memory = 0;
+    int in_layout = 0;
+    Footprint_Output output = {0};
+    static Footprint_Section section;
+
+    memset(map, 0, sizeof(*map));
+    map->path = path;
+    section.object = -1;
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        char* tokens[6];
+        char* rest;
+        int count;
+
+        Cli_Chomp(line);
+        if (!in_layout)
+        {
+            if (strcmp(line, "Memory Configuration") == 0)
+            {
+                in_memory = 1;
+            }
+            else if (strcmp(line, "Linker script and memory map") == 0)
+            {
+                in_layout = 1;
+            }
+            else if (in_memory && (Cli_Tokenize(line, tokens, 3, &rest) == 3) && Cli_IsHex(tokens[1]))
+            {
+                int region = (strcmp(tokens[0], "rom") == 0) ? FOOTPRINT_FLASH :
+                             (strcmp(tokens[0], "ram") == 0) ? FOOTPRINT_RAM : -1;
+
+                if (region >= 0)
+                {
+                    map->region_origin[region] = (uint32_t)strtoul(tokens[1], NULL, 16);
+                    map->region_length[region] = (uint32_t)strtoul(tokens[2], NULL, 16);
+                }
+            }
+            continue;
+        }
+
+        // Output section: ".name addr size [load address lma]", the name alone if too long
+        if (line[0] == '.')
+        {
+            Cli_CloseSection(map, &section);
+            Cli_CloseOutput(map, &output);
+            count = Cli_Tokenize(line, tokens, 6, &rest);
+            Cli_CopyName(output.name, tokens[0], strlen(tokens[0]));
+            if (count == 1)
+            {
+                pending_output = 1;
+                continue;
+            }
+            pending_output = 0;
+            if ((count >= 3) && Cli_IsHex(tokens[1]) && Cli_IsHex(tokens[2]) && Cli_IsAllocated(output.name))
+            {
+                uint32_t address = (uint32_t)strtoul(tokens[1], NULL, 16);
+
+                output.size = (uint32_t)strtoul(tokens[2], NULL, 16);
+                output.in_region[FOOTPRINT_FLASH] = (uint8_t)Cli_InRegion(map, FOOTPRINT_FLASH, address);
+                output.in_region[FOOTPRINT_RAM] = (uint8_t)Cli_InRegion(map, FOOTPRINT_RAM, address);
+                if ((count == 6) && (strcmp(tokens[3], "load") == 0) && output.in_region[FOOTPRINT_RAM] &&
+                    Cli_InRegion(map, FOOTPRINT_FLASH, (uint32_t)strtoul(tokens[5], NULL, 16)) &&
+                    (strncmp(output.name, ".data", 5) == 0))
+                {
+                    // Initial values copied from flash at startup
+                    output.in_region[FOOTPRINT_FLASH] = 1;
+                }
+                if (!output.in_region[FOOTPRINT_FLASH] && !output.in_region[FOOTPRINT_RAM])
+                {
+                    output.size = 0;
+                }
+            }
+            continue;
+        }
+        if (!isspace((unsigned char)line[0]))
+        {
+            // LOAD, START GROUP, OUTPUT(...)
+            continue;
+        }
+
+        // Input section: " .name addr size file", the name alone if too long
+        if ((line[1] == '.') || (strncmp(line + 1, "COMMON", 6) == 0))
+        {
+            Cli_CloseSection(map, &section);
+            count = Cli_Tokenize(line, tokens, 3, &rest);
+            if (count == 1)
+            {
+                Cli_CopyName(pending, tokens[0], strlen(tokens[0]));
+                continue;
+            }
+            pending[0] = '\0';
+            if ((count == 3) && Cli_IsHex(tokens[1]) && Cli_IsHex(tokens[2]) && rest)
+            {
+                Cli_CopyName(section.name, tokens[0], strlen(tokens[0]));
+                section.address = (uint32_t)strtoul(tokens[1], NULL, 16);
+                section.size = (uint32_t)strtoul(tokens[2], NULL, 16);
+            }
+            else
+            {
+                continue;
+            }
+        }
+        else
+        {
+            count = Cli_Tokenize(line, tokens, 2, &rest);
+            if (pending_output)
+            {
+                // Address and size of a wrapped output section name
+                char wrapped[FOOTPRINT_LINE_LENGTH];
+
+                pending_output = 0;
+                if ((count == 2) && Cli_IsHex(tokens[0]) && Cli_IsHex(tokens[1]))
+                {
+                    snprintf(wrapped, sizeof(wrapped), "%s %s %s %s", output.name, tokens[0], tokens[1],
+                             rest ? rest : "");
+                    strcpy(line, wrapped);
+                    Cli_Chomp(line);
+                    // Parsed again as a one-line output section
+                    count = Cli_Tokenize(line, tokens, 6, &rest);
+                    if ((count >= 3) && Cli_IsAllocated(output.name))
+                    {
+                        uint32_t address = (uint32_t)strtoul(tokens[1], NULL, 16);
+
+                        output.size = (uint32_t)strtoul(tokens[2], NULL, 16);
+                        output.in_region[FOOTPRINT_FLASH] = (uint8_t)Cli_InRegion(map, FOOTPRINT_FLASH, address);
+                        output.in_region[FOOTPRINT_RAM] = (uint8_t)Cli_InRegion(map, FOOTPRINT_RAM, address);
+                        if (!output.in_region[FOOTPRINT_FLASH] && !output.in_region[FOOTPRINT_RAM])
+                        {
+                            output.size = 0;
+                        }
+                    }
+                }
+                continue;
+            }
+            if (pending[0] && (count == 2) && Cli_IsHex(tokens[0]) && Cli_IsHex(tokens[1]) && rest)
+            {
+                // Address, size and file of a wrapped input section name
+                Cli_CopyName(section.name, pending, strlen(pending));
+                section.address = (uint32_t)strtoul(tokens[0], NULL, 16);
+                section.size = (uint32_t)strtoul(tokens[1], NULL, 16);
+                pending[0] = '\0';
+            }
+            else
+            {
+                pending[0] = '\0';
+                // Symbol defined in the current input section: "addr name"
+                if ((section.object >= 0) && (count == 2) && Cli_IsHex(tokens[0]) && (rest == NULL) &&
+                    (tokens[1][0] != '(') && (tokens[1][0] != '[') &&
+                    (section.symbol_count < FOOTPRINT_MAX_SECTION_SYMBOLS))
+                {
+                    uint32_t address = (uint32_t)strtoul(tokens[0], NULL, 16);
+
+                    if ((address >= section.address) && (address < section.address + section.size))
+                    {
+                        section.symbol_address[section.symbol_count] = address;
+                        Cli_CopyName(section.symbol_name[section.symbol_count], tokens[1], strlen(tokens[1]));
+                        section.symbol_count++;
+                    }
+                }
+                continue;
+            }
+        }
+
+        // New input section of the current output section: rest is the file
+        {
+            char name[FOOTPRINT_NAME_LENGTH];
+            Footprint_Group group;
+
+            section.symbol_count = 0;
+            section.object = -1;
+            if ((output.size == 0) || (section.size == 0) || (rest == NULL))
+            {
+                continue;
+            }
+            Cli_ClassifyObject(rest, name, &group);
+            section.object = Cli_FindObject(map, name, group);
+            memcpy(section.in_region, output.in_region, sizeof(section.in_region));
+            output.claimed += section.size;
+        }
+    }
+    Cli_CloseSection(map, &section);
+    Cli_CloseOutput(map, &output);
+    fclose(file);
+
+    if (!in_layout)
+    {
+        fprintf(stderr, "%s: not a linker map\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+*   \brief Find an object of a map by name.
+*
+*   \retval Index of the object, -1 if not linked.
+*/
+static int Cli_LookupObject(const Footprint_Map* map, const char* name)
+{
+    for (int i = 0; i < map->object_count; i++)
+    {
+        if (strcmp(map->objects[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+*   \brief Find a group by name.
+*
+*   \retval Group, -1 if unknown.
+*/
+static int Cli_LookupGroup(const char* name)
+{
+    for (int group = 0; group < GROUP_COUNT; group++)
+    {
+        if (strcmp(group_names[group], name) == 0)
+        {
+            return group;
+        }
+    }
+    return -1;
+}
+
+/**
+*   \brief Bytes of a symbol of a map, matched by object and symbol name.
+*/
+static uint32_t Cli_LookupSymbol(const Footprint_Map* map, const char* object, const char* name, int region)
+{
+    for (int i = 0; i < map->symbol_count; i++)
+    {
+        if ((strcmp(map->symbols[i].name, name) == 0) &&
+            (strcmp(map->objects[map->symbols[i].object].name, object) == 0))
+        {
+            return map->symbols[i].size[region];
+        }
+    }
+    return 0;
+}
+
+/**
+*   \brief Sort order of the objects and symbols: largest first.
+*/
+static const Footprint_Map* sort_map;
+
+static int Cli_CompareObjects(const void* a, const void* b)
+{
+    const Footprint_Object* x = &sort_map->objects[*(const int*)a];
+    const Footprint_Object* y = &sort_map->objects[*(const int*)b];
+    uint32_t size_x = x->size[FOOTPRINT_FLASH] + x->size[FOOTPRINT_RAM];
+    uint32_t size_y = y->size[FOOTPRINT_FLASH] + y->size[FOOTPRINT_RAM];
+
+    return (size_x < size_y) - (size_x > size_y);
+}
+
+static int Cli_CompareSymbols(const void* a, const void* b)
+{
+    const Footprint_Symbol* x = &sort_map->symbols[*(const int*)a];
+    const Footprint_Symbol* y = &sort_map->symbols[*(const int*)b];
+    uint32_t size_x = x->size[FOOTPRINT_FLASH] + x->size[FOOTPRINT_RAM];
+    uint32_t size_y = y->size[FOOTPRINT_FLASH] + y->size[FOOTPRINT_RAM];
+
+    return (size_x < size_y) - (size_x > size_y);
+}
+
+/**
+*   \brief Indexes of the objects or symbols of a map, largest first.
+*/
+static int* Cli_SortedIndexes(const Footprint_Map* map, int count, int (*compare)(const void*, const void*))
+{
+    int* indexes = malloc((size_t)(count ? count : 1)*sizeof(int));
+
+    for (int i = 0; i < count; i++)
+    {
+        indexes[i] = i;
+    }
+    sort_map = map;
+    qsort(indexes, (size_t)count, sizeof(int), compare);
+    return indexes;
+}
+
+/**
+*   \brief Print out the footprint of a map.
+*/
+static void Cli_Report(const Footprint_Map* map, int symbol_rows)
+{
+    int* objects = Cli_SortedIndexes(map, map->object_count, Cli_CompareObjects);
+
+    printf("%s\n", map->path);
+    for (int region = 0; region < FOOTPRINT_REGION_COUNT; region++)
+    {
+        printf("  %-5s %7u of %7u bytes (%.1f%%)\n", region_names[region], map->total[region],
+               map->region_length[region],
+               map->region_length[region] ? 100.0*map->total[region]/map->region_length[region] : 0.0);
+    }
+
+    printf("\n  %-32s %7s %7s\n", "group", "flash", "ram");
+    for (int group = 0; group < GROUP_COUNT; group++)
+    {
+        printf("  %-32s %7u %7u\n", group_names[group], map->group[group][FOOTPRINT_FLASH],
+               map->group[group][FOOTPRINT_RAM]);
+    }
+
+    printf("\n  %-32s %-9s %7s %7s\n", "object", "group", "flash", "ram");
+    for (int i = 0; i < map->object_count; i++)
+    {
+        const Footprint_Object* object = &map->objects[objects[i]];
+
+        printf("  %-32s %-9s %7u %7u\n", object->name, group_names[object->group], object->size[FOOTPRINT_FLASH],
+               object->size[FOOTPRINT_RAM]);
+    }
+    free(objects);
+
+    if (symbol_rows)
+    {
+        int* symbols = Cli_SortedIndexes(map, map->symbol_count, Cli_CompareSymbols);
+
+        printf("\n  %-32s %-24s %7s %7s\n", "symbol", "object", "flash", "ram");
+        for (int i = 0; (i < map->symbol_count) && ((symbol_rows < 0) || (i < symbol_rows)); i++)
+        {
+            const Footprint_Symbol* symbol = &map->symbols[symbols[i]];
+
+            printf("  %-32s %-24s %7u %7u\n", symbol->name, map->objects[symbol->object].name,
+                   symbol->size[FOOTPRINT_FLASH], symbol->size[FOOTPRINT_RAM]);
+        }
+        free(symbols);
+    }
+}
+
+/**
+*   \brief Symbol changed between two maps.
+*/
+typedef struct {
+    const char* name;
+    const char* object;
+    uint32_t base[FOOTPRINT_REGION_COUNT];
+    uint32_t size[FOOTPRINT_REGION_COUNT];
+} Footprint_Change;
+
+/**
+*   \brief Sort order of the changes: largest difference first.
+*/
+static int Cli_CompareChanges(const void* a, const void* b)
+{
+    const Footprint_Change* x = a;
+    const Footprint_Change* y = b;
+    long delta_x = labs((long)x->size[FOOTPRINT_FLASH] - (long)x->base[FOOTPRINT_FLASH]) +
+                   labs((long)x->size[FOOTPRINT_RAM] - (long)x->base[FOOTPRINT_RAM]);
+    long delta_y = labs((long)y->size[FOOTPRINT_FLASH] - (long)y->base[FOOTPRINT_FLASH]) +
+                   labs((long)y->size[FOOTPRINT_RAM] - (long)y->base[FOOTPRINT_RAM]);
+
+    return (delta_x < delta_y) - (delta_x > delta_y);
+}
+
+/**
+*   \brief Print out a row of the difference, if anything changed.
+*/
+static void Cli_DiffRow(const char* name, const char* group, const uint32_t* base, const uint32_t* size)
+{
+    long flash = (long)size[FOOTPRINT_FLASH] - (long)base[FOOTPRINT_FLASH];
+    long ram = (long)size[FOOTPRINT_RAM] - (long)base[FOOTPRINT_RAM];
+
+    if (flash || ram)
+    {
+        printf("  %-32s %-24s %7u %+7ld %7u %+7ld\n", name, group, size[FOOTPRINT_FLASH], flash, size[FOOTPRINT_RAM],
+               ram);
+    }
+}
+
+/**
+*   \brief Print out the difference between two maps: totals, groups, objects and symbols.
+*/
+static void Cli_Diff(const Footprint_Map* base, const Footprint_Map* map, int symbol_rows)
+{
+    static const uint32_t none[FOOTPRINT_REGION_COUNT] = {0, 0};
+    int* objects = Cli_SortedIndexes(map, map->object_count, Cli_CompareObjects);
+
+    printf("%s -> %s\n", base->path, map->path);
+    printf("\n  %-32s %-24s %7s %7s %7s %7s\n", "", "group", "flash", "delta", "ram", "delta");
+    Cli_DiffRow("total", "", base->total, map->total);
+    for (int group = 0; group < GROUP_COUNT; group++)
+    {
+        Cli_DiffRow(group_names[group], group_names[group], base->group[group], map->group[group]);
+    }
+
+    printf("\n");
+    for (int i = 0; i < map->object_count; i++)
+    {
+        const Footprint_Object* object = &map->objects[objects[i]];
+        int old = Cli_LookupObject(base, object->name);
+
+        Cli_DiffRow(object->name, group_names[object->group], (old >= 0) ? base->objects[old].size : none,
+                    object->size);
+    }
+    for (int i = 0; i < base->object_count; i++)
+    {
+        if (Cli_LookupObject(map, base->objects[i].name) < 0)
+        {
+            Cli_DiffRow(base->objects[i].name, group_names[base->objects[i].group], base->objects[i].size, none);
+        }
+    }
+    free(objects);
+
+    if (symbol_rows)
+    {
+        Footprint_Change* changes = malloc((size_t)(map->symbol_count + base->symbol_count + 1)*
+                                           sizeof(Footprint_Change));
+        int change_count = 0;
+
+        for (int i = 0; i < map->symbol_count; i++)
+        {
+            const Footprint_Symbol* symbol = &map->symbols[i];
+            Footprint_Change* change = &changes[change_count];
+
+            change->name = symbol->name;
+            change->object = map->objects[symbol->object].name;
+            change->base[FOOTPRINT_FLASH] = Cli_LookupSymbol(base, change->object, symbol->name, FOOTPRINT_FLASH);
+            change->base[FOOTPRINT_RAM] = Cli_LookupSymbol(base, change->object, symbol->name, FOOTPRINT_RAM);
+            memcpy(change->size, symbol->size, sizeof(change->size));
+            if (memcmp(change->base, change->size, sizeof(change->size)))
+            {
+                change_count++;
+            }
+        }
+        for (int i = 0; i < base->symbol_count; i++)
+        {
+            const Footprint_Symbol* symbol = &base->symbols[i];
+            const char* object = base->objects[symbol->object].name;
+
+            if (!Cli_LookupSymbol(map, object, symbol->name, FOOTPRINT_FLASH) &&
+                !Cli_LookupSymbol(map, object, symbol->name, FOOTPRINT_RAM))
+            {
+                changes[change_count] = (Footprint_Change){symbol->name, object, {0}, {0}};
+                memcpy(changes[change_count].base, symbol->size, sizeof(symbol->size));
+                change_count++;
+            }
+        }
+        qsort(changes, (size_t)change_count, sizeof(Footprint_Change), Cli_CompareChanges);
+
+        printf("\n  %-32s %-24s %7s %7s %7s %7s\n", "symbol", "object", "flash", "delta", "ram", "delta");
+        for (int i = 0; (i < change_count) && ((symbol_rows < 0) || (i < symbol_rows)); i++)
+        {
+            Cli_DiffRow(changes[i].name, changes[i].object, changes[i].base, changes[i].size);
+        }
+        free(changes);
+    }
+}
+
+/**
+*   \brief Parse the budget file.
+*
+*   One limit per line, '#' starts a comment:
+*
+*     total flash 32768           bytes of the whole image
+*     group newlib flash 1024     bytes of a group
+*     object main.o ram 512       bytes of an object
+*     growth flash 512            bytes gained since the base map (--base)
+*
+*   \retval Number of limits, -1 on a syntax error.
+*/
+static int Cli_ParseBudget(const char* path, Footprint_Limit** limits)
+{
+    FILE* file = fopen(path, "r");
+    char line[FOOTPRINT_LINE_LENGTH];
+    int count = 0;
+    int line_number = 0;
+
+    *limits = NULL;
+    if (file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file))
+    {
+        char* tokens[4];
+        char* rest;
+        char* comment = strchr(line, '#');
+        int token_count;
+        Footprint_Limit limit = {0};
+        int named;
+
+        line_number++;
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        token_count = Cli_Tokenize(line, tokens, 4, &rest);
+        if (token_count == 0)
+        {
+            continue;
+        }
+        named = (strcmp(tokens[0], "group") == 0) || (strcmp(tokens[0], "object") == 0);
+        if ((rest != NULL) || (token_count != (named ? 4 : 3)) ||
+            (!named && strcmp(tokens[0], "total") && strcmp(tokens[0], "growth")))
+        {
+            fprintf(stderr, "%s:%d: expected <total|growth> <flash|ram> <bytes> or <group|object> <name> ...\n",
+                    path, line_number);
+            fclose(file);
+            return -1;
+        }
+        Cli_CopyName(limit.kind, tokens[0], strlen(tokens[0]));
+        if (named)
+        {
+            Cli_CopyName(limit.name, tokens[1], strlen(tokens[1]));
+            if ((strcmp(tokens[0], "group") == 0) && (Cli_LookupGroup(limit.name) < 0))
+            {
+                fprintf(stderr, "%s:%d: unknown group %s\n", path, line_number, limit.name);
+                fclose(file);
+                return -1;
+            }
+        }
+        limit.region = (strcmp(tokens[named + 1], "flash") == 0) ? FOOTPRINT_FLASH :
+                       (strcmp(tokens[named + 1], "ram") == 0) ? FOOTPRINT_RAM : -1;
+        if (limit.region < 0)
+        {
+            fprintf(stderr, "%s:%d: unknown region %s\n", path, line_number, tokens[named + 1]);
+            fclose(file);
+            return -1;
+        }
+        limit.limit = (uint32_t)strtoul(tokens[named + 2], NULL, 0);
+
+        *limits = realloc(*limits, (size_t)(count + 1)*sizeof(Footprint_Limit));
+        (*limits)[count++] = limit;
+    }
+    fclose(file);
+    return count;
+}
+
+/**
+*   \brief Check a map against the budget.
+*
+*   \param base Map of the previous build, NULL if not given (growth limits are skipped).
+*   \retval Number of limits exceeded.
+*/
+static int Cli_CheckBudget(const Footprint_Map* map, const Footprint_Map* base, const Footprint_Limit* limits,
+                           int limit_count)
+{
+    int exceeded = 0;
+
+    printf("\n  %-40s %7s %7s\n", "budget", "used", "limit");
+    for (int i = 0; i < limit_count; i++)
+    {
+        const Footprint_Limit* limit = &limits[i];
+        const char* region = region_names[limit->region];
+        char label[FOOTPRINT_NAME_LENGTH + 32];
+        long used;
+
+        if (strcmp(limit->kind, "total") == 0)
+        {
+            used = map->total[limit->region];
+            snprintf(label, sizeof(label), "total %s", region);
+        }
+        else if (strcmp(limit->kind, "growth") == 0)
+        {
+            if (base == NULL)
+            {
+                continue;
+            }
+            used = (long)map->total[limit->region] - (long)base->total[limit->region];
+            snprintf(label, sizeof(label), "growth %s", region);
+        }
+        else if (strcmp(limit->kind, "group") == 0)
+        {
+            used = map->group[Cli_LookupGroup(limit->name)][limit->region];
+            snprintf(label, sizeof(label), "group %s %s", limit->name, region);
+        }
+        else
+        {
+            int object = Cli_LookupObject(map, limit->name);
+
+            used = (object >= 0) ? map->objects[object].size[limit->region] : 0;
+            snprintf(label, sizeof(label), "object %s %s", limit->name, region);
+        }
+
+        printf("  %-40s %7ld %7u%s\n", label, used, limit->limit, (used > (long)limit->limit) ? "  OVER" : "");
+        if (used > (long)limit->limit)
+        {
+            exceeded++;
+        }
+    }
+    return exceeded;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] MAP\n"
+            "  --base MAP        print out the difference from a previous build\n"
+            "  --budget FILE     check the footprint against a budget file, exit code 1 if exceeded\n"
+            "  --symbols N       list the N largest (or changed) symbols, all with 0\n"
+            "  --quiet           print out the budget check only\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"base", required_argument, NULL, 'b'},
+        {"budget", required_argument, NULL, 'g'},
+        {"symbols", required_argument, NULL, 's'},
+        {"quiet", no_argument, NULL, 'q'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    const char* base_path = NULL;
+    const char* budget_path = NULL;
+    int symbol_rows = 0;
+    int quiet = 0;
+    Footprint_Map map;
+    Footprint_Map base;
+    Footprint_Limit* limits = NULL;
+    int limit_count = 0;
+    int exceeded = 0;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'b': base_path = optarg; break;
+            case 'g': budget_path = optarg; break;
+            case 's': symbol_rows = atoi(optarg) ? atoi(optarg) : -1; break;
+            case 'q': quiet = 1; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    if ((Cli_ParseMap(argv[optind], &map) < 0) || (base_path && (Cli_ParseMap(base_path, &base) < 0)))
+    {
+        return 2;
+    }
+    if (budget_path && ((limit_count = Cli_ParseBudget(budget_path, &limits)) < 0))
+    {
+        return 2;
+    }
+
+    if (!quiet)
+    {
+        if (base_path)
+        {
+            Cli_Diff(&base, &map, symbol_rows);
+        }
+        else
+        {
+            Cli_Report(&map, symbol_rows);
+        }
+    }
+    if (budget_path)
+    {
+        exceeded = Cli_CheckBudget(&map, base_path ? &base : NULL, limits, limit_count);
+        printf("%s: %d limit(s) exceeded\n", map.path, exceeded);
+    }
+    free(limits);
+    return exceeded ? 1 : 0;
+}
+
+/* [] END OF FILE */
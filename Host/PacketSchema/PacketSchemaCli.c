@@ -0,0 +1,416 @@
+/*
+* This file includes the host side of the packet schema (PacketSchema.h):
+* the Bridge Control Panel .iic and .ini files and the decoder of the
+* captures are generated at compile time from the same field lists as
+* the firmware encoders.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn \
+*       Host/PacketSchema/PacketSchemaCli.c -o lis3dh_schema
+*
+* Without a mode, the packets are listed with the offset of each field.
+* The Bridge Control Panel files are regenerated with, e.g.
+*
+*   ./lis3dh_schema --packet ACC_MG --iic --output "Bridge Control Panel/HW_05_DIGIACOMO_SUSANNA_A.iic"
+*   ./lis3dh_schema --packet ACC_MG --ini --output "Bridge Control Panel/HW_05_DIGIACOMO_SUSANNA_A.ini"
+*
+* and --decode turns the packets of a capture (files or stdin) into CSV,
+* one line per sample, with the values scaled as plotted.
+*/
+
+#include "PacketSchema.h"
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+*   \brief Variables and flags of a Bridge Control Panel .ini file.
+*/
+#define CLI_BCP_VARIABLES 32
+#define CLI_BCP_FLAGS 16
+
+/**
+*   \brief Size of the input chunks.
+*/
+#define CLI_CHUNK_SIZE 65536
+
+/**
+*   \brief Field of a packet, as listed in PacketSchema.h.
+*/
+typedef struct {
+    const char* name;
+    uint8_t bytes;
+    uint8_t sign;
+    double scale;
+    const char* scale_text;         ///< Scale as written in the schema, copied into the .ini
+    const char* color;
+    uint8_t offset;                 ///< Offset in the first sample, the header is at 0
+} Cli_Field;
+
+/**
+*   \brief Packet, as listed in PacketSchema.h.
+*/
+typedef struct {
+    const char* name;
+    uint8_t header;
+    uint8_t footer;
+    uint8_t batch;
+    uint8_t length;
+    uint8_t sample_length;
+    const Cli_Field* fields;
+    uint8_t field_count;
+
+    /**
+    *   \brief Decode a frame into the scaled values, sample by sample.
+    */
+    void (*decode)(const uint8_t* frame, double* values);
+} Cli_Packet;
+
+/**
+*   \brief Field tables and decoders generated from PacketSchema.h.
+*/
+#define CLI_FIELD_ENTRY(P, name, bytes, sign, scale, color) \
+    {#name, bytes, sign, scale, #scale, #color, PACKET_##P##_##name##_OFFSET},
+#define CLI_FIELD_VALUE(P, name, bytes, sign, scale, color) *values++ = samples[s].name*(scale);
+#define CLI_DEFINE(P) \
+    static const Cli_Field fields_##P[] = { \
+        PACKET_##P##_FIELDS(CLI_FIELD_ENTRY, P) \
+    }; \
+    static void Cli_Decode_##P(const uint8_t* frame, double* values) \
+    { \
+        Packet_##P samples[PACKET_##P##_BATCH]; \
+        Packet_Decode_##P(frame, samples); \
+        for (uint8_t s = 0; s < PACKET_##P##_BATCH; s++) \
+        { \
+            PACKET_##P##_FIELDS(CLI_FIELD_VALUE, P) \
+        } \
+    }
+PACKET_LIST(CLI_DEFINE)
+#undef CLI_DEFINE
+
+static const Cli_Packet packets[] = {
+    #define CLI_PACKET_ENTRY(P) \
+        {#P, PACKET_##P##_HEADER, PACKET_##P##_FOOTER, PACKET_##P##_BATCH, PACKET_##P##_LENGTH, \
+         PACKET_##P##_SAMPLE_LENGTH, fields_##P, sizeof(fields_##P)/sizeof(fields_##P[0]), Cli_Decode_##P},
+    PACKET_LIST(CLI_PACKET_ENTRY)
+    #undef CLI_PACKET_ENTRY
+};
+
+#define CLI_PACKET_COUNT (sizeof(packets)/sizeof(packets[0]))
+
+/**
+*   \brief Default colors of the unused variables and of the flags, as saved by Bridge Control Panel.
+*/
+static const char* const variable_colors[CLI_BCP_VARIABLES] = {
+    "Red", "Blue", "Lime", "Green", "BlueViolet", "LawnGreen", "Magenta", "Olive",
+    "MidnightBlue", "Orange", "SeaGreen", "Maroon", "OrangeRed", "Purple", "SaddleBrown", "Gray",
+    "Black", "Blue", "Lime", "Red", "BlueViolet", "LawnGreen", "Magenta", "Olive",
+    "MidnightBlue", "Orange", "SeaGreen", "Maroon", "OrangeRed", "Purple", "SaddleBrown", "Gray",
+};
+
+static const char* const flag_colors[CLI_BCP_FLAGS] = {
+    "Blue", "BlueViolet", "Chocolate", "Gray", "Green", "LawnGreen", "Lime", "Magenta",
+    "Maroon", "MidnightBlue", "Olive", "Orange", "OrangeRed", "Purple", "Red", "SaddleBrown",
+};
+
+/**
+*   \brief Bridge Control Panel type of a field.
+*/
+static const char* Cli_BcpType(uint8_t bytes)
+{
+    return (bytes == 1) ? "byte" : (bytes == 2) ? "int" : "long int";
+}
+
+/**
+*   \brief Name of a variable: the field name, with the sample index if the packet is batched.
+*/
+static void Cli_VariableName(const Cli_Packet* packet, uint8_t sample, uint8_t field, char* name, size_t size)
+{
+    if (packet->batch > 1)
+    {
+        snprintf(name, size, "%s_%u", packet->fields[field].name, sample);
+    }
+    else
+    {
+        snprintf(name, size, "%s", packet->fields[field].name);
+    }
+}
+
+/**
+*   \brief Print out the packets, with the offset of each field.
+*/
+static void Cli_PrintList(FILE* output)
+{
+    for (size_t p = 0; p < CLI_PACKET_COUNT; p++)
+    {
+        const Cli_Packet* packet = &packets[p];
+
+        fprintf(output, "%-8s header 0x%02X footer 0x%02X, %u bytes (%u sample%s of %u bytes)\n", packet->name,
+                packet->header, packet->footer, packet->length, packet->batch, (packet->batch > 1) ? "s" : "",
+                packet->sample_length);
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            const Cli_Field* field = &packet->fields[f];
+
+            fprintf(output, "    %-10s offset %2u  %s%u  scale %s\n", field->name, field->offset,
+                    field->sign ? "int" : "uint", 8*field->bytes, field->scale_text);
+        }
+    }
+}
+
+/**
+*   \brief Write the rx8 line of the .iic script, without line terminator as saved by Bridge Control Panel.
+*/
+static void Cli_WriteIic(const Cli_Packet* packet, FILE* output)
+{
+    char name[64];
+
+    fprintf(output, "rx8 [h=%02X]", packet->header);
+    for (uint8_t s = 0; s < packet->batch; s++)
+    {
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            Cli_VariableName(packet, s, f, name, sizeof(name));
+            for (uint8_t b = 0; b < packet->fields[f].bytes; b++)
+            {
+                fprintf(output, " @%u%s", b, name);
+            }
+        }
+    }
+    fprintf(output, " [t=%02X]", packet->footer);
+}
+
+/**
+*   \brief Write the .ini file: the variables of the packet first, then the unused ones.
+*/
+static void Cli_WriteIni(const Cli_Packet* packet, FILE* output)
+{
+    char first[64];
+
+    Cli_VariableName(packet, 0, 0, first, sizeof(first));
+    fprintf(output, "[VARIABLES_SETTINGS]\nPACKET=1\nSCROLL=0\nAXIS_X_TYPE=1\nAUTO_RANGE_OF_AXIS_Y=1\n"
+                    "AXIS_Y_MIN=0\nAXIS_Y_MAX=500\nSHOW_FLAGS=0\nAMPLITUDE=10\nTHICKNESS=1\nVARIABLES=%u\n",
+            CLI_BCP_VARIABLES);
+    for (uint8_t v = 0; v < CLI_BCP_VARIABLES; v++)
+    {
+        uint8_t used = v < packet->batch*packet->field_count;
+        const Cli_Field* field = used ? &packet->fields[v % packet->field_count] : NULL;
+        char name[64];
+
+        if (used)
+        {
+            Cli_VariableName(packet, v/packet->field_count, v % packet->field_count, name, sizeof(name));
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "Var%u", v + 1);
+        }
+        fprintf(output, "Var%u.Number=%u\n", v + 1, v + 1);
+        fprintf(output, "Var%u.Active=%s\n", v + 1, used ? "True" : "False");
+        fprintf(output, "Var%u.VariableName=%s\n", v + 1, name);
+        fprintf(output, "Var%u.Type=%s\n", v + 1, used ? Cli_BcpType(field->bytes) : "byte");
+        fprintf(output, "Var%u.Sign=%s\n", v + 1, (used && field->sign) ? "True" : "False");
+        fprintf(output, "Var%u.Scale=%s\n", v + 1, used ? field->scale_text : "1");
+        fprintf(output, "Var%u.Offset=0\n", v + 1);
+        fprintf(output, "Var%u.Color=%s\n", v + 1, used ? field->color : variable_colors[v]);
+    }
+
+    fprintf(output, "[FLAGS_SETTINGS]\nFLAGS=%u\n", CLI_BCP_FLAGS);
+    for (uint8_t f = 0; f < CLI_BCP_FLAGS; f++)
+    {
+        fprintf(output, "Flag%u.Number=%u\n", f + 1, f + 1);
+        fprintf(output, "Flag%u.Active=False\n", f + 1);
+        fprintf(output, "Flag%u.VariableName=%s\n", f + 1, first);
+        fprintf(output, "Flag%u.FlagName=gf%X\n", f + 1, f);
+        fprintf(output, "Flag%u.BitMask=00000000\n", f + 1);
+        fprintf(output, "Flag%u.Inversion=False\n", f + 1);
+        fprintf(output, "Flag%u.Visible=False\n", f + 1);
+        fprintf(output, "Flag%u.Position=0\n", f + 1);
+        fprintf(output, "Flag%u.Color=%s\n", f + 1, flag_colors[f]);
+    }
+}
+
+/**
+*   \brief Decimals to print a value of the given scale: those of the scale as written.
+*/
+static int Cli_Decimals(const char* scale_text)
+{
+    const char* point = strchr(scale_text, '.');
+    return point ? (int)strlen(point + 1) : 0;
+}
+
+/**
+*   \brief Decode the packets of a buffer into CSV lines.
+*
+*   \retval Bytes consumed: the bytes after it may be the start of a packet.
+*/
+static size_t Cli_Decode(const Cli_Packet* packet, const uint8_t* data, size_t length, FILE* output,
+                         uint64_t* decoded, uint64_t* skipped)
+{
+    double values[CLI_BCP_VARIABLES];
+    size_t position = 0;
+
+    while (length - position >= packet->length)
+    {
+        if ((data[position] != packet->header) || (data[position + packet->length - 1] != packet->footer))
+        {
+            position++;
+            (*skipped)++;
+            continue;
+        }
+        packet->decode(&data[position], values);
+        for (uint8_t s = 0; s < packet->batch; s++)
+        {
+            for (uint8_t f = 0; f < packet->field_count; f++)
+            {
+                fprintf(output, "%s%.*f", f ? "," : "", Cli_Decimals(packet->fields[f].scale_text),
+                        values[s*packet->field_count + f]);
+            }
+            fprintf(output, "\n");
+        }
+        position += packet->length;
+        (*decoded)++;
+    }
+    return position;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [--packet NAME (--iic | --ini | --decode)] [--output FILE] [CAPTURE...]\n"
+            "  --packet NAME   packet of PacketSchema.h (see the list without options)\n"
+            "  --iic           write the rx8 line of the Bridge Control Panel script\n"
+            "  --ini           write the Bridge Control Panel variables\n"
+            "  --decode        decode the packets of the captures (or stdin) into CSV\n"
+            "  --output FILE   write to FILE instead of stdout\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"packet", required_argument, NULL, 'p'},
+        {"iic", no_argument, NULL, 'i'},
+        {"ini", no_argument, NULL, 'n'},
+        {"decode", no_argument, NULL, 'd'},
+        {"output", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    const Cli_Packet* packet = NULL;
+    const char* output_path = NULL;
+    FILE* output = stdout;
+    int mode = 0;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'p':
+                for (size_t p = 0; p < CLI_PACKET_COUNT; p++)
+                {
+                    if (strcmp(optarg, packets[p].name) == 0)
+                    {
+                        packet = &packets[p];
+                    }
+                }
+                if (packet == NULL)
+                {
+                    fprintf(stderr, "unknown packet %s\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'i':
+            case 'n':
+            case 'd':
+                mode = option;
+                break;
+            case 'o': output_path = optarg; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if ((mode != 0) && (packet == NULL))
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+    if (packet && (packet->batch*packet->field_count > CLI_BCP_VARIABLES))
+    {
+        fprintf(stderr, "%s: %u variables, Bridge Control Panel plots up to %u\n", packet->name,
+                packet->batch*packet->field_count, CLI_BCP_VARIABLES);
+        return 2;
+    }
+    if (output_path && ((output = fopen(output_path, "w")) == NULL))
+    {
+        perror(output_path);
+        return 2;
+    }
+
+    if (mode == 'i')
+    {
+        Cli_WriteIic(packet, output);
+    }
+    else if (mode == 'n')
+    {
+        Cli_WriteIni(packet, output);
+    }
+    else if (mode == 'd')
+    {
+        static uint8_t chunk[UINT8_MAX + CLI_CHUNK_SIZE];
+        uint64_t decoded = 0;
+        uint64_t skipped = 0;
+        size_t carry = 0;
+
+        // One line per sample, batched or not
+        for (uint8_t f = 0; f < packet->field_count; f++)
+        {
+            fprintf(output, "%s%s", f ? "," : "", packet->fields[f].name);
+        }
+        fprintf(output, "\n");
+
+        for (int i = optind; (i < argc) || (i == optind); i++)
+        {
+            FILE* input = (i < argc) ? fopen(argv[i], "rb") : stdin;
+            size_t length;
+
+            if (input == NULL)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+            // The bytes of a packet not yet complete are kept at the start of the chunk
+            while ((length = fread(&chunk[carry], 1, CLI_CHUNK_SIZE, input)) > 0)
+            {
+                size_t used = Cli_Decode(packet, chunk, carry + length, output, &decoded, &skipped);
+
+                carry = carry + length - used;
+                memmove(chunk, &chunk[used], carry);
+            }
+            if (input != stdin)
+            {
+                fclose(input);
+            }
+        }
+        fprintf(stderr, "%llu packets, %llu bytes skipped\n", (unsigned long long)decoded,
+                (unsigned long long)skipped);
+    }
+    else
+    {
+        Cli_PrintList(output);
+    }
+
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,445 @@
+/*
+* This file includes the source code of the writer and of the
+* memory-mapped reader of the columnar capture files.
+*/
+
+#include "CaptureFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Recorder
+{
+/**
+*   \brief Columns start on 8-byte boundaries, so that the raw ones can be used in place.
+*/
+static inline uint64_t Align8(uint64_t offset)
+{
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+/**
+*   \brief Bytes of a raw value of a column.
+*/
+static inline uint32_t ValueBytes(uint8_t column)
+{
+    return (column == TIME_COLUMN) ? sizeof(int64_t) : sizeof(int32_t);
+}
+
+/**
+*   \brief Append the zigzag varints of the differences of the values.
+*/
+template <typename T>
+static void EncodeDeltas(const T* values, size_t count, std::vector<uint8_t>& out)
+{
+    int64_t previous = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int64_t delta = static_cast<int64_t>(values[i]) - previous;
+        uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+
+        while (zigzag >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(zigzag) | 0x80);
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(zigzag));
+        previous = values[i];
+    }
+}
+
+/**
+*   \brief Expand the zigzag varints of a column.
+*
+*   \retval false if the bytes end before count values.
+*/
+template <typename T>
+static bool DecodeDeltas(const uint8_t* bytes, size_t length, T* values, size_t count)
+{
+    const uint8_t* end = bytes + length;
+    int64_t previous = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t zigzag = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+
+        do
+        {
+            if ((bytes == end) || (shift > 63))
+            {
+                return false;
+            }
+            byte = *bytes++;
+            zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+
+        previous += static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        values[i] = static_cast<T>(previous);
+    }
+    return true;
+}
+
+    Writer::~Writer()
+    {
+        if (file)
+        {
+            Close();
+        }
+    }
+
+    bool Writer::Open(const std::string& path, uint8_t sensor_count, double scale, uint32_t chunk_rows,
+                      bool compress_columns)
+    {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        header = FileHeader();
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.version = FILE_VERSION;
+        header.sensor_count = std::min<uint8_t>(std::max<uint8_t>(sensor_count, 1), ACQUISITION_MAX_SENSORS);
+        header.column_count = 1 + header.sensor_count*LIS3DH_AXIS_COUNT;
+        header.chunk_rows = chunk_rows ? chunk_rows : DEFAULT_CHUNK_ROWS;
+        header.scale = scale;
+        compress = compress_columns;
+        write_error = false;
+        file_bytes = 0;
+        chunk_losses = 0;
+        index.clear();
+        times.clear();
+        times.reserve(header.chunk_rows);
+        for (uint8_t column = 1; column < header.column_count; column++)
+        {
+            values_by_column[column].clear();
+            values_by_column[column].reserve(header.chunk_rows);
+        }
+
+        // Written again with the index offset at close
+        Write(&header, sizeof(header));
+        return !write_error;
+    }
+
+    void Writer::Write(const void* data, size_t length)
+    {
+        if (length && (std::fwrite(data, 1, length, file) != length))
+        {
+            write_error = true;
+        }
+        file_bytes += length;
+    }
+
+    void Writer::FlushChunk()
+    {
+        ChunkEntry entry = ChunkEntry();
+        uint32_t rows = static_cast<uint32_t>(times.size());
+
+        if (rows == 0)
+        {
+            return;
+        }
+        entry.magic = CHUNK_MAGIC;
+        entry.rows = rows;
+        entry.losses = chunk_losses;
+        entry.offset = file_bytes;
+        entry.first_row = header.row_count;
+
+        // Columns after the entry, each aligned; the offsets are known before writing
+        encoded.clear();
+        for (uint8_t column = 0; column < header.column_count; column++)
+        {
+            ColumnEntry& entry_column = entry.columns[column];
+            size_t start = encoded.size();
+            size_t raw_length = static_cast<size_t>(rows)*ValueBytes(column);
+            const uint8_t* raw;
+
+            if (column == TIME_COLUMN)
+            {
+                auto range = std::minmax_element(times.begin(), times.end());
+                entry_column.min = *range.first;
+                entry_column.max = *range.second;
+                raw = reinterpret_cast<const uint8_t*>(times.data());
+                if (compress)
+                {
+                    EncodeDeltas(times.data(), rows, encoded);
+                }
+            }
+            else
+            {
+                const std::vector<int32_t>& values = values_by_column[column];
+                auto range = std::minmax_element(values.begin(), values.end());
+                entry_column.min = *range.first;
+                entry_column.max = *range.second;
+                raw = reinterpret_cast<const uint8_t*>(values.data());
+                if (compress)
+                {
+                    EncodeDeltas(values.data(), rows, encoded);
+                }
+            }
+
+            // Keep the raw values when the varints do not save anything (e.g. noise)
+            if (compress && (encoded.size() - start < raw_length))
+            {
+                entry_column.encoding = Encoding::DeltaVarint;
+            }
+            else
+            {
+                encoded.resize(start);
+                encoded.insert(encoded.end(), raw, raw + raw_length);
+                entry_column.encoding = Encoding::Raw;
+            }
+            entry_column.offset = entry.offset + sizeof(ChunkEntry) + start;
+            entry_column.length = static_cast<uint32_t>(encoded.size() - start);
+            encoded.resize(Align8(encoded.size()), 0);
+        }
+
+        Write(&entry, sizeof(entry));
+        Write(encoded.data(), encoded.size());
+        index.push_back(entry);
+
+        header.chunk_count++;
+        header.row_count += rows;
+        header.losses += chunk_losses;
+        chunk_losses = 0;
+        times.clear();
+        for (uint8_t column = 1; column < header.column_count; column++)
+        {
+            values_by_column[column].clear();
+        }
+    }
+
+    bool Writer::Close()
+    {
+        if (file == nullptr)
+        {
+            return false;
+        }
+        FlushChunk();
+        header.losses += chunk_losses;
+        chunk_losses = 0;
+        header.index_offset = file_bytes;
+        Write(index.data(), index.size()*sizeof(ChunkEntry));
+
+        if ((std::fseek(file, 0, SEEK_SET) != 0) || (std::fwrite(&header, sizeof(header), 1, file) != 1))
+        {
+            write_error = true;
+        }
+        if (std::fclose(file) != 0)
+        {
+            write_error = true;
+        }
+        file = nullptr;
+        return !write_error;
+    }
+
+    Reader::~Reader()
+    {
+        if (map)
+        {
+            munmap(const_cast<uint8_t*>(map), map_length);
+        }
+    }
+
+    bool Reader::Open(const std::string& path)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat info;
+
+        if (fd < 0)
+        {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        if ((fstat(fd, &info) != 0) || (static_cast<size_t>(info.st_size) < sizeof(FileHeader)))
+        {
+            error = path + ": not a capture file";
+            close(fd);
+            return false;
+        }
+        map_length = static_cast<size_t>(info.st_size);
+        void* mapping = mmap(nullptr, map_length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            error = path + ": " + std::strerror(errno);
+            map_length = 0;
+            return false;
+        }
+        map = static_cast<const uint8_t*>(mapping);
+        header = reinterpret_cast<const FileHeader*>(map);
+
+        if ((std::memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) ||
+            (header->version != FILE_VERSION) || (header->sensor_count == 0) ||
+            (header->sensor_count > ACQUISITION_MAX_SENSORS) ||
+            (header->column_count != 1 + header->sensor_count*LIS3DH_AXIS_COUNT) || (header->chunk_rows == 0))
+        {
+            error = path + ": not a capture file, or of another version";
+            return false;
+        }
+        if (!LoadIndex())
+        {
+            error = path + ": damaged chunk index";
+            return false;
+        }
+        return true;
+    }
+
+    bool Reader::CheckEntry(const ChunkEntry* entry) const
+    {
+        if ((entry->magic != CHUNK_MAGIC) || (entry->rows == 0) || (entry->rows > header->chunk_rows))
+        {
+            return false;
+        }
+        for (uint8_t column = 0; column < header->column_count; column++)
+        {
+            const ColumnEntry& entry_column = entry->columns[column];
+
+            if ((entry_column.offset % 8) || (entry_column.offset > map_length) ||
+                (entry_column.length > map_length - entry_column.offset))
+            {
+                return false;
+            }
+            if ((entry_column.encoding == Encoding::Raw) &&
+                (entry_column.length != static_cast<uint64_t>(entry->rows)*ValueBytes(column)))
+            {
+                return false;
+            }
+            if ((entry_column.encoding != Encoding::Raw) && (entry_column.encoding != Encoding::DeltaVarint))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Reader::LoadIndex()
+    {
+        uint64_t index_offset = header->index_offset;
+
+        chunks.clear();
+        row_count = 0;
+        recovered = false;
+
+        if ((index_offset != 0) && (index_offset % 8 == 0) && (index_offset <= map_length) &&
+            (header->chunk_count <= (map_length - index_offset)/sizeof(ChunkEntry)))
+        {
+            const ChunkEntry* entries = reinterpret_cast<const ChunkEntry*>(map + index_offset);
+
+            for (uint64_t chunk = 0; chunk < header->chunk_count; chunk++)
+            {
+                if (!CheckEntry(&entries[chunk]))
+                {
+                    return false;
+                }
+                chunks.push_back(&entries[chunk]);
+                row_count += entries[chunk].rows;
+            }
+            return true;
+        }
+
+        // Not closed: walk the chunk entries, up to the first incomplete one
+        recovered = true;
+        for (uint64_t offset = sizeof(FileHeader); map_length - offset >= sizeof(ChunkEntry);)
+        {
+            const ChunkEntry* entry = reinterpret_cast<const ChunkEntry*>(map + offset);
+            uint64_t end = offset + sizeof(ChunkEntry);
+
+            if ((entry->offset != offset) || !CheckEntry(entry))
+            {
+                break;
+            }
+            chunks.push_back(entry);
+            row_count += entry->rows;
+            for (uint8_t column = 0; column < header->column_count; column++)
+            {
+                end = std::max(end, Align8(entry->columns[column].offset + entry->columns[column].length));
+            }
+            offset = end;
+        }
+        return true;
+    }
+
+    const int64_t* Reader::GetTimes(size_t chunk, std::vector<int64_t>& scratch) const
+    {
+        const ChunkEntry& entry = *chunks[chunk];
+        const ColumnEntry& column = entry.columns[TIME_COLUMN];
+
+        if (column.encoding == Encoding::Raw)
+        {
+            return reinterpret_cast<const int64_t*>(map + column.offset);
+        }
+        scratch.resize(entry.rows);
+        if (!DecodeDeltas(map + column.offset, column.length, scratch.data(), entry.rows))
+        {
+            std::fill(scratch.begin(), scratch.end(), 0);
+        }
+        return scratch.data();
+    }
+
+    const int32_t* Reader::GetColumn(size_t chunk, uint8_t column_index, std::vector<int32_t>& scratch) const
+    {
+        const ChunkEntry& entry = *chunks[chunk];
+        const ColumnEntry& column = entry.columns[column_index];
+
+        if (column.encoding == Encoding::Raw)
+        {
+            return reinterpret_cast<const int32_t*>(map + column.offset);
+        }
+        scratch.resize(entry.rows);
+        if (!DecodeDeltas(map + column.offset, column.length, scratch.data(), entry.rows))
+        {
+            std::fill(scratch.begin(), scratch.end(), 0);
+        }
+        return scratch.data();
+    }
+
+    RowRange Reader::Find(int64_t begin_us, int64_t end_us) const
+    {
+        RowRange range = {0, 0, 0, 0, 0};
+        std::vector<int64_t> scratch;
+
+        if (chunks.empty() || (begin_us >= end_us))
+        {
+            return range;
+        }
+
+        // First chunk ending at or after begin, first chunk starting at or after end
+        auto first = std::partition_point(chunks.begin(), chunks.end(), [begin_us](const ChunkEntry* entry)
+        {
+            return entry->columns[TIME_COLUMN].max < begin_us;
+        });
+        auto last = std::partition_point(first, chunks.end(), [end_us](const ChunkEntry* entry)
+        {
+            return entry->columns[TIME_COLUMN].min < end_us;
+        });
+        if (first == last)
+        {
+            return range;
+        }
+
+        range.first_chunk = static_cast<size_t>(first - chunks.begin());
+        range.last_chunk = static_cast<size_t>(last - chunks.begin()) - 1;
+
+        const int64_t* times = GetTimes(range.first_chunk, scratch);
+        range.first_row = static_cast<uint32_t>(std::lower_bound(times, times + (*first)->rows, begin_us) - times);
+
+        const ChunkEntry& last_entry = *chunks[range.last_chunk];
+        times = GetTimes(range.last_chunk, scratch);
+        range.end_row = static_cast<uint32_t>(std::lower_bound(times, times + last_entry.rows, end_us) - times);
+
+        uint64_t begin_row = (*first)->first_row + range.first_row;
+        uint64_t end_row = last_entry.first_row + range.end_row;
+        range.rows = (end_row > begin_row) ? end_row - begin_row : 0;
+        return range;
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,245 @@
+/**
+*   \file CaptureFile.h
+*   \brief Columnar capture file of the decoded accelerometer samples.
+*
+*   Long recordings are stored as decoded samples, one column per value:
+*   the time (int64, us) and the axes of each device (int32, in the units
+*   of the stream, see FileHeader::scale). Rows are grouped in chunks;
+*   each chunk starts with an entry giving its time range, the min/max of
+*   each column and where each column is. The entries are repeated in an
+*   index at the end of the file, so that the reader finds the chunks of
+*   a time range with a binary search, without reading the data.
+*
+*   A column is stored raw, or compressed as zigzag varints of the
+*   differences between consecutive values. The file is read through
+*   mmap: a raw column is returned as a pointer into the mapping (no copy),
+*   a compressed one is expanded into a buffer of the caller. Columns start
+*   on 8-byte boundaries.
+*
+*   The times must not decrease from a row to the next one: the recorder
+*   unwraps the device timestamps and keeps the time going on restarts.
+*
+*   The index is written when the file is closed. A file cut short (e.g.
+*   the recorder killed) is still readable: the reader then walks the
+*   chunk entries, and the last incomplete chunk is dropped.
+*
+*   The values are little endian, as on the hosts that read them.
+*/
+
+#ifndef __CAPTURE_FILE_H
+    #define __CAPTURE_FILE_H
+
+    #include "Acquisition.h"
+    #include <cstddef>
+    #include <cstdint>
+    #include <cstdio>
+    #include <string>
+    #include <vector>
+
+    namespace Recorder
+    {
+        /**
+        *   \brief Columns: the time, then X, Y, Z of each device.
+        */
+        constexpr uint8_t TIME_COLUMN = 0;
+        constexpr uint8_t MAX_COLUMNS = 1 + ACQUISITION_MAX_SENSORS*LIS3DH_AXIS_COUNT;
+
+        /**
+        *   \brief Default rows per chunk.
+        */
+        constexpr uint32_t DEFAULT_CHUNK_ROWS = 8192;
+
+        constexpr char FILE_MAGIC[8] = {'L', 'I', 'S', '3', 'D', 'C', 'A', 'P'};
+        constexpr uint16_t FILE_VERSION = 1;
+        constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843;    ///< "CHNK"
+
+        /**
+        *   \brief Storage of a column in a chunk.
+        */
+        enum class Encoding : uint8_t
+        {
+            Raw,            ///< int64 (time) or int32 (axes) array
+            DeltaVarint,    ///< Zigzag LEB128 varints of the differences, the first from 0
+        };
+
+        /**
+        *   \brief First bytes of the file.
+        */
+        struct FileHeader
+        {
+            char magic[8];
+            uint16_t version;
+            uint8_t sensor_count;
+            uint8_t column_count;       ///< 1 + 3*sensor_count
+            uint32_t chunk_rows;        ///< Rows of the full chunks
+            double scale;               ///< m/s^2 of one unit of the axes
+            uint64_t index_offset;      ///< Offset of the index, 0 if the file was not closed
+            uint64_t chunk_count;
+            uint64_t row_count;
+            uint64_t losses;            ///< Samples reported lost by the device (0xA3 markers)
+            uint8_t reserved[8];
+        };
+        static_assert(sizeof(FileHeader) == 64, "file header layout");
+
+        /**
+        *   \brief Place and range of a column in a chunk.
+        */
+        struct ColumnEntry
+        {
+            uint64_t offset;            ///< From the start of the file
+            uint32_t length;            ///< Bytes
+            Encoding encoding;
+            uint8_t reserved[3];
+            int64_t min;
+            int64_t max;
+        };
+
+        /**
+        *   \brief Chunk header, repeated in the index.
+        */
+        struct ChunkEntry
+        {
+            uint32_t magic;
+            uint32_t rows;
+            uint32_t losses;            ///< Samples reported lost while the chunk was recorded
+            uint32_t reserved;
+            uint64_t offset;            ///< Offset of this entry in the file
+            uint64_t first_row;         ///< Rows before the chunk
+            ColumnEntry columns[MAX_COLUMNS];
+        };
+
+        /**
+        *   \brief Writer of a capture file.
+        */
+        class Writer
+        {
+        public:
+            ~Writer();
+
+            /**
+            *   \brief Create the file.
+            *
+            *   \retval false if the file can not be created.
+            */
+            bool Open(const std::string& path, uint8_t sensor_count, double scale,
+                      uint32_t chunk_rows = DEFAULT_CHUNK_ROWS, bool compress = true);
+
+            /**
+            *   \brief Append a row: the time and sensor_count*3 values.
+            */
+            void Append(int64_t time_us, const int32_t* values)
+            {
+                times.push_back(time_us);
+                for (uint8_t column = 1; column < header.column_count; column++)
+                {
+                    values_by_column[column].push_back(values[column - 1]);
+                }
+                if (times.size() == header.chunk_rows)
+                {
+                    FlushChunk();
+                }
+            }
+
+            /**
+            *   \brief Count samples lost before the next row.
+            */
+            void CountLosses(uint32_t samples) { chunk_losses += samples; }
+
+            /**
+            *   \brief Write the last chunk, the index and the header.
+            *
+            *   \retval false on a write error.
+            */
+            bool Close();
+
+            uint64_t GetFileBytes() const { return file_bytes; }
+            const FileHeader& GetHeader() const { return header; }
+
+        private:
+            void FlushChunk();
+            void Write(const void* data, size_t length);
+
+            FILE* file = nullptr;
+            FileHeader header = FileHeader();
+            bool compress = true;
+            bool write_error = false;
+            uint64_t file_bytes = 0;
+            uint32_t chunk_losses = 0;
+            std::vector<int64_t> times;
+            std::vector<int32_t> values_by_column[MAX_COLUMNS];
+            std::vector<uint8_t> encoded;
+            std::vector<ChunkEntry> index;
+        };
+
+        /**
+        *   \brief Rows of a time range: from (first_chunk, first_row) to (last_chunk, end_row), excluded.
+        */
+        struct RowRange
+        {
+            size_t first_chunk;
+            uint32_t first_row;
+            size_t last_chunk;
+            uint32_t end_row;
+            uint64_t rows;
+        };
+
+        /**
+        *   \brief Reader of a capture file, mapped in memory.
+        */
+        class Reader
+        {
+        public:
+            ~Reader();
+
+            /**
+            *   \brief Map the file and load the index.
+            *
+            *   \retval false if the file is not a capture file; see GetError.
+            */
+            bool Open(const std::string& path);
+
+            const FileHeader& GetHeader() const { return *header; }
+            const std::string& GetError() const { return error; }
+            size_t GetChunkCount() const { return chunks.size(); }
+            const ChunkEntry& GetChunk(size_t chunk) const { return *chunks[chunk]; }
+            uint64_t GetRowCount() const { return row_count; }
+
+            /**
+            *   \brief Whether the index was rebuilt from the chunk entries (file not closed).
+            */
+            bool IsRecovered() const { return recovered; }
+
+            /**
+            *   \brief Times of a chunk: into the mapping if raw, else expanded into scratch.
+            */
+            const int64_t* GetTimes(size_t chunk, std::vector<int64_t>& scratch) const;
+
+            /**
+            *   \brief Values of a column of a chunk: into the mapping if raw, else expanded into scratch.
+            */
+            const int32_t* GetColumn(size_t chunk, uint8_t column, std::vector<int32_t>& scratch) const;
+
+            /**
+            *   \brief Rows with begin_us <= time < end_us.
+            *
+            *   The chunks are found in the index; only the times of the first
+            *   and last chunk of the range are read.
+            */
+            RowRange Find(int64_t begin_us, int64_t end_us) const;
+
+        private:
+            bool LoadIndex();
+            bool CheckEntry(const ChunkEntry* entry) const;
+
+            const uint8_t* map = nullptr;
+            size_t map_length = 0;
+            const FileHeader* header = nullptr;
+            std::vector<const ChunkEntry*> chunks;
+            uint64_t row_count = 0;
+            bool recovered = false;
+            std::string error;
+        };
+    }
+
+#endif
+/* [] END OF FILE */
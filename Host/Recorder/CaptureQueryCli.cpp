@@ -0,0 +1,356 @@
+/*
+* This file includes the query tool of the columnar capture files
+* written by lis3dh_record (CaptureFile.h).
+*
+* Build from the repository root:
+*
+*   g++ -std=c++17 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn -IHost/Recorder \
+*       Host/Recorder/CaptureFile.cpp Host/Recorder/CaptureQueryCli.cpp -o lis3dh_query
+*
+* The rows of a time range (--from, --to, in ms from the first row) are
+* printed out as CSV in m/s^2, or summarized with --stats: the min/max of
+* the chunks covered by the range come from the index, only the chunks
+* at the ends of the range are read. --bench times random range queries.
+*/
+
+#include "CaptureFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <limits>
+#include <vector>
+
+static const char* const encoding_names[] = {"raw", "delta-varint"};
+
+/**
+*   \brief Call handler(chunk, first row, end row) for each chunk of a range.
+*/
+template <typename Handler>
+static void Cli_ForEachChunk(const Recorder::Reader& reader, const Recorder::RowRange& range, Handler&& handler)
+{
+    if (range.rows == 0)
+    {
+        return;
+    }
+    for (size_t chunk = range.first_chunk; chunk <= range.last_chunk; chunk++)
+    {
+        uint32_t first = (chunk == range.first_chunk) ? range.first_row : 0;
+        uint32_t end = (chunk == range.last_chunk) ? range.end_row : reader.GetChunk(chunk).rows;
+
+        if (first < end)
+        {
+            handler(chunk, first, end);
+        }
+    }
+}
+
+/**
+*   \brief Print out the header, the size of each column and the range of each value.
+*/
+static void Cli_PrintInfo(const Recorder::Reader& reader)
+{
+    const Recorder::FileHeader& header = reader.GetHeader();
+    uint64_t column_bytes[Recorder::MAX_COLUMNS] = {};
+    uint32_t encodings[Recorder::MAX_COLUMNS] = {};
+    int64_t min[Recorder::MAX_COLUMNS];
+    int64_t max[Recorder::MAX_COLUMNS];
+    uint64_t losses = 0;
+
+    for (uint8_t column = 0; column < header.column_count; column++)
+    {
+        min[column] = std::numeric_limits<int64_t>::max();
+        max[column] = std::numeric_limits<int64_t>::min();
+    }
+    for (size_t chunk = 0; chunk < reader.GetChunkCount(); chunk++)
+    {
+        const Recorder::ChunkEntry& entry = reader.GetChunk(chunk);
+
+        losses += entry.losses;
+        for (uint8_t column = 0; column < header.column_count; column++)
+        {
+            column_bytes[column] += entry.columns[column].length;
+            encodings[column] |= 1u << static_cast<uint8_t>(entry.columns[column].encoding);
+            min[column] = std::min(min[column], entry.columns[column].min);
+            max[column] = std::max(max[column], entry.columns[column].max);
+        }
+    }
+
+    std::printf("devices  %u, %u columns, chunks of %u rows, scale %g m/s^2%s\n", header.sensor_count,
+                header.column_count, header.chunk_rows, header.scale,
+                reader.IsRecovered() ? " (not closed: index rebuilt)" : "");
+    std::printf("rows     %llu in %zu chunks, %llu samples lost\n", static_cast<unsigned long long>(reader.GetRowCount()),
+                reader.GetChunkCount(), static_cast<unsigned long long>(losses));
+    if (reader.GetChunkCount() == 0)
+    {
+        return;
+    }
+    std::printf("time     %.3f .. %.3f ms\n", min[Recorder::TIME_COLUMN]*1e-3, max[Recorder::TIME_COLUMN]*1e-3);
+    for (uint8_t column = 0; column < header.column_count; column++)
+    {
+        char name[16];
+
+        if (column == Recorder::TIME_COLUMN)
+        {
+            std::snprintf(name, sizeof(name), "time");
+        }
+        else
+        {
+            std::snprintf(name, sizeof(name), "%c%u", 'X' + (column - 1) % LIS3DH_AXIS_COUNT,
+                          (column - 1)/LIS3DH_AXIS_COUNT);
+        }
+        std::printf("column   %-4s %12llu bytes, %5.2f bytes/row, %s%s", name,
+                    static_cast<unsigned long long>(column_bytes[column]),
+                    static_cast<double>(column_bytes[column])/reader.GetRowCount(),
+                    (encodings[column] & 2) ? encoding_names[1] : encoding_names[0],
+                    (encodings[column] == 3) ? " and raw" : "");
+        if (column != Recorder::TIME_COLUMN)
+        {
+            std::printf(", %.4f .. %.4f m/s^2", min[column]*header.scale, max[column]*header.scale);
+        }
+        std::printf("\n");
+    }
+}
+
+/**
+*   \brief Print out the rows of a range as CSV.
+*/
+static void Cli_PrintRows(const Recorder::Reader& reader, const Recorder::RowRange& range)
+{
+    const Recorder::FileHeader& header = reader.GetHeader();
+    std::vector<int64_t> time_scratch;
+    std::vector<int32_t> scratch[Recorder::MAX_COLUMNS];
+    const int32_t* columns[Recorder::MAX_COLUMNS];
+
+    std::printf("time_ms");
+    for (uint8_t column = 1; column < header.column_count; column++)
+    {
+        std::printf(",%c%u", 'X' + (column - 1) % LIS3DH_AXIS_COUNT, (column - 1)/LIS3DH_AXIS_COUNT);
+    }
+    std::printf("\n");
+
+    Cli_ForEachChunk(reader, range, [&](size_t chunk, uint32_t first, uint32_t end)
+    {
+        const int64_t* times = reader.GetTimes(chunk, time_scratch);
+
+        for (uint8_t column = 1; column < header.column_count; column++)
+        {
+            columns[column] = reader.GetColumn(chunk, column, scratch[column]);
+        }
+        for (uint32_t row = first; row < end; row++)
+        {
+            std::printf("%.3f", times[row]*1e-3);
+            for (uint8_t column = 1; column < header.column_count; column++)
+            {
+                std::printf(",%.4f", columns[column][row]*header.scale);
+            }
+            std::printf("\n");
+        }
+    });
+}
+
+/**
+*   \brief Min/max of each value over a range.
+*
+*   \retval Rows read from the columns; the other rows are covered by the chunk entries.
+*/
+static uint64_t Cli_RangeStats(const Recorder::Reader& reader, const Recorder::RowRange& range, int64_t* min,
+                               int64_t* max)
+{
+    const Recorder::FileHeader& header = reader.GetHeader();
+    std::vector<int32_t> scratch;
+    uint64_t rows_read = 0;
+
+    for (uint8_t column = 1; column < header.column_count; column++)
+    {
+        min[column] = std::numeric_limits<int64_t>::max();
+        max[column] = std::numeric_limits<int64_t>::min();
+    }
+    Cli_ForEachChunk(reader, range, [&](size_t chunk, uint32_t first, uint32_t end)
+    {
+        const Recorder::ChunkEntry& entry = reader.GetChunk(chunk);
+
+        for (uint8_t column = 1; column < header.column_count; column++)
+        {
+            if ((first == 0) && (end == entry.rows))
+            {
+                min[column] = std::min(min[column], entry.columns[column].min);
+                max[column] = std::max(max[column], entry.columns[column].max);
+                continue;
+            }
+            const int32_t* values = reader.GetColumn(chunk, column, scratch);
+
+            for (uint32_t row = first; row < end; row++)
+            {
+                min[column] = std::min<int64_t>(min[column], values[row]);
+                max[column] = std::max<int64_t>(max[column], values[row]);
+            }
+        }
+        if ((first != 0) || (end != entry.rows))
+        {
+            rows_read += end - first;
+        }
+    });
+    return rows_read;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options] FILE\n"
+                 "  --from MS       start of the range, from the first row (default: first row)\n"
+                 "  --to MS         end of the range, excluded (default: last row)\n"
+                 "  --csv           print out the rows of the range, in m/s^2\n"
+                 "  --stats         print out the min/max of the range\n"
+                 "  --bench N       time N queries of random ranges of --window ms\n"
+                 "  --window MS     range of the benchmark queries (default 1000)\n"
+                 "Without --csv, --stats or --bench, the file is described.\n",
+                 program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"from", required_argument, nullptr, 'f'},
+        {"to", required_argument, nullptr, 't'},
+        {"csv", no_argument, nullptr, 'c'},
+        {"stats", no_argument, nullptr, 's'},
+        {"bench", required_argument, nullptr, 'b'},
+        {"window", required_argument, nullptr, 'w'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    double from_ms = -INFINITY;
+    double to_ms = INFINITY;
+    bool csv = false;
+    bool stats = false;
+    uint32_t bench = 0;
+    double window_ms = 1000;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 'f': from_ms = std::atof(optarg); break;
+            case 't': to_ms = std::atof(optarg); break;
+            case 'c': csv = true; break;
+            case 's': stats = true; break;
+            case 'b': bench = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'w': window_ms = std::atof(optarg); break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    Recorder::Reader reader;
+    auto start = std::chrono::steady_clock::now();
+
+    if (!reader.Open(argv[optind]))
+    {
+        std::fprintf(stderr, "%s\n", reader.GetError().c_str());
+        return 2;
+    }
+    double open_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const Recorder::FileHeader& header = reader.GetHeader();
+
+    int64_t begin_us = std::isinf(from_ms) ? std::numeric_limits<int64_t>::min() : std::llround(from_ms*1000);
+    int64_t end_us = std::isinf(to_ms) ? std::numeric_limits<int64_t>::max() : std::llround(to_ms*1000);
+
+    if (csv)
+    {
+        Cli_PrintRows(reader, reader.Find(begin_us, end_us));
+    }
+    if (stats)
+    {
+        int64_t min[Recorder::MAX_COLUMNS];
+        int64_t max[Recorder::MAX_COLUMNS];
+        auto query_start = std::chrono::steady_clock::now();
+        Recorder::RowRange range = reader.Find(begin_us, end_us);
+        uint64_t rows_read = Cli_RangeStats(reader, range, min, max);
+        double query_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                    query_start).count();
+
+        std::printf("rows     %llu in chunks %zu..%zu, %llu read, the others from the index (%.3f ms)\n",
+                    static_cast<unsigned long long>(range.rows), range.first_chunk, range.last_chunk,
+                    static_cast<unsigned long long>(rows_read), query_ms);
+        for (uint8_t column = 1; (column < header.column_count) && range.rows; column++)
+        {
+            std::printf("%c%u       %.4f .. %.4f m/s^2\n", 'X' + (column - 1) % LIS3DH_AXIS_COUNT,
+                        (column - 1)/LIS3DH_AXIS_COUNT, min[column]*header.scale, max[column]*header.scale);
+        }
+    }
+    if (bench && reader.GetChunkCount())
+    {
+        int64_t first_us = reader.GetChunk(0).columns[Recorder::TIME_COLUMN].min;
+        int64_t last_us = reader.GetChunk(reader.GetChunkCount() - 1).columns[Recorder::TIME_COLUMN].max;
+        int64_t window_us = std::llround(window_ms*1000);
+        std::vector<int64_t> time_scratch;
+        std::vector<int32_t> scratch;
+        uint32_t state = 0x12345678;
+        uint64_t rows = 0;
+        int64_t checksum = 0;
+        double worst_ms = 0;
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t query = 0; query < bench; query++)
+        {
+            auto query_start = std::chrono::steady_clock::now();
+
+            // xorshift32, the same ranges at each run
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            int64_t begin = first_us + static_cast<int64_t>(static_cast<double>(state)/4294967296.0*
+                                                            std::max<int64_t>(last_us - first_us - window_us, 1));
+            Recorder::RowRange range = reader.Find(begin, begin + window_us);
+
+            // Touch every value of the range
+            Cli_ForEachChunk(reader, range, [&](size_t chunk, uint32_t first, uint32_t end)
+            {
+                const int64_t* times = reader.GetTimes(chunk, time_scratch);
+
+                for (uint32_t row = first; row < end; row++)
+                {
+                    checksum += times[row];
+                }
+                for (uint8_t column = 1; column < header.column_count; column++)
+                {
+                    const int32_t* values = reader.GetColumn(chunk, column, scratch);
+
+                    for (uint32_t row = first; row < end; row++)
+                    {
+                        checksum += values[row];
+                    }
+                }
+            });
+            rows += range.rows;
+            worst_ms = std::max(worst_ms, std::chrono::duration<double, std::milli>(
+                                              std::chrono::steady_clock::now() - query_start).count());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("open     %.3f ms (%zu chunks, %llu rows)\n", open_ms, reader.GetChunkCount(),
+                    static_cast<unsigned long long>(reader.GetRowCount()));
+        std::printf("queries  %u of %.0f ms, %.1f rows each: %.3f ms mean, %.3f ms worst (checksum %lld)\n", bench,
+                    window_ms, static_cast<double>(rows)/bench, seconds*1e3/bench, worst_ms,
+                    static_cast<long long>(checksum));
+    }
+    if (!csv && !stats && !bench)
+    {
+        Cli_PrintInfo(reader);
+    }
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,242 @@
+/*
+* This file includes the recorder of the UART stream of PROJ_2 and
+* PROJ_3 into a columnar capture file (CaptureFile.h).
+*
+* Build from the repository root:
+*
+*   g++ -std=c++17 -O2 -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn -IHost/Decoder -IHost/Recorder \
+*       Host/Decoder/StreamDecoder.cpp Host/Recorder/CaptureFile.cpp Host/Recorder/RecorderCli.cpp \
+*       -o lis3dh_record
+*
+* The input is the raw UART stream: capture files, or stdin (e.g. a
+* serial port set up with stty). The accelerometer frames are decoded
+* and appended as rows; the 0xA3 loss markers are counted in the chunk
+* of the next rows; the other frames are skipped.
+*
+* The time of a row is the timestamp of the 0xA2 frames, unwrapped to
+* 64 bits, or the sample count at the output data rate for the 0xA0
+* frames, which carry no timestamp. It starts from 0 at the first row.
+*/
+
+#include "CaptureFile.h"
+#include "StreamDecoder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <vector>
+
+/**
+*   \brief Time of the rows, kept increasing across timestamp wraps and device restarts.
+*/
+struct Cli_Clock
+{
+    uint32_t period_us;             ///< Period of the 0xA0 frames
+    uint64_t samples = 0;           ///< 0xA0 frames since the first one
+    bool started = false;
+    uint32_t last_timestamp = 0;    ///< Last 0xA2 timestamp
+    int64_t base_us = 0;            ///< Time of the row of timestamp 0
+    int64_t last_us = 0;
+};
+
+/**
+*   \brief Time of a row of 0xA2 frames.
+*/
+static int64_t Cli_TimestampTime(Cli_Clock& clock, uint32_t timestamp)
+{
+    if (!clock.started)
+    {
+        clock.base_us = -static_cast<int64_t>(timestamp);
+        clock.started = true;
+    }
+    else if (timestamp < clock.last_timestamp)
+    {
+        if (clock.last_timestamp - timestamp > 0x80000000u)
+        {
+            // uint32 wrap, every 71 minutes
+            clock.base_us += 0x100000000ll;
+        }
+        else
+        {
+            // Device restarted (or capture repeated): go on one period after the last row
+            clock.base_us = clock.last_us + clock.period_us - timestamp;
+        }
+    }
+    clock.last_timestamp = timestamp;
+    clock.last_us = clock.base_us + timestamp;
+    return clock.last_us;
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s --output FILE [options] [CAPTURE...]\n"
+                 "  --output FILE          capture file to write\n"
+                 "  --format proj2|proj3   frame format (default proj3)\n"
+                 "  --axis-mask MASK       enabled axes, CTRL_REG1 bits 2:0 (default 7)\n"
+                 "  --sensors N            devices of the 0xA2 frames (default 1)\n"
+                 "  --odr-hz HZ            rate of the 0xA0 frames, for their time (default 100)\n"
+                 "  --chunk-rows N         rows per chunk (default %u)\n"
+                 "  --raw                  store the columns uncompressed\n"
+                 "  --repeat N             record the input N times, e.g. to build a long file\n",
+                 program, Recorder::DEFAULT_CHUNK_ROWS);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"output", required_argument, nullptr, 'o'},
+        {"format", required_argument, nullptr, 'f'},
+        {"axis-mask", required_argument, nullptr, 'a'},
+        {"sensors", required_argument, nullptr, 's'},
+        {"odr-hz", required_argument, nullptr, 'r'},
+        {"chunk-rows", required_argument, nullptr, 'c'},
+        {"raw", no_argument, nullptr, 'w'},
+        {"repeat", required_argument, nullptr, 'n'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    Decoder::Config config;
+    const char* output_path = nullptr;
+    uint32_t odr_hz = 100;
+    uint32_t chunk_rows = Recorder::DEFAULT_CHUNK_ROWS;
+    bool compress = true;
+    uint32_t repeat = 1;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 'o': output_path = optarg; break;
+            case 'f':
+                if (std::strcmp(optarg, "proj2") == 0)
+                {
+                    config.format = Decoder::Format::Proj2;
+                }
+                else if (std::strcmp(optarg, "proj3") == 0)
+                {
+                    config.format = Decoder::Format::Proj3;
+                }
+                else
+                {
+                    Cli_Usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'a': config.axis_mask = static_cast<uint8_t>(std::strtoul(optarg, nullptr, 0)); break;
+            case 's': config.sensor_count = static_cast<uint8_t>(std::atoi(optarg)); break;
+            case 'r': odr_hz = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'c': chunk_rows = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'w': compress = false; break;
+            case 'n': repeat = static_cast<uint32_t>(std::atoi(optarg)); break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if ((output_path == nullptr) || (odr_hz == 0) || (repeat == 0))
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    Decoder::StreamDecoder decoder(config);
+    Recorder::Writer writer;
+    uint8_t sensor_count = (config.format == Decoder::Format::Proj3) ? config.sensor_count : 1;
+    Cli_Clock clock;
+
+    clock.period_us = 1000000/odr_hz;
+    if (!writer.Open(output_path, sensor_count, decoder.GetScale(), chunk_rows, compress))
+    {
+        std::perror(output_path);
+        return 2;
+    }
+    sensor_count = writer.GetHeader().sensor_count;
+
+    auto handler = [&](const Decoder::Frame& frame)
+    {
+        int32_t values[ACQUISITION_MAX_SENSORS*LIS3DH_AXIS_COUNT];
+        int64_t time_us;
+
+        switch (frame.type)
+        {
+            case Decoder::FrameType::Accel:
+                time_us = static_cast<int64_t>(clock.samples*1000000/odr_hz);
+                clock.samples++;
+                break;
+            case Decoder::FrameType::MultiAccel:
+                time_us = Cli_TimestampTime(clock, frame.timestamp_us);
+                break;
+            case Decoder::FrameType::Loss:
+                writer.CountLosses(frame.lost);
+                return;
+            default:
+                return;
+        }
+        std::memcpy(values, frame.values, sizeof(int32_t)*sensor_count*LIS3DH_AXIS_COUNT);
+        writer.Append(time_us, values);
+    };
+
+    std::vector<uint8_t> buffer(65536);
+    uint64_t input_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t pass = 0; pass < repeat; pass++)
+    {
+        for (int i = optind; (i < argc) || (i == optind); i++)
+        {
+            FILE* input = (i < argc) ? std::fopen(argv[i], "rb") : stdin;
+            size_t length;
+
+            if (input == nullptr)
+            {
+                std::perror(argv[i]);
+                return 2;
+            }
+            while ((length = std::fread(buffer.data(), 1, buffer.size(), input)) > 0)
+            {
+                decoder.Feed(buffer.data(), length, handler);
+                input_bytes += length;
+            }
+            if (input != stdin)
+            {
+                std::fclose(input);
+            }
+            else
+            {
+                // stdin can not be read again
+                repeat = 1;
+            }
+        }
+    }
+    if (!writer.Close())
+    {
+        std::perror(output_path);
+        return 2;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const Recorder::FileHeader& header = writer.GetHeader();
+    uint64_t raw_bytes = header.row_count*(sizeof(int64_t) + sizeof(int32_t)*sensor_count*LIS3DH_AXIS_COUNT);
+
+    std::printf("input    %llu bytes, %llu bytes skipped, %llu resyncs\n",
+                static_cast<unsigned long long>(input_bytes),
+                static_cast<unsigned long long>(decoder.GetStats().skipped_bytes),
+                static_cast<unsigned long long>(decoder.GetStats().resyncs));
+    std::printf("rows     %llu in %llu chunks, %llu samples lost, %.1f s recorded\n",
+                static_cast<unsigned long long>(header.row_count), static_cast<unsigned long long>(header.chunk_count),
+                static_cast<unsigned long long>(header.losses), (clock.samples ? clock.samples*1.0/odr_hz :
+                                                                  clock.last_us*1e-6));
+    std::printf("file     %llu bytes, %.2f bytes/row (%.1f%% of raw columns)\n",
+                static_cast<unsigned long long>(writer.GetFileBytes()),
+                header.row_count ? static_cast<double>(writer.GetFileBytes())/header.row_count : 0.0,
+                raw_bytes ? 100.0*writer.GetFileBytes()/raw_bytes : 0.0);
+    std::printf("rate     %.1f MB/s of input (%.3f s)\n", input_bytes/seconds/1e6, seconds);
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,528 @@
+/*
+* This file includes the replay of recorded UART streams through a
+* virtual serial port (VirtualSerial.h), at the baud rate or N times
+* faster, with bit errors and dropped bytes.
+*
+* Build from the repository root:
+*
+*   g++ -std=c++17 -O2 -pthread -IHost/Simulator/psoc -IAY1920_II_HW_05_PROJ_3.cydsn -IHost/Decoder -IHost/Replay \
+*       Host/Decoder/StreamDecoder.cpp Host/Replay/VirtualSerial.cpp Host/Replay/ReplayCli.cpp \
+*       -o lis3dh_replay
+*
+* The stream is made of the captures (e.g. from lis3dh_sim --capture),
+* of --synthetic accelerometer frames encoded from PacketSchema.h and of
+* the --text bytes (e.g. firmware commands), in this order, repeated
+* --loop times. The faults are applied as the stream is written.
+*
+* By default the pty path is printed and the stream is written to it
+* for any tool that opens it (lis3dh_record, a terminal...). The same
+* stream can instead drive a benchmark:
+*
+* - --bench-decoder: a thread reads the pty and decodes it with the
+*   StreamDecoder; the frames decoded are compared with those of the
+*   stream before the faults, and the time from the write of a byte to
+*   the decode of its frame is measured.
+* - --bench-firmware SIM: the simulator (Host/Simulator) is started with
+*   the pty as --rx-file and receives the stream at the rate of the
+*   replay in virtual time; its report shows what the firmware command
+*   path read and lost (UART RX line). The pty is then written as fast
+*   as the simulator reads, the pacing being in its virtual clock.
+*/
+
+#include "StreamDecoder.h"
+#include "VirtualSerial.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <getopt.h>
+#include <mutex>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const char* const frame_names[] = {"accel", "aux", "multi", "loss", "raw", "log"};
+
+/**
+*   \brief Append a file to the stream.
+*
+*   \retval false if the file can not be read.
+*/
+static bool Cli_Load(const char* path, std::vector<uint8_t>& stream)
+{
+    FILE* file = std::fopen(path, "rb");
+    uint8_t buffer[65536];
+    size_t length;
+
+    if (file == nullptr)
+    {
+        std::perror(path);
+        return false;
+    }
+    while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        stream.insert(stream.end(), buffer, buffer + length);
+    }
+    std::fclose(file);
+    return true;
+}
+
+/**
+*   \brief Append 0xA0 frames of a 1 g tilt sweep, in the format of the configuration (all axes).
+*/
+static void Cli_Synthesize(const Decoder::Config& config, uint32_t sample_count, std::vector<uint8_t>& stream)
+{
+    for (uint32_t sample = 0; sample < sample_count; sample++)
+    {
+        double angle = 2*M_PI*sample/1000.0;
+        double axes[LIS3DH_AXIS_COUNT] = {std::sin(angle), std::cos(angle), 0.1};
+
+        if (config.format == Decoder::Format::Proj2)
+        {
+            uint8_t frame[PACKET_ACC_MG_LENGTH];
+            Packet_ACC_MG acc = {static_cast<int16_t>(axes[0]*1000), static_cast<int16_t>(axes[1]*1000),
+                                 static_cast<int16_t>(axes[2]*1000)};
+
+            Packet_Encode_ACC_MG(frame, &acc);
+            stream.insert(stream.end(), frame, frame + sizeof(frame));
+        }
+        else
+        {
+            uint8_t frame[PACKET_ACC_LENGTH];
+            Packet_ACC acc = {static_cast<int32_t>(axes[0]*98066.5), static_cast<int32_t>(axes[1]*98066.5),
+                              static_cast<int32_t>(axes[2]*98066.5)};
+
+            Packet_Encode_ACC(frame, &acc);
+            stream.insert(stream.end(), frame, frame + sizeof(frame));
+        }
+    }
+}
+
+/**
+*   \brief Times at which the bytes were written, for the latency of the decoder.
+*/
+struct Cli_Timeline
+{
+    std::mutex mutex;
+    std::deque<std::pair<uint64_t, std::chrono::steady_clock::time_point>> writes;  ///< End offset, time
+};
+
+/**
+*   \brief Write the stream, repeated, with the faults, at the pace.
+*
+*   \retval false if the output failed.
+*/
+template <typename Sink>
+static bool Cli_Replay(const std::vector<uint8_t>& stream, uint32_t loops, Replay::FaultInjector& injector,
+                       Replay::Pacer& pacer, double& max_lag_ms, uint64_t& written, Sink&& sink)
+{
+    std::vector<uint8_t> slice(pacer.GetSliceBytes());
+    uint64_t sent = 0;
+
+    max_lag_ms = 0.0;
+    written = 0;
+    pacer.Start();
+    for (uint32_t loop = 0; loop < loops; loop++)
+    {
+        for (size_t offset = 0; offset < stream.size(); )
+        {
+            size_t length = std::min(slice.size(), stream.size() - offset);
+
+            std::memcpy(slice.data(), &stream[offset], length);
+            offset += length;
+            sent += length;
+            // The bytes of the slice are written when the last one would have been shifted out
+            if (pacer.IsPaced())
+            {
+                auto due = pacer.DueTime(sent - 1);
+                auto now = std::chrono::steady_clock::now();
+
+                if (now < due)
+                {
+                    std::this_thread::sleep_until(due);
+                }
+                else
+                {
+                    max_lag_ms = std::max(max_lag_ms, std::chrono::duration<double, std::milli>(now - due).count());
+                }
+            }
+            length = injector.Apply(slice.data(), length);
+            if (length && !sink(slice.data(), length))
+            {
+                return false;
+            }
+            written += length;
+        }
+    }
+    return true;
+}
+
+/**
+*   \brief Value at a fraction of the sorted samples.
+*/
+static double Cli_Percentile(const std::vector<double>& sorted, double fraction)
+{
+    return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction*sorted.size()))];
+}
+
+/**
+*   \brief Split the extra arguments of the simulator at the spaces.
+*/
+static void Cli_SplitArguments(const std::string& text, std::vector<std::string>& arguments)
+{
+    size_t begin = 0;
+
+    while ((begin = text.find_first_not_of(' ', begin)) != std::string::npos)
+    {
+        size_t end = text.find(' ', begin);
+        arguments.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+}
+
+/**
+*   \brief Print out the usage.
+*/
+static void Cli_Usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [options] [CAPTURE...]\n"
+                 "  --format proj2|proj3   frame format (default proj3)\n"
+                 "  --axis-mask MASK       enabled axes of the captures, CTRL_REG1 bits 2:0 (default 7)\n"
+                 "  --sensors N            devices of the 0xA2 frames (default 1)\n"
+                 "  --synthetic N          append N synthetic 0xA0 frames\n"
+                 "  --text STRING          append bytes, e.g. firmware commands\n"
+                 "  --loop N               replay the stream N times (default 1)\n"
+                 "  --baud BAUD            line rate, 10 bits per byte (default 19200)\n"
+                 "  --speed N              replay N times faster than the line, 0 as fast as possible (default 1)\n"
+                 "  --bit-errors P         probability of a flip per data bit\n"
+                 "  --drops P              probability of a drop per byte\n"
+                 "  --drop-burst N         bytes lost by a drop (default 1)\n"
+                 "  --seed N               seed of the faults (default 1)\n"
+                 "  --link PATH            symbolic link to the pty\n"
+                 "  --delay-ms MS          wait before the replay, e.g. for a reader to open the pty\n"
+                 "  --output FILE          write the stream with the faults to FILE instead of a pty\n"
+                 "  --bench-decoder        decode the pty in a thread and report the losses and latency\n"
+                 "  --bench-firmware SIM   feed the pty to the simulator SIM as its UART input\n"
+                 "  --sim-args ARGS        more arguments of the simulator, e.g. \"--devices 2\"\n",
+                 program);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"format", required_argument, nullptr, 'f'},
+        {"axis-mask", required_argument, nullptr, 'a'},
+        {"sensors", required_argument, nullptr, 's'},
+        {"synthetic", required_argument, nullptr, 'y'},
+        {"text", required_argument, nullptr, 't'},
+        {"loop", required_argument, nullptr, 'l'},
+        {"baud", required_argument, nullptr, 'b'},
+        {"speed", required_argument, nullptr, 'x'},
+        {"bit-errors", required_argument, nullptr, 'e'},
+        {"drops", required_argument, nullptr, 'd'},
+        {"drop-burst", required_argument, nullptr, 'u'},
+        {"seed", required_argument, nullptr, 'r'},
+        {"link", required_argument, nullptr, 'k'},
+        {"delay-ms", required_argument, nullptr, 'w'},
+        {"output", required_argument, nullptr, 'o'},
+        {"bench-decoder", no_argument, nullptr, 'D'},
+        {"bench-firmware", required_argument, nullptr, 'F'},
+        {"sim-args", required_argument, nullptr, 'A'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    Decoder::Config config;
+    Replay::Faults faults;
+    uint32_t synthetic_samples = 0;
+    std::string text;
+    uint32_t loops = 1;
+    uint32_t baud = 19200;
+    double speed = 1.0;
+    const char* link_path = nullptr;
+    uint32_t delay_ms = 0;
+    const char* output_path = nullptr;
+    bool bench_decoder = false;
+    const char* simulator = nullptr;
+    std::string sim_args;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, nullptr)) != -1)
+    {
+        switch (option)
+        {
+            case 'f':
+                if (std::strcmp(optarg, "proj2") == 0)
+                {
+                    config.format = Decoder::Format::Proj2;
+                }
+                else if (std::strcmp(optarg, "proj3") == 0)
+                {
+                    config.format = Decoder::Format::Proj3;
+                }
+                else
+                {
+                    Cli_Usage(argv[0]);
+                    return 2;
+                }
+                break;
+            case 'a': config.axis_mask = static_cast<uint8_t>(std::strtoul(optarg, nullptr, 0)); break;
+            case 's': config.sensor_count = static_cast<uint8_t>(std::atoi(optarg)); break;
+            case 'y': synthetic_samples = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 't': text += optarg; break;
+            case 'l': loops = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'b': baud = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'x': speed = std::atof(optarg); break;
+            case 'e': faults.bit_error_rate = std::atof(optarg); break;
+            case 'd': faults.drop_rate = std::atof(optarg); break;
+            case 'u': faults.drop_burst = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'r': faults.seed = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'k': link_path = optarg; break;
+            case 'w': delay_ms = static_cast<uint32_t>(std::atoi(optarg)); break;
+            case 'o': output_path = optarg; break;
+            case 'D': bench_decoder = true; break;
+            case 'F': simulator = optarg; break;
+            case 'A': sim_args = optarg; break;
+            default: Cli_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if ((baud == 0) || (speed < 0) || (loops == 0) || (bench_decoder && simulator) ||
+        (output_path && (bench_decoder || simulator || link_path)))
+    {
+        Cli_Usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<uint8_t> stream;
+
+    for (int i = optind; i < argc; i++)
+    {
+        if (!Cli_Load(argv[i], stream))
+        {
+            return 2;
+        }
+    }
+    Cli_Synthesize(config, synthetic_samples, stream);
+    stream.insert(stream.end(), text.begin(), text.end());
+    if (stream.empty())
+    {
+        std::fprintf(stderr, "%s: empty stream, give captures, --synthetic or --text\n", argv[0]);
+        return 2;
+    }
+
+    double rate = speed*baud/Replay::BITS_PER_BYTE;
+    Replay::FaultInjector injector(faults);
+    double max_lag_ms;
+    uint64_t written;
+
+    std::printf("stream   %zu bytes x %u, %.2f s at %u baud\n", stream.size(), loops,
+                static_cast<double>(stream.size())*loops*Replay::BITS_PER_BYTE/baud, baud);
+
+    // Stream with the faults into a file, e.g. for lis3dh_sim --rx-file
+    if (output_path)
+    {
+        FILE* output = std::fopen(output_path, "wb");
+        Replay::Pacer pacer(0.0);
+
+        if ((output == nullptr) ||
+            !Cli_Replay(stream, loops, injector, pacer, max_lag_ms, written,
+                        [&](const uint8_t* data, size_t length) { return std::fwrite(data, 1, length, output) == length; }) ||
+            (std::fclose(output) != 0))
+        {
+            std::perror(output_path);
+            return 2;
+        }
+        std::printf("faults   %llu bit errors, %llu bytes dropped\n",
+                    static_cast<unsigned long long>(injector.GetStats().bit_errors),
+                    static_cast<unsigned long long>(injector.GetStats().dropped_bytes));
+        std::printf("output   %llu bytes\n", static_cast<unsigned long long>(written));
+        return 0;
+    }
+
+    Replay::VirtualSerial serial;
+
+    if (!serial.Open())
+    {
+        std::perror("pty");
+        return 2;
+    }
+    if (link_path && !serial.Link(link_path))
+    {
+        std::perror(link_path);
+        return 2;
+    }
+    std::printf("pty      %s\n", serial.GetSlavePath().c_str());
+    std::fflush(stdout);
+
+    // Decoder benchmark: the reader thread
+    Decoder::StreamDecoder decoder(config);
+    Cli_Timeline timeline;
+    std::vector<double> latencies_ms;
+    std::thread reader;
+
+    if (bench_decoder)
+    {
+        reader = std::thread([&]()
+        {
+            std::vector<uint8_t> buffer(4096);
+            uint64_t received = 0;
+            ssize_t length;
+
+            while (((length = ::read(serial.GetSlaveFd(), buffer.data(), buffer.size())) > 0) ||
+                   ((length < 0) && (errno == EINTR)))
+            {
+                uint32_t frames = 0;
+
+                if (length < 0)
+                {
+                    continue;
+                }
+                decoder.Feed(buffer.data(), static_cast<size_t>(length), [&](const Decoder::Frame&) { frames++; });
+                received += static_cast<uint64_t>(length);
+                if (frames == 0)
+                {
+                    continue;
+                }
+                // The frames completed by this read: from the write of its last byte
+                auto now = std::chrono::steady_clock::now();
+                std::lock_guard<std::mutex> lock(timeline.mutex);
+                while ((timeline.writes.size() > 1) && (timeline.writes.front().first < received))
+                {
+                    timeline.writes.pop_front();
+                }
+                if (!timeline.writes.empty())
+                {
+                    double latency_ms = std::chrono::duration<double, std::milli>(now - timeline.writes.front().second).count();
+                    latencies_ms.insert(latencies_ms.end(), frames, latency_ms);
+                }
+            }
+        });
+    }
+
+    // Firmware benchmark: the simulator reads the pty as its UART input
+    pid_t child = -1;
+
+    if (simulator)
+    {
+        // As fast as possible is taken as the line rate; the input is followed by 1 s
+        double rx_rate = (rate > 0) ? rate : static_cast<double>(baud)/Replay::BITS_PER_BYTE;
+        std::vector<std::string> arguments = {simulator, "--rx-file", serial.GetSlavePath(),
+                                              "--baud", std::to_string(baud),
+                                              "--rx-rate", std::to_string(rx_rate),
+                                              "--duration-ms",
+                                              std::to_string(static_cast<uint64_t>(1000.0 + 1000.0*stream.size()*loops/rx_rate))};
+        std::vector<char*> pointers;
+
+        Cli_SplitArguments(sim_args, arguments);
+        for (std::string& argument : arguments)
+        {
+            pointers.push_back(&argument[0]);
+        }
+        pointers.push_back(nullptr);
+        child = fork();
+        if (child == 0)
+        {
+            execv(simulator, pointers.data());
+            std::perror(simulator);
+            _exit(127);
+        }
+        if (child < 0)
+        {
+            std::perror("fork");
+            return 2;
+        }
+    }
+
+    if (delay_ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+
+    // The simulator has its own clock: the pty is only the transport
+    Replay::Pacer pacer(simulator ? 0.0 : rate);
+    auto start = std::chrono::steady_clock::now();
+    bool replayed = Cli_Replay(stream, loops, injector, pacer, max_lag_ms, written,
+                               [&](const uint8_t* data, size_t length)
+                               {
+                                   if (bench_decoder)
+                                   {
+                                       std::lock_guard<std::mutex> lock(timeline.mutex);
+                                       timeline.writes.emplace_back(written + length, std::chrono::steady_clock::now());
+                                   }
+                                   return serial.Write(data, length);
+                               });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    bool drained = serial.Drain(std::chrono::milliseconds(10000));
+
+    serial.Close();
+    if (reader.joinable())
+    {
+        reader.join();
+    }
+    if (!replayed)
+    {
+        std::perror("pty");
+    }
+    // The report of the simulator comes first
+    if (child > 0)
+    {
+        int status;
+
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            std::fprintf(stderr, "%s: simulator failed\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::printf("faults   %llu bit errors, %llu bytes dropped\n",
+                static_cast<unsigned long long>(injector.GetStats().bit_errors),
+                static_cast<unsigned long long>(injector.GetStats().dropped_bytes));
+    std::printf("replay   %llu bytes in %.3f s, %.1f kB/s", static_cast<unsigned long long>(written), seconds,
+                written/seconds/1e3);
+    if (pacer.IsPaced())
+    {
+        std::printf(" (%.1fx of %u baud), max lag %.3f ms", speed, baud, max_lag_ms);
+    }
+    std::printf("%s\n", drained ? "" : ", not all read");
+
+    if (bench_decoder)
+    {
+        Decoder::StreamDecoder reference(config);
+        const Decoder::Stats& stats = decoder.GetStats();
+
+        // Frames of the stream without the faults
+        for (uint32_t loop = 0; loop < loops; loop++)
+        {
+            reference.Feed(stream.data(), stream.size(), [](const Decoder::Frame&) {});
+        }
+        for (size_t type = 0; type < static_cast<size_t>(Decoder::FrameType::Count); type++)
+        {
+            if (reference.GetStats().frames[type] || stats.frames[type])
+            {
+                std::printf("frames   %-5s %llu of %llu decoded\n", frame_names[type],
+                            static_cast<unsigned long long>(stats.frames[type]),
+                            static_cast<unsigned long long>(reference.GetStats().frames[type]));
+            }
+        }
+        std::printf("decoder  %llu bytes, %llu skipped, %llu resyncs\n", static_cast<unsigned long long>(stats.bytes),
+                    static_cast<unsigned long long>(stats.skipped_bytes), static_cast<unsigned long long>(stats.resyncs));
+        std::sort(latencies_ms.begin(), latencies_ms.end());
+        std::printf("latency  p50 %.3f ms, p99 %.3f ms, max %.3f ms (write to decode)\n",
+                    Cli_Percentile(latencies_ms, 0.5), Cli_Percentile(latencies_ms, 0.99),
+                    latencies_ms.empty() ? 0.0 : latencies_ms.back());
+    }
+    std::fflush(stdout);
+
+    return replayed ? 0 : 1;
+}
+
+/* [] END OF FILE */
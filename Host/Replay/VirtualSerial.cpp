@@ -0,0 +1,204 @@
+/*
+* This file includes the source code of the pseudo-terminal, of the
+* pacing and of the fault injection used to replay the UART streams.
+*/
+
+#include "VirtualSerial.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <limits>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+namespace Replay
+{
+/**
+*   \brief Distance to the next event of probability p per trial, or never.
+*/
+static uint64_t NextDistance(std::mt19937_64& generator, double p)
+{
+    if (p <= 0.0)
+    {
+        return std::numeric_limits<uint64_t>::max()/2;
+    }
+    if (p >= 1.0)
+    {
+        return 0;
+    }
+    return std::geometric_distribution<uint64_t>(p)(generator);
+}
+
+    FaultInjector::FaultInjector(const Faults& faults) : faults(faults), generator(faults.seed)
+    {
+        next_bit_error = NextDistance(generator, faults.bit_error_rate);
+        next_drop = NextDistance(generator, faults.drop_rate);
+        if (this->faults.drop_burst == 0)
+        {
+            this->faults.drop_burst = 1;
+        }
+    }
+
+    size_t FaultInjector::Apply(uint8_t* data, size_t length)
+    {
+        size_t kept = 0;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            uint64_t byte = stats.bytes++;
+            uint8_t value = data[i];
+
+            while (next_bit_error < 8*(byte + 1))
+            {
+                value ^= static_cast<uint8_t>(1u << (next_bit_error - 8*byte));
+                stats.bit_errors++;
+                next_bit_error += 1 + NextDistance(generator, faults.bit_error_rate);
+            }
+            if ((dropping == 0) && (byte >= next_drop))
+            {
+                dropping = faults.drop_burst;
+                next_drop = byte + faults.drop_burst + NextDistance(generator, faults.drop_rate);
+            }
+            if (dropping)
+            {
+                dropping--;
+                stats.dropped_bytes++;
+                continue;
+            }
+            data[kept++] = value;
+        }
+        return kept;
+    }
+
+    Pacer::Pacer(double bytes_per_second)
+    {
+        byte_ns = (bytes_per_second > 0.0) ? 1e9/bytes_per_second : 0.0;
+        // Writes of 1 ms when paced; when not, the size of the pty buffer
+        slice_bytes = (bytes_per_second > 0.0) ? std::max<size_t>(1, static_cast<size_t>(std::ceil(bytes_per_second/1000.0)))
+                                               : 4096;
+        start = std::chrono::steady_clock::now();
+    }
+
+    VirtualSerial::~VirtualSerial()
+    {
+        Close();
+        if (slave_fd >= 0)
+        {
+            ::close(slave_fd);
+        }
+    }
+
+    bool VirtualSerial::Open()
+    {
+        struct termios settings;
+
+        // Not inherited by the child processes, else the master would not be closed with Close
+        master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if ((master_fd < 0) || (fcntl(master_fd, F_SETFD, FD_CLOEXEC) != 0) ||
+            (grantpt(master_fd) != 0) || (unlockpt(master_fd) != 0))
+        {
+            return false;
+        }
+        slave_path = ptsname(master_fd);
+        slave_fd = ::open(slave_path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if ((slave_fd < 0) || (tcgetattr(slave_fd, &settings) != 0))
+        {
+            return false;
+        }
+        // Bytes as they are: no echo, no line editing, no CR/LF translation
+        cfmakeraw(&settings);
+        settings.c_cc[VMIN] = 1;
+        settings.c_cc[VTIME] = 0;
+        if (tcsetattr(slave_fd, TCSANOW, &settings) != 0)
+        {
+            return false;
+        }
+        return fcntl(master_fd, F_SETFL, fcntl(master_fd, F_GETFL) | O_NONBLOCK) == 0;
+    }
+
+    bool VirtualSerial::Link(const std::string& path)
+    {
+        ::unlink(path.c_str());
+        if (::symlink(slave_path.c_str(), path.c_str()) != 0)
+        {
+            return false;
+        }
+        link_path = path;
+        return true;
+    }
+
+    bool VirtualSerial::Write(const uint8_t* data, size_t length)
+    {
+        while (length)
+        {
+            ssize_t written = ::write(master_fd, data, length);
+
+            if (written > 0)
+            {
+                data += written;
+                length -= static_cast<size_t>(written);
+            }
+            else if ((written < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+            {
+                // The pty buffer is full: the reader is behind
+                struct pollfd descriptor = {master_fd, POLLOUT, 0};
+                ::poll(&descriptor, 1, 100);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool VirtualSerial::Drain(std::chrono::milliseconds timeout)
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        uint32_t empty_checks = 0;
+
+        // The bytes pass through the pty buffer before the line discipline: two empty checks in a row
+        while (empty_checks < 2)
+        {
+            int unread = 0;
+
+            if (ioctl(slave_fd, FIONREAD, &unread) != 0)
+            {
+                return false;
+            }
+            empty_checks = (unread == 0) ? empty_checks + 1 : 0;
+            if (empty_checks == 2)
+            {
+                return true;
+            }
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void VirtualSerial::Close()
+    {
+        if (master_fd >= 0)
+        {
+            ::close(master_fd);
+            master_fd = -1;
+        }
+        if (!link_path.empty())
+        {
+            ::unlink(link_path.c_str());
+            link_path.clear();
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,173 @@
+/**
+*   \file VirtualSerial.h
+*   \brief Virtual serial port, pacing and line faults for replaying UART streams.
+*
+*   A VirtualSerial is a pseudo-terminal in raw mode: the host tools open
+*   its slave side as they would open the USB-UART bridge, and the replay
+*   writes the stream into the master side. The Pacer spaces the writes
+*   as the bytes of a UART at a baud rate, possibly N times faster; the
+*   FaultInjector flips bits and drops bytes as a noisy or overrun line
+*   does.
+*/
+
+#ifndef __VIRTUAL_SERIAL_H
+    #define __VIRTUAL_SERIAL_H
+
+    #include <chrono>
+    #include <cstddef>
+    #include <cstdint>
+    #include <random>
+    #include <string>
+
+    namespace Replay
+    {
+        /**
+        *   \brief Bits on the line for a byte: start, 8 data, stop.
+        */
+        constexpr uint32_t BITS_PER_BYTE = 10;
+
+        /**
+        *   \brief Faults of the line.
+        */
+        struct Faults
+        {
+            double bit_error_rate = 0.0;    ///< Probability of a flip per data bit
+            double drop_rate = 0.0;         ///< Probability of a drop per byte
+            uint32_t drop_burst = 1;        ///< Consecutive bytes lost by a drop
+            uint32_t seed = 1;
+        };
+
+        /**
+        *   \brief Faults injected so far.
+        */
+        struct FaultStats
+        {
+            uint64_t bytes;                 ///< Bytes seen
+            uint64_t bit_errors;
+            uint64_t dropped_bytes;
+        };
+
+        /**
+        *   \brief Injector of the faults into a stream, chunk by chunk.
+        *
+        *   The distances between the faults are drawn from geometric
+        *   distributions, so that the cost does not depend on the rates.
+        */
+        class FaultInjector
+        {
+        public:
+            explicit FaultInjector(const Faults& faults);
+
+            /**
+            *   \brief Apply the faults to a chunk, in place.
+            *
+            *   \retval Bytes left in the chunk after the drops.
+            */
+            size_t Apply(uint8_t* data, size_t length);
+
+            const FaultStats& GetStats() const { return stats; }
+
+        private:
+            Faults faults;
+            std::mt19937_64 generator;
+            uint64_t next_bit_error;        ///< Data bit of the next flip, from the first byte seen
+            uint64_t next_drop;             ///< Byte of the next drop
+            uint32_t dropping = 0;          ///< Bytes still to drop in the burst
+            FaultStats stats = FaultStats();
+        };
+
+        /**
+        *   \brief Times of the bytes of a UART at a rate.
+        */
+        class Pacer
+        {
+        public:
+            /**
+            *   \param bytes_per_second Rate of the stream, 0 to write as fast as possible.
+            */
+            explicit Pacer(double bytes_per_second);
+
+            /**
+            *   \brief Start the clock: byte 0 is due now.
+            */
+            void Start() { start = std::chrono::steady_clock::now(); }
+
+            bool IsPaced() const { return byte_ns > 0; }
+
+            /**
+            *   \brief Time at which a byte has been shifted out.
+            */
+            std::chrono::steady_clock::time_point DueTime(uint64_t byte) const
+            {
+                return start + std::chrono::nanoseconds(static_cast<int64_t>((byte + 1)*byte_ns));
+            }
+
+            /**
+            *   \brief Bytes written at once: those of 1 ms, or a large block if not paced.
+            */
+            size_t GetSliceBytes() const { return slice_bytes; }
+
+        private:
+            double byte_ns;
+            size_t slice_bytes;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        /**
+        *   \brief Pseudo-terminal in raw mode.
+        */
+        class VirtualSerial
+        {
+        public:
+            ~VirtualSerial();
+
+            /**
+            *   \brief Create the pty.
+            *
+            *   \retval false on error, with errno set.
+            */
+            bool Open();
+
+            /**
+            *   \brief Make a symbolic link to the slave, e.g. a fixed name for a script.
+            */
+            bool Link(const std::string& path);
+
+            /**
+            *   \brief Write all the bytes, waiting while the reader lags behind.
+            *
+            *   \retval false if the pty is closed or on error.
+            */
+            bool Write(const uint8_t* data, size_t length);
+
+            /**
+            *   \brief Wait until the reader has read all the bytes written.
+            *
+            *   \retval false if some are still unread after the timeout.
+            */
+            bool Drain(std::chrono::milliseconds timeout);
+
+            /**
+            *   \brief Close the master: the reads of the slave then fail with EIO.
+            *
+            *   The slave fd stays open until the destruction, as a reader may still use it.
+            */
+            void Close();
+
+            const std::string& GetSlavePath() const { return slave_path; }
+
+            /**
+            *   \brief Slave side opened by Open, kept open for the terminal settings.
+            */
+            int GetSlaveFd() const { return slave_fd; }
+
+        private:
+            int master_fd = -1;
+            int slave_fd = -1;
+            std::string slave_path;
+            std::string link_path;
+        };
+    }
+
+#endif
+/* [] END OF FILE */
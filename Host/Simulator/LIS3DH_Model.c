@@ -0,0 +1,200 @@
+/*
+* This file includes the register-level model of the LIS3DH.
+*/
+
+#include "LIS3DH_Model.h"
+#include <math.h>
+#include <string.h>
+
+#define REG_STATUS_AUX   0x07
+#define REG_OUT_ADC1_L   0x08
+#define REG_OUT_ADC3_H   0x0D
+#define REG_WHO_AM_I     0x0F
+#define REG_TEMP_CFG     0x1F
+#define REG_CTRL_REG1    0x20
+#define REG_CTRL_REG4    0x23
+#define REG_CTRL_REG5    0x24
+#define REG_STATUS       0x27
+#define REG_OUT_X_L      0x28
+#define REG_OUT_Z_H      0x2D
+
+#define STATUS_ZYXDA 0x08
+#define STATUS_ZYXOR 0x80
+
+#define BOOT_TIME_NS 5000000ull
+
+/**
+*   \brief Output data rates of CTRL_REG1 ODR[3:0] (normal/high resolution mode).
+*/
+static const uint32_t odr_table[16] = {0, 1, 10, 25, 50, 100, 200, 400, 1600, 1344, 0, 0, 0, 0, 0, 0};
+
+    uint32_t LIS3DH_Model_GetOdr(const LIS3DH_Model* model)
+    {
+        uint8_t odr = model->reg[REG_CTRL_REG1] >> 4;
+        // ODR 1001 is 5376 Hz in low-power mode
+        if ((odr == 9) && (model->reg[REG_CTRL_REG1] & 0x08))
+        {
+            return 5376;
+        }
+        return odr_table[odr];
+    }
+
+    void LIS3DH_Model_Init(LIS3DH_Model* model, uint8_t address, uint64_t now_ns)
+    {
+        memset(model, 0, sizeof(*model));
+        model->address = address;
+        model->reg[REG_WHO_AM_I] = 0x33;
+        model->reg[REG_CTRL_REG1] = 0x07;
+        model->reg[REG_CTRL_REG5] = 0x80;   // boot in progress
+        model->boot_done_ns = now_ns + BOOT_TIME_NS;
+        model->temperature = 25;
+    }
+
+    uint8_t LIS3DH_Model_IsReady(LIS3DH_Model* model, uint64_t now_ns)
+    {
+        if (now_ns < model->boot_done_ns)
+        {
+            return 0;
+        }
+        model->reg[REG_CTRL_REG5] &= 0x7F;
+        return 1;
+    }
+
+    /**
+    *   \brief Store a sample left-justified with the current resolution.
+    */
+    static void LIS3DH_Model_Store(LIS3DH_Model* model, uint8_t reg, double g)
+    {
+        static const double sensitivity_mg[4] = {1.0, 2.0, 4.0, 12.0};
+        uint8_t fs = (model->reg[REG_CTRL_REG4] >> 4) & 0x03;
+        uint8_t bits = (model->reg[REG_CTRL_REG1] & 0x08) ? 8 : ((model->reg[REG_CTRL_REG4] & 0x08) ? 12 : 10);
+        double digit_mg = sensitivity_mg[fs]*(double)(1 << (12 - bits));
+        long digits = lround(g*1000.0/digit_mg);
+        long limit = (1L << (bits - 1)) - 1;
+
+        if (digits > limit) digits = limit;
+        if (digits < -limit - 1) digits = -limit - 1;
+
+        uint16_t raw = (uint16_t)((int16_t)digits << (16 - bits));
+        model->reg[reg] = (uint8_t)(raw & 0xFF);
+        model->reg[reg + 1] = (uint8_t)(raw >> 8);
+    }
+
+    /**
+    *   \brief Produce the samples due at the given time.
+    */
+    static void LIS3DH_Model_Update(LIS3DH_Model* model, uint64_t now_ns)
+    {
+        uint32_t odr = LIS3DH_Model_GetOdr(model);
+
+        // The BOOT bit clears itself at the end of the boot procedure
+        LIS3DH_Model_IsReady(model, now_ns);
+
+        if (odr == 0)
+        {
+            model->next_sample_ns = 0;
+            return;
+        }
+        uint64_t period_ns = 1000000000ull/odr;
+        if (model->next_sample_ns == 0)
+        {
+            model->next_sample_ns = now_ns + period_ns;
+        }
+        while (now_ns >= model->next_sample_ns)
+        {
+            uint8_t axes = model->reg[REG_CTRL_REG1] & 0x07;
+
+            // Samples not read yet are overwritten
+            if (model->reg[REG_STATUS] & STATUS_ZYXDA)
+            {
+                model->reg[REG_STATUS] |= STATUS_ZYXOR | (uint8_t)(axes << 4);
+                model->overruns++;
+            }
+            model->phase += 2.0*M_PI*5.0/odr;
+            LIS3DH_Model_Store(model, REG_OUT_X_L, 0.5*sin(model->phase));
+            LIS3DH_Model_Store(model, REG_OUT_X_L + 2, -1.0 + (double)(model->samples % 1000)/500.0);
+            LIS3DH_Model_Store(model, REG_OUT_X_L + 4, 1.0);
+            model->reg[REG_STATUS] |= STATUS_ZYXDA | axes;
+            model->samples++;
+            model->last_sample_ns = model->next_sample_ns;
+
+            // Auxiliary ADC: 10-bit left-justified, ADC3 is the temperature if enabled
+            if (model->reg[REG_TEMP_CFG] & 0x80)
+            {
+                int16_t adc[3] = {100, -100, (model->reg[REG_TEMP_CFG] & 0x40) ? model->temperature : 0};
+                for (uint8_t i = 0; i < 3; i++)
+                {
+                    uint16_t raw = (uint16_t)(adc[i] << 6);
+                    model->reg[REG_OUT_ADC1_L + 2*i] = (uint8_t)(raw & 0xFF);
+                    model->reg[REG_OUT_ADC1_L + 2*i + 1] = (uint8_t)(raw >> 8);
+                }
+                model->reg[REG_STATUS_AUX] |= 0x0F;
+            }
+            model->next_sample_ns += period_ns;
+        }
+    }
+
+    void LIS3DH_Model_Write(LIS3DH_Model* model, const uint8_t* data, uint16_t count, uint64_t now_ns)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        LIS3DH_Model_Update(model, now_ns);
+        model->pointer = data[0] & 0x7F;
+        model->auto_increment = data[0] & 0x80;
+        for (uint16_t i = 1; i < count; i++)
+        {
+            uint8_t reg = model->pointer;
+            // Read-only registers are not written
+            if ((reg >= REG_TEMP_CFG) && (reg <= REG_CTRL_REG5 + 1))
+            {
+                model->reg[reg] = data[i];
+            }
+            else if ((reg >= 0x2E) && (reg < LIS3DH_MODEL_REG_COUNT))
+            {
+                model->reg[reg] = data[i];
+            }
+            if (reg == REG_CTRL_REG5 && (data[i] & 0x80))
+            {
+                // Reboot memory content
+                model->boot_done_ns = now_ns + BOOT_TIME_NS/10;
+            }
+            if (model->auto_increment)
+            {
+                model->pointer = (model->pointer + 1) & (LIS3DH_MODEL_REG_COUNT - 1);
+            }
+        }
+        LIS3DH_Model_Update(model, now_ns);
+    }
+
+    void LIS3DH_Model_Read(LIS3DH_Model* model, uint8_t* data, uint16_t count, uint64_t now_ns)
+    {
+        LIS3DH_Model_Update(model, now_ns);
+        for (uint16_t i = 0; i < count; i++)
+        {
+            uint8_t reg = model->pointer;
+            data[i] = model->reg[reg];
+
+            // Reading the high byte of an output clears its data-ready bit
+            if ((reg >= REG_OUT_X_L) && (reg <= REG_OUT_Z_H) && (reg & 1))
+            {
+                uint8_t axis = (reg - REG_OUT_X_L)/2;
+                model->reg[REG_STATUS] &= (uint8_t)~((1 << axis) | (0x10 << axis));
+                if (!(model->reg[REG_STATUS] & 0x07))
+                {
+                    model->reg[REG_STATUS] &= (uint8_t)~(STATUS_ZYXDA | STATUS_ZYXOR);
+                }
+            }
+            if ((reg >= REG_OUT_ADC1_L) && (reg <= REG_OUT_ADC3_H) && (reg & 1))
+            {
+                model->reg[REG_STATUS_AUX] &= (uint8_t)~(1 << ((reg - REG_OUT_ADC1_L)/2));
+            }
+            if (model->auto_increment)
+            {
+                model->pointer = (model->pointer + 1) & (LIS3DH_MODEL_REG_COUNT - 1);
+            }
+        }
+    }
+
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/**
+*   \file LIS3DH_Model.h
+*   \brief Register-level model of the LIS3DH accelerometer.
+*
+*   The model keeps the register file of one device and produces a new
+*   sample at the output data rate set in CTRL_REG1, with the resolution
+*   and full scale set in CTRL_REG1/CTRL_REG4. Data-ready and overrun bits
+*   of the status register follow the datasheet. The signal is synthetic:
+*   a sine on X, a slow ramp on Y and 1 g on Z, plus the temperature on ADC3.
+*/
+
+#ifndef __LIS3DH_MODEL_H
+    #define __LIS3DH_MODEL_H
+
+    #include <stdint.h>
+
+    /**
+    *   \brief Size of the register file (0x00..0x3F).
+    */
+    #define LIS3DH_MODEL_REG_COUNT 0x40
+
+    typedef struct {
+        uint8_t address;                        ///< 7-bit I2C address (0x18 or 0x19)
+        uint8_t reg[LIS3DH_MODEL_REG_COUNT];    ///< Register file
+        uint8_t pointer;                        ///< Register address latched by the last write
+        uint8_t auto_increment;                 ///< MSB of the latched register address
+        uint64_t boot_done_ns;                  ///< End of the boot procedure
+        uint64_t next_sample_ns;                ///< Time of the next sample (0 = ODR off)
+        uint64_t last_sample_ns;                ///< Time of the last sample produced
+        uint32_t samples;                       ///< Samples produced
+        uint32_t overruns;                      ///< Samples overwritten before being read
+        double phase;                           ///< Phase of the synthetic signal
+        int16_t temperature;                    ///< Temperature (ADC3 digits, right-justified)
+    } LIS3DH_Model;
+
+    /**
+    *   \brief Power up the device.
+    *
+    *   \param model Model to be initialized.
+    *   \param address 7-bit I2C address.
+    *   \param now_ns Power-up time.
+    */
+    void LIS3DH_Model_Init(LIS3DH_Model* model, uint8_t address, uint64_t now_ns);
+
+    /**
+    *   \brief Whether the device acknowledges its address.
+    */
+    uint8_t LIS3DH_Model_IsReady(LIS3DH_Model* model, uint64_t now_ns);
+
+    /**
+    *   \brief Write transfer: register address followed by data.
+    */
+    void LIS3DH_Model_Write(LIS3DH_Model* model, const uint8_t* data, uint16_t count, uint64_t now_ns);
+
+    /**
+    *   \brief Read transfer from the latched register address.
+    */
+    void LIS3DH_Model_Read(LIS3DH_Model* model, uint8_t* data, uint16_t count, uint64_t now_ns);
+
+    /**
+    *   \brief Output data rate set in CTRL_REG1, in Hz (0 = power-down).
+    */
+    uint32_t LIS3DH_Model_GetOdr(const LIS3DH_Model* model);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,1335 @@
+/*
+* This file includes the virtual clock, the shims of the PSoC components
+* and the entry point of the host simulator.
+*
+* Build from the repository root:
+*
+*   gcc -std=gnu99 -O2 -fcommon -no-pie -Dmain=Firmware_Main -DSPI_PERIPHERAL_ENABLED=1 \
+*       -IHost/Simulator/psoc -IHost/Simulator -IAY1920_II_HW_05_PROJ_3.cydsn \
+*       $(find AY1920_II_HW_05_PROJ_3.cydsn Host/Simulator -maxdepth 1 -name '*.c') \
+*       -lm -o lis3dh_sim
+*
+* The firmware main() is renamed to Firmware_Main() and runs until the
+* virtual clock reaches the requested duration, then the report is printed.
+* Add -DLIS3DH_TRANSPORT=I2C_PERIPHERAL_TRANSPORT_SPI to run the firmware
+* over SPI: the first LIS3DH model is also connected to SPIM and CS_1.
+* Add -DPASSTHROUGH_ENABLED=1 -DLIS3DH_PASSTHROUGH=1 to send the raw
+* bursts through the DMA_UART_TX channel.
+*/
+
+#include "Sim.h"
+#include "project.h"
+#include "I2C_Interface.h"
+#include "SPI_Interface.h"
+#include "Scheduler.h"
+#include "Acquisition.h"
+#include "LogEvent.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#undef main
+
+int Firmware_Main(void);
+
+/**
+*   \brief Cost of the polling loops, in virtual time.
+*/
+#define SIM_STATUS_POLL_NS 500
+#define SIM_GETCHAR_NS 2000
+#define SIM_PUTCHAR_NS 500
+#define SIM_UART_REGISTER_NS 100
+
+/**
+*   \brief Duration of a flash row write of the emulated EEPROM.
+*/
+#define SIM_FLASH_ROW_WRITE_NS 15000000ull
+
+/**
+*   \brief Depth of the hardware TX FIFO of the UART.
+*/
+#define SIM_UART_FIFO 4
+
+/**
+*   \brief Software TX buffer of UART_Debug: none when the buffer size does not exceed the FIFO.
+*/
+#define SIM_UART_SOFTWARE_BUFFER ((UART_Debug_TX_BUFFER_SIZE > SIM_UART_FIFO) ? UART_Debug_TX_BUFFER_SIZE : 0)
+
+/**
+*   \brief Longest frame cut out of the bytes written by the CPU.
+*/
+#define SIM_UART_MAX_FRAME 64
+
+#define CYCCNT_ADDRESS 0xE0001004u
+
+Sim_Options sim_options =
+{
+    .duration_ms = 1000.0,
+    .timer_hz = 300.0,
+    .baud = 19200,
+    .stuck_at_ms = -1.0,
+    .stuck_bits = 5,
+    .nack_rate = 0.0,
+    .arb_lost_rate = 0.0,
+    .seed = 1,
+    .capture_path = NULL,
+    .rx_script = "",
+    .rx_length = 0,
+    .rx_rate = 0.0,
+    .devices = 1,
+};
+
+static uint64_t now_ns;
+static uint64_t end_ns;
+
+/******************************************/
+/*          Virtual clock, Timer          */
+/******************************************/
+
+static cyisraddress timer_isr;
+static uint8_t timer_running;
+static uint64_t timer_period_ns;
+static uint64_t timer_next_ns;
+static uint32_t timer_ticks;
+
+static void Sim_Finish(void);
+
+    uint64_t Sim_NowNs(void)
+    {
+        return now_ns;
+    }
+
+    void Sim_AdvanceNs(uint64_t ns)
+    {
+        now_ns += ns;
+        while (timer_running && (now_ns >= timer_next_ns))
+        {
+            timer_ticks++;
+            timer_next_ns += timer_period_ns;
+            if (timer_isr)
+            {
+                timer_isr();
+            }
+        }
+        if (now_ns >= end_ns)
+        {
+            Sim_Finish();
+        }
+    }
+
+    void Sim_WaitForInterrupt(void)
+    {
+        Sim_AdvanceNs((timer_running && (timer_next_ns > now_ns)) ? timer_next_ns - now_ns : SIM_STATUS_POLL_NS);
+    }
+
+    void Timer_Start(void)
+    {
+        timer_running = 1;
+        timer_period_ns = (uint64_t)(1e9/sim_options.timer_hz);
+        timer_next_ns = now_ns + timer_period_ns;
+    }
+
+    void Timer_Stop(void)
+    {
+        timer_running = 0;
+    }
+
+    uint8 Timer_ReadStatusRegister(void)
+    {
+        return 0x80u;
+    }
+
+    uint16 Timer_ReadPeriod(void)
+    {
+        return 0;
+    }
+
+    void Timer_WritePeriod(uint16 period)
+    {
+        (void)period;
+    }
+
+    uint16 Timer_ReadCounter(void)
+    {
+        return 0;
+    }
+
+    void isr_ADC_StartEx(cyisraddress address)
+    {
+        timer_isr = address;
+    }
+
+    void isr_ADC_Stop(void)
+    {
+        timer_isr = NULL;
+    }
+
+    void CyDelay(uint32 milliseconds)
+    {
+        Sim_AdvanceNs((uint64_t)milliseconds*1000000ull);
+    }
+
+    void CyDelayUs(uint16 microseconds)
+    {
+        Sim_AdvanceNs((uint64_t)microseconds*1000ull);
+    }
+
+    void CyDelayCycles(uint32 cycles)
+    {
+        Sim_AdvanceNs((uint64_t)cycles*1000ull/BCLK__BUS_CLK__MHZ);
+    }
+
+    uint8 CyEnterCriticalSection(void)
+    {
+        return 0;
+    }
+
+    void CyExitCriticalSection(uint8 savedIntrStatus)
+    {
+        (void)savedIntrStatus;
+    }
+
+/******************************************/
+/*             Core registers             */
+/******************************************/
+
+static uint32_t core_reg[256];
+static uint64_t cyccnt_base_ns;
+
+    uint32 Sim_ReadReg32(uintptr_t address)
+    {
+        if (address == CYCCNT_ADDRESS)
+        {
+            return (uint32)((now_ns - cyccnt_base_ns)*BCLK__BUS_CLK__MHZ/1000ull);
+        }
+        return core_reg[(address >> 2) & 0xFF];
+    }
+
+    void Sim_WriteReg32(uintptr_t address, uint32 value)
+    {
+        if (address == CYCCNT_ADDRESS)
+        {
+            cyccnt_base_ns = now_ns - (uint64_t)value*1000ull/BCLK__BUS_CLK__MHZ;
+            return;
+        }
+        core_reg[(address >> 2) & 0xFF] = value;
+    }
+
+/******************************************/
+/*                 UART                   */
+/******************************************/
+
+static FILE* capture;
+static uint64_t uart_busy_until_ns;
+static uint64_t uart_bytes;
+static uint64_t uart_blocked_ns;
+static uint64_t uart_rx_start_ns;
+static size_t uart_rx_index;
+static uint8 uart_rx_fifo[UART_Debug_RX_BUFFER_SIZE];
+static uint64_t uart_rx_arrival_ns[UART_Debug_RX_BUFFER_SIZE];
+static uint8 uart_rx_head;
+static uint8 uart_rx_count;
+static uint64_t uart_rx_read;
+static uint64_t uart_rx_overruns;
+static uint64_t uart_rx_wait_sum_ns;
+static uint64_t uart_rx_wait_max_ns;
+static uint32_t frames[256];
+static uint64_t first_frame_ns;
+static uint64_t latency_max_ns;
+static uint32_t loss_marked[4];
+static uint64_t latency_sum_ns;
+static uint8 uart_frame[SIM_UART_MAX_FRAME];
+static uint8 uart_frame_received;
+
+reg8 Sim_UartTxData;
+
+static uint64_t Sim_UartByteNs(void)
+{
+    return 10ull*1000000000ull/sim_options.baud;
+}
+
+/**
+*   \brief Queue a byte behind the ones being shifted out.
+*/
+static void Sim_UartShift(uint8 txDataByte)
+{
+    uart_busy_until_ns = ((uart_busy_until_ns > now_ns) ? uart_busy_until_ns : now_ns) + Sim_UartByteNs();
+    uart_bytes++;
+    if (capture)
+    {
+        fputc(txDataByte, capture);
+    }
+}
+
+/**
+*   \brief Interval between the received bytes.
+*/
+static uint64_t Sim_UartRxByteNs(void)
+{
+    return (sim_options.rx_rate > 0) ? (uint64_t)(1e9/sim_options.rx_rate) : Sim_UartByteNs();
+}
+
+/**
+*   \brief Move the bytes received by now into the RX buffer.
+*
+*   The input starts after the first frame. A byte received with the
+*   buffer full is lost (overrun), as on the PSoC UART without an RX
+*   interrupt: the firmware must read the buffer faster than it fills.
+*/
+static void Sim_UartReceive(void)
+{
+    uint64_t byte_ns = Sim_UartRxByteNs();
+
+    while (uart_rx_start_ns && (uart_rx_index < sim_options.rx_length))
+    {
+        uint64_t arrival_ns = uart_rx_start_ns + (uart_rx_index + 1)*byte_ns;
+        if (now_ns < arrival_ns)
+        {
+            break;
+        }
+        if (uart_rx_count < UART_Debug_RX_BUFFER_SIZE)
+        {
+            uint8 tail = (uint8)((uart_rx_head + uart_rx_count) % UART_Debug_RX_BUFFER_SIZE);
+            uart_rx_fifo[tail] = (uint8)sim_options.rx_script[uart_rx_index];
+            uart_rx_arrival_ns[tail] = arrival_ns;
+            uart_rx_count++;
+        }
+        else
+        {
+            uart_rx_overruns++;
+        }
+        uart_rx_index++;
+    }
+}
+
+/**
+*   \brief Account a frame queued by the firmware, by the CPU or by DMA.
+*/
+static void Sim_UartFrame(const uint8* frame, uint8 length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    frames[frame[0]]++;
+    // Losses reported in the stream
+    if ((length == ACQUISITION_LOSS_FRAME_LENGTH) && (frame[0] == ACQUISITION_LOSS_HEADER))
+    {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            loss_marked[i] += frame[1 + i];
+        }
+    }
+    // Latency of the accelerometer data: from the oldest sample in the devices to the frame queued
+    if ((frame[0] == 0xA0) || (frame[0] == 0xA2) || (frame[0] == 0xA4))
+    {
+        uint64_t oldest_ns = Sim_GetDevice(0)->last_sample_ns;
+        for (uint8_t d = 1; d < sim_options.devices; d++)
+        {
+            if (Sim_GetDevice(d)->last_sample_ns < oldest_ns)
+            {
+                oldest_ns = Sim_GetDevice(d)->last_sample_ns;
+            }
+        }
+        uint64_t latency_ns = now_ns - oldest_ns;
+        latency_sum_ns += latency_ns;
+        if (latency_ns > latency_max_ns)
+        {
+            latency_max_ns = latency_ns;
+        }
+        if (first_frame_ns == 0)
+        {
+            first_frame_ns = now_ns;
+            uart_rx_start_ns = now_ns;
+        }
+    }
+}
+
+/**
+*   \brief Length of the frame starting with a header, 0 while unknown, 1 for a text byte.
+*/
+static uint8 Sim_UartFrameLength(const uint8* frame, uint8 received)
+{
+    switch (frame[0])
+    {
+        case ACQUISITION_HEADER:
+        case ACQUISITION_MULTI_HEADER:
+            return Acquisition_GetFrameLength();
+        case ACQUISITION_AUX_HEADER:
+            return ACQUISITION_AUX_FRAME_LENGTH;
+        case ACQUISITION_LOSS_HEADER:
+            return ACQUISITION_LOSS_FRAME_LENGTH;
+        case LOG_EVENT_HEADER:
+            return (received < 3) ? 0 : (uint8)(frame[2] + 4);
+        default:
+            return 1;
+    }
+}
+
+/**
+*   \brief Shift out a byte written by the CPU, and account the frames cut out of these bytes.
+*
+*   The frames are accounted once their last byte is in the FIFO.
+*/
+static void Sim_UartWrite(uint8 txDataByte)
+{
+    uint8 length;
+
+    Sim_UartShift(txDataByte);
+    uart_frame[uart_frame_received++] = txDataByte;
+    length = Sim_UartFrameLength(uart_frame, uart_frame_received);
+    if ((length != 0) && (uart_frame_received >= length))
+    {
+        if (length > 1)
+        {
+            Sim_UartFrame(uart_frame, length);
+        }
+        uart_frame_received = 0;
+    }
+    else if (uart_frame_received == SIM_UART_MAX_FRAME)
+    {
+        uart_frame_received = 0;
+    }
+}
+
+    void UART_Debug_Start(void)
+    {
+    }
+
+    void UART_Debug_Stop(void)
+    {
+    }
+
+    uint8 UART_Debug_ReadTxStatus(void)
+    {
+        uint64_t byte_ns = Sim_UartByteNs();
+        uint8 status = 0;
+
+        Sim_AdvanceNs(SIM_UART_REGISTER_NS);
+        // The byte being shifted out is not in the FIFO
+        if (uart_busy_until_ns <= now_ns)
+        {
+            status |= UART_Debug_TX_STS_COMPLETE;
+        }
+        if (uart_busy_until_ns <= now_ns + byte_ns)
+        {
+            status |= UART_Debug_TX_STS_FIFO_EMPTY;
+        }
+        status |= (uart_busy_until_ns <= now_ns + SIM_UART_FIFO*byte_ns) ? UART_Debug_TX_STS_FIFO_NOT_FULL
+                                                                         : UART_Debug_TX_STS_FIFO_FULL;
+        return status;
+    }
+
+    void UART_Debug_WriteTxData(uint8 txDataByte)
+    {
+        Sim_AdvanceNs(SIM_UART_REGISTER_NS);
+        Sim_UartWrite(txDataByte);
+    }
+
+    void UART_Debug_PutChar(uint8 txDataByte)
+    {
+        uint64_t byte_ns = Sim_UartByteNs();
+        uint64_t room_ns = (SIM_UART_SOFTWARE_BUFFER + SIM_UART_FIFO)*byte_ns;
+
+        Sim_AdvanceNs(SIM_PUTCHAR_NS);
+        // A full buffer blocks the caller until a byte is shifted out
+        if (uart_busy_until_ns > now_ns + room_ns)
+        {
+            uint64_t wait_ns = uart_busy_until_ns - now_ns - room_ns;
+            uart_blocked_ns += wait_ns;
+            Sim_AdvanceNs(wait_ns);
+        }
+        Sim_UartWrite(txDataByte);
+    }
+
+    void UART_Debug_PutString(const char8 string[])
+    {
+        while (*string)
+        {
+            UART_Debug_PutChar((uint8)*string++);
+        }
+    }
+
+    void UART_Debug_PutArray(const uint8 string[], uint8 byteCount)
+    {
+        for (uint8 i = 0; i < byteCount; i++)
+        {
+            UART_Debug_PutChar(string[i]);
+        }
+    }
+
+    void UART_Debug_PutCRLF(uint8 txDataByte)
+    {
+        UART_Debug_PutChar(txDataByte);
+        UART_Debug_PutChar('\r');
+        UART_Debug_PutChar('\n');
+    }
+
+    uint8 UART_Debug_GetChar(void)
+    {
+        uint8 byte;
+
+        Sim_AdvanceNs(SIM_GETCHAR_NS);
+        Sim_UartReceive();
+        if (uart_rx_count == 0)
+        {
+            return 0;
+        }
+        byte = uart_rx_fifo[uart_rx_head];
+        uint64_t wait_ns = now_ns - uart_rx_arrival_ns[uart_rx_head];
+        uart_rx_wait_sum_ns += wait_ns;
+        if (wait_ns > uart_rx_wait_max_ns)
+        {
+            uart_rx_wait_max_ns = wait_ns;
+        }
+        uart_rx_head = (uint8)((uart_rx_head + 1) % UART_Debug_RX_BUFFER_SIZE);
+        uart_rx_count--;
+        uart_rx_read++;
+        return byte;
+    }
+
+    uint8 UART_Debug_GetRxBufferSize(void)
+    {
+        Sim_UartReceive();
+        return uart_rx_count;
+    }
+
+    uint8 UART_Debug_GetTxBufferSize(void)
+    {
+        uint64_t byte_ns = Sim_UartByteNs();
+        uint64_t pending = (uart_busy_until_ns > now_ns) ? (uart_busy_until_ns - now_ns + byte_ns - 1)/byte_ns : 0;
+
+        // Bytes waiting in the software buffer, the hardware FIFO excluded
+        if (SIM_UART_SOFTWARE_BUFFER)
+        {
+            return (pending > SIM_UART_FIFO + 1) ? (uint8)(pending - SIM_UART_FIFO - 1) : 0;
+        }
+        // FIFO only: as the component, full, empty or "some"
+        if (pending > SIM_UART_FIFO)
+        {
+            return SIM_UART_FIFO;
+        }
+        return (pending > 1) ? 1 : 0;
+    }
+
+    void UART_Debug_ClearTxBuffer(void)
+    {
+    }
+
+/******************************************/
+/*                 DMA                    */
+/******************************************/
+
+/**
+*   \brief Transaction descriptors and the channel of DMA_UART_TX.
+*/
+static struct {
+    uint8_t allocated;
+    uint16 count;
+    uint8 next;
+    uint8 configuration;
+    uint16 source;
+} dma_tds[CY_DMA_NUMBEROF_TDS];
+static uint8 dma_initial_td = CY_DMA_INVALID_TD;
+static uint64_t dma_busy_until_ns;
+static uint32_t dma_frames;
+
+/**
+*   \brief Full addresses of the low halves passed to LO16.
+*/
+static uint32 sim_lo16_addresses[65536];
+
+    uint16 Sim_Lo16(uint32 address)
+    {
+        sim_lo16_addresses[address & 0xFFFFu] = address;
+        return (uint16)(address & 0xFFFFu);
+    }
+
+    uint8 DMA_UART_TX_DmaInitialize(uint8 BurstCount, uint8 ReqestPerBurst, uint16 UpperSrcAddress, uint16 UpperDestAddress)
+    {
+        (void)BurstCount;
+        (void)ReqestPerBurst;
+        (void)UpperSrcAddress;
+        (void)UpperDestAddress;
+        return 0;
+    }
+
+    void DMA_UART_TX_DmaRelease(void)
+    {
+    }
+
+    uint8 CyDmaTdAllocate(void)
+    {
+        for (uint8 td = 0; td < CY_DMA_NUMBEROF_TDS; td++)
+        {
+            if (!dma_tds[td].allocated)
+            {
+                dma_tds[td].allocated = 1;
+                return td;
+            }
+        }
+        return CY_DMA_INVALID_TD;
+    }
+
+    void CyDmaTdFree(uint8 tdHandle)
+    {
+        dma_tds[tdHandle].allocated = 0;
+    }
+
+    cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration)
+    {
+        dma_tds[tdHandle].count = transferCount;
+        dma_tds[tdHandle].next = nextTd;
+        dma_tds[tdHandle].configuration = configuration;
+        return CYRET_SUCCESS;
+    }
+
+    cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination)
+    {
+        // The only destination in the design is the UART TX FIFO
+        (void)destination;
+        dma_tds[tdHandle].source = source;
+        return CYRET_SUCCESS;
+    }
+
+    cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd)
+    {
+        (void)chHandle;
+        dma_initial_td = startTd;
+        return CYRET_SUCCESS;
+    }
+
+    cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds)
+    {
+        (void)chHandle;
+        (void)preserveTds;
+        // Each TX FIFO not full request moves a byte: the CPU is not involved
+        for (uint8 td = dma_initial_td; td < CY_DMA_NUMBEROF_TDS; td = dma_tds[td].next)
+        {
+            const uint8* source = (const uint8*)(uintptr_t)sim_lo16_addresses[dma_tds[td].source];
+
+            for (uint16 i = 0; i < dma_tds[td].count; i++)
+            {
+                Sim_UartShift(source[(dma_tds[td].configuration & CY_DMA_TD_INC_SRC_ADR) ? i : 0]);
+            }
+            Sim_UartFrame(source, (uint8)dma_tds[td].count);
+            dma_frames++;
+        }
+        // The channel is done once the last byte is in the FIFO
+        dma_busy_until_ns = uart_busy_until_ns - SIM_UART_FIFO*Sim_UartByteNs();
+        return CYRET_SUCCESS;
+    }
+
+    cystatus CyDmaChDisable(uint8 chHandle)
+    {
+        (void)chHandle;
+        dma_busy_until_ns = 0;
+        return CYRET_SUCCESS;
+    }
+
+    cystatus CyDmaChStatus(uint8 chHandle, uint8 * currentTd, uint8 * state)
+    {
+        (void)chHandle;
+        *currentTd = dma_initial_td;
+        *state = (dma_busy_until_ns > now_ns) ? (CY_DMA_STATUS_CHAIN_ACTIVE | CY_DMA_STATUS_TD_ACTIVE) : 0;
+        return CYRET_SUCCESS;
+    }
+
+/******************************************/
+/*               I2C bus                  */
+/******************************************/
+
+uint8 I2C_Master_clkDiv[2];
+uint8 I2C_Master_cfg;
+
+static LIS3DH_Model devices[SIM_MAX_DEVICES];
+static uint8_t i2c_enabled;
+static uint8_t i2c_int_enabled;     ///< The ISR of the component runs the byte transfers
+static uint8_t i2c_status;
+static uint8_t i2c_pending_status;
+static uint8_t i2c_halted;
+static uint64_t i2c_done_ns;
+static uint8_t i2c_stuck;
+static uint8_t i2c_stuck_triggered;
+static uint32_t i2c_scl_pulses;
+static uint8_t scl_level = 1;
+
+/**
+*   \brief SCL_1 and SDA_1 connected to the I2C block, as set by the fitter.
+*/
+reg8 Sim_I2cPortBypass = SCL_1_MASK | SDA_1_MASK;
+
+static uint64_t i2c_busy_ns;
+static uint32_t i2c_transfers;
+static uint32_t injected_nacks;
+static uint32_t injected_arb_lost;
+static uint32_t injected_stuck;
+
+    LIS3DH_Model* Sim_GetDevice(uint8_t index)
+    {
+        return &devices[index];
+    }
+
+static uint64_t Sim_I2cByteNs(void)
+{
+    uint32_t divider = I2C_Master_clkDiv[0] | ((uint32_t)I2C_Master_clkDiv[1] << 8);
+    if (divider == 0)
+    {
+        divider = I2C_Master_DEFAULT_DIVIDE_FACTOR;
+    }
+    // The fixed-function block oversamples SCL by 16, by 32 in fast mode
+    uint64_t oversampling = (I2C_Master_cfg & I2C_Master_CFG_CLK_RATE_MSK) ? 32 : 16;
+    uint64_t bit_ns = (uint64_t)divider*oversampling*1000000000ull/BCLK__BUS_CLK__HZ;
+    return 9ull*bit_ns;
+}
+
+static double Sim_Random(void)
+{
+    return (double)rand()/((double)RAND_MAX + 1.0);
+}
+
+/**
+*   \brief Start a transfer: address phase, faults and data phase.
+*/
+static uint8 Sim_I2cTransfer(uint8 address, uint8* data, uint8 count, uint8 mode, uint8 read)
+{
+    if (!i2c_enabled)
+    {
+        return I2C_Master_MSTR_NOT_READY;
+    }
+    if ((mode & I2C_Master_MODE_REPEAT_START) && !i2c_halted)
+    {
+        return I2C_Master_MSTR_NOT_READY;
+    }
+    if (!(mode & I2C_Master_MODE_REPEAT_START) && i2c_halted)
+    {
+        return I2C_Master_MSTR_BUS_BUSY;
+    }
+    if ((sim_options.stuck_at_ms >= 0) && !i2c_stuck_triggered && (now_ns >= (uint64_t)(sim_options.stuck_at_ms*1e6)))
+    {
+        i2c_stuck = 1;
+        i2c_stuck_triggered = 1;
+        i2c_scl_pulses = 0;
+        injected_stuck++;
+    }
+
+    i2c_transfers++;
+    i2c_status = I2C_Master_MSTAT_XFER_INP;
+    if (i2c_stuck)
+    {
+        // SDA held low by the slave: the transfer never completes
+        i2c_done_ns = UINT64_MAX;
+        return I2C_Master_MSTR_NO_ERROR;
+    }
+
+    uint64_t duration_ns = (uint64_t)(count + 1)*Sim_I2cByteNs();
+    i2c_done_ns = now_ns + duration_ns;
+    i2c_busy_ns += duration_ns;
+    i2c_halted = (mode & I2C_Master_MODE_NO_STOP) ? 1 : 0;
+
+    LIS3DH_Model* device = NULL;
+    for (uint8_t i = 0; i < sim_options.devices; i++)
+    {
+        if ((devices[i].address == address) && LIS3DH_Model_IsReady(&devices[i], now_ns))
+        {
+            device = &devices[i];
+        }
+    }
+
+    if (Sim_Random() < sim_options.nack_rate)
+    {
+        injected_nacks++;
+        device = NULL;
+    }
+    if (Sim_Random() < sim_options.arb_lost_rate)
+    {
+        injected_arb_lost++;
+        i2c_pending_status = I2C_Master_MSTAT_ERR_XFER | I2C_Master_MSTAT_ERR_ARB_LOST;
+        i2c_halted = 0;
+        return I2C_Master_MSTR_NO_ERROR;
+    }
+    if (device == NULL)
+    {
+        i2c_pending_status = I2C_Master_MSTAT_ERR_XFER | I2C_Master_MSTAT_ERR_ADDR_NAK;
+        i2c_done_ns = now_ns + Sim_I2cByteNs();
+        i2c_halted = 0;
+        return I2C_Master_MSTR_NO_ERROR;
+    }
+
+    if (read)
+    {
+        LIS3DH_Model_Read(device, data, count, i2c_done_ns);
+        i2c_pending_status = I2C_Master_MSTAT_RD_CMPLT;
+    }
+    else
+    {
+        LIS3DH_Model_Write(device, data, count, i2c_done_ns);
+        i2c_pending_status = I2C_Master_MSTAT_WR_CMPLT;
+    }
+    if (i2c_halted)
+    {
+        i2c_pending_status |= I2C_Master_MSTAT_XFER_HALT;
+    }
+    return I2C_Master_MSTR_NO_ERROR;
+}
+
+    void I2C_Master_Init(void)
+    {
+        I2C_Master_clkDiv[0] = LO8(I2C_Master_DEFAULT_DIVIDE_FACTOR);
+        I2C_Master_clkDiv[1] = HI8(I2C_Master_DEFAULT_DIVIDE_FACTOR);
+        I2C_Master_cfg = I2C_Master_DEFAULT_CFG;
+        i2c_status = 0;
+        i2c_halted = 0;
+    }
+
+    void I2C_Master_Enable(void)
+    {
+        I2C_Master_cfg |= I2C_Master_CFG_EN_MSTR;
+        i2c_enabled = 1;
+    }
+
+    void I2C_Master_EnableInt(void)
+    {
+        i2c_int_enabled = 1;
+    }
+
+    void I2C_Master_DisableInt(void)
+    {
+        i2c_int_enabled = 0;
+    }
+
+    void I2C_Master_Start(void)
+    {
+        static uint8_t init_var;
+        if (!init_var)
+        {
+            I2C_Master_Init();
+            init_var = 1;
+        }
+        I2C_Master_Enable();
+        I2C_Master_EnableInt();
+    }
+
+    void I2C_Master_Stop(void)
+    {
+        I2C_Master_DisableInt();
+        I2C_Master_cfg &= (uint8)~I2C_Master_CFG_EN_MSTR;
+        i2c_enabled = 0;
+        i2c_status = 0;
+        i2c_halted = 0;
+    }
+
+    uint8 I2C_Master_MasterWriteBuf(uint8 slaveAddress, uint8 * wrData, uint8 cnt, uint8 mode)
+    {
+        return Sim_I2cTransfer(slaveAddress, wrData, cnt, mode, 0);
+    }
+
+    uint8 I2C_Master_MasterReadBuf(uint8 slaveAddress, uint8 * rdData, uint8 cnt, uint8 mode)
+    {
+        return Sim_I2cTransfer(slaveAddress, rdData, cnt, mode, 1);
+    }
+
+    uint8 I2C_Master_MasterStatus(void)
+    {
+        Sim_AdvanceNs(SIM_STATUS_POLL_NS);
+        // Without its interrupt the component never gets past the address byte
+        if ((i2c_status & I2C_Master_MSTAT_XFER_INP) && i2c_int_enabled && (now_ns >= i2c_done_ns))
+        {
+            i2c_status = i2c_pending_status;
+        }
+        return i2c_status;
+    }
+
+    uint8 I2C_Master_MasterClearStatus(void)
+    {
+        uint8 status = i2c_status;
+        if (!(i2c_status & I2C_Master_MSTAT_XFER_INP))
+        {
+            i2c_status = 0;
+        }
+        return status;
+    }
+
+    void SCL_1_Write(uint8 value)
+    {
+        // Hardware-connected to the block: the data register does not drive the line
+        if (Sim_I2cPortBypass & SCL_1_MASK)
+        {
+            return;
+        }
+        // Falling edges clocked while the block is stopped release a stuck slave
+        if (!i2c_enabled && scl_level && !value && i2c_stuck)
+        {
+            if (++i2c_scl_pulses >= sim_options.stuck_bits)
+            {
+                i2c_stuck = 0;
+            }
+        }
+        scl_level = value ? 1 : 0;
+    }
+
+    uint8 SCL_1_Read(void)
+    {
+        return scl_level;
+    }
+
+    void SDA_1_Write(uint8 value)
+    {
+        (void)value;
+    }
+
+    uint8 SDA_1_Read(void)
+    {
+        return i2c_stuck ? 0 : 1;
+    }
+
+/******************************************/
+/*               SPI bus                  */
+/******************************************/
+
+/**
+*   \brief Cost of polling the SPIM status, in virtual time.
+*/
+#define SIM_SPI_POLL_NS 100
+
+/**
+*   \brief Depth of the hardware FIFOs of SPIM.
+*/
+#define SIM_SPI_FIFO 4
+
+static uint8_t spi_enabled;
+static uint8_t cs_level = 1;
+static uint64_t spi_busy_until_ns;
+static struct {
+    uint8_t value;
+    uint64_t ready_ns;
+} spi_rx[256];
+static uint8_t spi_rx_head;
+static uint8_t spi_rx_tail;
+static uint8_t spi_frame[256];
+static uint16_t spi_frame_count;
+static uint8_t spi_read;
+static uint32_t spi_transfers;
+static uint64_t spi_busy_ns;
+
+static uint64_t Sim_SpiByteNs(void)
+{
+    return 8ull*1000000000ull/SPI_PERIPHERAL_BIT_RATE_HZ;
+}
+
+    void SPIM_Start(void)
+    {
+        spi_enabled = 1;
+    }
+
+    void SPIM_Stop(void)
+    {
+        spi_enabled = 0;
+    }
+
+    void SPIM_WriteTxData(uint8 txData)
+    {
+        uint64_t byte_ns = Sim_SpiByteNs();
+        uint64_t done_ns = ((spi_busy_until_ns > now_ns) ? spi_busy_until_ns : now_ns) + byte_ns;
+        uint8_t value = 0xFF;
+
+        spi_busy_until_ns = done_ns;
+        spi_busy_ns += byte_ns;
+        if (spi_enabled && !cs_level)
+        {
+            if (spi_frame_count == 0)
+            {
+                // RW, MS and address: the model takes the I2C form of the sub-address
+                spi_transfers++;
+                spi_read = (txData & 0x80) ? 1 : 0;
+                spi_frame[0] = (txData & 0x3F) | ((txData & 0x40) ? 0x80 : 0x00);
+                if (spi_read)
+                {
+                    LIS3DH_Model_Write(&devices[0], spi_frame, 1, done_ns);
+                }
+            }
+            else if (spi_read)
+            {
+                LIS3DH_Model_Read(&devices[0], &value, 1, done_ns);
+            }
+            else if (spi_frame_count < sizeof(spi_frame))
+            {
+                spi_frame[spi_frame_count] = txData;
+            }
+            spi_frame_count++;
+        }
+        spi_rx[spi_rx_tail].value = value;
+        spi_rx[spi_rx_tail].ready_ns = done_ns;
+        spi_rx_tail++;
+    }
+
+    uint8 SPIM_ReadRxData(void)
+    {
+        uint8 value = spi_rx[spi_rx_head].value;
+        if (spi_rx_head != spi_rx_tail)
+        {
+            spi_rx_head++;
+        }
+        return value;
+    }
+
+    uint8 SPIM_GetRxBufferSize(void)
+    {
+        uint8 count = 0;
+
+        Sim_AdvanceNs(SIM_SPI_POLL_NS);
+        for (uint8_t i = spi_rx_head; (i != spi_rx_tail) && (spi_rx[i].ready_ns <= now_ns); i++)
+        {
+            count++;
+        }
+        return count;
+    }
+
+    uint8 SPIM_ReadTxStatus(void)
+    {
+        uint64_t byte_ns = Sim_SpiByteNs();
+        uint8 status = 0;
+
+        Sim_AdvanceNs(SIM_SPI_POLL_NS);
+        if (spi_busy_until_ns <= now_ns)
+        {
+            status |= SPIM_STS_SPI_DONE | SPIM_STS_TX_FIFO_EMPTY | SPIM_STS_SPI_IDLE;
+        }
+        if (spi_busy_until_ns < now_ns + SIM_SPI_FIFO*byte_ns)
+        {
+            status |= SPIM_STS_TX_FIFO_NOT_FULL;
+        }
+        return status;
+    }
+
+    void SPIM_ClearRxBuffer(void)
+    {
+        spi_rx_head = spi_rx_tail;
+    }
+
+    void SPIM_ClearTxBuffer(void)
+    {
+    }
+
+    void CS_1_Write(uint8 value)
+    {
+        // The write transfer is applied when the chip select is released
+        if (!cs_level && value && spi_frame_count && !spi_read)
+        {
+            uint16_t count = (spi_frame_count < sizeof(spi_frame)) ? spi_frame_count : sizeof(spi_frame);
+            LIS3DH_Model_Write(&devices[0], spi_frame, (uint8_t)count, now_ns);
+        }
+        if (value)
+        {
+            spi_frame_count = 0;
+        }
+        cs_level = value ? 1 : 0;
+    }
+
+    uint8 CS_1_Read(void)
+    {
+        return cs_level;
+    }
+
+/******************************************/
+/*           Emulated EEPROM              */
+/******************************************/
+
+static uint8_t eeprom[4096];
+static uint32_t eeprom_writes;
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Init(cy_stc_eeprom_config_t* config, cy_stc_eeprom_context_t * context)
+    {
+        if ((config->eepromSize == 0) || (config->eepromSize > sizeof(eeprom)) || (config->wearLevelingFactor == 0))
+        {
+            return CY_EM_EEPROM_BAD_PARAM;
+        }
+        context->eepromSize = config->eepromSize;
+        context->wearLevelingFactor = config->wearLevelingFactor;
+        context->redundantCopy = config->redundantCopy;
+        context->blockingWrite = config->blockingWrite;
+        context->userFlashStartAddr = config->userFlashStartAddr;
+        return CY_EM_EEPROM_SUCCESS;
+    }
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Read(uint32 addr, void * eepromData, uint32 size, cy_stc_eeprom_context_t * context)
+    {
+        if ((size == 0) || (addr + size > context->eepromSize))
+        {
+            return CY_EM_EEPROM_BAD_PARAM;
+        }
+        memcpy(eepromData, &eeprom[addr], size);
+        return CY_EM_EEPROM_SUCCESS;
+    }
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Write(uint32 addr, void * eepromData, uint32 size, cy_stc_eeprom_context_t * context)
+    {
+        if ((size == 0) || (addr + size > context->eepromSize))
+        {
+            return CY_EM_EEPROM_BAD_PARAM;
+        }
+        memcpy(&eeprom[addr], eepromData, size);
+        eeprom_writes++;
+        Sim_AdvanceNs(SIM_FLASH_ROW_WRITE_NS*(1u + context->redundantCopy));
+        return CY_EM_EEPROM_SUCCESS;
+    }
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Erase(cy_stc_eeprom_context_t * context)
+    {
+        memset(eeprom, 0, context->eepromSize);
+        return CY_EM_EEPROM_SUCCESS;
+    }
+
+    uint32 Cy_Em_EEPROM_NumWrites(cy_stc_eeprom_context_t * context)
+    {
+        (void)context;
+        return eeprom_writes;
+    }
+
+/******************************************/
+/*             Report, main               */
+/******************************************/
+
+static const char* const error_names[ERROR_CODE_COUNT] =
+{
+    [NO_ERROR] = "none",
+    [ERROR] = "other",
+    [ERROR_I2C_ADDR_NAK] = "addr NAK",
+    [ERROR_I2C_DATA_NAK] = "data NAK",
+    [ERROR_I2C_ARB_LOST] = "arb lost",
+    [ERROR_I2C_BUS_BUSY] = "bus busy",
+    [ERROR_I2C_NOT_READY] = "not ready",
+    [ERROR_I2C_TIMEOUT] = "timeout",
+    [ERROR_SPI_TIMEOUT] = "SPI timeout",
+};
+
+static void Sim_Finish(void)
+{
+    double seconds = (double)now_ns/1e9;
+    I2C_Peripheral_Stats stats;
+
+    I2C_Peripheral_GetStats(&stats);
+    if (capture)
+    {
+        fclose(capture);
+    }
+
+    printf("virtual time          %.3f s, %u timer ticks\n", seconds, timer_ticks);
+    for (uint16_t header = 0; header < 256; header++)
+    {
+        if (frames[header])
+        {
+            printf("frames 0x%02X           %u (%.1f/s)\n", header, frames[header], frames[header]/seconds);
+        }
+    }
+    printf("first sample          %.3f ms\n", (double)first_frame_ns/1e6);
+    if (dma_frames)
+    {
+        printf("DMA                   %u frames moved to the UART\n", dma_frames);
+    }
+    printf("UART                  %llu bytes, %.1f%% of %u baud, blocked %.3f ms\n",
+           (unsigned long long)uart_bytes, 100.0*(double)uart_bytes*10.0/(sim_options.baud*seconds),
+           sim_options.baud, (double)uart_blocked_ns/1e6);
+    if (sim_options.rx_length)
+    {
+        Sim_UartReceive();
+        printf("UART RX               %llu of %llu bytes received, %llu read, %llu overruns, wait avg %.3f ms, max %.3f ms\n",
+               (unsigned long long)uart_rx_index, (unsigned long long)sim_options.rx_length,
+               (unsigned long long)uart_rx_read, (unsigned long long)uart_rx_overruns,
+               uart_rx_read ? (double)uart_rx_wait_sum_ns/uart_rx_read/1e6 : 0.0, (double)uart_rx_wait_max_ns/1e6);
+    }
+    for (uint8_t i = 0; i < sim_options.devices; i++)
+    {
+        printf("LIS3DH 0x%02X           %u samples at %u Hz, %u overwritten\n", devices[i].address,
+               devices[i].samples, LIS3DH_Model_GetOdr(&devices[i]), devices[i].overruns);
+    }
+    if (frames[0xA0] + frames[0xA2] + frames[0xA4])
+    {
+        printf("sample latency        avg %.3f ms, max %.3f ms\n",
+               (double)latency_sum_ns/(frames[0xA0] + frames[0xA2] + frames[0xA4])/1e6, (double)latency_max_ns/1e6);
+    }
+    printf("I2C bus               %u transfers, %.1f%% busy\n", i2c_transfers, 100.0*(double)i2c_busy_ns/(double)now_ns);
+    if (spi_transfers)
+    {
+        printf("SPI bus               %u transfers, %.1f%% busy\n", spi_transfers, 100.0*(double)spi_busy_ns/(double)now_ns);
+    }
+    printf("faults injected       %u NACK, %u arbitration lost, %u stuck SDA\n",
+           injected_nacks, injected_arb_lost, injected_stuck);
+    printf("I2C transactions      %u, %u retries, %u recoveries, %u failed\n",
+           stats.transactions, stats.retries, stats.recoveries, stats.failures);
+    for (uint8_t error = ERROR; error < ERROR_CODE_COUNT; error++)
+    {
+        if (stats.errors[error])
+        {
+            printf("I2C errors %-10s %u\n", error_names[error], stats.errors[error]);
+        }
+    }
+    printf("I2C latency           max %u us, bound %u us (6-byte burst)\n",
+           stats.max_latency_us, I2C_Peripheral_GetWorstCaseUs(6));
+    printf("EEPROM writes         %u\n", eeprom_writes);
+    Acquisition_LossStats loss;
+    Acquisition_GetLossStats(&loss);
+    printf("losses                %u sensor overruns, %u tick merges, %u UART drops, %u read errors\n",
+           loss.sensor_overruns, loss.tick_merges, loss.uart_drops, loss.read_errors);
+    printf("loss markers          %u sensor overruns, %u tick merges, %u UART drops, %u read errors\n",
+           loss_marked[0], loss_marked[1], loss_marked[2], loss_marked[3]);
+    printf("log events            %u frames sent, %u dropped\n", frames[LOG_EVENT_HEADER], LogEvent_GetDropped());
+    for (uint8_t i = 0; i < Scheduler_GetTaskCount(); i++)
+    {
+        Scheduler_TaskStats task;
+        Scheduler_GetStats(i, &task);
+        printf("task %-16s %u runs, %u skipped, %u overruns, max %u us (WCET %u us)\n", Scheduler_GetTask(i)->name,
+               task.runs, task.skipped, task.overruns, task.max_us, Scheduler_GetTask(i)->wcet_us);
+    }
+    fflush(stdout);
+    exit(0);
+}
+
+/**
+*   \brief Read the received bytes from a file, or from a pty until its master is closed.
+*
+*   \retval 0 if the file can not be read.
+*/
+static int Sim_LoadRx(const char* path)
+{
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    size_t capacity = 65536;
+    size_t length = 0;
+    char* data = malloc(capacity);
+    ssize_t count;
+
+    if ((fd < 0) || (data == NULL))
+    {
+        perror(path);
+        free(data);
+        return 0;
+    }
+    while (((count = read(fd, data + length, capacity - length)) > 0) || ((count < 0) && (errno == EINTR)))
+    {
+        length += (count > 0) ? (size_t)count : 0;
+        if (length == capacity)
+        {
+            capacity *= 2;
+            char* larger = realloc(data, capacity);
+            if (larger == NULL)
+            {
+                break;
+            }
+            data = larger;
+        }
+    }
+    // A pty slave returns EIO once the master is closed: the end of the input
+    if ((count < 0) && (errno != EIO))
+    {
+        perror(path);
+        close(fd);
+        free(data);
+        return 0;
+    }
+    close(fd);
+    sim_options.rx_script = data;
+    sim_options.rx_length = length;
+    return 1;
+}
+
+static void Sim_Usage(const char* name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --duration-ms MS     virtual time to simulate (default 1000)\n"
+            "  --timer-hz HZ        Timer interrupt rate (default 300)\n"
+            "  --baud BAUD          UART baud rate (default 19200)\n"
+            "  --stuck-at-ms MS     hold SDA low from this time\n"
+            "  --stuck-bits N       SCL pulses needed to release SDA (default 5, >9 never)\n"
+            "  --nack-rate P        probability of an address NACK per transfer\n"
+            "  --arb-lost-rate P    probability of an arbitration loss per transfer\n"
+            "  --seed N             seed of the fault generator\n"
+            "  --devices N          LIS3DH models on the bus, at 0x18 and 0x19 (default 1)\n"
+            "  --rx STRING          bytes received over UART after the first frame\n"
+            "  --rx-file FILE       bytes received over UART, read from FILE (a pty: until closed)\n"
+            "  --rx-rate BYTES_S    rate of the received bytes (default the line rate, baud/10)\n"
+            "  --capture FILE       write the UART output to FILE\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option long_options[] =
+    {
+        {"duration-ms", required_argument, NULL, 'd'},
+        {"timer-hz", required_argument, NULL, 't'},
+        {"baud", required_argument, NULL, 'b'},
+        {"stuck-at-ms", required_argument, NULL, 's'},
+        {"stuck-bits", required_argument, NULL, 'k'},
+        {"nack-rate", required_argument, NULL, 'n'},
+        {"arb-lost-rate", required_argument, NULL, 'a'},
+        {"seed", required_argument, NULL, 'r'},
+        {"devices", required_argument, NULL, 'v'},
+        {"rx", required_argument, NULL, 'x'},
+        {"rx-file", required_argument, NULL, 'f'},
+        {"rx-rate", required_argument, NULL, 'q'},
+        {"capture", required_argument, NULL, 'c'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int option;
+
+    while ((option = getopt_long(argc, argv, "h", long_options, NULL)) != -1)
+    {
+        switch (option)
+        {
+            case 'd': sim_options.duration_ms = atof(optarg); break;
+            case 't': sim_options.timer_hz = atof(optarg); break;
+            case 'b': sim_options.baud = (uint32_t)atoi(optarg); break;
+            case 's': sim_options.stuck_at_ms = atof(optarg); break;
+            case 'k': sim_options.stuck_bits = (uint32_t)atoi(optarg); break;
+            case 'n': sim_options.nack_rate = atof(optarg); break;
+            case 'a': sim_options.arb_lost_rate = atof(optarg); break;
+            case 'r': sim_options.seed = (uint32_t)atoi(optarg); break;
+            case 'v': sim_options.devices = (uint8_t)atoi(optarg); break;
+            case 'x':
+                sim_options.rx_script = optarg;
+                sim_options.rx_length = strlen(optarg);
+                break;
+            case 'f':
+                if (!Sim_LoadRx(optarg))
+                {
+                    return 1;
+                }
+                break;
+            case 'q': sim_options.rx_rate = atof(optarg); break;
+            case 'c': sim_options.capture_path = optarg; break;
+            default: Sim_Usage(argv[0]); return (option == 'h') ? 0 : 2;
+        }
+    }
+    if ((sim_options.devices < 1) || (sim_options.devices > SIM_MAX_DEVICES) ||
+        (sim_options.baud == 0) || (sim_options.timer_hz <= 0))
+    {
+        Sim_Usage(argv[0]);
+        return 2;
+    }
+
+    srand(sim_options.seed);
+    if (sim_options.capture_path)
+    {
+        capture = fopen(sim_options.capture_path, "wb");
+        if (!capture)
+        {
+            perror(sim_options.capture_path);
+            return 1;
+        }
+    }
+    for (uint8_t i = 0; i < sim_options.devices; i++)
+    {
+        LIS3DH_Model_Init(&devices[i], (uint8_t)(0x18 + i), 0);
+    }
+    end_ns = (uint64_t)(sim_options.duration_ms*1e6);
+
+    Firmware_Main();
+    Sim_Finish();
+    return 0;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,61 @@
+/**
+*   \file Sim.h
+*   \brief Host simulator of the PROJ_3 firmware.
+*
+*   The firmware sources are compiled unchanged against the shims in
+*   psoc/ and run on a virtual clock. Bus transfers, UART transmission,
+*   delays and register polling advance the clock; the Timer interrupt
+*   is raised at its period of virtual time. The I2C bus is connected to
+*   LIS3DH register models, and faults can be injected on it.
+*/
+
+#ifndef __SIM_H
+    #define __SIM_H
+
+    #include <stdint.h>
+    #include <stdio.h>
+    #include "LIS3DH_Model.h"
+
+    /**
+    *   \brief Maximum number of LIS3DH models on the bus.
+    */
+    #define SIM_MAX_DEVICES 2
+
+    /**
+    *   \brief Options of the simulation.
+    */
+    typedef struct {
+        double duration_ms;         ///< Length of the simulation
+        double timer_hz;            ///< Period of the Timer interrupt
+        uint32_t baud;              ///< UART baud rate
+        double stuck_at_ms;         ///< SDA stuck low from this time (< 0 = never)
+        uint32_t stuck_bits;        ///< SCL pulses needed to release SDA (> 9 = never released)
+        double nack_rate;           ///< Probability of an address NACK per transfer
+        double arb_lost_rate;       ///< Probability of an arbitration loss per transfer
+        uint32_t seed;              ///< Seed of the fault generator
+        const char* capture_path;   ///< File receiving the UART bytes (NULL = none)
+        const char* rx_script;      ///< Bytes received over UART after the first sample
+        size_t rx_length;           ///< Bytes of rx_script, which may hold NUL bytes (--rx-file)
+        double rx_rate;             ///< Bytes/s of the received stream (0 = line rate)
+        uint8_t devices;            ///< Number of LIS3DH models (0x18, 0x19)
+    } Sim_Options;
+
+    extern Sim_Options sim_options;
+
+    /**
+    *   \brief Current virtual time.
+    */
+    uint64_t Sim_NowNs(void);
+
+    /**
+    *   \brief Advance the virtual time, raising the Timer interrupts that fall in it.
+    */
+    void Sim_AdvanceNs(uint64_t ns);
+
+    /**
+    *   \brief LIS3DH models on the bus.
+    */
+    LIS3DH_Model* Sim_GetDevice(uint8_t index);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,15 @@
+/**
+*   \file CS_1.h
+*   \brief Host shim of the CS_1 pin component (chip select of the LIS3DH).
+*/
+
+#ifndef CY_PINS_CS_1_H
+    #define CY_PINS_CS_1_H
+
+    #include "cytypes.h"
+
+    void CS_1_Write(uint8 value);
+    uint8 CS_1_Read(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,42 @@
+/**
+*   \file CyDmac.h
+*   \brief Host shim of the PSoC Creator DMA controller API.
+*
+*   The transaction descriptors are kept by the simulator; a channel with
+*   the UART TX FIFO as destination moves its bytes at the baud rate
+*   without blocking the CPU.
+*/
+
+#ifndef CY_BOOT_CYDMAC_H
+    #define CY_BOOT_CYDMAC_H
+
+    #include "cytypes.h"
+
+    #define CY_DMA_NUMBEROF_TDS         (128u)
+    #define CY_DMA_INVALID_TD           (0xFFu)
+    #define CY_DMA_END_CHAIN_TD         (0xFFu)
+    #define CY_DMA_DISABLE_TD           (0xFEu)
+
+    #define CY_DMA_TD_SWAP_EN           (0x80u)
+    #define CY_DMA_TD_SWAP_SIZE4        (0x40u)
+    #define CY_DMA_TD_AUTO_EXEC_NEXT    (0x20u)
+    #define CY_DMA_TD_TERMIN_EN         (0x10u)
+    #define CY_DMA_TD_TERMOUT1_EN       (0x08u)
+    #define CY_DMA_TD_TERMOUT0_EN       (0x04u)
+    #define CY_DMA_TD_INC_DST_ADR       (0x04u)
+    #define CY_DMA_TD_INC_SRC_ADR       (0x08u)
+
+    #define CY_DMA_STATUS_CHAIN_ACTIVE  (0x01u)
+    #define CY_DMA_STATUS_TD_ACTIVE     (0x02u)
+
+    uint8 CyDmaTdAllocate(void);
+    void CyDmaTdFree(uint8 tdHandle);
+    cystatus CyDmaTdSetConfiguration(uint8 tdHandle, uint16 transferCount, uint8 nextTd, uint8 configuration);
+    cystatus CyDmaTdSetAddress(uint8 tdHandle, uint16 source, uint16 destination);
+    cystatus CyDmaChSetInitialTd(uint8 chHandle, uint8 startTd);
+    cystatus CyDmaChEnable(uint8 chHandle, uint8 preserveTds);
+    cystatus CyDmaChDisable(uint8 chHandle);
+    cystatus CyDmaChStatus(uint8 chHandle, uint8 * currentTd, uint8 * state);
+
+#endif
+/* [] END OF FILE */
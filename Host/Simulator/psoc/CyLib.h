@@ -0,0 +1,22 @@
+/**
+*   \file CyLib.h
+*   \brief Host shim of the PSoC Creator system functions.
+*/
+
+#ifndef CY_BOOT_CYLIB_H
+    #define CY_BOOT_CYLIB_H
+
+    #include "cytypes.h"
+    #include "cyfitter.h"
+
+    #define CyGlobalIntEnable   do { } while (0)
+    #define CyGlobalIntDisable  do { } while (0)
+
+    void CyDelay(uint32 milliseconds);
+    void CyDelayUs(uint16 microseconds);
+    void CyDelayCycles(uint32 cycles);
+    uint8 CyEnterCriticalSection(void);
+    void CyExitCriticalSection(uint8 savedIntrStatus);
+
+#endif
+/* [] END OF FILE */
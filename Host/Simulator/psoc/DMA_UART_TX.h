@@ -0,0 +1,15 @@
+/**
+*   \file DMA_UART_TX.h
+*   \brief Host shim of the DMA_UART_TX component.
+*/
+
+#ifndef CY_DMA_DMA_UART_TX_DMA_H
+    #define CY_DMA_DMA_UART_TX_DMA_H
+
+    #include "CyDmac.h"
+
+    uint8 DMA_UART_TX_DmaInitialize(uint8 BurstCount, uint8 ReqestPerBurst, uint16 UpperSrcAddress, uint16 UpperDestAddress);
+    void DMA_UART_TX_DmaRelease(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,71 @@
+/**
+*   \file I2C_Master.h
+*   \brief Host shim of the I2C_Master component (fixed-function, master only).
+*
+*   Transfers are routed to the LIS3DH models of the simulator. Only the
+*   buffer API used by I2C_Interface.c is provided. As on the component,
+*   the interrupt drives the transfers: Stop disables it, Enable does not
+*   turn it back on, and a transfer started without it never completes.
+*/
+
+#ifndef CY_I2C_I2C_Master_H
+    #define CY_I2C_I2C_Master_H
+
+    #include "cytypes.h"
+
+    void I2C_Master_Start(void);
+    void I2C_Master_Stop(void);
+    void I2C_Master_Init(void);
+    void I2C_Master_Enable(void);
+    void I2C_Master_EnableInt(void);
+    void I2C_Master_DisableInt(void);
+
+    uint8 I2C_Master_MasterWriteBuf(uint8 slaveAddress, uint8 * wrData, uint8 cnt, uint8 mode);
+    uint8 I2C_Master_MasterReadBuf(uint8 slaveAddress, uint8 * rdData, uint8 cnt, uint8 mode);
+    uint8 I2C_Master_MasterStatus(void);
+    uint8 I2C_Master_MasterClearStatus(void);
+
+    #define I2C_Master_WRITE_XFER_MODE  (0u)
+    #define I2C_Master_READ_XFER_MODE   (1u)
+    #define I2C_Master_ACK_DATA         (0u)
+    #define I2C_Master_NAK_DATA         (1u)
+
+    #define I2C_Master_MODE_COMPLETE_XFER   (0x00u)
+    #define I2C_Master_MODE_REPEAT_START    (0x01u)
+    #define I2C_Master_MODE_NO_STOP         (0x02u)
+
+    #define I2C_Master_MSTR_NO_ERROR            (0x00u)
+    #define I2C_Master_MSTR_BUS_BUSY            (0x01u)
+    #define I2C_Master_MSTR_NOT_READY           (0x02u)
+    #define I2C_Master_MSTR_ERR_LB_NAK          (0x03u)
+    #define I2C_Master_MSTR_ERR_ARB_LOST        (0x04u)
+    #define I2C_Master_MSTR_ERR_ABORT_START_GEN (0x05u)
+
+    #define I2C_Master_MSTAT_RD_CMPLT       (0x01u)
+    #define I2C_Master_MSTAT_WR_CMPLT       (0x02u)
+    #define I2C_Master_MSTAT_XFER_INP       (0x04u)
+    #define I2C_Master_MSTAT_XFER_HALT      (0x08u)
+    #define I2C_Master_MSTAT_ERR_SHORT_XFER (0x10u)
+    #define I2C_Master_MSTAT_ERR_ADDR_NAK   (0x20u)
+    #define I2C_Master_MSTAT_ERR_ARB_LOST   (0x40u)
+    #define I2C_Master_MSTAT_ERR_XFER       (0x80u)
+
+    /**
+    *   \brief Clock divider of the fixed-function block.
+    */
+    extern uint8 I2C_Master_clkDiv[2];
+    #define I2C_Master_CLKDIV1_REG (I2C_Master_clkDiv[0])
+    #define I2C_Master_CLKDIV2_REG (I2C_Master_clkDiv[1])
+    #define I2C_Master_DEFAULT_DIVIDE_FACTOR (15u)
+
+    /**
+    *   \brief Configuration register of the fixed-function block.
+    */
+    extern uint8 I2C_Master_cfg;
+    #define I2C_Master_CFG_REG (I2C_Master_cfg)
+    #define I2C_Master_CFG_CLK_RATE_MSK (0x04u)
+    #define I2C_Master_CFG_EN_MSTR (0x02u)
+    #define I2C_Master_DEFAULT_CFG (0x02u)
+
+#endif
+/* [] END OF FILE */
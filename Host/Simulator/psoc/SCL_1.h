@@ -0,0 +1,25 @@
+/**
+*   \file SCL_1.h
+*   \brief Host shim of the SCL_1 pin component.
+*/
+
+#ifndef CY_PINS_SCL_1_H
+    #define CY_PINS_SCL_1_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Bypass register of the port of the I2C pins, shared by SCL_1 and SDA_1.
+    *
+    *   With the bit of the pin set, the pin is hardware-connected to the
+    *   I2C block and its data register drives nothing.
+    */
+    extern reg8 Sim_I2cPortBypass;
+    #define SCL_1_BYP (Sim_I2cPortBypass)
+    #define SCL_1_MASK (0x01u)
+
+    void SCL_1_Write(uint8 value);
+    uint8 SCL_1_Read(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,30 @@
+/**
+*   \file SPIM.h
+*   \brief Host shim of the SPIM component (SPI Master, 8-bit).
+*
+*   Bytes are shifted to the LIS3DH model selected by CS_1. Only the
+*   functions used by SPI_Interface.c are provided.
+*/
+
+#ifndef CY_SPIM_SPIM_H
+    #define CY_SPIM_SPIM_H
+
+    #include "cytypes.h"
+
+    void SPIM_Start(void);
+    void SPIM_Stop(void);
+    void SPIM_WriteTxData(uint8 txData);
+    uint8 SPIM_ReadRxData(void);
+    uint8 SPIM_GetRxBufferSize(void);
+    uint8 SPIM_ReadTxStatus(void);
+    void SPIM_ClearRxBuffer(void);
+    void SPIM_ClearTxBuffer(void);
+
+    #define SPIM_STS_SPI_DONE           (0x01u)
+    #define SPIM_STS_TX_FIFO_EMPTY      (0x02u)
+    #define SPIM_STS_TX_FIFO_NOT_FULL   (0x04u)
+    #define SPIM_STS_BYTE_COMPLETE      (0x08u)
+    #define SPIM_STS_SPI_IDLE           (0x10u)
+
+#endif
+/* [] END OF FILE */
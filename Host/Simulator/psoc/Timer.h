@@ -0,0 +1,19 @@
+/**
+*   \file Timer.h
+*   \brief Host shim of the Timer component.
+*/
+
+#ifndef CY_TIMER_Timer_H
+    #define CY_TIMER_Timer_H
+
+    #include "cytypes.h"
+
+    void Timer_Start(void);
+    void Timer_Stop(void);
+    uint8 Timer_ReadStatusRegister(void);
+    uint16 Timer_ReadPeriod(void);
+    void Timer_WritePeriod(uint16 period);
+    uint16 Timer_ReadCounter(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,46 @@
+/**
+*   \file UART_Debug.h
+*   \brief Host shim of the UART_Debug component.
+*
+*   Transmitted bytes are timed at the simulated baud rate and captured
+*   by the simulator; received bytes come from the simulator input script.
+*   As in TopDesign, the TX buffer is the 4-byte hardware FIFO only.
+*/
+
+#ifndef CY_UART_UART_Debug_H
+    #define CY_UART_UART_Debug_H
+
+    #include "cytypes.h"
+
+    #define UART_Debug_TX_BUFFER_SIZE (4u)
+    #define UART_Debug_RX_BUFFER_SIZE (4u)
+
+    /**
+    *   \brief Bits of the TX status register.
+    */
+    #define UART_Debug_TX_STS_COMPLETE (0x01u)
+    #define UART_Debug_TX_STS_FIFO_EMPTY (0x02u)
+    #define UART_Debug_TX_STS_FIFO_FULL (0x04u)
+    #define UART_Debug_TX_STS_FIFO_NOT_FULL (0x08u)
+
+    /**
+    *   \brief TX FIFO of the UART, destination of the DMA transfers.
+    */
+    extern reg8 Sim_UartTxData;
+    #define UART_Debug_TXDATA_PTR (&Sim_UartTxData)
+
+    void UART_Debug_Start(void);
+    void UART_Debug_Stop(void);
+    uint8 UART_Debug_ReadTxStatus(void);
+    void UART_Debug_WriteTxData(uint8 txDataByte);
+    void UART_Debug_PutChar(uint8 txDataByte);
+    void UART_Debug_PutString(const char8 string[]);
+    void UART_Debug_PutArray(const uint8 string[], uint8 byteCount);
+    void UART_Debug_PutCRLF(uint8 txDataByte);
+    uint8 UART_Debug_GetChar(void);
+    uint8 UART_Debug_GetRxBufferSize(void);
+    uint8 UART_Debug_GetTxBufferSize(void);
+    void UART_Debug_ClearTxBuffer(void);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,18 @@
+/**
+*   \file cyPm.h
+*   \brief Host shim of the PSoC Creator power management API.
+*/
+
+#ifndef CY_BOOT_CYPM_H
+    #define CY_BOOT_CYPM_H
+
+    #include "cytypes.h"
+
+    /**
+    *   \brief Wait for interrupt: the virtual time jumps to the next Timer interrupt.
+    */
+    void Sim_WaitForInterrupt(void);
+    #define CY_PM_WFI Sim_WaitForInterrupt()
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,56 @@
+/**
+*   \file cy_em_eeprom.h
+*   \brief Host shim of the Em_EEPROM_Dynamic library.
+*
+*   The emulated EEPROM is kept in RAM by the simulator; the flash storage
+*   passed through userFlashStartAddr is not used.
+*/
+
+#ifndef CY_EM_EEPROM_H
+    #define CY_EM_EEPROM_H
+
+    #include "cytypes.h"
+
+    #define CY_EM_EEPROM_FLASH_SIZEOF_ROW (256u)
+    #define CY_EM_EEPROM_EEPROM_DATA_LEN (CY_EM_EEPROM_FLASH_SIZEOF_ROW / 2u)
+    #define CY_EM_EEPROM_GET_NUM_DATA(size) (((size) + CY_EM_EEPROM_EEPROM_DATA_LEN - 1u) / CY_EM_EEPROM_EEPROM_DATA_LEN)
+    #define CY_EM_EEPROM_GET_PHYSICAL_SIZE(size, wearLeveling, redundantCopy) \
+        (CY_EM_EEPROM_GET_NUM_DATA(size) * CY_EM_EEPROM_FLASH_SIZEOF_ROW * (wearLeveling) * (1u + (redundantCopy)))
+
+    typedef enum
+    {
+        CY_EM_EEPROM_SUCCESS,
+        CY_EM_EEPROM_BAD_PARAM,
+        CY_EM_EEPROM_BAD_CHECKSUM,
+        CY_EM_EEPROM_BAD_DATA,
+        CY_EM_EEPROM_WRITE_FAIL
+    } cy_en_em_eeprom_status_t;
+
+    typedef struct
+    {
+        uint32 eepromSize;
+        uint32 wearLevelingFactor;
+        uint8 redundantCopy;
+        uint8 blockingWrite;
+        uint32 userFlashStartAddr;
+    } cy_stc_eeprom_config_t;
+
+    typedef struct
+    {
+        uint32 eepromSize;
+        uint32 numberOfRows;
+        uint32 wearLevelingFactor;
+        uint8 redundantCopy;
+        uint8 blockingWrite;
+        uint32 lastWrRowAddr;
+        uint32 userFlashStartAddr;
+    } cy_stc_eeprom_context_t;
+
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Init(cy_stc_eeprom_config_t* config, cy_stc_eeprom_context_t * context);
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Read(uint32 addr, void * eepromData, uint32 size, cy_stc_eeprom_context_t * context);
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Write(uint32 addr, void * eepromData, uint32 size, cy_stc_eeprom_context_t * context);
+    cy_en_em_eeprom_status_t Cy_Em_EEPROM_Erase(cy_stc_eeprom_context_t * context);
+    uint32 Cy_Em_EEPROM_NumWrites(cy_stc_eeprom_context_t * context);
+
+#endif
+/* [] END OF FILE */
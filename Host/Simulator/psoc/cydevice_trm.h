@@ -0,0 +1,13 @@
+/**
+*   \file cydevice_trm.h
+*   \brief Host shim of the register map generated by PSoC Creator.
+*/
+
+#ifndef CYDEVICE_TRM_H
+    #define CYDEVICE_TRM_H
+
+    #define CYDEV_SRAM_BASE 0x1fff8000u
+    #define CYDEV_PERIPH_BASE 0x40000000u
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,14 @@
+/**
+*   \file cyfitter.h
+*   \brief Host shim of the clock tree generated by PSoC Creator.
+*/
+
+#ifndef INCLUDED_CYFITTER_H
+    #define INCLUDED_CYFITTER_H
+
+    #define BCLK__BUS_CLK__HZ 24000000U
+    #define BCLK__BUS_CLK__KHZ 24000U
+    #define BCLK__BUS_CLK__MHZ 24U
+
+#endif
+/* [] END OF FILE */
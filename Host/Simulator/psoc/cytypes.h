@@ -0,0 +1,69 @@
+/**
+*   \file cytypes.h
+*   \brief Host shim of the PSoC Creator basic types.
+*
+*   Only the subset used by the firmware of this repository is provided.
+*/
+
+#ifndef CY_BOOT_CYTYPES_H
+    #define CY_BOOT_CYTYPES_H
+
+    #include <stdint.h>
+    #include <stddef.h>
+
+    typedef uint8_t  uint8;
+    typedef uint16_t uint16;
+    typedef uint32_t uint32;
+    typedef int8_t   int8;
+    typedef int16_t  int16;
+    typedef int32_t  int32;
+    typedef float    float32;
+    typedef double   float64;
+    typedef char     char8;
+    typedef uint32   cystatus;
+
+    #define CYRET_SUCCESS           (0x00u)
+    #define CYRET_BAD_PARAM         (0x01u)
+
+    typedef volatile uint8  reg8;
+    typedef volatile uint16 reg16;
+    typedef volatile uint32 reg32;
+
+    typedef void (* cyisraddress)(void);
+
+    #define CY_ISR(FuncName)        void FuncName (void)
+    #define CY_ISR_PROTO(FuncName)  void FuncName (void)
+
+    #define CY_ALIGN(align)         __attribute__ ((aligned(align)))
+    #define CY_INLINE               inline
+    #define CYCODE
+    #define CY_NOINIT
+
+    #define LO8(x)  ((uint8) ((x) & 0xFFu))
+    #define HI8(x)  ((uint8) ((uint16)(x) >> 8))
+    #define HI16(x) ((uint16) ((uint32)(x) >> 16))
+
+    /**
+    *   \brief Low half of an address, recorded by the simulator.
+    *
+    *   DMA descriptors only hold the low 16 bits of their addresses: the
+    *   simulator keeps the full address of each low half it has seen, so
+    *   that a descriptor can be resolved to host memory. The simulator is
+    *   linked with -no-pie for the static buffers to have 32-bit addresses.
+    */
+    uint16 Sim_Lo16(uint32 address);
+    #define LO16(x) Sim_Lo16((uint32)(x))
+
+    /**
+    *   \brief Register access, routed to the simulator (cycle counter, DMA, ...).
+    */
+    uint32 Sim_ReadReg32(uintptr_t address);
+    void Sim_WriteReg32(uintptr_t address, uint32 value);
+
+    #define CY_GET_REG8(addr)        ((uint8) Sim_ReadReg32((uintptr_t)(addr)))
+    #define CY_SET_REG8(addr, value) Sim_WriteReg32((uintptr_t)(addr), (uint8)(value))
+    #define CY_GET_REG32(addr)       Sim_ReadReg32((uintptr_t)(addr))
+    #define CY_SET_REG32(addr, value) Sim_WriteReg32((uintptr_t)(addr), (uint32)(value))
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,15 @@
+/**
+*   \file isr_ADC.h
+*   \brief Host shim of the isr_ADC interrupt component (Timer terminal count).
+*/
+
+#ifndef CY_ISR_isr_ADC_H
+    #define CY_ISR_isr_ADC_H
+
+    #include "cytypes.h"
+
+    void isr_ADC_StartEx(cyisraddress address);
+    void isr_ADC_Stop(void);
+
+#endif
+/* [] END OF FILE */
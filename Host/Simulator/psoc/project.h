@@ -0,0 +1,23 @@
+/**
+*   \file project.h
+*   \brief Host shim of the project header generated by PSoC Creator.
+*/
+
+#include "cytypes.h"
+#include "cyfitter.h"
+#include "cydevice_trm.h"
+#include "CyLib.h"
+#include "cyPm.h"
+#include "CyDmac.h"
+#include "I2C_Master.h"
+#include "UART_Debug.h"
+#include "Timer.h"
+#include "isr_ADC.h"
+#include "SCL_1.h"
+#include "SDA_1.h"
+#include "SPIM.h"
+#include "CS_1.h"
+#include "cy_em_eeprom.h"
+#include "DMA_UART_TX.h"
+
+/* [] END OF FILE */